@@ -1,4 +1,7 @@
 #!/bin/bash
 
-$VULKAN_SDK/bin/glslangValidator -V src/shaders/vert.vert && mv vert.spv src/shaders
-$VULKAN_SDK/bin/glslangValidator -V src/shaders/frag.frag && mv frag.spv src/shaders
+# The build does this too - this is for re-compiling shaders without building.
+$VULKAN_SDK/bin/glslangValidator -V src/shaders/vert.vert -o src/shaders/vert.spv
+$VULKAN_SDK/bin/glslangValidator -V src/shaders/frag.frag -o src/shaders/frag.spv
+$VULKAN_SDK/bin/glslangValidator -V src/shaders/balls.comp -o src/shaders/balls.spv
+$VULKAN_SDK/bin/glslangValidator -V src/shaders/cull.comp -o src/shaders/cull.spv
@@ -1,4 +1,9 @@
 
+newoption {
+     trigger = "avx2",
+     description = "Build the batched simulation kernels with AVX2 (defaults to SSE2)"
+}
+
 workspace "Pong"
      startproject "Pong"
      configurations { 
@@ -7,6 +12,7 @@ workspace "Pong"
      }
 
 outputdir = "%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
+glslang = os.getenv("VULKAN_SDK") .. "/bin/glslangValidator"
 include "vendor/GLFW/"
 
 project "Pong"
@@ -17,6 +23,15 @@ project "Pong"
 
      files { "src/**.h", "src/**.cpp" }
 
+     -- The SPIR-V is compiled from the GLSL on every build, so it can't fall
+     -- behind the shaders it came from.
+     prebuildcommands {
+          glslang .. " -V %{prj.location}/src/shaders/vert.vert -o %{prj.location}/src/shaders/vert.spv",
+          glslang .. " -V %{prj.location}/src/shaders/frag.frag -o %{prj.location}/src/shaders/frag.spv",
+          glslang .. " -V %{prj.location}/src/shaders/balls.comp -o %{prj.location}/src/shaders/balls.spv",
+          glslang .. " -V %{prj.location}/src/shaders/cull.comp -o %{prj.location}/src/shaders/cull.spv",
+     }
+
      links {
           "GLFW",
      }
@@ -52,6 +67,10 @@ project "Pong"
                os.getenv("VULKAN_SDK") .. "/lib32/vulkan-1.lib",
           }
 
+     filter "options:avx2"
+          vectorextensions "AVX2"
+          defines { "PONG_AVX2" }
+
      filter "configurations:Debug"
           defines { "DEBUG" }
           symbols "On"
@@ -0,0 +1,29 @@
+#ifndef PONG_VK_CLOCK_H
+#define PONG_VK_CLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+// A 64-bit monotonic nanosecond clock. Unlike a float seconds counter this
+// never loses precision the longer the game runs, and it can't go backwards
+// when the system time is adjusted.
+namespace Clock {
+
+    constexpr uint64_t NANOS_PER_SECOND = 1000000000ull;
+    constexpr uint64_t NANOS_PER_MICRO = 1000ull;
+
+    inline uint64_t nowNanos() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    inline double toSeconds(uint64_t nanos) {
+        return static_cast<double>(nanos) / static_cast<double>(NANOS_PER_SECOND);
+    }
+
+    inline uint64_t toMicros(uint64_t nanos) {
+        return nanos / NANOS_PER_MICRO;
+    }
+}
+
+#endif //PONG_VK_CLOCK_H
@@ -0,0 +1,187 @@
+#include "jobs.h"
+#include "../logger.h"
+
+namespace Jobs {
+
+    // Index of the queue owned by the current thread. Threads the system
+    // didn't start (other than the one which created it) don't own one, and
+    // must never push into someone else's.
+    constexpr uint32_t NO_QUEUE = UINT32_MAX;
+    static thread_local uint32_t t_QueueIndex = NO_QUEUE;
+
+    // How many times an idle worker looks for work before going to sleep.
+    constexpr uint32_t IDLE_SPIN_COUNT = 64;
+
+    // ----------------------------- QUEUES -------------------------------------
+
+    static bool pushBack(WorkQueue* queue, const Job& job) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (queue->tail - queue->head == QUEUE_CAPACITY) return false;
+        queue->jobs[queue->tail++ % QUEUE_CAPACITY] = job;
+        return true;
+    }
+
+    static bool popBack(WorkQueue* queue, Job* job) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (queue->tail == queue->head) return false;
+        *job = queue->jobs[--queue->tail % QUEUE_CAPACITY];
+        return true;
+    }
+
+    static bool stealFront(WorkQueue* queue, Job* job) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (queue->tail == queue->head) return false;
+        *job = queue->jobs[queue->head++ % QUEUE_CAPACITY];
+        return true;
+    }
+
+    // Takes a job from our own queue, or failing that steals one.
+    static bool findJob(JobSystem* system, Job* job) {
+
+        uint32_t queueCount = system->workerCount + 1;
+        uint32_t self = t_QueueIndex;
+
+        if (self != NO_QUEUE && popBack(&system->queues[self], job)) return true;
+
+        if (stealFront(&system->injectionQueue, job)) return true;
+
+        // Starting after our own queue, so the threads don't all hit the same one.
+        uint32_t first = self != NO_QUEUE ? self + 1 : 0;
+        for (uint32_t i = 0; i < queueCount; i++) {
+            uint32_t index = (first + i) % queueCount;
+            if (index != self && stealFront(&system->queues[index], job)) return true;
+        }
+
+        return false;
+    }
+
+    static void runJob(const Job& job) {
+        job.function(job.data, job.start, job.end);
+        if (job.counter) job.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    static bool runNextJob(JobSystem* system) {
+        Job job;
+        if (!findJob(system, &job)) return false;
+        system->queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        runJob(job);
+        return true;
+    }
+
+    // ----------------------------- WORKERS ------------------------------------
+
+    static void runWorker(JobSystem* system, uint32_t queueIndex) {
+
+        t_QueueIndex = queueIndex;
+
+        while (system->isRunning.load(std::memory_order_acquire)) {
+
+            bool didWork = false;
+            for (uint32_t spin = 0; spin < IDLE_SPIN_COUNT && !didWork; spin++) {
+                didWork = runNextJob(system);
+                if (!didWork) std::this_thread::yield();
+            }
+
+            if (didWork) continue;
+
+            std::unique_lock<std::mutex> lock(system->sleepMutex);
+            system->wakeCondition.wait(lock, [system]() {
+                return system->queuedJobs.load(std::memory_order_acquire) > 0
+                    || !system->isRunning.load(std::memory_order_acquire);
+            });
+        }
+    }
+
+    bool initialiseJobSystem(JobSystem* system, uint32_t workerCount) {
+
+        if (workerCount == 0) {
+            uint32_t hardwareThreads = std::thread::hardware_concurrency();
+            workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+        }
+
+        system->workerCount = workerCount;
+        system->queues = new WorkQueue[workerCount + 1];
+        system->workers = new std::thread[workerCount];
+        system->injectionQueue.head = 0;
+        system->injectionQueue.tail = 0;
+        system->queuedJobs.store(0);
+        system->isRunning.store(true, std::memory_order_release);
+
+        // The creating thread owns queue 0.
+        t_QueueIndex = 0;
+
+        for (uint32_t i = 0; i < workerCount; i++) {
+            system->workers[i] = std::thread(runWorker, system, i + 1);
+        }
+
+        PONG_INFO("Started job system with {0} worker threads", workerCount);
+
+        return true;
+    }
+
+    void shutdownJobSystem(JobSystem* system) {
+
+        if (!system->workers) return;
+
+        {
+            std::lock_guard<std::mutex> lock(system->sleepMutex);
+            system->isRunning.store(false, std::memory_order_release);
+        }
+        system->wakeCondition.notify_all();
+
+        for (uint32_t i = 0; i < system->workerCount; i++) {
+            system->workers[i].join();
+        }
+
+        delete[] system->workers;
+        delete[] system->queues;
+        system->workers = nullptr;
+        system->queues = nullptr;
+        system->workerCount = 0;
+    }
+
+    // ----------------------------- SUBMISSION ---------------------------------
+
+    void submitJob(JobSystem* system, JobFunction function, void* data, Counter* counter, uint32_t start, uint32_t end) {
+
+        Job job = { function, data, start, end, counter };
+        if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+        {
+            // Taking the lock orders this with a worker checking the predicate
+            // right before it sleeps, so the wake up can't be missed. The count
+            // goes up before the push so it never dips below zero when another
+            // thread grabs the job straight away.
+            std::lock_guard<std::mutex> lock(system->sleepMutex);
+            system->queuedJobs.fetch_add(1, std::memory_order_release);
+        }
+
+        WorkQueue* queue = t_QueueIndex != NO_QUEUE ? &system->queues[t_QueueIndex] : &system->injectionQueue;
+
+        if (!pushBack(queue, job)) {
+            // The queue is full - just do the work now.
+            system->queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            runJob(job);
+            return;
+        }
+
+        system->wakeCondition.notify_one();
+    }
+
+    void parallelFor(JobSystem* system, JobFunction function, void* data, uint32_t count,
+        uint32_t batchSize, Counter* counter) {
+
+        if (batchSize == 0) batchSize = 1;
+
+        for (uint32_t start = 0; start < count; start += batchSize) {
+            uint32_t end = count - start > batchSize ? start + batchSize : count;
+            submitJob(system, function, data, counter, start, end);
+        }
+    }
+
+    void waitForCounter(JobSystem* system, Counter* counter) {
+        while (counter->pending.load(std::memory_order_acquire) > 0) {
+            if (!runNextJob(system)) std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef PONG_VK_JOBS_H
+#define PONG_VK_JOBS_H
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+// A small work-stealing thread pool.
+//
+// Every thread that runs jobs (the main thread plus each worker) owns a queue.
+// A thread pushes and pops its own queue from the back, so it keeps working on
+// the most recently split (and most cache-warm) piece of work. When its queue
+// runs dry it steals from the front of someone else's - the oldest, and usually
+// largest, piece of work they have.
+//
+// Any other thread can submit jobs too, but doesn't own a queue to push them
+// into - they go into a shared injection queue, which every thread steals from.
+//
+// Completion is tracked with counters rather than futures: submitting a job
+// increments its counter, finishing it decrements it, and waiting on a counter
+// runs other jobs until it reaches zero. Because waiting threads keep working,
+// jobs can safely wait on jobs they spawned themselves.
+
+namespace Jobs {
+
+    // Jobs operate on the range [start, end) of whatever 'data' points to.
+    typedef void (*JobFunction)(void* data, uint32_t start, uint32_t end);
+
+    struct Counter {
+        std::atomic<uint32_t> pending {0};
+    };
+
+    struct Job {
+        JobFunction function    {nullptr};
+        void* data              {nullptr};
+        uint32_t start          {0};
+        uint32_t end            {0};
+        Counter* counter        {nullptr};
+    };
+
+    // Queues are fixed-size rings. A full queue just runs the job inline.
+    constexpr uint32_t QUEUE_CAPACITY = 1024;
+
+    struct WorkQueue {
+        std::mutex mutex;
+        Job jobs[QUEUE_CAPACITY];
+        uint32_t head   {0};
+        uint32_t tail   {0};
+    };
+
+    struct JobSystem {
+        uint32_t workerCount                {0};
+        std::thread* workers                {nullptr};
+        // workerCount + 1 queues - queue 0 belongs to the thread which created the system.
+        WorkQueue* queues                   {nullptr};
+        // Jobs submitted by threads without a queue of their own.
+        WorkQueue injectionQueue;
+        std::atomic<bool> isRunning         {false};
+        // Total jobs sitting in queues, so idle workers know when to wake.
+        std::atomic<uint32_t> queuedJobs    {0};
+        std::mutex sleepMutex;
+        std::condition_variable wakeCondition;
+    };
+
+    // Spawns the worker threads. A worker count of 0 uses one per hardware
+    // thread, minus the calling thread.
+    bool initialiseJobSystem(JobSystem*, uint32_t workerCount = 0);
+    void shutdownJobSystem(JobSystem*);
+
+    void submitJob(JobSystem*, JobFunction, void* data, Counter*, uint32_t start = 0, uint32_t end = 0);
+    // Splits [0, count) into batches of batchSize and submits one job per batch.
+    void parallelFor(JobSystem*, JobFunction, void* data, uint32_t count, uint32_t batchSize, Counter*);
+    // Runs queued jobs until the counter reaches zero.
+    void waitForCounter(JobSystem*, Counter*);
+}
+
+#endif //PONG_VK_JOBS_H
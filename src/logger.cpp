@@ -2,9 +2,387 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
 
 std::shared_ptr<spdlog::logger> Logger::s_CoreLogger;
+std::atomic<uint8_t> Logger::s_Level {static_cast<uint8_t>(LogLevel::TRACE)};
+
+#ifdef DEBUG
 
 void initLogger() {
     spdlog::set_pattern("%^[%T] %n: %v%$");
     Logger::s_CoreLogger = spdlog::stdout_color_mt("PONG");
     Logger::s_CoreLogger -> set_level(spdlog::level::trace);
-}
\ No newline at end of file
+}
+
+void shutdownLogger() {
+    Logger::s_CoreLogger->flush();
+}
+
+void setLogLevel(LogLevel level) {
+    Logger::s_Level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+    Logger::s_CoreLogger->set_level(level == LogLevel::OFF ? spdlog::level::off :
+        static_cast<spdlog::level::level_enum>(static_cast<int>(level) + (level >= LogLevel::INFO ? 1 : 0)));
+}
+
+#elif defined(RELEASE)
+
+#include <thread>
+#include <mutex>
+#include <ctime>
+#include <cstdio>
+
+namespace AsyncLog {
+
+    constexpr uint32_t MAX_THREADS = 64;
+
+    thread_local ThreadRing* t_Ring = nullptr;
+
+    // Rings are registered once per thread and never released, so messages
+    // from a thread that has already exited are still written out, and a
+    // thread still running at shutdown (a job worker on an early exit) never
+    // writes into freed memory - its messages just stop being written.
+    static ThreadRing* s_Rings[MAX_THREADS];
+    static std::atomic<uint32_t> s_RingCount {0};
+    static std::mutex s_RegistryMutex;
+
+    static std::thread s_Thread;
+    static std::atomic<bool> s_IsRunning {false};
+
+    // Used to turn steady clock timestamps back into wall clock time.
+    static int64_t s_StartSteady {0};
+    static std::chrono::system_clock::time_point s_StartSystem;
+
+    static const char* s_LevelNames[] = { "trace", "info", "warning", "error", "critical" };
+
+    ThreadRing* registerThread() {
+
+        std::lock_guard<std::mutex> lock(s_RegistryMutex);
+
+        uint32_t count = s_RingCount.load(std::memory_order_relaxed);
+        if (count == MAX_THREADS) return nullptr;
+
+        t_Ring = new ThreadRing();
+        s_Rings[count] = t_Ring;
+        s_RingCount.store(count + 1, std::memory_order_release);
+
+        return t_Ring;
+    }
+
+    // ----------------------------- FORMATTING ----------------------------------
+
+    struct Arg {
+        ArgType type;
+        union {
+            int64_t i;
+            uint64_t u;
+            double f;
+        };
+        std::string_view s;
+    };
+
+    static uint32_t decodeArgs(const Record* record, Arg* args, uint32_t maxArgs) {
+
+        uint32_t count = 0;
+        size_t offset = 0;
+
+        while (offset < record->size && count < maxArgs) {
+            Arg& arg = args[count++];
+            arg.type = static_cast<ArgType>(record->payload[offset++]);
+
+            switch (arg.type) {
+                case ARG_INT:
+                    memcpy(&arg.i, record->payload + offset, sizeof(int64_t));
+                    offset += sizeof(int64_t);
+                    break;
+                case ARG_UINT:
+                    memcpy(&arg.u, record->payload + offset, sizeof(uint64_t));
+                    offset += sizeof(uint64_t);
+                    break;
+                case ARG_FLOAT:
+                    memcpy(&arg.f, record->payload + offset, sizeof(double));
+                    offset += sizeof(double);
+                    break;
+                case ARG_BOOL:
+                    arg.u = record->payload[offset];
+                    offset += 1;
+                    break;
+                case ARG_STRING: {
+                    uint16_t length;
+                    memcpy(&length, record->payload + offset, sizeof(uint16_t));
+                    arg.s = std::string_view(reinterpret_cast<const char*>(record->payload + offset + 2), length);
+                    offset += 2 + length;
+                    break;
+                }
+            }
+        }
+
+        return count;
+    }
+
+    // Turns the part of fmt's spec grammar that printf shares -
+    // [sign][#][0][width][.precision][type] - into a printf format with the
+    // given length modifier and default conversion. Returns false for
+    // anything printf can't express the same way (fill, alignment, 'b', ...).
+    static bool toPrintfFormat(std::string_view spec, const char* length, char defaultType, const char* types,
+        bool allowPrecision, char* format, size_t size) {
+
+        size_t i = 0;
+        if (i < spec.size() && (spec[i] == '+' || spec[i] == ' ')) i++;
+        if (i < spec.size() && spec[i] == '#') i++;
+        while (i < spec.size() && spec[i] >= '0' && spec[i] <= '9') i++;
+
+        if (i < spec.size() && spec[i] == '.') {
+            if (!allowPrecision) return false;
+            i++;
+            while (i < spec.size() && spec[i] >= '0' && spec[i] <= '9') i++;
+        }
+
+        size_t flagsLength = i;
+        char type = defaultType;
+        if (i < spec.size()) {
+            type = spec[i++];
+            if (!strchr(types, type)) return false;
+        }
+
+        if (i != spec.size()) return false;
+
+        return snprintf(format, size, "%%%.*s%s%c", static_cast<int>(flagsLength), spec.data(), length, type)
+            < static_cast<int>(size);
+    }
+
+    // The slow path for specs printf can't express - fmt parses them itself.
+    // A spec fmt rejects prints as {?} rather than throwing on the log thread.
+    template <typename T>
+    static void appendWithFmt(std::string& out, const T& value, std::string_view spec) {
+
+        std::string format = "{:";
+        format.append(spec.data(), spec.size());
+        format += '}';
+
+        try {
+            out += fmt::vformat(format, fmt::make_format_args(value));
+        } catch (const fmt::format_error&) {
+            out += "{?}";
+        }
+    }
+
+    // Formats a single argument. Numbers with a spec printf understands are
+    // formatted with snprintf, anything else with a spec goes through fmt, so
+    // output matches the DEBUG logger either way.
+    static void appendArg(std::string& out, const Arg& arg, std::string_view spec) {
+
+        char buffer[64];
+        char format[32];
+        int length = -1;
+
+        switch (arg.type) {
+            case ARG_INT:
+                // fmt prints negative hex and octal with a sign, printf as two's complement.
+                if (toPrintfFormat(spec, "ll", 'd', arg.i < 0 ? "d" : "dxXo", false, format, sizeof(format))) {
+                    length = snprintf(buffer, sizeof(buffer), format, static_cast<long long>(arg.i));
+                } else {
+                    appendWithFmt(out, arg.i, spec);
+                }
+                break;
+            case ARG_UINT:
+                if (toPrintfFormat(spec, "ll", 'u', "dxXo", false, format, sizeof(format))) {
+                    // printf only has 'u' for unsigned decimal.
+                    char* type = format + strlen(format) - 1;
+                    if (*type == 'd') *type = 'u';
+                    length = snprintf(buffer, sizeof(buffer), format, static_cast<unsigned long long>(arg.u));
+                } else {
+                    appendWithFmt(out, arg.u, spec);
+                }
+                break;
+            case ARG_FLOAT:
+                if (toPrintfFormat(spec, "", 'g', "fFeEgG", true, format, sizeof(format))) {
+                    length = snprintf(buffer, sizeof(buffer), format, arg.f);
+                } else {
+                    appendWithFmt(out, arg.f, spec);
+                }
+                break;
+            case ARG_BOOL:
+                if (spec.empty()) out += arg.u ? "true" : "false";
+                else appendWithFmt(out, arg.u != 0, spec);
+                break;
+            case ARG_STRING:
+                if (spec.empty()) out += arg.s;
+                else appendWithFmt(out, arg.s, spec);
+                break;
+        }
+
+        if (length > 0) out.append(buffer, std::min<size_t>(length, sizeof(buffer) - 1));
+    }
+
+    // Minimal fmt-style substitution: supports {}, {N}, {:spec}, {N:spec}, {{ and }}.
+    static void formatRecord(std::string& out, const Record* record) {
+
+        Arg args[32];
+        uint32_t argCount = decodeArgs(record, args, 32);
+
+        std::string_view format;
+        uint32_t firstArg = 0;
+
+        if (record->isInlineFormat) {
+            format = argCount > 0 ? args[0].s : std::string_view();
+            firstArg = 1;
+        } else {
+            format = record->format;
+        }
+
+        uint32_t nextArg = 0;
+
+        for (size_t i = 0; i < format.size(); i++) {
+            char c = format[i];
+
+            if (c == '{' && i + 1 < format.size() && format[i + 1] == '{') {
+                out += '{';
+                i++;
+                continue;
+            }
+
+            if (c == '}' && i + 1 < format.size() && format[i + 1] == '}') {
+                out += '}';
+                i++;
+                continue;
+            }
+
+            if (c != '{') {
+                out += c;
+                continue;
+            }
+
+            size_t end = format.find('}', i);
+            if (end == std::string_view::npos) {
+                out.append(format.substr(i));
+                break;
+            }
+
+            std::string_view field = format.substr(i + 1, end - i - 1);
+            std::string_view spec;
+            size_t colon = field.find(':');
+            if (colon != std::string_view::npos) {
+                spec = field.substr(colon + 1);
+                field = field.substr(0, colon);
+            }
+
+            uint32_t index = nextArg++;
+            if (!field.empty()) {
+                index = 0;
+                for (char digit : field) index = index * 10 + static_cast<uint32_t>(digit - '0');
+            }
+
+            if (firstArg + index < argCount) {
+                appendArg(out, args[firstArg + index], spec);
+            } else {
+                out += "{?}";
+            }
+
+            i = end;
+        }
+
+        if (record->isTruncated) out += " [truncated]";
+    }
+
+    // ------------------------------ CONSUMER -----------------------------------
+
+    static void writeRecord(std::string& line, const Record* record) {
+
+        auto sinceStart = std::chrono::nanoseconds(record->timestamp - s_StartSteady);
+        auto wallTime = s_StartSystem + std::chrono::duration_cast<std::chrono::system_clock::duration>(sinceStart);
+        std::time_t seconds = std::chrono::system_clock::to_time_t(wallTime);
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+            wallTime.time_since_epoch()).count() % 1000000;
+
+        std::tm time = *std::localtime(&seconds);
+
+        char prefix[64];
+        snprintf(prefix, sizeof(prefix), "[%02d:%02d:%02d.%06lld] PONG %s: ", time.tm_hour, time.tm_min,
+            time.tm_sec, static_cast<long long>(micros), s_LevelNames[std::min<uint8_t>(record->level, 4)]);
+
+        line.clear();
+        line += prefix;
+        formatRecord(line, record);
+        line += '\n';
+
+        fwrite(line.data(), 1, line.size(), stdout);
+    }
+
+    // Writes out every pending record, merging the per-thread rings by
+    // timestamp so output stays in (roughly) the order it was logged.
+    static bool drainRings(std::string& line) {
+
+        bool wroteAny = false;
+        uint32_t ringCount = s_RingCount.load(std::memory_order_acquire);
+
+        for (uint32_t i = 0; i < ringCount; i++) {
+            uint64_t dropped = s_Rings[i]->dropped.exchange(0, std::memory_order_relaxed);
+            if (dropped > 0) {
+                fprintf(stdout, "PONG warning: dropped %llu log messages (ring full)\n",
+                    static_cast<unsigned long long>(dropped));
+            }
+        }
+
+        while (true) {
+            ThreadRing* oldest = nullptr;
+            const Record* oldestRecord = nullptr;
+
+            for (uint32_t i = 0; i < ringCount; i++) {
+                ThreadRing* ring = s_Rings[i];
+                uint32_t head = ring->head.load(std::memory_order_relaxed);
+                if (head == ring->tail.load(std::memory_order_acquire)) continue;
+
+                const Record* record = &ring->records[head & (RING_CAPACITY - 1)];
+                if (!oldestRecord || record->timestamp < oldestRecord->timestamp) {
+                    oldest = ring;
+                    oldestRecord = record;
+                }
+            }
+
+            if (!oldest) break;
+
+            writeRecord(line, oldestRecord);
+            oldest->head.store(oldest->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            wroteAny = true;
+        }
+
+        if (wroteAny) fflush(stdout);
+
+        return wroteAny;
+    }
+
+    static void runLogThread() {
+
+        std::string line;
+        line.reserve(512);
+
+        while (s_IsRunning.load(std::memory_order_acquire)) {
+            if (!drainRings(line)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        // Final flush once every producer has stopped.
+        drainRings(line);
+    }
+}
+
+void initLogger() {
+    AsyncLog::s_StartSteady = std::chrono::steady_clock::now().time_since_epoch().count();
+    AsyncLog::s_StartSystem = std::chrono::system_clock::now();
+    AsyncLog::s_IsRunning.store(true, std::memory_order_release);
+    AsyncLog::s_Thread = std::thread(AsyncLog::runLogThread);
+}
+
+void shutdownLogger() {
+
+    if (!AsyncLog::s_IsRunning.exchange(false)) return;
+
+    // The rings are left for the process to reclaim - other threads may
+    // still be holding (and writing to) theirs.
+    AsyncLog::s_Thread.join();
+}
+
+void setLogLevel(LogLevel level) {
+    Logger::s_Level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+}
+
+#endif
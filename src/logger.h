@@ -3,12 +3,36 @@
 
 #include <spdlog/spdlog.h>
 #include <spdlog/fmt/ostr.h>
+#include <atomic>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+enum class LogLevel : uint8_t {
+    TRACE = 0,
+    INFO,
+    WARN,
+    ERROR,
+    FATAL,
+    OFF
+};
 
 struct Logger {
     static std::shared_ptr<spdlog::logger> s_CoreLogger;
+    static std::atomic<uint8_t> s_Level;
 };
 
 void initLogger();
+// Drains any pending messages and stops the background thread (RELEASE).
+void shutdownLogger();
+// Messages below this level are discarded before any work is done.
+void setLogLevel(LogLevel);
+
+inline bool isLogLevelEnabled(LogLevel level) {
+    return static_cast<uint8_t>(level) >= Logger::s_Level.load(std::memory_order_relaxed);
+}
 
 // Core logging macros
 
@@ -18,16 +42,162 @@ void initLogger();
     #define PONG_INFO(...)  Logger::s_CoreLogger->info     (__VA_ARGS__)
     #define PONG_WARN(...)  Logger::s_CoreLogger->warn     (__VA_ARGS__)
     #define PONG_ERROR(...) Logger::s_CoreLogger->error    (__VA_ARGS__)
-    #define PONG_FATAL(...) Logger::s_CoreLogger->fatal    (__VA_ARGS__)
+    #define PONG_FATAL(...) Logger::s_CoreLogger->critical (__VA_ARGS__)
 
 #elif defined(RELEASE)
 
-    #define PONG_TRACE(...)
-    #define PONG_INFO(...)
-    #define PONG_WARN(...)
-    #define PONG_ERROR(...)
-    #define PONG_FATAL(...)
+// In RELEASE builds logging is asynchronous. The calling thread only copies a
+// pointer to the format string and the raw argument values into a fixed-size
+// record in its own lock-free ring. Formatting and writing happens on a
+// background thread. If a ring is full the message is dropped (and counted)
+// instead of blocking the caller.
+//
+// Format strings are expected to be literals - only the pointer is stored.
+// std::string formats are copied into the record instead.
+
+namespace AsyncLog {
+
+    constexpr size_t RECORD_SIZE = 128;
+    constexpr uint32_t RING_CAPACITY = 1024;
+
+    enum ArgType : uint8_t {
+        ARG_INT = 0,
+        ARG_UINT,
+        ARG_FLOAT,
+        ARG_BOOL,
+        ARG_STRING
+    };
+
+    struct Record {
+        const char* format          {nullptr};
+        int64_t timestamp           {0};
+        uint8_t level               {0};
+        uint8_t argCount            {0};
+        uint8_t isInlineFormat      {0};
+        uint8_t isTruncated         {0};
+        uint16_t size               {0};
+        uint8_t payload[RECORD_SIZE - 24];
+    };
+
+    static_assert(sizeof(Record) == RECORD_SIZE, "Log records must stay a fixed size");
+
+    // Single producer (the owning thread), single consumer (the log thread).
+    struct ThreadRing {
+        Record records[RING_CAPACITY];
+        alignas(64) std::atomic<uint32_t> head      {0};
+        alignas(64) std::atomic<uint32_t> tail      {0};
+        std::atomic<uint64_t> dropped               {0};
+    };
+
+    extern thread_local ThreadRing* t_Ring;
+    ThreadRing* registerThread();
+
+    inline Record* beginRecord(LogLevel level) {
+
+        ThreadRing* ring = t_Ring ? t_Ring : registerThread();
+        if (!ring) return nullptr;
+
+        uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+        if (tail - ring->head.load(std::memory_order_acquire) == RING_CAPACITY) {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Record* record = &ring->records[tail & (RING_CAPACITY - 1)];
+        record->timestamp = std::chrono::steady_clock::now().time_since_epoch().count();
+        record->level = static_cast<uint8_t>(level);
+        record->argCount = 0;
+        record->isInlineFormat = 0;
+        record->isTruncated = 0;
+        record->size = 0;
+        return record;
+    }
+
+    inline void commitRecord() {
+        t_Ring->tail.store(t_Ring->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    inline bool reserve(Record* record, size_t bytes) {
+        if (record->size + bytes > sizeof(record->payload)) {
+            record->isTruncated = 1;
+            return false;
+        }
+        return true;
+    }
+
+    template <typename T>
+    inline void writeValue(Record* record, ArgType type, T value) {
+        if (!reserve(record, 1 + sizeof(T))) return;
+        record->payload[record->size] = type;
+        memcpy(record->payload + record->size + 1, &value, sizeof(T));
+        record->size += 1 + sizeof(T);
+        record->argCount++;
+    }
+
+    inline void writeString(Record* record, std::string_view value) {
+        if (!reserve(record, 3)) return;
+        size_t length = std::min(value.size(), sizeof(record->payload) - record->size - 3);
+        if (length < value.size()) record->isTruncated = 1;
+        uint16_t storedLength = static_cast<uint16_t>(length);
+        record->payload[record->size] = ARG_STRING;
+        memcpy(record->payload + record->size + 1, &storedLength, sizeof(uint16_t));
+        memcpy(record->payload + record->size + 3, value.data(), length);
+        record->size += static_cast<uint16_t>(3 + length);
+        record->argCount++;
+    }
+
+    template <typename T>
+    inline void writeArg(Record* record, const T& value) {
+        using Type = std::decay_t<T>;
+        if constexpr (std::is_same_v<Type, bool>) {
+            writeValue<uint8_t>(record, ARG_BOOL, value ? 1 : 0);
+        } else if constexpr (std::is_same_v<Type, char>) {
+            writeString(record, std::string_view(&value, 1));
+        } else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type>) {
+            writeValue<int64_t>(record, ARG_INT, static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral_v<Type> || std::is_enum_v<Type>) {
+            writeValue<uint64_t>(record, ARG_UINT, static_cast<uint64_t>(value));
+        } else if constexpr (std::is_floating_point_v<Type>) {
+            writeValue<double>(record, ARG_FLOAT, static_cast<double>(value));
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            writeString(record, std::string_view(value));
+        } else {
+            // Slow path for anything fmt knows how to print (glm types etc.) -
+            // format it on the calling thread and store the text.
+            writeString(record, fmt::format("{}", value));
+        }
+    }
+
+    template <typename... Args>
+    inline void log(LogLevel level, const char* format, const Args&... args) {
+        Record* record = beginRecord(level);
+        if (!record) return;
+        record->format = format;
+        (writeArg(record, args), ...);
+        commitRecord();
+    }
+
+    template <typename... Args>
+    inline void log(LogLevel level, const std::string& format, const Args&... args) {
+        Record* record = beginRecord(level);
+        if (!record) return;
+        // The format itself is stored as the first string argument.
+        record->isInlineFormat = 1;
+        writeString(record, format);
+        (writeArg(record, args), ...);
+        commitRecord();
+    }
+}
+
+    #define PONG_LOG_ASYNC(level, ...) \
+        do { if (isLogLevelEnabled(level)) AsyncLog::log(level, __VA_ARGS__); } while (0)
+
+    #define PONG_TRACE(...) PONG_LOG_ASYNC(LogLevel::TRACE, __VA_ARGS__)
+    #define PONG_INFO(...)  PONG_LOG_ASYNC(LogLevel::INFO,  __VA_ARGS__)
+    #define PONG_WARN(...)  PONG_LOG_ASYNC(LogLevel::WARN,  __VA_ARGS__)
+    #define PONG_ERROR(...) PONG_LOG_ASYNC(LogLevel::ERROR, __VA_ARGS__)
+    #define PONG_FATAL(...) PONG_LOG_ASYNC(LogLevel::FATAL, __VA_ARGS__)
 
 #endif
 
-#endif // LOGGER_H
\ No newline at end of file
+#endif // LOGGER_H
@@ -1,20 +1,33 @@
-#include <chrono>
 #include "logger.h"
+#include "clock.h"
 #include <cstdint>
+#include <cstring>
 #include "renderer/renderer.h"
 #include "window/window.h"
 #include "pongApp/input.h"
-#include "pongApp/components.h"
-
-#define PONG_FATAL_ERROR(...) PONG_ERROR(__VA_ARGS__); return EXIT_FAILURE
+#include "pongApp/game.h"
+#include "pongApp/kernels.h"
+#include "pongApp/particles.h"
+#include "jobs/jobs.h"
+#include "pongApp/frameStats.h"
+#include "pongApp/replay.h"
+#include "pongApp/renderThread.h"
 
 // TODO: Handle paddle bounce logic
 // TODO: Handle scene resetting when ball hits either end of the map
 // TODO: Score tracking
-// TODO: Text rendering for menus + display
 
-const float BALL_VELOCITY = 800.0f;
-const float PADDLE_VELOCITY = 500.0f;
+// Upper bound on live entities - columns are allocated up front.
+const uint32_t ENTITY_CAPACITY = 1024;
+// Simulation ticks per second unless overridden with --tick-rate.
+const uint32_t DEFAULT_TICK_RATE = 120;
+// Longest frame we'll try to catch up on - anything beyond this (a breakpoint,
+// a stall) is dropped rather than simulated all at once.
+const uint64_t MAX_FRAME_NANOS = Clock::NANOS_PER_SECOND / 4;
+// Particles alive at once - the ball's trail and impact sparks share them.
+const uint32_t PARTICLE_CAPACITY = 2048;
+// Fraction of a particle's speed lost per second.
+const float PARTICLE_DRAG = 3.0f;
 
 // TODO: Move these to a separate file
 #define KEY_W GLFW_KEY_W
@@ -33,24 +46,386 @@ const float PADDLE_VELOCITY = 500.0f;
     const bool enableValidationLayers = false;
 #endif
 
-float getTime() {
-    static auto startTime = std::chrono::high_resolution_clock::now();
-    auto currentTime = std::chrono::high_resolution_clock::now();
+// Packs the keys we care about into the input for the next simulation tick.
+Pong::TickInput sampleInput(const Pong::InputSnapshot* snapshot) {
+    Pong::TickInput input;
+    if (Pong::isKeyPressed(snapshot, KEY_W)) input.buttons |= Pong::INPUT_PADDLE_A_UP;
+    if (Pong::isKeyPressed(snapshot, KEY_S)) input.buttons |= Pong::INPUT_PADDLE_A_DOWN;
+    if (Pong::isKeyPressed(snapshot, KEY_UP)) input.buttons |= Pong::INPUT_PADDLE_B_UP;
+    if (Pong::isKeyPressed(snapshot, KEY_DOWN)) input.buttons |= Pong::INPUT_PADDLE_B_DOWN;
+    return input;
+}
+
+// Sparks off everything the ball has hit since the last call, and a little
+// more of its trail wherever it is now. Called once per tick.
+void emitGameParticles(Pong::ParticlePool* particles, Pong::GameState* game) {
+
+    for (uint32_t i = 0; i < game->impactCount; i++) {
+        Pong::ParticleBurst sparks;
+        sparks.position = game->impacts[i].position;
+        sparks.direction = game->impacts[i].normal;
+        sparks.spread = 70.0f;
+        sparks.count = 24;
+        sparks.minSpeed = 100.0f;
+        sparks.maxSpeed = 400.0f;
+        sparks.minLifetime = 0.2f;
+        sparks.maxLifetime = 0.6f;
+        sparks.size = 4.0f;
+        sparks.color = {1.0f, 0.8f, 0.3f};
+        Pong::emitParticles(particles, sparks);
+    }
+    game->impactCount = 0;
+
+    // Nothing to trail while the ball sits in the middle waiting to serve.
+    if (game->isResetting) return;
+
+    Pong::Transform ball = Pong::getTransform(&game->entities, Pong::getEntityIndex(&game->entities, game->ball));
+
+    Pong::ParticleBurst trail;
+    trail.position = ball.position;
+    trail.count = 2;
+    trail.maxSpeed = 20.0f;
+    trail.minLifetime = 0.15f;
+    trail.maxLifetime = 0.3f;
+    trail.size = 8.0f;
+    trail.color = {0.6f, 0.6f, 1.0f};
+    Pong::emitParticles(particles, trail);
+}
 
-    return std::chrono::duration<float,
-            std::chrono::seconds::period>(currentTime - startTime).count();
+// Settings for --stress-balls and friends.
+struct StressConfig {
+    uint32_t ballCount      {0};
+    uint32_t obstacleCount  {0};
+    uint32_t seed           {1};
+    // Each run doubles the number of balls.
+    uint32_t runCount       {1};
+    uint64_t ticksPerRun    {600};
+};
+
+// Balls in the given run of a stress test. The level is clamped before it's
+// shifted by, and the count saturates - so it can be anything up to
+// UINT32_MAX, and has to be added to other counts in 64 bits.
+uint32_t getStressBallCount(const StressConfig& config, uint32_t run) {
+    uint32_t level = std::min(run, 31u);
+    uint64_t ballCount = static_cast<uint64_t>(config.ballCount) << level;
+    return static_cast<uint32_t>(std::min<uint64_t>(ballCount, UINT32_MAX));
 }
 
-int main() {  
+// Entities in the given run of a stress test - the stress balls and obstacles
+// on top of the game's own.
+uint64_t getStressEntityCount(const StressConfig& config, uint32_t run) {
+    return static_cast<uint64_t>(ENTITY_CAPACITY) + getStressBallCount(config, run) + config.obstacleCount;
+}
 
-    // ----------------------- INITIALISE WINDOW -----------------------------
+// Entities in the last (largest) run of a stress test.
+uint64_t getMaxStressEntities(const StressConfig& config) {
+    return getStressEntityCount(config, config.runCount > 0 ? config.runCount - 1 : 0);
+}
+
+// Spawns the stress scene and runs it one tick per frame through the normal
+// simulation and drawQuad path, once for each step of the sweep, logging what
+// every stage costs per frame so it's clear which one stops scaling first.
+int runStressTest(Renderer::Renderer* renderer, PongWindow::Window* window, Jobs::JobSystem* jobs,
+    const StressConfig& config, uint32_t tickRate) {
+
+    const float tickDelta = static_cast<float>(Clock::toSeconds(Clock::NANOS_PER_SECOND / tickRate));
+
+    for (uint32_t run = 0; run < config.runCount && PongWindow::isWindowRunning(window); run++) {
+
+        uint32_t ballCount = getStressBallCount(config, run);
+        // Checked against MAX_ENTITIES before the sweep starts.
+        auto capacity = static_cast<uint32_t>(getStressEntityCount(config, run));
+
+        Pong::GameState game;
+        Pong::RenderSnapshot snapshot;
+        if (!Pong::initialiseGame(&game, { window->windowData.width * 0.5f, window->windowData.height * 0.5f },
+            capacity) || !Pong::initialiseRenderSnapshot(&snapshot, capacity)) {
+            PONG_ERROR("Failed to allocate a stress scene with {0} entities!", capacity);
+            return EXIT_FAILURE;
+        }
+
+        if (!Pong::spawnStressEntities(&game, ballCount, config.obstacleCount, config.seed, tickDelta)) {
+            Pong::destroyRenderSnapshot(&snapshot);
+            Pong::destroyGame(&game);
+            return EXIT_FAILURE;
+        }
+
+        // The last run's frames still in flight are counted before this run's
+        // start, and this run's before it's reported.
+        Renderer::collectFrameStats(renderer);
+
+        uint64_t simulateNanos = 0, snapshotNanos = 0, submitNanos = 0, frameNanos = 0;
+        uint64_t droppedQuads = renderer->stats.quadsDropped;
+        uint64_t drawnQuads = renderer->stats.quadsDrawn;
+        uint64_t culledQuads = renderer->stats.quadsCulled;
+        uint64_t frames = 0;
+
+        for (; frames < config.ticksPerRun && PongWindow::isWindowRunning(window); frames++) {
+
+            PongWindow::onWindowUpdate(window);
+
+            uint64_t start = Clock::nowNanos();
+            Pong::tickGame(&game, Pong::TickInput{}, tickDelta, jobs);
+            uint64_t simulated = Clock::nowNanos();
+            Pong::buildRenderSnapshot(&game, 1.0f, &snapshot);
+            uint64_t snapshotted = Clock::nowNanos();
+
+            Renderer::QuadColumns quads = Pong::getSnapshotQuads(&snapshot);
+            Renderer::drawQuads(renderer, &quads, {1.0f, 1.0f, 1.0f});
+            uint64_t submitted = Clock::nowNanos();
+
+            Renderer::Status renderStatus = Renderer::drawFrame(renderer, &window->windowData.isResized);
+            uint64_t drawn = Clock::nowNanos();
+
+            simulateNanos += simulated - start;
+            snapshotNanos += snapshotted - simulated;
+            submitNanos += submitted - snapshotted;
+            frameNanos += drawn - submitted;
+
+            if (renderStatus == Renderer::Status::FAILURE) {
+                PONG_ERROR("Error drawing frame - stopping stress test!");
+                Pong::destroyRenderSnapshot(&snapshot);
+                Pong::destroyGame(&game);
+                return EXIT_FAILURE;
+            } else if (renderStatus == Renderer::Status::SKIPPED_FRAME) {
+                PongWindow::onWindowMinimised(window->nativeWindow, window->type,
+                    &renderer->deviceData.framebufferWidth, &renderer->deviceData.framebufferHeight);
+                Renderer::recreateSwapchain(renderer);
+                window->windowData.isResized = false;
+            }
+
+            Renderer::flushRenderer(renderer);
+        }
+
+        Renderer::collectFrameStats(renderer);
+
+        if (frames > 0) {
+            auto perFrame = [frames](uint64_t nanos) { return Clock::toSeconds(nanos) * 1000.0 / frames; };
+            const Pong::TickStageTimes& stages = game.stageTimes;
+
+            PONG_INFO("Stress run {0}: {1} balls, {2} obstacles, {3} frames (ms per frame)", run + 1, ballCount,
+                config.obstacleCount, frames);
+            PONG_INFO("  simulate {0:.3f} (transforms {1:.3f} | broadphase {2:.3f} | ball {3:.3f} | stress {4:.3f})",
+                perFrame(simulateNanos), perFrame(stages.transformNanos), perFrame(stages.broadphaseNanos),
+                perFrame(stages.ballNanos), perFrame(stages.stressNanos));
+            PONG_INFO("  snapshot {0:.3f} | drawQuad {1:.3f} | drawFrame {2:.3f} | {3} broadphase pairs",
+                perFrame(snapshotNanos), perFrame(submitNanos), perFrame(frameNanos), game.broadphase.pairCount);
+            PONG_INFO("  {0} quads drawn, {1} culled per frame", (renderer->stats.quadsDrawn - drawnQuads) / frames,
+                (renderer->stats.quadsCulled - culledQuads) / frames);
+
+            if (renderer->stats.quadsDropped > droppedQuads) {
+                PONG_WARN("  {0} quads dropped - raise --max-quads", renderer->stats.quadsDropped - droppedQuads);
+            }
+        }
+
+        Pong::destroyRenderSnapshot(&snapshot);
+        Pong::destroyGame(&game);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// Plays a recorded session back with no window or renderer, as fast as the
+// host can tick it, and checks every run ends in exactly the recorded state.
+int runReplay(const char* path, uint32_t runCount, uint32_t workerCount) {
+
+    Pong::ReplayPlayer replay;
+    if (!Pong::openReplay(&replay, path)) return EXIT_FAILURE;
+
+    const uint64_t tickNanos = Clock::NANOS_PER_SECOND / replay.header.tickRate;
+    const float tickDelta = static_cast<float>(Clock::toSeconds(tickNanos));
+
+    Jobs::JobSystem jobs;
+    Jobs::initialiseJobSystem(&jobs, workerCount);
+
+    PONG_INFO("Replaying {0} ({1} ticks at {2}Hz) {3} time(s)", path, replay.header.tickCount,
+        replay.header.tickRate, runCount);
+
+    bool isMatching = true;
+    uint64_t replayStart = Clock::nowNanos();
+
+    for (uint32_t run = 0; run < runCount && isMatching; run++) {
+
+        Pong::GameState game;
+        if (!Pong::initialiseGame(&game, { replay.header.arenaHalfWidth, replay.header.arenaHalfHeight },
+            replay.header.entityCapacity)) {
+            PONG_ERROR("Failed to initialise game state!");
+            isMatching = false;
+            break;
+        }
+
+        Pong::rewindReplay(&replay);
+
+        Pong::TickInput input;
+        while (Pong::nextReplayTick(&replay, &input, &game.arenaHalfSize)) {
+            Pong::tickGame(&game, input, tickDelta, &jobs);
+        }
+
+        uint64_t hash = Pong::hashGameState(&game);
+        if (hash != replay.header.finalHash) {
+            PONG_ERROR("Replay diverged on run {0}: ended in state {1:016x} after {2} ticks, recorded {3:016x}",
+                run, hash, game.tick, replay.header.finalHash);
+            isMatching = false;
+        }
+
+        Pong::destroyGame(&game);
+    }
+
+    double replaySeconds = Clock::toSeconds(Clock::nowNanos() - replayStart);
+    double recordedSeconds = Clock::toSeconds(tickNanos * replay.header.tickCount) * runCount;
+
+    if (isMatching) {
+        PONG_INFO("Replay matched the recording - {0:.3f}s ({1:.1f}x real time)", replaySeconds,
+            replaySeconds > 0.0 ? recordedSeconds / replaySeconds : 0.0);
+    }
+
+    Jobs::shutdownJobSystem(&jobs);
+    Pong::closeReplay(&replay);
+
+    return isMatching ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Everything main has started so far. shutdownApp tears it down in reverse,
+// so every way out - early or not - leaves nothing running.
+struct AppState {
+    PongWindow::Window* window          {nullptr};
+    Renderer::Renderer* renderer        {nullptr};
+    Jobs::JobSystem* jobs               {nullptr};
+    Pong::GameState* game               {nullptr};
+    Pong::ParticlePool* particles       {nullptr};
+    Pong::RenderThread* renderThread    {nullptr};
+};
+
+int shutdownApp(const AppState& app, int exitCode) {
+
+    if (app.renderThread) Pong::shutdownRenderThread(app.renderThread);
+    if (app.particles) Pong::destroyParticlePool(app.particles);
+    if (app.game) Pong::destroyGame(app.game);
+    if (app.jobs) Jobs::shutdownJobSystem(app.jobs);
+    if (app.renderer) Renderer::cleanupRenderer(app.renderer, enableValidationLayers);
+    if (app.window) PongWindow::destroyWindow(app.window);
+
+    shutdownLogger();
+
+    return exitCode;
+}
+
+int main(int argc, char** argv) {
+
+    // ----------------------- COMMAND LINE ----------------------------------
 
     initLogger();
 
-    // Initialise the window struct
-    auto window = PongWindow::initialiseWindow(PongWindow::NativeWindowType::GLFW, 800, 600, "Pong");
+    // --capture <png|y4m>      record every presented frame.
+    // --capture-out <prefix>   output path prefix for captured frames.
+    // --null                   run headless with the null renderer backend.
+    // --ticks <n>              exit after n simulation ticks (0 = run forever).
+    // --tick-rate <hz>         simulation ticks per second.
+    // --workers <n>            job system worker threads (0 = one per core).
+    // --log-level <level>      trace, info, warn, error or off.
+    // --frame-stats <path>     write session frame time percentiles to a CSV on exit.
+    // --record <path>          record the session's input to a replay file.
+    // --replay <path>          replay a recording headlessly at full speed and exit.
+    // --replay-runs <n>        number of times to play the replay back.
+    // --stress-balls <n>       run the stress test, starting with n extra balls.
+    // --stress-obstacles <n>   static obstacles in the stress scene.
+    // --stress-seed <n>        seed for the stress scene's random layout.
+    // --stress-sweep <n>       stress runs to do, doubling the ball count each time.
+    // --max-quads <n>          quads the renderer can draw per frame.
+    // --gpu-balls <n>          simulate n extra balls on the GPU, bouncing off the paddles.
+    // --gpu-culling            cull quads in a compute pass instead of as they're drawn.
+    // --hud                    draw the frame rate on screen.
+    Renderer::CaptureFormat captureFormat = Renderer::CaptureFormat::NONE;
+    const char* capturePath = "capture";
+    Renderer::Backend backend = Renderer::Backend::VULKAN;
+    uint64_t maxTicks = 0;
+    uint32_t tickRate = DEFAULT_TICK_RATE;
+    uint32_t workerCount = 0;
+    const char* frameStatsPath = nullptr;
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    uint32_t replayRuns = 1;
+    StressConfig stress;
+    size_t maxQuads = 0;
+    uint64_t gpuBudgetMegabytes = 0;
+    bool showHud = false;
+    uint32_t gpuBallCount = 0;
+    bool useGpuCulling = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "png") == 0) {
+                captureFormat = Renderer::CaptureFormat::PNG;
+            } else if (strcmp(argv[i], "y4m") == 0) {
+                captureFormat = Renderer::CaptureFormat::Y4M;
+            } else {
+                PONG_WARN("Unknown capture format '{0}' - capture disabled", argv[i]);
+            }
+        } else if (strcmp(argv[i], "--capture-out") == 0 && i + 1 < argc) {
+            capturePath = argv[++i];
+        } else if (strcmp(argv[i], "--null") == 0) {
+            backend = Renderer::Backend::NONE;
+        } else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            maxTicks = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            tickRate = static_cast<uint32_t>(std::max(1ul, strtoul(argv[++i], nullptr, 10)));
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            workerCount = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--frame-stats") == 0 && i + 1 < argc) {
+            frameStatsPath = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay-runs") == 0 && i + 1 < argc) {
+            replayRuns = static_cast<uint32_t>(std::max(1ul, strtoul(argv[++i], nullptr, 10)));
+        } else if (strcmp(argv[i], "--stress-balls") == 0 && i + 1 < argc) {
+            stress.ballCount = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--stress-obstacles") == 0 && i + 1 < argc) {
+            stress.obstacleCount = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--stress-seed") == 0 && i + 1 < argc) {
+            stress.seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--stress-sweep") == 0 && i + 1 < argc) {
+            stress.runCount = static_cast<uint32_t>(std::min(16ul, std::max(1ul, strtoul(argv[++i], nullptr, 10))));
+        } else if (strcmp(argv[i], "--max-quads") == 0 && i + 1 < argc) {
+            maxQuads = static_cast<size_t>(strtoull(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--gpu-budget") == 0 && i + 1 < argc) {
+            gpuBudgetMegabytes = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--gpu-balls") == 0 && i + 1 < argc) {
+            gpuBallCount = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--gpu-culling") == 0) {
+            useGpuCulling = true;
+        } else if (strcmp(argv[i], "--hud") == 0) {
+            showHud = true;
+        } else if (strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "trace") == 0) setLogLevel(LogLevel::TRACE);
+            else if (strcmp(argv[i], "info") == 0) setLogLevel(LogLevel::INFO);
+            else if (strcmp(argv[i], "warn") == 0) setLogLevel(LogLevel::WARN);
+            else if (strcmp(argv[i], "error") == 0) setLogLevel(LogLevel::ERROR);
+            else if (strcmp(argv[i], "off") == 0) setLogLevel(LogLevel::OFF);
+        }
+    }
+
+    if (replayPath) {
+        int result = runReplay(replayPath, replayRuns, workerCount);
+        shutdownLogger();
+        return result;
+    }
+
+    // ----------------------- INITIALISE WINDOW -----------------------------
+
+    bool isHeadless = backend == Renderer::Backend::NONE;
 
-    PONG_INFO("Created GLFW window");
+    // Initialise the window struct. The null backend doesn't need a native window.
+    auto window = PongWindow::initialiseWindow(isHeadless ? PongWindow::NativeWindowType::NONE :
+        PongWindow::NativeWindowType::GLFW, 800, 600, "Pong");
+
+    AppState app;
+    app.window = window;
+
+    PONG_INFO("Created window");
 
     // ============================ RENDERER =================================
 
@@ -62,217 +437,224 @@ int main() {
     Renderer::loadDefaultValidationLayers(&renderer);
     Renderer::loadDefaultDeviceExtensions(&renderer);
 
+    // Make sure the largest stress run fits in a frame unless told otherwise.
+    bool isStressTest = stress.ballCount > 0 || stress.obstacleCount > 0;
+    if (isStressTest && getMaxStressEntities(stress) >= Pong::MAX_ENTITIES) {
+        PONG_ERROR("The largest stress run needs {0} entities - there can only be {1}!",
+            getMaxStressEntities(stress), Pong::MAX_ENTITIES - 1);
+        return shutdownApp(app, EXIT_FAILURE);
+    }
+    if (maxQuads == 0 && isStressTest) {
+        maxQuads = std::max<size_t>(renderer.renderer2DData.quadData.maxQuads,
+            static_cast<size_t>(getMaxStressEntities(stress)));
+    } else if (maxQuads == 0) {
+        // Room for every particle on top of the usual quads.
+        maxQuads = renderer.renderer2DData.quadData.maxQuads + PARTICLE_CAPACITY;
+    }
+    if (maxQuads > 0) Renderer::setMaxQuads(&renderer, maxQuads);
+    if (gpuBudgetMegabytes > 0) Renderer::setGpuMemoryBudget(&renderer, gpuBudgetMegabytes * 1024 * 1024);
+
     if (Renderer::initialiseRenderer(&renderer, enableValidationLayers, window->nativeWindow,
-        Renderer::WindowType::GLFW) != Renderer::Status::SUCCESS) {
-        PONG_FATAL_ERROR("Failed to initialise renderer!");
+        isHeadless ? Renderer::WindowType::NONE : Renderer::WindowType::GLFW, backend) != Renderer::Status::SUCCESS) {
+        PONG_ERROR("Failed to initialise renderer!");
+        return shutdownApp(app, EXIT_FAILURE);
+    }
+    app.renderer = &renderer;
+
+    if (captureFormat != Renderer::CaptureFormat::NONE
+        && Renderer::enableCapture(&renderer, captureFormat, capturePath) != Renderer::Status::SUCCESS) {
+        PONG_WARN("Failed to enable frame capture - continuing without it");
     }
 
     // ------------------------ SCENE SETUP -----------------------------
 
-    uint32_t currentEntities = 3;
-
-    size_t paddleA  {0};
-    size_t paddleB  {1};
-    size_t ball     {2};
-
-    Pong::Transform transformComponents[] {
-        {
-            {-375.0f,0.0f,},
-            {0.0f,0.0f,1.0f},
-            {20.0f,75.0f, 1.0f}, 0.0f
-        },
-        {
-            {375.0f, 0.0f },
-            {0.0f,0.0f,1.0f},
-            {20.0f,75.0f, 1.0f}, 0.0f
-        },
-        {
-            {0.0f, 0.0f},
-            {0.0f,0.0f,1.0f},
-            {20.0f,20.0f, 1.0f}, 0.0f
-        }
-    };
-    Pong::Velocity velocityComponents[] {
-        { {0.0f, 0.0f}, {0.0f, 0.0f, 0.0f} },
-        { {0.0f, 0.0f}, {0.0f, 0.0f, 0.0f} },
-        { {0.0f, 0.0f}, {0.0f, 0.0f, 0.0f} }
-    };
+#ifdef DEBUG
+    if (!Pong::verifyKernels()) {
+        PONG_ERROR("{0} simulation kernels don't match the scalar reference!", Pong::getKernelInstructionSet());
+        return shutdownApp(app, EXIT_FAILURE);
+    }
+    if (!Renderer::verifyCulling()) {
+        PONG_ERROR("{0} culling doesn't match the scalar reference!", Pong::getKernelInstructionSet());
+        return shutdownApp(app, EXIT_FAILURE);
+    }
+    if (!Pong::verifyParticles()) {
+        PONG_ERROR("{0} particle update doesn't match the scalar reference!", Pong::getKernelInstructionSet());
+        return shutdownApp(app, EXIT_FAILURE);
+    }
+    if (!Renderer::verifyTextureEviction(&renderer)) {
+        PONG_ERROR("Quad texture wasn't evicted over budget and re-loaded!");
+        return shutdownApp(app, EXIT_FAILURE);
+    }
+#endif
+    PONG_INFO("Using {0} simulation kernels", Pong::getKernelInstructionSet());
 
-    Pong::RectBounds rectBoundComponents[] {
-        Pong::initialiseRectBounds(transformComponents[paddleA]),
-        Pong::initialiseRectBounds(transformComponents[paddleB]),
-        Pong::initialiseRectBounds(transformComponents[ball])
-    };
+    // Before the stress test, so it can be measured either way.
+    if (useGpuCulling && Renderer::enableGpuCulling(&renderer) != Renderer::Status::SUCCESS) {
+        PONG_WARN("Failed to enable GPU culling - culling on the CPU instead");
+    }
 
-    float oldTime, currentTime, deltaTime, elapsed, resetElapsed, frames { 0.0f };
+    Jobs::JobSystem jobs;
+    Jobs::initialiseJobSystem(&jobs, workerCount);
+    app.jobs = &jobs;
 
-    bool isResetting{false};
+    if (isStressTest) {
+        if (maxTicks > 0) stress.ticksPerRun = maxTicks;
+        return shutdownApp(app, runStressTest(&renderer, window, &jobs, stress, tickRate));
+    }
 
-    glm::vec2 ballDirection {1.0f, 0.0f};
-    glm::vec2 oldDirection = ballDirection;
+    Pong::GameState game;
+    if (!Pong::initialiseGame(&game, { window->windowData.width * 0.5f, window->windowData.height * 0.5f },
+        ENTITY_CAPACITY)) {
+        PONG_ERROR("Failed to initialise game state!");
+        return shutdownApp(app, EXIT_FAILURE);
+    }
+    app.game = &game;
 
-    float timeFactor{1.0f};
+    if (gpuBallCount > 0
+        && Renderer::enableGpuBalls(&renderer, gpuBallCount, game.arenaHalfSize) != Renderer::Status::SUCCESS) {
+        PONG_WARN("Failed to enable GPU balls - continuing without them");
+    }
+
+    // Trails and impact sparks - simulated alongside the game, drawn as of the last tick.
+    Pong::ParticlePool particles;
+    if (!Pong::initialiseParticlePool(&particles, PARTICLE_CAPACITY)) {
+        PONG_ERROR("Failed to allocate particles!");
+        return shutdownApp(app, EXIT_FAILURE);
+    }
+    app.particles = &particles;
+
+    // Frame timing histograms - the render thread reports these once a second.
+    static Pong::FrameStats frameStats;
+
+    // From here on the renderer belongs to the render thread. This thread only
+    // simulates and hands it a packet describing each frame to draw.
+    static Pong::RenderThread renderThread;
+    renderThread.showHud = showHud;
+    if (!Pong::initialiseRenderThread(&renderThread, &renderer, &frameStats, ENTITY_CAPACITY, PARTICLE_CAPACITY)) {
+        PONG_ERROR("Failed to start render thread!");
+        return shutdownApp(app, EXIT_FAILURE);
+    }
+    app.renderThread = &renderThread;
+    uint32_t resizeCount = 0;
+
+    Pong::ReplayRecorder recorder;
+    if (recordPath && !Pong::beginRecording(&recorder, recordPath, tickRate, ENTITY_CAPACITY, game.arenaHalfSize)) {
+        PONG_WARN("Continuing without recording");
+    }
+
+    // The simulation always advances in steps of exactly tickNanos. Rendering
+    // runs as fast as it likes and draws the state interpolated between the
+    // last two ticks.
+    const uint64_t tickNanos = Clock::NANOS_PER_SECOND / tickRate;
+    const float tickDelta = static_cast<float>(Clock::toSeconds(tickNanos));
+    uint64_t accumulator = 0;
+
+    uint64_t benchmarkStart = Clock::nowNanos();
+    uint64_t lastTime = benchmarkStart;
+
+    // Input arrives as events from the window and is snapshotted once per frame.
+    static Pong::InputState inputState;
+    Pong::TickInput input;
 
     // -------------------------- MAIN LOOP ------------------------------
 
-    while (PongWindow::isWindowRunning(window)) {
+    while (PongWindow::isWindowRunning(window) && (maxTicks == 0 || game.tick < maxTicks)) {
+
+        uint64_t frameStart = Clock::nowNanos();
 
-        glm::vec2 windowSize = {
+        game.arenaHalfSize = {
             static_cast<float>(window->windowData.width * 0.5f),
             static_cast<float>(window->windowData.height * 0.5f)
         };
 
-        currentTime = getTime();
-
-        PongWindow::onWindowUpdate();
-        
-        deltaTime = std::clamp((currentTime - oldTime) * timeFactor, 0.0f, 0.1f);
-        elapsed += deltaTime;
+        PongWindow::onWindowUpdate(window);
+        Pong::processInputEvents(window, &inputState);
 
-        // Input
-        if (Pong::isKeyPressed(window, KEY_W)) {
-            velocityComponents[paddleA].positionVelocity.y += (PADDLE_VELOCITY * deltaTime);
-        }
-        if (Pong::isKeyPressed(window, KEY_S)) {
-            velocityComponents[paddleA].positionVelocity.y -= (PADDLE_VELOCITY * deltaTime);
-        }
-
-        if (Pong::isKeyPressed(window, KEY_UP)) {
-            velocityComponents[paddleB].positionVelocity.y += (PADDLE_VELOCITY * deltaTime);
-        }
-        if (Pong::isKeyPressed(window, KEY_DOWN)) {
-            velocityComponents[paddleB].positionVelocity.y -= (PADDLE_VELOCITY * deltaTime);
-        }
-
-        // Game Logic
-        if (ballDirection != glm::vec2(0.0f))
-            velocityComponents[ball].positionVelocity += ((BALL_VELOCITY * glm::normalize(ballDirection)) * deltaTime);
-
-        for (int i = 0; i < currentEntities; i++) {
-            Pong::addVelocity(transformComponents[i], velocityComponents[i]);
-            if (i != ball) {
-                transformComponents[i].position = { 
-                    transformComponents[i].position.x, 
-                    std::clamp(transformComponents[i].position.y,-windowSize.y + (transformComponents[i].scale.y * 0.5f), 
-                    windowSize.y - (transformComponents[i].scale.y * 0.5f))
-                };
-            }
-            Pong::updateRectBounds(rectBoundComponents[i], transformComponents[i]);
+        if (window->windowData.isResized) {
+            resizeCount++;
+            window->windowData.isResized = false;
         }
 
-        Pong::Transform& ballTransform = transformComponents[ball];
-        // AABB Collisions
-        for (size_t i = 0; i < currentEntities; i++) {
-            if (i == ball) continue;
-            if (Pong::isOverlapping(rectBoundComponents[ball], rectBoundComponents[i])) {
-                Pong::CollisionInfo info = Pong::resolveCollision(transformComponents[ball], transformComponents[i],
-                    rectBoundComponents[ball], rectBoundComponents[i], ballDirection);
-                // ball bounce
-                float distanceFromCentre = transformComponents[ball].position.y - transformComponents[i].position.y;
-                float normalised = std::clamp(distanceFromCentre / (transformComponents[i].scale.y * 0.5f), -1.0f, 1.0f);
-
-                // Check for which direction the collisions occurred in
-                if (info.direction == Pong::CollisionDirection::UP || info.direction == Pong::CollisionDirection::DOWN) {
-                    ballDirection.y = -ballDirection.y;
-                } else {
-                    if (info.direction == Pong::CollisionDirection::DIAGONAL_DOWN_RIGHT || info.direction == Pong::CollisionDirection::DIAGONAL_DOWN_LEFT
-                        || info.direction == Pong::CollisionDirection::DIAGONAL_UP_RIGHT || info.direction == Pong::CollisionDirection::DIAGONAL_UP_LEFT) {
-
-                        if (glm::abs(info.difference.x) < glm::abs(info.difference.y)) {
-                            transformComponents[ball].position.x += info.difference.x;
-                            ballDirection.x = -ballDirection.x;
-                        }
-                        else if (glm::abs(info.difference.y) < glm::abs(info.difference.x)) {
-                            transformComponents[ball].position.y += info.difference.y;
-                            ballDirection.y = -ballDirection.y;
-                        }
-                    }
-                    else if (info.direction == Pong::CollisionDirection::RIGHT
-                        || info.direction == Pong::CollisionDirection::LEFT) {
-                        transformComponents[ball].position.x += info.difference.x;
-                        ballDirection.x = -ballDirection.x;
-                    }
-
-                    ballDirection.y = normalised;
-                }
-            }
+        // Pause while minimised, without spinning, and don't try to catch up on
+        // the time spent away afterwards.
+        if (!isHeadless && (window->windowData.framebufferWidth == 0 || window->windowData.framebufferHeight == 0)) {
+            PongWindow::waitForWindowEvents(window, 0.1);
+            lastTime = Clock::nowNanos();
+            continue;
         }
 
-        // Handle horizontal collisions with side of field.
-        if (!isResetting) {
-            if ((rectBoundComponents[ball].maxX > windowSize.x) ||
-                rectBoundComponents[ball].minX < -windowSize.x) {
-
-                transformComponents[ball].position = {0.0f,0.0f};
-                oldDirection = ballDirection;
-                ballDirection = {0.0f,0.0f};
-                isResetting = true;
-
-            } else if ((rectBoundComponents[ball].maxY > windowSize.y) ||
-                       rectBoundComponents[ball].minY < -windowSize.y) {
-                if (glm::sign(ballDirection.y) == 1) {
-                    transformComponents[ball].position.y = windowSize.y - transformComponents[ball].scale.y;
-                } else if (glm::sign(ballDirection.y) == -1) {
-                    transformComponents[ball].position.y = -windowSize.y + transformComponents[ball].scale.y;
-                }
-                ballDirection.y = -ballDirection.y;
-            }
-        } else {
-            resetElapsed += deltaTime;
-            if (resetElapsed >= 1.0f) {
-                ballDirection.x = -oldDirection.x;
-                ballDirection.y = 0;
-                resetElapsed = 0.0f;
-                isResetting = false;
-            }
-        }
+        // Headless runs advance exactly one tick per loop, so the simulation
+        // behaves the same regardless of how fast the host can tick it.
+        accumulator += isHeadless ? tickNanos : std::min(frameStart - lastTime, MAX_FRAME_NANOS);
+        lastTime = frameStart;
 
-        for (size_t i = 0; i < currentEntities; i++) {
-            velocityComponents[i].positionVelocity = glm::vec2(0.0f);
+        uint32_t tickCount = 0;
+        while (accumulator >= tickNanos && (maxTicks == 0 || game.tick + tickCount < maxTicks)) {
+            accumulator -= tickNanos;
+            tickCount++;
         }
 
-        // Basic FPS counter
-        if (elapsed > 1.0f) {
-            PONG_TRACE("FRAMES: {0}", frames);
-            frames = 0;
-            elapsed = 0;
+        // Only snapshot when there's a tick to use it - otherwise a tap latched in
+        // the snapshot would be thrown away before the simulation ever saw it.
+        uint64_t inputNanos = 0;
+        if (tickCount > 0) {
+            Pong::InputSnapshot snapshot = Pong::takeInputSnapshot(&inputState);
+            input = sampleInput(&snapshot);
+            inputNanos = snapshot.timeNanos;
         }
+        Pong::recordTicks(&recorder, input, game.arenaHalfSize, tickCount);
 
-        // Render Frame
-        for (int i = 0; i < currentEntities; i++) {
-            Pong::Transform& player = transformComponents[i];
-            Renderer::drawQuad(&renderer, { player.position.x, player.position.y, 0.0f }, player.rotation, glm::radians(player.rotationAngle),
-                player.scale, {1.0f, 1.0f, 1.0f});
+        for (uint32_t i = 0; i < tickCount; i++) {
+            Pong::tickGame(&game, input, tickDelta, &jobs);
+            emitGameParticles(&particles, &game);
+            Pong::updateParticles(&particles, tickDelta, PARTICLE_DRAG);
         }
 
-        // Draw our frame and store the result.
-        Renderer::Status renderStatus = Renderer::drawFrame(&renderer, &window->windowData.isResized);
-
-        if (renderStatus == Renderer::Status::FAILURE) {
+        // Describe the frame and hand it over - drawing happens on the render thread.
+        Pong::RenderPacket* packet = Pong::getRenderPacket(&renderThread);
+        // How far we are between the last tick and the next one.
+        Pong::buildRenderSnapshot(&game, static_cast<float>(accumulator) / static_cast<float>(tickNanos),
+            &packet->snapshot);
+        packet->snapshot.inputNanos = inputNanos;
+        Pong::buildParticleSnapshot(&particles, &packet->particles);
+        packet->framebufferWidth = window->windowData.framebufferWidth;
+        packet->framebufferHeight = window->windowData.framebufferHeight;
+        packet->resizeCount = resizeCount;
+        packet->arenaHalfSize = game.arenaHalfSize;
+        packet->cpuMicros = Clock::toMicros(Clock::nowNanos() - frameStart);
+        Pong::publishRenderPacket(&renderThread);
+
+        if (Pong::hasRenderThreadFailed(&renderThread)) {
             PONG_ERROR("Error drawing frame - exiting main loop!");
             break;
-        } else if (renderStatus == Renderer::Status::SKIPPED_FRAME) {
-            timeFactor = 0.0f;
-            PongWindow::onWindowMinimised(window->nativeWindow, window->type,
-                &renderer.deviceData.framebufferWidth, &renderer.deviceData.framebufferHeight);
-            Renderer::recreateSwapchain(&renderer);
-            window->windowData.isResized = false;
-            timeFactor = 1.0f;
         }
 
-        oldTime = currentTime;
-        frames++;
-
-        Renderer::flushRenderer(&renderer);
+        // Nothing new to simulate until the next tick is due. Input wakes us up
+        // early so it's off the window's queue as soon as possible.
+        if (!isHeadless) {
+            uint64_t elapsed = Clock::nowNanos() - lastTime;
+            if (accumulator + elapsed < tickNanos) {
+                PongWindow::waitForWindowEvents(window, Clock::toSeconds(tickNanos - accumulator - elapsed));
+            }
+        }
     }
     
-    // --------------------------- CLEANUP ------------------------------
+    double benchmarkSeconds = Clock::toSeconds(Clock::nowNanos() - benchmarkStart);
 
-//    Renderer::destroyTexture2D(renderer.deviceData.logicalDevice, texture);
-    Renderer::cleanupRenderer(&renderer, enableValidationLayers);
+    // Stopped ahead of the rest, so the renderer's stats are final.
+    Pong::shutdownRenderThread(&renderThread);
+    app.renderThread = nullptr;
 
-    // GLFW cleanup
-    PongWindow::destroyWindow(window);
+    PONG_INFO("Ran {0} ticks in {1:.3f}s ({2:.1f} ticks/sec)", game.tick, benchmarkSeconds,
+        benchmarkSeconds > 0.0 ? game.tick / benchmarkSeconds : 0.0);
+    PONG_INFO("Renderer stats: {0} quads, {1} culled, {2} frames, {3} flushes", renderer.stats.quadsDrawn,
+        renderer.stats.quadsCulled, renderer.stats.framesDrawn, renderer.stats.flushes);
+    PONG_INFO("Particles: {0} emitted, {1} dropped with the pool full", particles.emitted, particles.dropped);
+
+    Pong::dumpFrameStats(&frameStats, frameStatsPath);
+    Pong::endRecording(&recorder, &game);
+
+    // --------------------------- CLEANUP ------------------------------
 
-    return EXIT_SUCCESS; 
+    return shutdownApp(app, EXIT_SUCCESS);
 } 
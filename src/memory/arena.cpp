@@ -0,0 +1,149 @@
+#include "arena.h"
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include "../logger.h"
+
+namespace Memory {
+
+    static uintptr_t alignUp(uintptr_t value, size_t alignment) {
+        return (value + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    }
+
+    bool initialiseArena(Arena* arena, const char* name, size_t capacity) {
+
+        *arena = Arena{};
+        arena->name = name;
+
+        if (capacity > 0) {
+            arena->base = static_cast<uint8_t*>(malloc(capacity));
+            if (!arena->base) {
+                PONG_ERROR("Failed to allocate {0} bytes for arena '{1}'", capacity, name);
+                return false;
+            }
+            arena->capacity = capacity;
+        }
+
+        return true;
+    }
+
+    static void freeOverflow(Arena* arena, OverflowBlock* until) {
+        while (arena->overflow != until) {
+            OverflowBlock* block = arena->overflow;
+            arena->overflow = block->next;
+            arena->overflowBytes -= block->size;
+            free(block);
+        }
+    }
+
+    void destroyArena(Arena* arena) {
+        freeOverflow(arena, nullptr);
+        free(arena->base);
+        *arena = Arena{};
+    }
+
+    static void trackAllocation(Arena* arena, size_t size, MemoryTag tag) {
+
+        auto index = static_cast<size_t>(tag);
+        arena->bytesByTag[index] += size;
+        arena->peakBytesByTag[index] = std::max(arena->peakBytesByTag[index], arena->bytesByTag[index]);
+
+        size_t used = arena->offset + arena->overflowBytes;
+        arena->peakBytes = std::max(arena->peakBytes, used);
+        arena->cyclePeakBytes = std::max(arena->cyclePeakBytes, used);
+        arena->allocationCount++;
+    }
+
+    void* allocate(Arena* arena, size_t size, MemoryTag tag, size_t alignment) {
+
+        uintptr_t start = alignUp(reinterpret_cast<uintptr_t>(arena->base) + arena->offset, alignment);
+        size_t end = static_cast<size_t>(start - reinterpret_cast<uintptr_t>(arena->base)) + size;
+
+        if (arena->base && end <= arena->capacity) {
+            arena->offset = end;
+            trackAllocation(arena, size, tag);
+            return reinterpret_cast<void*>(start);
+        }
+
+        // Out of room - borrow from the heap until the next reset.
+        size_t blockSize = sizeof(OverflowBlock) + alignment + size;
+        auto* block = static_cast<OverflowBlock*>(malloc(blockSize));
+        if (!block) {
+            PONG_ERROR("Arena '{0}' failed to allocate {1} bytes", arena->name, size);
+            return nullptr;
+        }
+
+        block->next = arena->overflow;
+        block->size = blockSize;
+        arena->overflow = block;
+        arena->overflowBytes += blockSize;
+        arena->overflowCount++;
+
+        trackAllocation(arena, size, tag);
+        return reinterpret_cast<void*>(alignUp(reinterpret_cast<uintptr_t>(block + 1), alignment));
+    }
+
+    void resetArena(Arena* arena) {
+
+        bool hasOverflowed = arena->overflow != nullptr;
+        freeOverflow(arena, nullptr);
+
+        // Grow to fit the whole of the last cycle, so the same workload doesn't
+        // overflow again.
+        if (hasOverflowed) {
+            size_t capacity = std::max(arena->capacity * 2, arena->cyclePeakBytes);
+            auto* base = static_cast<uint8_t*>(malloc(capacity));
+            if (base) {
+                free(arena->base);
+                arena->base = base;
+                arena->capacity = capacity;
+                PONG_INFO("Arena '{0}' overflowed - grown to {1} bytes", arena->name, capacity);
+            }
+        }
+
+        arena->offset = 0;
+        arena->cyclePeakBytes = 0;
+        memset(arena->bytesByTag, 0, sizeof(arena->bytesByTag));
+        arena->resetCount++;
+    }
+
+    ArenaMarker getArenaMarker(const Arena* arena) {
+        ArenaMarker marker;
+        marker.offset = arena->offset;
+        marker.overflow = arena->overflow;
+        memcpy(marker.bytesByTag, arena->bytesByTag, sizeof(marker.bytesByTag));
+        return marker;
+    }
+
+    void rewindArena(Arena* arena, const ArenaMarker& marker) {
+        freeOverflow(arena, marker.overflow);
+        arena->offset = marker.offset;
+        memcpy(arena->bytesByTag, marker.bytesByTag, sizeof(arena->bytesByTag));
+    }
+
+    const char* getMemoryTagName(MemoryTag tag) {
+        switch (tag) {
+            case MemoryTag::SWAPCHAIN:  return "swapchain";
+            case MemoryTag::PIPELINE:   return "pipeline";
+            case MemoryTag::RENDERER2D: return "renderer2D";
+            case MemoryTag::SYNC:       return "sync";
+            case MemoryTag::QUERIES:    return "queries";
+            case MemoryTag::DRAW:       return "draw";
+            case MemoryTag::SIMULATION: return "simulation";
+            case MemoryTag::TEXT:       return "text";
+            case MemoryTag::FRAME:      return "frame";
+            default:                    return "unknown";
+        }
+    }
+
+    void logArenaUsage(const Arena* arena) {
+
+        PONG_INFO("Arena '{0}': peak {1} of {2} bytes, {3} allocations, {4} resets, {5} overflows", arena->name,
+            arena->peakBytes, arena->capacity, arena->allocationCount, arena->resetCount, arena->overflowCount);
+
+        for (size_t i = 0; i < MEMORY_TAG_COUNT; i++) {
+            if (arena->peakBytesByTag[i] == 0) continue;
+            PONG_INFO("  {0}: peak {1} bytes", getMemoryTagName(static_cast<MemoryTag>(i)), arena->peakBytesByTag[i]);
+        }
+    }
+}
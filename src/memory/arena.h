@@ -0,0 +1,96 @@
+#ifndef PONG_VK_ARENA_H
+#define PONG_VK_ARENA_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Linear (bump) allocators.
+//
+// An arena hands out memory by bumping an offset through one block, and frees
+// everything it gave out at once when it's reset. Nothing is freed
+// individually, so allocations are a couple of adds and there's no per-block
+// bookkeeping to fragment. Each allocation also carries a tag naming the
+// subsystem it's for, so usage can be broken down afterwards.
+//
+// If the block runs out, the allocation still succeeds - it comes from the
+// heap instead and is freed on the next reset, at which point the block is
+// grown to fit everything that was asked of it. An arena that's been through
+// one reset at its steady-state size never touches the heap again.
+//
+// Markers allow scoped temporaries: take a marker, allocate, then rewind to
+// it to give back everything allocated since.
+
+namespace Memory {
+
+    enum class MemoryTag : uint8_t {
+        SWAPCHAIN = 0,
+        PIPELINE,
+        RENDERER2D,
+        SYNC,
+        QUERIES,
+        DRAW,
+        SIMULATION,
+        TEXT,
+        FRAME,
+        COUNT
+    };
+
+    constexpr size_t MEMORY_TAG_COUNT = static_cast<size_t>(MemoryTag::COUNT);
+
+    // Heap allocation made when the block was full.
+    struct OverflowBlock {
+        OverflowBlock* next     {nullptr};
+        size_t size             {0};
+    };
+
+    struct Arena {
+        const char* name                            {"arena"};
+        uint8_t* base                               {nullptr};
+        size_t capacity                             {0};
+        size_t offset                               {0};
+        OverflowBlock* overflow                     {nullptr};
+        // Bytes handed out from the heap since the last reset.
+        size_t overflowBytes                        {0};
+        // Live bytes per tag, and the most each tag has ever held at once.
+        size_t bytesByTag[MEMORY_TAG_COUNT]         {0};
+        size_t peakBytesByTag[MEMORY_TAG_COUNT]     {0};
+        // The most the arena has ever held at once, including overflow.
+        size_t peakBytes                            {0};
+        // The most the arena has held since the last reset - what the block
+        // needs to fit to never overflow.
+        size_t cyclePeakBytes                       {0};
+        uint64_t allocationCount                    {0};
+        uint64_t overflowCount                      {0};
+        uint64_t resetCount                         {0};
+    };
+
+    struct ArenaMarker {
+        size_t offset                               {0};
+        OverflowBlock* overflow                     {nullptr};
+        size_t bytesByTag[MEMORY_TAG_COUNT]         {0};
+    };
+
+    bool initialiseArena(Arena*, const char* name, size_t capacity);
+    void destroyArena(Arena*);
+
+    // The memory isn't zeroed. Alignment must be a power of two.
+    void* allocate(Arena*, size_t size, MemoryTag, size_t alignment = alignof(std::max_align_t));
+
+    template <typename T>
+    T* allocateArray(Arena* arena, size_t count, MemoryTag tag) {
+        return static_cast<T*>(allocate(arena, sizeof(T) * count, tag, alignof(T)));
+    }
+
+    // Frees everything in the arena, and grows the block if it overflowed.
+    void resetArena(Arena*);
+
+    ArenaMarker getArenaMarker(const Arena*);
+    // Frees everything allocated since the marker was taken.
+    void rewindArena(Arena*, const ArenaMarker&);
+
+    const char* getMemoryTagName(MemoryTag);
+    // Logs the arena's peak usage, broken down by tag.
+    void logArenaUsage(const Arena*);
+}
+
+#endif //PONG_VK_ARENA_H
@@ -0,0 +1,244 @@
+#include "broadphase.h"
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include "../logger.h"
+
+namespace Pong {
+
+    bool initialiseBroadphase(Broadphase* broadphase, float minX, float minY, float maxX, float maxY,
+        float cellSize, uint32_t maxEntities) {
+
+        if (cellSize <= 0.0f || maxX <= minX || maxY <= minY) {
+            PONG_ERROR("Invalid broadphase grid dimensions");
+            return false;
+        }
+
+        *broadphase = Broadphase{};
+
+        broadphase->originX = minX;
+        broadphase->originY = minY;
+        broadphase->inverseCellSize = 1.0f / cellSize;
+        broadphase->columns = std::max(1u, static_cast<uint32_t>(std::ceil((maxX - minX) / cellSize)));
+        broadphase->rows = std::max(1u, static_cast<uint32_t>(std::ceil((maxY - minY) / cellSize)));
+        broadphase->maxEntities = maxEntities;
+
+        uint32_t cellCount = broadphase->columns * broadphase->rows;
+
+        // Start with room for every entity touching up to four cells - updates
+        // grow this if needed.
+        broadphase->entryCapacity = maxEntities * 4;
+        broadphase->pairCapacity = maxEntities;
+
+        broadphase->cellStarts = static_cast<uint32_t*>(malloc(sizeof(uint32_t) * (cellCount + 1)));
+        broadphase->cellCursors = static_cast<uint32_t*>(malloc(sizeof(uint32_t) * cellCount));
+        broadphase->cellEntries = static_cast<uint32_t*>(malloc(sizeof(uint32_t) * broadphase->entryCapacity));
+        broadphase->entityCells = static_cast<uint32_t*>(malloc(sizeof(uint32_t) * 4 * maxEntities));
+        broadphase->pairs = static_cast<CollisionPair*>(malloc(sizeof(CollisionPair) * broadphase->pairCapacity));
+
+        if (!broadphase->cellStarts || !broadphase->cellCursors || !broadphase->cellEntries
+            || !broadphase->entityCells || !broadphase->pairs) {
+            PONG_ERROR("Failed to allocate broadphase grid ({0}x{1} cells)", broadphase->columns, broadphase->rows);
+            destroyBroadphase(broadphase);
+            return false;
+        }
+
+        return true;
+    }
+
+    void destroyBroadphase(Broadphase* broadphase) {
+        free(broadphase->cellStarts);
+        free(broadphase->cellCursors);
+        free(broadphase->cellEntries);
+        free(broadphase->entityCells);
+        free(broadphase->pairs);
+        for (PairBuffer& batch : broadphase->batches) free(batch.pairs);
+        *broadphase = Broadphase{};
+    }
+
+    static uint32_t toCell(float value, float origin, float inverseCellSize, uint32_t cells) {
+        float cell = (value - origin) * inverseCellSize;
+        if (cell <= 0.0f) return 0;
+        return std::min(static_cast<uint32_t>(cell), cells - 1);
+    }
+
+    // Grows an array to hold at least 'required' elements. Returns false (and
+    // leaves the array untouched) if the allocation fails.
+    template <typename T>
+    static bool reserve(T** data, uint32_t* capacity, uint32_t required) {
+
+        if (required <= *capacity) return true;
+
+        uint32_t newCapacity = std::max(required, *capacity * 2);
+        T* newData = static_cast<T*>(realloc(*data, sizeof(T) * newCapacity));
+        if (!newData) return false;
+
+        *data = newData;
+        *capacity = newCapacity;
+        return true;
+    }
+
+    // Entity count below which pair emission always runs on the calling thread.
+    constexpr uint32_t PARALLEL_ENTITY_THRESHOLD = 2048;
+
+    // Tests every pair of entities sharing a cell in [firstCell, lastCell).
+    //
+    // Entities are scattered in index order, so within a cell a < b always.
+    // Two entities spanning several cells will meet in every one of them - the
+    // pair is only emitted from the cell containing the minimum corner of
+    // their overlap, which is exactly one of the cells they share.
+    static void emitPairs(const Broadphase* broadphase, const RectBoundsColumns& bounds, uint32_t firstCell,
+        uint32_t lastCell, CollisionPair** pairs, uint32_t* pairCount, uint32_t* pairCapacity) {
+
+        const uint32_t* entityCells = broadphase->entityCells;
+        const uint32_t* cellStarts = broadphase->cellStarts;
+
+        for (uint32_t cell = firstCell; cell < lastCell; cell++) {
+
+            uint32_t start = cellStarts[cell];
+            uint32_t end = cellStarts[cell + 1];
+
+            for (uint32_t j = start; j < end; j++) {
+                uint32_t a = broadphase->cellEntries[j];
+
+                for (uint32_t k = j + 1; k < end; k++) {
+                    uint32_t b = broadphase->cellEntries[k];
+
+                    if (bounds.minX[a] > bounds.maxX[b] || bounds.minX[b] > bounds.maxX[a]
+                        || bounds.minY[a] > bounds.maxY[b] || bounds.minY[b] > bounds.maxY[a]) continue;
+
+                    uint32_t ownerX = std::max(entityCells[a * 4 + 0], entityCells[b * 4 + 0]);
+                    uint32_t ownerY = std::max(entityCells[a * 4 + 1], entityCells[b * 4 + 1]);
+                    if (ownerY * broadphase->columns + ownerX != cell) continue;
+
+                    if (!reserve(pairs, pairCapacity, *pairCount + 1)) {
+                        PONG_ERROR("Failed to grow broadphase pairs - dropping remaining pairs this tick");
+                        return;
+                    }
+
+                    (*pairs)[(*pairCount)++] = { a, b };
+                }
+            }
+        }
+    }
+
+    struct PairJobData {
+        Broadphase* broadphase;
+        const RectBoundsColumns* bounds;
+        uint32_t cellsPerBatch;
+        uint32_t cellCount;
+    };
+
+    static void emitPairsJob(void* data, uint32_t start, uint32_t end) {
+
+        auto* jobData = static_cast<PairJobData*>(data);
+
+        for (uint32_t batch = start; batch < end; batch++) {
+            PairBuffer& buffer = jobData->broadphase->batches[batch];
+            uint32_t firstCell = std::min(batch * jobData->cellsPerBatch, jobData->cellCount);
+            uint32_t lastCell = std::min(firstCell + jobData->cellsPerBatch, jobData->cellCount);
+
+            buffer.count = 0;
+            emitPairs(jobData->broadphase, *jobData->bounds, firstCell, lastCell, &buffer.pairs, &buffer.count,
+                &buffer.capacity);
+        }
+    }
+
+    void updateBroadphase(Broadphase* broadphase, const EntityStore* store, uint32_t mask, Jobs::JobSystem* jobs) {
+
+        broadphase->pairCount = 0;
+
+        uint32_t count = std::min(store->count, broadphase->maxEntities);
+        uint32_t cellCount = broadphase->columns * broadphase->rows;
+        const RectBoundsColumns& bounds = store->bounds;
+        uint32_t* entityCells = broadphase->entityCells;
+        uint32_t* cellStarts = broadphase->cellStarts;
+
+        // ------------------------ COUNT ENTRIES PER CELL --------------------------
+
+        memset(cellStarts, 0, sizeof(uint32_t) * (cellCount + 1));
+
+        uint32_t entryCount = 0;
+
+        for (uint32_t i = 0; i < count; i++) {
+
+            uint32_t* cells = entityCells + i * 4;
+
+            if ((store->componentMasks[i] & mask) != mask) {
+                // An empty range (min > max) so later passes skip it.
+                cells[0] = 1; cells[2] = 0;
+                continue;
+            }
+
+            cells[0] = toCell(bounds.minX[i], broadphase->originX, broadphase->inverseCellSize, broadphase->columns);
+            cells[1] = toCell(bounds.minY[i], broadphase->originY, broadphase->inverseCellSize, broadphase->rows);
+            cells[2] = toCell(bounds.maxX[i], broadphase->originX, broadphase->inverseCellSize, broadphase->columns);
+            cells[3] = toCell(bounds.maxY[i], broadphase->originY, broadphase->inverseCellSize, broadphase->rows);
+
+            for (uint32_t y = cells[1]; y <= cells[3]; y++) {
+                for (uint32_t x = cells[0]; x <= cells[2]; x++) {
+                    cellStarts[y * broadphase->columns + x + 1]++;
+                }
+            }
+
+            entryCount += (cells[2] - cells[0] + 1) * (cells[3] - cells[1] + 1);
+        }
+
+        if (!reserve(&broadphase->cellEntries, &broadphase->entryCapacity, entryCount)) {
+            PONG_ERROR("Failed to grow broadphase entries to {0} - skipping collisions this tick", entryCount);
+            return;
+        }
+
+        // Prefix sum turns the counts into the first entry of each cell.
+        for (uint32_t cell = 0; cell < cellCount; cell++) {
+            cellStarts[cell + 1] += cellStarts[cell];
+        }
+
+        // ---------------------------- SCATTER ------------------------------------
+
+        memcpy(broadphase->cellCursors, cellStarts, sizeof(uint32_t) * cellCount);
+
+        for (uint32_t i = 0; i < count; i++) {
+            const uint32_t* cells = entityCells + i * 4;
+            if (cells[0] > cells[2]) continue;
+
+            for (uint32_t y = cells[1]; y <= cells[3]; y++) {
+                for (uint32_t x = cells[0]; x <= cells[2]; x++) {
+                    broadphase->cellEntries[broadphase->cellCursors[y * broadphase->columns + x]++] = i;
+                }
+            }
+        }
+
+        // --------------------------- EMIT PAIRS ----------------------------------
+
+        uint32_t batchCount = std::min(BROADPHASE_BATCHES, cellCount);
+
+        // Not worth spreading across threads unless there's a decent amount to test.
+        if (!jobs || count < PARALLEL_ENTITY_THRESHOLD || batchCount < 2) {
+            emitPairs(broadphase, bounds, 0, cellCount, &broadphase->pairs, &broadphase->pairCount,
+                &broadphase->pairCapacity);
+            return;
+        }
+
+        PairJobData jobData = { broadphase, &bounds, (cellCount + batchCount - 1) / batchCount, cellCount };
+
+        Jobs::Counter counter;
+        Jobs::parallelFor(jobs, emitPairsJob, &jobData, batchCount, 1, &counter);
+        Jobs::waitForCounter(jobs, &counter);
+
+        uint32_t totalPairs = 0;
+        for (uint32_t batch = 0; batch < batchCount; batch++) totalPairs += broadphase->batches[batch].count;
+
+        if (!reserve(&broadphase->pairs, &broadphase->pairCapacity, totalPairs)) {
+            PONG_ERROR("Failed to grow broadphase pairs to {0} - skipping collisions this tick", totalPairs);
+            return;
+        }
+
+        for (uint32_t batch = 0; batch < batchCount; batch++) {
+            const PairBuffer& buffer = broadphase->batches[batch];
+            memcpy(broadphase->pairs + broadphase->pairCount, buffer.pairs, sizeof(CollisionPair) * buffer.count);
+            broadphase->pairCount += buffer.count;
+        }
+    }
+}
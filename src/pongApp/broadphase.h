@@ -0,0 +1,74 @@
+#ifndef PONG_VK_BROADPHASE_H
+#define PONG_VK_BROADPHASE_H
+
+#include <cstdint>
+#include "entities.h"
+#include "../jobs/jobs.h"
+
+namespace Pong {
+
+    // Uniform grid broadphase. Every tick each entity's RectBounds are binned
+    // into the grid cells they cover (a counting sort, so there's no per-cell
+    // allocation or hashing), then only entities sharing a cell are tested
+    // against each other. As long as the cell size is on the order of the
+    // typical entity size this keeps the collision pass close to linear,
+    // instead of testing all n^2 pairs.
+    //
+    // Anything outside the grid is clamped into the border cells - it still
+    // collides correctly, just less efficiently.
+
+    // Two dense entity indices with overlapping bounds, a < b.
+    struct CollisionPair {
+        uint32_t a  {0};
+        uint32_t b  {0};
+    };
+
+    // Pair emission is split into at most this many jobs, each with its own output.
+    constexpr uint32_t BROADPHASE_BATCHES = 16;
+
+    struct PairBuffer {
+        CollisionPair* pairs        {nullptr};
+        uint32_t count              {0};
+        uint32_t capacity           {0};
+    };
+
+    struct Broadphase {
+        float originX               {0.0f};
+        float originY               {0.0f};
+        float inverseCellSize       {0.0f};
+        uint32_t columns            {0};
+        uint32_t rows               {0};
+        uint32_t maxEntities        {0};
+
+        // Offsets into cellEntries for each cell (columns * rows + 1 entries).
+        uint32_t* cellStarts        {nullptr};
+        // Scratch write cursors used while scattering entities into cells.
+        uint32_t* cellCursors       {nullptr};
+        // Entity indices ordered by cell. Grows when entities cover more cells.
+        uint32_t* cellEntries       {nullptr};
+        uint32_t entryCapacity      {0};
+        // Inclusive cell range covered by each entity: minX, minY, maxX, maxY.
+        uint32_t* entityCells       {nullptr};
+
+        CollisionPair* pairs        {nullptr};
+        uint32_t pairCount          {0};
+        uint32_t pairCapacity       {0};
+
+        // Scratch output for each batch when emitting pairs in parallel.
+        PairBuffer batches[BROADPHASE_BATCHES];
+    };
+
+    // The grid covers [minX, maxX] x [minY, maxY] with square cells.
+    bool initialiseBroadphase(Broadphase*, float minX, float minY, float maxX, float maxY,
+        float cellSize, uint32_t maxEntities);
+    void destroyBroadphase(Broadphase*);
+
+    // Rebuilds the grid from every entity matching the mask and fills
+    // broadphase->pairs with each overlapping pair exactly once. Given a job
+    // system, the pair tests are split into batches of cells which run in
+    // parallel, and the results are concatenated in cell order - so the output
+    // is identical either way.
+    void updateBroadphase(Broadphase*, const EntityStore*, uint32_t mask, Jobs::JobSystem* = nullptr);
+}
+
+#endif //PONG_VK_BROADPHASE_H
@@ -1,13 +1,16 @@
 #include "components.h"
+#include <algorithm>
+#include <limits>
 #include "../logger.h"
 
 namespace Pong {
 
-    void addVelocity(Transform& transform, Velocity& velocity) {
+    void addVelocity(Transform& transform, const Velocity& velocity) {
         transform.position += velocity.positionVelocity;
+        transform.rotation += velocity.rotationVelocity;
     }
 
-    bool isOverlapping(RectBounds& rectA, RectBounds& rectB) {
+    bool isOverlapping(const RectBounds& rectA, const RectBounds& rectB) {
 
         bool collisionX = (rectB.maxX > rectA.maxX && rectB.minX < rectA.maxX)
                 || (rectB.maxX > rectA.minX && rectB.minX < rectA.minX);
@@ -18,70 +21,69 @@ namespace Pong {
         return collisionX && collisionY;
     }
 
-    CollisionInfo resolveCollision(Transform& transformA, Transform& transformB,
-        RectBounds& rectA, RectBounds& rectB, glm::vec2& direction) {
-
-        glm::vec2 directions[] = {
-            {1.0f, 0.0f},   // right
-            {0.0f, 1.0f},   // up
-            {-1.0f, 0.0f},  // left
-            {0.0, -1.0},    // down
-            {1.0, 1.0},     // diagonal up-right
-            {-1.0, 1.0},    // diaglonal up-left
-            {1.0, -1.0},    // diagonal down-right
-            {-1.0, -1.0},   // diagonal down-left
-        };
-
-        float max = 0.0f;
-        size_t bestMatch = -1;
-        for (size_t i = 0; i < 8; i++) {
-            float dot_product = glm::dot(glm::normalize(direction), directions[i]);
-            if (dot_product > max) {
-                bestMatch = i;
-                max = dot_product;
-            }
-        }
-
-        glm::vec2 hit_direction = directions[bestMatch];
-
-        float dirX = glm::sign(hit_direction.x);
-        float dirY = glm::sign(hit_direction.y);
-
-        glm::vec2 difference = { 0.0f, 0.0f};
+    RectBounds initialiseRectBounds(const Transform& transform) {
+        RectBounds rect{};
+        updateRectBounds(rect, transform);
+        return rect;
+    }
 
-        float distanceFromPoints {0.0f};
+    void updateRectBounds(RectBounds& rect, const Transform& transform) {
+        float halfX = transform.scale.x * 0.5f;
+        float halfY = transform.scale.y * 0.5f;
+        rect.minX = transform.position.x - halfX;
+        rect.minY = transform.position.y - halfY;
+        rect.maxX = transform.position.x + halfX;
+        rect.maxY = transform.position.y + halfY;
+    }
 
-        if (dirX == 1 || dirX == -1) {
-            if (transformA.position.x >= transformB.position.x) {
-                distanceFromPoints = rectB.maxX - rectA.minX;
-            } else {
-                distanceFromPoints = rectB.minX - rectA.maxX;
-            }
-            difference.x = distanceFromPoints;
+    // Slab test on the Minkowski difference: for each axis work out when the
+    // moving box starts and stops overlapping the target, the boxes touch for
+    // the span where both axes overlap.
+    bool sweepRectBounds(const RectBounds& moving, const glm::vec2& displacement, const RectBounds& target, SweepHit& hit) {
+
+        if (moving.minX < target.maxX && moving.maxX > target.minX
+            && moving.minY < target.maxY && moving.maxY > target.minY) return false;
+
+        float entryX, exitX, entryY, exitY;
+
+        if (displacement.x > 0.0f) {
+            entryX = (target.minX - moving.maxX) / displacement.x;
+            exitX = (target.maxX - moving.minX) / displacement.x;
+        } else if (displacement.x < 0.0f) {
+            entryX = (target.maxX - moving.minX) / displacement.x;
+            exitX = (target.minX - moving.maxX) / displacement.x;
+        } else {
+            // Not moving on this axis - it either always overlaps or never will.
+            if (moving.maxX <= target.minX || moving.minX >= target.maxX) return false;
+            entryX = -std::numeric_limits<float>::infinity();
+            exitX = std::numeric_limits<float>::infinity();
         }
-        if (dirY == 1 || dirY == -1) {
-            if (transformA.position.y >= transformB.position.y) {
-                distanceFromPoints = rectB.maxY - rectA.minY;
-            } else {
-                distanceFromPoints = rectB.minY - rectA.maxY;
-            }
-            difference.y = distanceFromPoints;
+
+        if (displacement.y > 0.0f) {
+            entryY = (target.minY - moving.maxY) / displacement.y;
+            exitY = (target.maxY - moving.minY) / displacement.y;
+        } else if (displacement.y < 0.0f) {
+            entryY = (target.maxY - moving.minY) / displacement.y;
+            exitY = (target.minY - moving.maxY) / displacement.y;
+        } else {
+            if (moving.maxY <= target.minY || moving.minY >= target.maxY) return false;
+            entryY = -std::numeric_limits<float>::infinity();
+            exitY = std::numeric_limits<float>::infinity();
         }
 
-        return { (CollisionDirection)bestMatch, difference };
-    }
+        float entry = std::max(entryX, entryY);
+        float exit = std::min(exitX, exitY);
 
-    RectBounds initialiseRectBounds(Transform& transform) {
-        RectBounds rect{};
-        updateRectBounds(rect, transform);
-        return rect;
-    }
+        if (entry > exit || entry < 0.0f || entry > 1.0f) return false;
+
+        hit.time = entry;
+        // The axis which started overlapping last is the one we hit.
+        if (entryX > entryY) {
+            hit.normal = { displacement.x > 0.0f ? -1.0f : 1.0f, 0.0f };
+        } else {
+            hit.normal = { 0.0f, displacement.y > 0.0f ? -1.0f : 1.0f };
+        }
 
-    void updateRectBounds(RectBounds& rect, Transform& transform) {
-        rect.minX = transform.position.x - (transform.scale.x / 2.0f);
-        rect.minY = transform.position.y - (transform.scale.y / 2.0f);
-        rect.maxX = transform.position.x + (transform.scale.x / 2.0f);
-        rect.maxY = transform.position.y + (transform.scale.y / 2.0f);
+        return true;
     }
 }
-
@@ -5,32 +5,25 @@
 
 namespace Pong {
 
-    enum class CollisionDirection {
-        RIGHT   = 0,
-        UP      = 1,
-        LEFT    = 2,
-        DOWN    = 3,
-        DIAGONAL_UP_RIGHT = 4, 
-        DIAGONAL_UP_LEFT = 5,
-        DIAGONAL_DOWN_RIGHT = 6,
-        DIAGONAL_DOWN_LEFT = 7
-    };
-
+    // Everything in the game is a flat quad, so rotation is a single angle (in
+    // degrees) around the Z axis.
     struct Transform {
         glm::vec2 position { 0.0f, 0.0f };
-        glm::vec3 rotation { 0.0f, 0.0f, 0.0f };
-        glm::vec3 scale { 0.0f, 0.0f, 0.0f };
-        float rotationAngle {0.f};
+        glm::vec2 scale { 0.0f, 0.0f };
+        float rotation {0.f};
     };
 
     struct Velocity {
         glm::vec2 positionVelocity { 0.0f, 0.0f };
-        glm::vec3 rotationVelocity { 0.0f, 0.0f, 0.0f };
+        float rotationVelocity { 0.0f };
     };
 
-    struct CollisionInfo {
-        CollisionDirection direction {CollisionDirection::RIGHT};
-        glm::vec2 difference {0.0f, 0.0f};
+    // The result of sweeping one box against another.
+    struct SweepHit {
+        // Fraction of the displacement travelled before contact, in [0, 1].
+        float time {1.0f};
+        // Contact normal on the surface that was hit (axis aligned, unit length).
+        glm::vec2 normal {0.0f, 0.0f};
     };
 
     struct RectBounds {
@@ -40,11 +33,15 @@ namespace Pong {
         float maxY {0};
     };
 
-    void addVelocity(Transform&, Velocity&);
-    bool isOverlapping(RectBounds&, RectBounds&);
-    CollisionInfo resolveCollision(Transform&, Transform&, RectBounds&, RectBounds&, glm::vec2&);
-    RectBounds initialiseRectBounds(Transform&);
-    void updateRectBounds(RectBounds&, Transform&);
+    void addVelocity(Transform&, const Velocity&);
+    bool isOverlapping(const RectBounds&, const RectBounds&);
+    RectBounds initialiseRectBounds(const Transform&);
+    void updateRectBounds(RectBounds&, const Transform&);
+    // Continuous collision: returns true if 'moving' touches 'target' while
+    // travelling by 'displacement', filling in the exact time of impact and
+    // contact normal. Boxes which already overlap are left to the
+    // narrowphase (see computeContactsBatch).
+    bool sweepRectBounds(const RectBounds& moving, const glm::vec2& displacement, const RectBounds& target, SweepHit&);
 }
 
 #endif //PONG_VK_COMPONENTS_H
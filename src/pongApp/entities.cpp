@@ -0,0 +1,338 @@
+#include "entities.h"
+#include "kernels.h"
+#include <cstdlib>
+#include <cstring>
+#include "../logger.h"
+
+namespace Pong {
+
+    // Columns are cache line aligned and padded to a multiple of 16 floats so
+    // that batched loops can always work on whole vectors.
+    constexpr size_t COLUMN_ALIGNMENT = 64;
+    constexpr uint32_t COLUMN_PADDING = 16;
+
+    static void* allocateColumn(size_t size) {
+        void* data = nullptr;
+        #if defined(_MSC_VER) || defined(__MINGW32__)
+            data = _aligned_malloc(size, COLUMN_ALIGNMENT);
+        #else
+        if (posix_memalign(&data, COLUMN_ALIGNMENT, size) != 0)
+            data = nullptr;
+        #endif
+        if (data) memset(data, 0, size);
+        return data;
+    }
+
+    static void freeColumn(void* data) {
+        if (!data) return;
+    #if	defined(_MSC_VER) || defined(__MINGW32__)
+        _aligned_free(data);
+    #else
+        free(data);
+    #endif
+    }
+
+    template <typename T>
+    static bool allocateColumn(T** column, uint32_t capacity) {
+        *column = static_cast<T*>(allocateColumn(sizeof(T) * capacity));
+        return *column != nullptr;
+    }
+
+    // ----------------------------- LIFETIME -----------------------------------
+
+    bool initialiseEntityStore(EntityStore* store, uint32_t capacity) {
+
+        if (capacity == 0 || capacity >= MAX_ENTITIES) {
+            PONG_ERROR("Invalid entity store capacity: {0}", capacity);
+            return false;
+        }
+
+        uint32_t paddedCapacity = (capacity + COLUMN_PADDING - 1) & ~(COLUMN_PADDING - 1);
+
+        *store = EntityStore{};
+        store->capacity = capacity;
+
+        bool isAllocated =
+            allocateColumn(&store->transforms.positionX, paddedCapacity)
+            && allocateColumn(&store->transforms.positionY, paddedCapacity)
+            && allocateColumn(&store->transforms.scaleX, paddedCapacity)
+            && allocateColumn(&store->transforms.scaleY, paddedCapacity)
+            && allocateColumn(&store->transforms.rotation, paddedCapacity)
+            && allocateColumn(&store->velocities.x, paddedCapacity)
+            && allocateColumn(&store->velocities.y, paddedCapacity)
+            && allocateColumn(&store->velocities.rotation, paddedCapacity)
+            && allocateColumn(&store->bounds.minX, paddedCapacity)
+            && allocateColumn(&store->bounds.minY, paddedCapacity)
+            && allocateColumn(&store->bounds.maxX, paddedCapacity)
+            && allocateColumn(&store->bounds.maxY, paddedCapacity)
+            && allocateColumn(&store->componentMasks, paddedCapacity)
+            && allocateColumn(&store->previousPositionX, paddedCapacity)
+            && allocateColumn(&store->previousPositionY, paddedCapacity)
+            && allocateColumn(&store->previousRotation, paddedCapacity)
+            && allocateColumn(&store->entities, paddedCapacity)
+            && allocateColumn(&store->denseIndices, capacity)
+            && allocateColumn(&store->generations, capacity)
+            && allocateColumn(&store->freeIndices, capacity);
+
+        if (!isAllocated) {
+            PONG_ERROR("Failed to allocate entity store with capacity {0}", capacity);
+            destroyEntityStore(store);
+            return false;
+        }
+
+        return true;
+    }
+
+    void destroyEntityStore(EntityStore* store) {
+
+        void* columns[] = {
+            store->transforms.positionX, store->transforms.positionY,
+            store->transforms.scaleX, store->transforms.scaleY, store->transforms.rotation,
+            store->velocities.x, store->velocities.y, store->velocities.rotation,
+            store->bounds.minX, store->bounds.minY, store->bounds.maxX, store->bounds.maxY,
+            store->componentMasks, store->previousPositionX, store->previousPositionY,
+            store->previousRotation, store->entities, store->denseIndices,
+            store->generations, store->freeIndices
+        };
+
+        for (void* column : columns) freeColumn(column);
+
+        *store = EntityStore{};
+    }
+
+    // ----------------------------- ENTITIES -----------------------------------
+
+    Entity createEntity(EntityStore* store, uint32_t componentMask) {
+
+        if (store->count == store->capacity) {
+            PONG_WARN("Entity store is full ({0} entities)", store->capacity);
+            return NULL_ENTITY;
+        }
+
+        uint32_t handleIndex = store->freeCount > 0 ? store->freeIndices[--store->freeCount] : store->nextIndex++;
+        Entity entity = (static_cast<uint32_t>(store->generations[handleIndex]) << ENTITY_INDEX_BITS) | handleIndex;
+
+        uint32_t index = store->count++;
+        store->denseIndices[handleIndex] = index;
+        store->entities[index] = entity;
+        store->componentMasks[index] = componentMask;
+
+        // Slots are reused, so make sure nothing from a previous occupant leaks through.
+        store->transforms.positionX[index] = 0.0f;
+        store->transforms.positionY[index] = 0.0f;
+        store->transforms.scaleX[index] = 0.0f;
+        store->transforms.scaleY[index] = 0.0f;
+        store->transforms.rotation[index] = 0.0f;
+        store->velocities.x[index] = 0.0f;
+        store->velocities.y[index] = 0.0f;
+        store->velocities.rotation[index] = 0.0f;
+        store->bounds.minX[index] = 0.0f;
+        store->bounds.minY[index] = 0.0f;
+        store->bounds.maxX[index] = 0.0f;
+        store->bounds.maxY[index] = 0.0f;
+        store->previousPositionX[index] = 0.0f;
+        store->previousPositionY[index] = 0.0f;
+        store->previousRotation[index] = 0.0f;
+
+        return entity;
+    }
+
+    bool isEntityAlive(const EntityStore* store, Entity entity) {
+
+        if (entity == NULL_ENTITY) return false;
+
+        uint32_t handleIndex = entity & ENTITY_INDEX_MASK;
+        if (handleIndex >= store->nextIndex) return false;
+
+        uint32_t index = store->denseIndices[handleIndex];
+        return index < store->count && store->entities[index] == entity;
+    }
+
+    bool destroyEntity(EntityStore* store, Entity entity) {
+
+        if (!isEntityAlive(store, entity)) return false;
+
+        uint32_t handleIndex = entity & ENTITY_INDEX_MASK;
+        uint32_t index = store->denseIndices[handleIndex];
+        uint32_t last = --store->count;
+
+        // Swap the last entity into the hole to keep the columns packed.
+        if (index != last) {
+            store->transforms.positionX[index] = store->transforms.positionX[last];
+            store->transforms.positionY[index] = store->transforms.positionY[last];
+            store->transforms.scaleX[index] = store->transforms.scaleX[last];
+            store->transforms.scaleY[index] = store->transforms.scaleY[last];
+            store->transforms.rotation[index] = store->transforms.rotation[last];
+            store->velocities.x[index] = store->velocities.x[last];
+            store->velocities.y[index] = store->velocities.y[last];
+            store->velocities.rotation[index] = store->velocities.rotation[last];
+            store->bounds.minX[index] = store->bounds.minX[last];
+            store->bounds.minY[index] = store->bounds.minY[last];
+            store->bounds.maxX[index] = store->bounds.maxX[last];
+            store->bounds.maxY[index] = store->bounds.maxY[last];
+            store->componentMasks[index] = store->componentMasks[last];
+            store->previousPositionX[index] = store->previousPositionX[last];
+            store->previousPositionY[index] = store->previousPositionY[last];
+            store->previousRotation[index] = store->previousRotation[last];
+
+            Entity moved = store->entities[last];
+            store->entities[index] = moved;
+            store->denseIndices[moved & ENTITY_INDEX_MASK] = index;
+        }
+
+        store->componentMasks[last] = COMPONENT_NONE;
+        store->entities[last] = NULL_ENTITY;
+
+        store->generations[handleIndex]++;
+        store->freeIndices[store->freeCount++] = handleIndex;
+
+        return true;
+    }
+
+    void addComponents(EntityStore* store, Entity entity, uint32_t mask) {
+        store->componentMasks[getEntityIndex(store, entity)] |= mask;
+    }
+
+    void removeComponents(EntityStore* store, Entity entity, uint32_t mask) {
+        uint32_t index = getEntityIndex(store, entity);
+        store->componentMasks[index] &= ~mask;
+
+        // applyVelocities() integrates every slot, so a removed velocity has to be zeroed.
+        if (mask & COMPONENT_VELOCITY) {
+            store->velocities.x[index] = 0.0f;
+            store->velocities.y[index] = 0.0f;
+            store->velocities.rotation[index] = 0.0f;
+        }
+    }
+
+    // ------------------------------ ACCESS ------------------------------------
+
+    Transform getTransform(const EntityStore* store, uint32_t index) {
+        const TransformColumns& transforms = store->transforms;
+        return {
+            { transforms.positionX[index], transforms.positionY[index] },
+            { transforms.scaleX[index], transforms.scaleY[index] },
+            transforms.rotation[index]
+        };
+    }
+
+    void setTransform(EntityStore* store, uint32_t index, const Transform& transform) {
+        TransformColumns& transforms = store->transforms;
+        transforms.positionX[index] = transform.position.x;
+        transforms.positionY[index] = transform.position.y;
+        transforms.scaleX[index] = transform.scale.x;
+        transforms.scaleY[index] = transform.scale.y;
+        transforms.rotation[index] = transform.rotation;
+    }
+
+    Velocity getVelocity(const EntityStore* store, uint32_t index) {
+        const VelocityColumns& velocities = store->velocities;
+        return { { velocities.x[index], velocities.y[index] }, velocities.rotation[index] };
+    }
+
+    void setVelocity(EntityStore* store, uint32_t index, const Velocity& velocity) {
+        VelocityColumns& velocities = store->velocities;
+        velocities.x[index] = velocity.positionVelocity.x;
+        velocities.y[index] = velocity.positionVelocity.y;
+        velocities.rotation[index] = velocity.rotationVelocity;
+    }
+
+    RectBounds getRectBounds(const EntityStore* store, uint32_t index) {
+        const RectBoundsColumns& bounds = store->bounds;
+        return { bounds.minX[index], bounds.minY[index], bounds.maxX[index], bounds.maxY[index] };
+    }
+
+    void setRectBounds(EntityStore* store, uint32_t index, const RectBounds& rect) {
+        RectBoundsColumns& bounds = store->bounds;
+        bounds.minX[index] = rect.minX;
+        bounds.minY[index] = rect.minY;
+        bounds.maxX[index] = rect.maxX;
+        bounds.maxY[index] = rect.maxY;
+    }
+
+    void storePreviousTransforms(EntityStore* store) {
+        memcpy(store->previousPositionX, store->transforms.positionX, sizeof(float) * store->count);
+        memcpy(store->previousPositionY, store->transforms.positionY, sizeof(float) * store->count);
+        memcpy(store->previousRotation, store->transforms.rotation, sizeof(float) * store->count);
+    }
+
+    void snapPreviousTransform(EntityStore* store, uint32_t index) {
+        store->previousPositionX[index] = store->transforms.positionX[index];
+        store->previousPositionY[index] = store->transforms.positionY[index];
+        store->previousRotation[index] = store->transforms.rotation[index];
+    }
+
+    // ------------------------------ SYSTEMS -----------------------------------
+
+    // These run over every live slot rather than filtering by component, which
+    // lets the kernels stream whole columns. That's safe because entities
+    // without a velocity always have a zero velocity, and bounds are simply
+    // ignored for entities that don't have COMPONENT_RECT_BOUNDS.
+
+    void applyVelocities(EntityStore* store) {
+        integrateBatch(&store->transforms, &store->velocities, store->count);
+    }
+
+    void clampToArena(EntityStore* store, uint32_t mask, float halfHeight) {
+        clampBatch(&store->transforms, store->componentMasks, mask | COMPONENT_TRANSFORM, halfHeight, store->count);
+    }
+
+    void computeRectBounds(EntityStore* store) {
+        computeBoundsBatch(&store->transforms, &store->bounds, store->count);
+    }
+
+    // Entities per job. A multiple of the column padding, so every batch but the
+    // last starts on a cache line and covers whole vectors.
+    constexpr uint32_t SYSTEM_BATCH_SIZE = 4096;
+
+    struct TransformJobData {
+        EntityStore* store;
+        uint32_t clampMask;
+        float halfHeight;
+    };
+
+    static void updateTransformsJob(void* data, uint32_t start, uint32_t end) {
+
+        auto* jobData = static_cast<TransformJobData*>(data);
+        EntityStore* store = jobData->store;
+        uint32_t count = end - start;
+
+        TransformColumns transforms = {
+            store->transforms.positionX + start, store->transforms.positionY + start,
+            store->transforms.scaleX + start, store->transforms.scaleY + start, store->transforms.rotation + start
+        };
+        VelocityColumns velocities = {
+            store->velocities.x + start, store->velocities.y + start, store->velocities.rotation + start
+        };
+        RectBoundsColumns bounds = {
+            store->bounds.minX + start, store->bounds.minY + start, store->bounds.maxX + start, store->bounds.maxY + start
+        };
+
+        integrateBatch(&transforms, &velocities, count);
+        clampBatch(&transforms, store->componentMasks + start, jobData->clampMask, jobData->halfHeight, count);
+        computeBoundsBatch(&transforms, &bounds, count);
+    }
+
+    void updateTransforms(EntityStore* store, uint32_t clampMask, float halfHeight, Jobs::JobSystem* jobs) {
+
+        TransformJobData jobData = { store, clampMask | COMPONENT_TRANSFORM, halfHeight };
+
+        if (!jobs || store->count <= SYSTEM_BATCH_SIZE) {
+            updateTransformsJob(&jobData, 0, store->count);
+            return;
+        }
+
+        Jobs::Counter counter;
+        Jobs::parallelFor(jobs, updateTransformsJob, &jobData, store->count, SYSTEM_BATCH_SIZE, &counter);
+        Jobs::waitForCounter(jobs, &counter);
+    }
+
+    void resetVelocities(EntityStore* store, uint32_t mask) {
+        for (uint32_t i = 0; i < store->count; i++) {
+            if ((store->componentMasks[i] & mask) != mask) continue;
+            store->velocities.x[i] = 0.0f;
+            store->velocities.y[i] = 0.0f;
+            store->velocities.rotation[i] = 0.0f;
+        }
+    }
+}
@@ -0,0 +1,152 @@
+#ifndef PONG_VK_ENTITIES_H
+#define PONG_VK_ENTITIES_H
+
+#include <cstdint>
+#include "components.h"
+#include "../jobs/jobs.h"
+
+namespace Pong {
+
+    // A handle to an entity in the store. The low 24 bits index into the sparse
+    // table, the top 8 bits are a generation counter which is bumped every time
+    // the index is recycled - so a stale handle to a destroyed entity is
+    // detected rather than silently pointing at whatever replaced it.
+    typedef uint32_t Entity;
+
+    constexpr uint32_t ENTITY_INDEX_BITS = 24;
+    constexpr uint32_t ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+    constexpr uint32_t MAX_ENTITIES = 1u << ENTITY_INDEX_BITS;
+    constexpr Entity NULL_ENTITY = UINT32_MAX;
+
+    // Component (and tag) flags. An entity's mask says which columns hold
+    // meaningful data for it. Tags carry no data of their own and only exist so
+    // systems can select e.g. 'every paddle'.
+    enum ComponentFlags : uint32_t {
+        COMPONENT_NONE          = 0,
+        COMPONENT_TRANSFORM     = 1 << 0,
+        COMPONENT_VELOCITY      = 1 << 1,
+        COMPONENT_RECT_BOUNDS   = 1 << 2,
+        TAG_PADDLE              = 1 << 3,
+        TAG_BALL                = 1 << 4,
+        TAG_OBSTACLE            = 1 << 5
+    };
+
+    // Every component is split into one column per field so that systems only
+    // pull the fields they actually touch into cache, and so each column can be
+    // processed several entities at a time.
+    struct TransformColumns {
+        float* positionX    {nullptr};
+        float* positionY    {nullptr};
+        float* scaleX       {nullptr};
+        float* scaleY       {nullptr};
+        float* rotation     {nullptr};
+    };
+
+    struct VelocityColumns {
+        float* x            {nullptr};
+        float* y            {nullptr};
+        float* rotation     {nullptr};
+    };
+
+    struct RectBoundsColumns {
+        float* minX         {nullptr};
+        float* minY         {nullptr};
+        float* maxX         {nullptr};
+        float* maxY         {nullptr};
+    };
+
+    // The store keeps all live entities densely packed in [0, count). Destroying
+    // an entity moves the last one into its slot, so the columns never contain
+    // holes. Since dense slots move around, entities are referred to through
+    // their handle and resolved to a slot with getEntityIndex().
+    struct EntityStore {
+        uint32_t capacity               {0};
+        uint32_t count                  {0};
+
+        TransformColumns transforms;
+        VelocityColumns velocities;
+        RectBoundsColumns bounds;
+        uint32_t* componentMasks        {nullptr};
+
+        // Transform state from the end of the previous tick, so rendering can
+        // interpolate between the last two ticks.
+        float* previousPositionX        {nullptr};
+        float* previousPositionY        {nullptr};
+        float* previousRotation         {nullptr};
+
+        // dense slot -> handle
+        Entity* entities                {nullptr};
+        // handle index -> dense slot
+        uint32_t* denseIndices          {nullptr};
+        uint8_t* generations            {nullptr};
+        // Handle indices which have been released and can be reused.
+        uint32_t* freeIndices           {nullptr};
+        uint32_t freeCount              {0};
+        uint32_t nextIndex              {0};
+    };
+
+    bool initialiseEntityStore(EntityStore*, uint32_t capacity);
+    void destroyEntityStore(EntityStore*);
+
+    // Returns NULL_ENTITY if the store is full.
+    Entity createEntity(EntityStore*, uint32_t componentMask = COMPONENT_NONE);
+    bool destroyEntity(EntityStore*, Entity);
+    bool isEntityAlive(const EntityStore*, Entity);
+
+    // Resolves a (live) handle to its current dense slot. Slots are only stable
+    // until the next call to destroyEntity().
+    inline uint32_t getEntityIndex(const EntityStore* store, Entity entity) {
+        return store->denseIndices[entity & ENTITY_INDEX_MASK];
+    }
+
+    inline bool hasComponents(const EntityStore* store, Entity entity, uint32_t mask) {
+        return (store->componentMasks[getEntityIndex(store, entity)] & mask) == mask;
+    }
+
+    void addComponents(EntityStore*, Entity, uint32_t mask);
+    void removeComponents(EntityStore*, Entity, uint32_t mask);
+
+    // Gather/scatter helpers for code which wants to work with a single entity
+    // as a struct (mostly collision response).
+    Transform getTransform(const EntityStore*, uint32_t index);
+    void setTransform(EntityStore*, uint32_t index, const Transform&);
+    Velocity getVelocity(const EntityStore*, uint32_t index);
+    void setVelocity(EntityStore*, uint32_t index, const Velocity&);
+    RectBounds getRectBounds(const EntityStore*, uint32_t index);
+    void setRectBounds(EntityStore*, uint32_t index, const RectBounds&);
+
+    // Copies the current transforms into the previous* columns. Called at the
+    // start of every tick.
+    void storePreviousTransforms(EntityStore*);
+    // Makes an entity's previous transform match its current one, so a teleport
+    // isn't smeared across a rendered frame.
+    void snapPreviousTransform(EntityStore*, uint32_t index);
+
+    // Calls fn(denseIndex) for every entity which has all of the requested
+    // components. The function must not create or destroy entities.
+    template <typename Fn>
+    inline void forEachEntity(EntityStore* store, uint32_t mask, Fn&& fn) {
+        for (uint32_t i = 0; i < store->count; i++) {
+            if ((store->componentMasks[i] & mask) == mask) fn(i);
+        }
+    }
+
+    // ------------------------------ SYSTEMS -------------------------------------
+    // Backed by the batch kernels in kernels.h.
+
+    // position += velocity for everything with a transform and velocity.
+    void applyVelocities(EntityStore*);
+    // Keeps everything matching the mask vertically inside [-halfHeight, halfHeight].
+    void clampToArena(EntityStore*, uint32_t mask, float halfHeight);
+    // Recomputes the bounds of everything with a transform and rect bounds.
+    void computeRectBounds(EntityStore*);
+    // Zeroes the velocity of everything matching the mask.
+    void resetVelocities(EntityStore*, uint32_t mask);
+
+    // Integrates, clamps and recomputes bounds in one pass over the columns.
+    // With a job system, large stores are split into batches which run in
+    // parallel.
+    void updateTransforms(EntityStore*, uint32_t clampMask, float halfHeight, Jobs::JobSystem* = nullptr);
+}
+
+#endif //PONG_VK_ENTITIES_H
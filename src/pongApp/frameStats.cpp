@@ -0,0 +1,201 @@
+#include "frameStats.h"
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include "../logger.h"
+
+namespace Pong {
+
+    // ---------------------------- HISTOGRAM ----------------------------------
+
+    static uint32_t bucketIndex(uint64_t value) {
+
+        if (value < HISTOGRAM_SUB_BUCKETS) return static_cast<uint32_t>(value);
+
+        // Frame times only ever span a few powers of two, so a simple scan is fine
+        // (and portable to 32-bit MSVC).
+        uint32_t msb = 0;
+        for (uint64_t remaining = value; remaining >>= 1;) msb++;
+        uint32_t shift = msb - HISTOGRAM_SUB_BUCKET_BITS;
+        uint32_t mantissa = static_cast<uint32_t>(value >> shift);
+
+        return HISTOGRAM_SUB_BUCKETS + shift * HISTOGRAM_SUB_BUCKETS + (mantissa - HISTOGRAM_SUB_BUCKETS);
+    }
+
+    // Returns the largest value which would be recorded in the given bucket.
+    static uint64_t bucketValue(uint32_t index) {
+
+        if (index < HISTOGRAM_SUB_BUCKETS) return index;
+
+        uint32_t shift = (index - HISTOGRAM_SUB_BUCKETS) / HISTOGRAM_SUB_BUCKETS;
+        uint64_t mantissa = HISTOGRAM_SUB_BUCKETS + (index - HISTOGRAM_SUB_BUCKETS) % HISTOGRAM_SUB_BUCKETS;
+
+        return (mantissa << shift) + ((1ull << shift) - 1);
+    }
+
+    void recordValue(Histogram* histogram, uint64_t value) {
+
+        uint64_t maxTrackable = (1ull << HISTOGRAM_MAX_BITS) - 1;
+        if (value > maxTrackable) value = maxTrackable;
+
+        histogram->counts[bucketIndex(value)]++;
+        histogram->totalCount++;
+        histogram->sum += value;
+        if (value > histogram->maxValue) histogram->maxValue = value;
+    }
+
+    uint64_t valueAtPercentile(const Histogram* histogram, double percentile) {
+
+        if (histogram->totalCount == 0) return 0;
+
+        // The rank of the sample we're looking for (1-based).
+        auto target = static_cast<uint64_t>(std::ceil((percentile / 100.0) * histogram->totalCount));
+        if (target == 0) target = 1;
+
+        uint64_t cumulative = 0;
+        for (uint32_t i = 0; i < HISTOGRAM_BUCKET_COUNT; i++) {
+            cumulative += histogram->counts[i];
+            if (cumulative >= target) {
+                uint64_t value = bucketValue(i);
+                return value < histogram->maxValue ? value : histogram->maxValue;
+            }
+        }
+
+        return histogram->maxValue;
+    }
+
+    HistogramSummary summariseHistogram(const Histogram* histogram) {
+
+        HistogramSummary summary;
+        summary.count = histogram->totalCount;
+        summary.mean = histogram->totalCount ? histogram->sum / histogram->totalCount : 0;
+        summary.p50 = valueAtPercentile(histogram, 50.0);
+        summary.p90 = valueAtPercentile(histogram, 90.0);
+        summary.p99 = valueAtPercentile(histogram, 99.0);
+        summary.max = histogram->maxValue;
+
+        return summary;
+    }
+
+    void resetHistogram(Histogram* histogram) {
+        memset(histogram->counts, 0, sizeof(histogram->counts));
+        histogram->totalCount = 0;
+        histogram->maxValue = 0;
+        histogram->sum = 0;
+    }
+
+    // --------------------------- FRAME STATS ---------------------------------
+
+    static void recordTiming(FrameTimings* timings, uint64_t value) {
+        recordValue(&timings->interval, value);
+        recordValue(&timings->session, value);
+    }
+
+    void recordFrame(FrameStats* stats, uint64_t cpuMicros, int64_t gpuMicros, uint64_t presentMicros) {
+
+        recordTiming(&stats->cpuTime, cpuMicros);
+        if (gpuMicros >= 0) recordTiming(&stats->gpuTime, static_cast<uint64_t>(gpuMicros));
+        recordTiming(&stats->presentInterval, presentMicros);
+
+        if (presentMicros > stats->hitchThresholdMicros) {
+            stats->intervalHitches++;
+            stats->sessionHitches++;
+        }
+
+        stats->intervalSeconds += presentMicros / 1e6;
+        stats->sessionSeconds += presentMicros / 1e6;
+    }
+
+    void recordLatency(FrameStats* stats, uint64_t submitMicros, uint64_t presentMicros, int64_t displayMicros) {
+
+        recordTiming(&stats->inputToSubmit, submitMicros);
+        recordTiming(&stats->inputToPresent, presentMicros);
+        if (displayMicros >= 0) recordTiming(&stats->inputToDisplay, static_cast<uint64_t>(displayMicros));
+    }
+
+    static void logSummary(const char* name, const Histogram* histogram) {
+
+        if (histogram->totalCount == 0) return;
+
+        HistogramSummary summary = summariseHistogram(histogram);
+
+        PONG_TRACE("  {0}: p50 {1:.2f}ms | p90 {2:.2f}ms | p99 {3:.2f}ms | max {4:.2f}ms", name,
+            summary.p50 / 1000.0, summary.p90 / 1000.0, summary.p99 / 1000.0, summary.max / 1000.0);
+    }
+
+    void reportFrameStatsInterval(FrameStats* stats) {
+
+        double hitchesPerSecond = stats->intervalSeconds > 0.0 ? stats->intervalHitches / stats->intervalSeconds : 0.0;
+
+        PONG_TRACE("FRAMES: {0} | hitches: {1} ({2:.2f}/s)", stats->presentInterval.interval.totalCount,
+            stats->intervalHitches, hitchesPerSecond);
+
+        const char* names[] = { "cpu          ", "gpu          ", "present      ",
+            "in->submit   ", "in->present  ", "in->display  " };
+        FrameTimings* timings[] = {
+            &stats->cpuTime, &stats->gpuTime, &stats->presentInterval,
+            &stats->inputToSubmit, &stats->inputToPresent, &stats->inputToDisplay
+        };
+
+        for (size_t i = 0; i < sizeof(timings) / sizeof(timings[0]); i++) {
+            logSummary(names[i], &timings[i]->interval);
+            resetHistogram(&timings[i]->interval);
+        }
+        stats->intervalHitches = 0;
+        stats->intervalSeconds = 0.0;
+    }
+
+    static void writeSummaryRow(FILE* file, const char* name, const Histogram* histogram) {
+        HistogramSummary summary = summariseHistogram(histogram);
+        fprintf(file, "%s,%llu,%llu,%llu,%llu,%llu,%llu\n", name,
+            static_cast<unsigned long long>(summary.count), static_cast<unsigned long long>(summary.mean),
+            static_cast<unsigned long long>(summary.p50), static_cast<unsigned long long>(summary.p90),
+            static_cast<unsigned long long>(summary.p99), static_cast<unsigned long long>(summary.max));
+    }
+
+    void dumpFrameStats(const FrameStats* stats, const char* path) {
+
+        PONG_INFO("Session frame stats ({0} frames, {1} hitches over {2:.1f}s):",
+            stats->presentInterval.session.totalCount, stats->sessionHitches, stats->sessionSeconds);
+
+        const char* names[] = { "cpu", "gpu", "present", "input_to_submit", "input_to_present", "input_to_display" };
+        const Histogram* histograms[] = {
+            &stats->cpuTime.session, &stats->gpuTime.session, &stats->presentInterval.session,
+            &stats->inputToSubmit.session, &stats->inputToPresent.session, &stats->inputToDisplay.session
+        };
+        const size_t metricCount = sizeof(histograms) / sizeof(histograms[0]);
+
+        for (size_t i = 0; i < metricCount; i++) {
+            if (histograms[i]->totalCount == 0) continue;
+            HistogramSummary summary = summariseHistogram(histograms[i]);
+            PONG_INFO("  {0}: p50 {1:.2f}ms | p90 {2:.2f}ms | p99 {3:.2f}ms | max {4:.2f}ms", names[i],
+                summary.p50 / 1000.0, summary.p90 / 1000.0, summary.p99 / 1000.0, summary.max / 1000.0);
+        }
+
+        if (!path) return;
+
+        FILE* file = fopen(path, "w");
+        if (!file) {
+            PONG_ERROR("Failed to open frame stats file: {0}", path);
+            return;
+        }
+
+        // All values are in microseconds.
+        fprintf(file, "metric,count,mean,p50,p90,p99,max\n");
+        for (size_t i = 0; i < metricCount; i++) {
+            writeSummaryRow(file, names[i], histograms[i]);
+        }
+
+        fprintf(file, "\nhitch_threshold,%llu\nhitches,%llu\n\npresent_bucket_max,count\n",
+            static_cast<unsigned long long>(stats->hitchThresholdMicros),
+            static_cast<unsigned long long>(stats->sessionHitches));
+
+        for (uint32_t i = 0; i < HISTOGRAM_BUCKET_COUNT; i++) {
+            if (stats->presentInterval.session.counts[i] == 0) continue;
+            fprintf(file, "%llu,%llu\n", static_cast<unsigned long long>(bucketValue(i)),
+                static_cast<unsigned long long>(stats->presentInterval.session.counts[i]));
+        }
+
+        fclose(file);
+    }
+}
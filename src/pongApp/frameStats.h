@@ -0,0 +1,76 @@
+#ifndef PONG_VK_FRAMESTATS_H
+#define PONG_VK_FRAMESTATS_H
+
+#include <cstdint>
+
+namespace Pong {
+
+    // A log-linear (HDR-style) histogram of microsecond values. Each power of two
+    // is split into 32 linear sub-buckets, so any recorded value is reproduced
+    // to within ~3% while the whole histogram stays a fixed 7KB. Recording
+    // finds the value's highest set bit (a short loop over its bits), then
+    // takes a couple of shifts and an increment.
+    constexpr uint32_t HISTOGRAM_SUB_BUCKET_BITS = 5;
+    constexpr uint32_t HISTOGRAM_SUB_BUCKETS = 1u << HISTOGRAM_SUB_BUCKET_BITS;
+    // Values up to 2^32us (a bit over an hour) - anything larger is clamped.
+    constexpr uint32_t HISTOGRAM_MAX_BITS = 32;
+    constexpr uint32_t HISTOGRAM_BUCKET_COUNT =
+        HISTOGRAM_SUB_BUCKETS * (HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BUCKET_BITS + 1);
+
+    struct Histogram {
+        uint64_t counts[HISTOGRAM_BUCKET_COUNT]     {0};
+        uint64_t totalCount                         {0};
+        uint64_t maxValue                           {0};
+        uint64_t sum                                {0};
+    };
+
+    struct HistogramSummary {
+        uint64_t count  {0};
+        uint64_t mean   {0};
+        uint64_t p50    {0};
+        uint64_t p90    {0};
+        uint64_t p99    {0};
+        uint64_t max    {0};
+    };
+
+    void recordValue(Histogram*, uint64_t);
+    uint64_t valueAtPercentile(const Histogram*, double);
+    HistogramSummary summariseHistogram(const Histogram*);
+    void resetHistogram(Histogram*);
+
+    // Per-frame timings. Each metric keeps a histogram for the current reporting
+    // interval and one for the whole session.
+    struct FrameTimings {
+        Histogram interval;
+        Histogram session;
+    };
+
+    struct FrameStats {
+        FrameTimings cpuTime;
+        FrameTimings gpuTime;
+        FrameTimings presentInterval;
+        // Time from an input event to the first frame responding to it being
+        // submitted, handed to the presentation engine, and shown on screen.
+        FrameTimings inputToSubmit;
+        FrameTimings inputToPresent;
+        FrameTimings inputToDisplay;
+        // Any present interval above this counts as a hitch.
+        uint64_t hitchThresholdMicros   {33333};
+        uint64_t intervalHitches        {0};
+        uint64_t sessionHitches         {0};
+        double intervalSeconds          {0.0};
+        double sessionSeconds           {0.0};
+    };
+
+    // Pass a negative GPU time when none is available (e.g. the null renderer).
+    void recordFrame(FrameStats*, uint64_t cpuMicros, int64_t gpuMicros, uint64_t presentMicros);
+    // Pass a negative display time when present completion can't be measured.
+    void recordLatency(FrameStats*, uint64_t submitMicros, uint64_t presentMicros, int64_t displayMicros);
+    // Logs the current interval and starts a new one.
+    void reportFrameStatsInterval(FrameStats*);
+    // Logs the whole-session percentiles and optionally writes them, plus the raw
+    // present interval histogram, to a CSV file.
+    void dumpFrameStats(const FrameStats*, const char* = nullptr);
+}
+
+#endif //PONG_VK_FRAMESTATS_H
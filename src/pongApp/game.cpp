@@ -0,0 +1,468 @@
+#include "game.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "components.h"
+#include "kernels.h"
+#include "../clock.h"
+#include "../logger.h"
+
+namespace Pong {
+
+    const float BALL_VELOCITY = 800.0f;
+    const float PADDLE_VELOCITY = 500.0f;
+    // Broadphase grid cell size - roughly the size of a paddle.
+    const float COLLISION_CELL_SIZE = 64.0f;
+    // A ball can bounce off at most this many surfaces in a single tick.
+    const uint32_t MAX_BALL_BOUNCES = 4;
+    // Upper bound on paddles the ball can reach in a single tick.
+    const uint32_t MAX_BALL_CANDIDATES = 16;
+    // Starting size of the per-tick scratch arena - it grows to fit if a tick needs more.
+    const size_t TICK_ARENA_SIZE = 64 * 1024;
+
+    static void addImpact(GameState* game, glm::vec2 position, glm::vec2 normal) {
+        if (game->impactCount < MAX_IMPACTS) game->impacts[game->impactCount++] = { position, normal };
+    }
+
+    bool initialiseGame(GameState* game, glm::vec2 arenaHalfSize, uint32_t entityCapacity) {
+
+        *game = GameState{};
+        game->arenaHalfSize = arenaHalfSize;
+
+        if (!initialiseEntityStore(&game->entities, entityCapacity)) return false;
+
+        if (!Memory::initialiseArena(&game->tickArena, "tick", TICK_ARENA_SIZE)) {
+            destroyEntityStore(&game->entities);
+            return false;
+        }
+
+        // The grid covers the starting arena - anything outside of it after a resize
+        // still collides, it just ends up sharing the border cells.
+        if (!initialiseBroadphase(&game->broadphase, -arenaHalfSize.x, -arenaHalfSize.y,
+            arenaHalfSize.x, arenaHalfSize.y, COLLISION_CELL_SIZE, entityCapacity)) {
+            Memory::destroyArena(&game->tickArena);
+            destroyEntityStore(&game->entities);
+            return false;
+        }
+
+        EntityStore* entities = &game->entities;
+
+        const uint32_t paddleComponents = COMPONENT_TRANSFORM | COMPONENT_VELOCITY
+            | COMPONENT_RECT_BOUNDS | TAG_PADDLE;
+        const uint32_t ballComponents = COMPONENT_TRANSFORM | COMPONENT_VELOCITY
+            | COMPONENT_RECT_BOUNDS | TAG_BALL;
+
+        game->paddleA = createEntity(entities, paddleComponents);
+        game->paddleB = createEntity(entities, paddleComponents);
+        game->ball = createEntity(entities, ballComponents);
+
+        setTransform(entities, getEntityIndex(entities, game->paddleA), { {-375.0f, 0.0f}, {20.0f, 75.0f} });
+        setTransform(entities, getEntityIndex(entities, game->paddleB), { {375.0f, 0.0f}, {20.0f, 75.0f} });
+        setTransform(entities, getEntityIndex(entities, game->ball), { {0.0f, 0.0f}, {20.0f, 20.0f} });
+
+        computeRectBounds(entities);
+        storePreviousTransforms(entities);
+
+        return true;
+    }
+
+    void destroyGame(GameState* game) {
+        if (game->tickArena.allocationCount > 0) Memory::logArenaUsage(&game->tickArena);
+        Memory::destroyArena(&game->tickArena);
+        destroyBroadphase(&game->broadphase);
+        destroyEntityStore(&game->entities);
+    }
+
+    bool spawnStressEntities(GameState* game, uint32_t ballCount, uint32_t obstacleCount, uint32_t seed,
+        float tickDelta) {
+
+        EntityStore* entities = &game->entities;
+
+        if (entities->capacity - entities->count < static_cast<uint64_t>(ballCount) + obstacleCount) {
+            PONG_ERROR("Not enough room for {0} balls and {1} obstacles ({2} of {3} entities free)", ballCount,
+                obstacleCount, entities->capacity - entities->count, entities->capacity);
+            return false;
+        }
+
+        // Small LCG so a given seed always spawns the same scene.
+        uint32_t state = seed;
+        auto random = [&state](float min, float max) {
+            state = state * 1664525u + 1013904223u;
+            return min + (max - min) * static_cast<float>(state >> 8) / static_cast<float>(1u << 24);
+        };
+
+        glm::vec2 arena = game->arenaHalfSize;
+
+        // Obstacles stay clear of the paddles' lanes so they can't box a paddle in.
+        for (uint32_t i = 0; i < obstacleCount; i++) {
+            Entity obstacle = createEntity(entities, COMPONENT_TRANSFORM | COMPONENT_RECT_BOUNDS | TAG_OBSTACLE);
+            if (obstacle == NULL_ENTITY) {
+                PONG_ERROR("Entity store filled up after {0} of {1} obstacles", i, obstacleCount);
+                return false;
+            }
+
+            setTransform(entities, getEntityIndex(entities, obstacle), {
+                { random(-arena.x * 0.8f, arena.x * 0.8f), random(-arena.y, arena.y) },
+                { random(10.0f, 60.0f), random(10.0f, 60.0f) }
+            });
+        }
+
+        for (uint32_t i = 0; i < ballCount; i++) {
+            Entity ball = createEntity(entities, COMPONENT_TRANSFORM | COMPONENT_VELOCITY
+                | COMPONENT_RECT_BOUNDS | TAG_BALL);
+            if (ball == NULL_ENTITY) {
+                PONG_ERROR("Entity store filled up after {0} of {1} balls", i, ballCount);
+                return false;
+            }
+
+            uint32_t index = getEntityIndex(entities, ball);
+
+            float size = random(4.0f, 16.0f);
+            float angle = glm::radians(random(0.0f, 360.0f));
+            float speed = random(100.0f, 600.0f) * tickDelta;
+
+            setTransform(entities, index, { { random(-arena.x, arena.x), random(-arena.y, arena.y) }, { size, size } });
+            setVelocity(entities, index, { { std::cos(angle) * speed, std::sin(angle) * speed } });
+        }
+
+        game->stressBallCount += ballCount;
+
+        computeRectBounds(entities);
+        storePreviousTransforms(entities);
+
+        PONG_INFO("Spawned {0} balls and {1} obstacles", ballCount, obstacleCount);
+        return true;
+    }
+
+    // The stress balls' velocities are never reset, so they keep moving in a
+    // straight line until they hit something. Their contacts all go through the
+    // batched narrowphase in one call.
+    static void updateStressBalls(GameState* game, uint32_t ballIndex) {
+
+        EntityStore* entities = &game->entities;
+        const Broadphase* broadphase = &game->broadphase;
+        const uint32_t* masks = entities->componentMasks;
+
+        float* positionX = entities->transforms.positionX;
+        float* positionY = entities->transforms.positionY;
+        float* velocityX = entities->velocities.x;
+        float* velocityY = entities->velocities.y;
+
+        auto* stressPairs = Memory::allocateArray<CollisionPair>(&game->tickArena, broadphase->pairCount,
+            Memory::MemoryTag::SIMULATION);
+        auto* stressContacts = Memory::allocateArray<Contact>(&game->tickArena, broadphase->pairCount,
+            Memory::MemoryTag::SIMULATION);
+
+        if (!stressPairs || !stressContacts) return;
+
+        uint32_t pairCount = 0;
+
+        for (uint32_t pair = 0; pair < broadphase->pairCount; pair++) {
+            uint32_t a = broadphase->pairs[pair].a;
+            uint32_t b = broadphase->pairs[pair].b;
+
+            bool isStressA = (masks[a] & TAG_BALL) && a != ballIndex;
+            bool isStressB = (masks[b] & TAG_BALL) && b != ballIndex;
+            if (isStressA == isStressB) continue;
+
+            uint32_t ball = isStressA ? a : b;
+            uint32_t other = isStressA ? b : a;
+            if (!(masks[other] & (TAG_PADDLE | TAG_OBSTACLE))) continue;
+
+            stressPairs[pairCount++] = { ball, other };
+        }
+
+        computeContactsBatch(&entities->bounds, stressPairs, pairCount, stressContacts);
+
+        for (uint32_t c = 0; c < pairCount; c++) {
+            const Contact& contact = stressContacts[c];
+            if (contact.penetration <= 0.0f) continue;
+
+            uint32_t i = stressPairs[c].a;
+            positionX[i] += contact.normalX * contact.penetration;
+            positionY[i] += contact.normalY * contact.penetration;
+
+            if (contact.normalX != 0.0f) {
+                velocityX[i] = glm::abs(velocityX[i]) * contact.normalX;
+            } else {
+                velocityY[i] = glm::abs(velocityY[i]) * contact.normalY;
+            }
+        }
+
+        // Arena walls - all four of them, there's no scoring for these balls.
+        glm::vec2 arena = game->arenaHalfSize;
+
+        for (uint32_t i = 0; i < entities->count; i++) {
+            if (!(masks[i] & TAG_BALL) || i == ballIndex) continue;
+
+            float halfX = entities->transforms.scaleX[i] * 0.5f;
+            float halfY = entities->transforms.scaleY[i] * 0.5f;
+
+            if (positionX[i] - halfX < -arena.x) velocityX[i] = glm::abs(velocityX[i]);
+            else if (positionX[i] + halfX > arena.x) velocityX[i] = -glm::abs(velocityX[i]);
+
+            if (positionY[i] - halfY < -arena.y) velocityY[i] = glm::abs(velocityY[i]);
+            else if (positionY[i] + halfY > arena.y) velocityY[i] = -glm::abs(velocityY[i]);
+        }
+    }
+
+    void tickGame(GameState* game, TickInput input, float deltaTime, Jobs::JobSystem* jobs) {
+
+        EntityStore* entities = &game->entities;
+        glm::vec2& ballDirection = game->ballDirection;
+        glm::vec2 windowSize = game->arenaHalfSize;
+
+        Memory::resetArena(&game->tickArena);
+        storePreviousTransforms(entities);
+
+        // No entities are created or destroyed mid-tick, so these stay valid until the end of it.
+        uint32_t paddleAIndex = getEntityIndex(entities, game->paddleA);
+        uint32_t paddleBIndex = getEntityIndex(entities, game->paddleB);
+        uint32_t ballIndex = getEntityIndex(entities, game->ball);
+
+        float* velocityY = entities->velocities.y;
+        float* positionX = entities->transforms.positionX;
+        float* positionY = entities->transforms.positionY;
+        float* scaleY = entities->transforms.scaleY;
+
+        // Input
+        if (input.buttons & INPUT_PADDLE_A_UP) {
+            velocityY[paddleAIndex] += (PADDLE_VELOCITY * deltaTime);
+        }
+        if (input.buttons & INPUT_PADDLE_A_DOWN) {
+            velocityY[paddleAIndex] -= (PADDLE_VELOCITY * deltaTime);
+        }
+
+        if (input.buttons & INPUT_PADDLE_B_UP) {
+            velocityY[paddleBIndex] += (PADDLE_VELOCITY * deltaTime);
+        }
+        if (input.buttons & INPUT_PADDLE_B_DOWN) {
+            velocityY[paddleBIndex] -= (PADDLE_VELOCITY * deltaTime);
+        }
+
+        // Game Logic
+        // The ball isn't integrated with everything else - it's swept against the
+        // paddles below so it can't tunnel through them, however large the step.
+        glm::vec2 ballDisplacement {0.0f, 0.0f};
+        if (ballDirection != glm::vec2(0.0f)) {
+            ballDisplacement = (BALL_VELOCITY * glm::normalize(ballDirection)) * deltaTime;
+        }
+
+        uint64_t stageStart = Clock::nowNanos();
+
+        updateTransforms(entities, TAG_PADDLE, windowSize.y, jobs);
+
+        uint64_t stageEnd = Clock::nowNanos();
+        game->stageTimes.transformNanos += stageEnd - stageStart;
+        stageStart = stageEnd;
+
+        // AABB Collisions
+        Transform ballTransform = getTransform(entities, ballIndex);
+        RectBounds ballBounds = getRectBounds(entities, ballIndex);
+
+        // Bin the ball by the whole area it sweeps through this tick, so the
+        // broadphase returns every paddle it could possibly reach.
+        entities->bounds.minX[ballIndex] = std::min(ballBounds.minX, ballBounds.minX + ballDisplacement.x);
+        entities->bounds.minY[ballIndex] = std::min(ballBounds.minY, ballBounds.minY + ballDisplacement.y);
+        entities->bounds.maxX[ballIndex] = std::max(ballBounds.maxX, ballBounds.maxX + ballDisplacement.x);
+        entities->bounds.maxY[ballIndex] = std::max(ballBounds.maxY, ballBounds.maxY + ballDisplacement.y);
+
+        updateBroadphase(&game->broadphase, entities, COMPONENT_RECT_BOUNDS, jobs);
+
+        stageEnd = Clock::nowNanos();
+        game->stageTimes.broadphaseNanos += stageEnd - stageStart;
+        stageStart = stageEnd;
+
+        // Only ball vs paddle collisions are handled for now.
+        uint32_t ballCandidates[MAX_BALL_CANDIDATES];
+        uint32_t candidateCount = 0;
+
+        for (uint32_t pair = 0; pair < game->broadphase.pairCount && candidateCount < MAX_BALL_CANDIDATES; pair++) {
+            CollisionPair candidate = game->broadphase.pairs[pair];
+            if (candidate.a != ballIndex && candidate.b != ballIndex) continue;
+
+            uint32_t i = candidate.a == ballIndex ? candidate.b : candidate.a;
+            if (entities->componentMasks[i] & TAG_PADDLE) ballCandidates[candidateCount++] = i;
+        }
+
+        // Continuous collision: move the ball to the earliest contact, bounce, and
+        // carry on with whatever distance is left.
+        for (uint32_t bounce = 0; bounce < MAX_BALL_BOUNCES && ballDisplacement != glm::vec2(0.0f); bounce++) {
+
+            SweepHit earliest;
+            uint32_t hitIndex = UINT32_MAX;
+
+            for (uint32_t c = 0; c < candidateCount; c++) {
+                SweepHit hit;
+                if (sweepRectBounds(ballBounds, ballDisplacement, getRectBounds(entities, ballCandidates[c]), hit)
+                    && hit.time < earliest.time) {
+                    earliest = hit;
+                    hitIndex = ballCandidates[c];
+                }
+            }
+
+            ballTransform.position += ballDisplacement * earliest.time;
+            updateRectBounds(ballBounds, ballTransform);
+
+            if (hitIndex == UINT32_MAX) break;
+
+            addImpact(game, ballTransform.position, earliest.normal);
+
+            if (earliest.normal.x != 0.0f) {
+                // Hitting the face of a paddle - the further from its centre, the steeper the bounce.
+                float distanceFromCentre = ballTransform.position.y - positionY[hitIndex];
+                ballDirection.x = -ballDirection.x;
+                ballDirection.y = std::clamp(distanceFromCentre / (scaleY[hitIndex] * 0.5f), -1.0f, 1.0f);
+            } else {
+                ballDirection.y = -ballDirection.y;
+            }
+
+            float remaining = glm::length(ballDisplacement) * (1.0f - earliest.time);
+            ballDisplacement = remaining * glm::normalize(ballDirection);
+        }
+
+        // Discrete fallback for when a paddle moves into the ball rather than the
+        // other way around - the sweep above ignores boxes which already overlap.
+        CollisionPair ballPairs[MAX_BALL_CANDIDATES];
+        Contact contacts[MAX_BALL_CANDIDATES];
+
+        setRectBounds(entities, ballIndex, ballBounds);
+        for (uint32_t c = 0; c < candidateCount; c++) ballPairs[c] = { ballIndex, ballCandidates[c] };
+        computeContactsBatch(&entities->bounds, ballPairs, candidateCount, contacts);
+
+        for (uint32_t c = 0; c < candidateCount; c++) {
+            const Contact& contact = contacts[c];
+            if (contact.penetration <= 0.0f) continue;
+
+            ballTransform.position += glm::vec2(contact.normalX, contact.normalY) * contact.penetration;
+            addImpact(game, ballTransform.position, { contact.normalX, contact.normalY });
+
+            if (contact.normalX != 0.0f) {
+                // Pushed out of the face of a paddle - same bounce as a swept hit.
+                ballDirection.x = glm::abs(ballDirection.x) * contact.normalX;
+                ballDirection.y = contact.offset;
+            } else {
+                ballDirection.y = glm::abs(ballDirection.y) * contact.normalY;
+            }
+        }
+
+        setTransform(entities, ballIndex, ballTransform);
+        updateRectBounds(ballBounds, ballTransform);
+        setRectBounds(entities, ballIndex, ballBounds);
+
+        stageEnd = Clock::nowNanos();
+        game->stageTimes.ballNanos += stageEnd - stageStart;
+        stageStart = stageEnd;
+
+        if (game->stressBallCount > 0) {
+            updateStressBalls(game, ballIndex);
+
+            stageEnd = Clock::nowNanos();
+            game->stageTimes.stressNanos += stageEnd - stageStart;
+        }
+
+        // Handle horizontal collisions with side of field.
+        if (!game->isResetting) {
+            if ((ballBounds.maxX > windowSize.x) || ballBounds.minX < -windowSize.x) {
+
+                float side = glm::sign(positionX[ballIndex]);
+                addImpact(game, { side * windowSize.x, positionY[ballIndex] }, { -side, 0.0f });
+
+                positionX[ballIndex] = 0.0f;
+                positionY[ballIndex] = 0.0f;
+                // The ball teleports back to the centre - don't interpolate across the field.
+                snapPreviousTransform(entities, ballIndex);
+                game->oldDirection = ballDirection;
+                ballDirection = {0.0f,0.0f};
+                game->isResetting = true;
+
+            } else if ((ballBounds.maxY > windowSize.y) || ballBounds.minY < -windowSize.y) {
+                if (glm::sign(ballDirection.y) == 1) {
+                    positionY[ballIndex] = windowSize.y - scaleY[ballIndex];
+                } else if (glm::sign(ballDirection.y) == -1) {
+                    positionY[ballIndex] = -windowSize.y + scaleY[ballIndex];
+                }
+                addImpact(game, { positionX[ballIndex], positionY[ballIndex] }, { 0.0f, -glm::sign(ballDirection.y) });
+                ballDirection.y = -ballDirection.y;
+            }
+        } else {
+            game->resetElapsed += deltaTime;
+            if (game->resetElapsed >= 1.0f) {
+                ballDirection.x = -game->oldDirection.x;
+                ballDirection.y = 0;
+                game->resetElapsed = 0.0f;
+                game->isResetting = false;
+            }
+        }
+
+        // Paddle velocities come from this tick's input only.
+        resetVelocities(entities, TAG_PADDLE);
+
+        game->tick++;
+    }
+
+    // --------------------------- RENDER SNAPSHOT ------------------------------
+
+    bool initialiseRenderSnapshot(RenderSnapshot* snapshot, uint32_t capacity) {
+
+        *snapshot = RenderSnapshot{};
+        snapshot->capacity = capacity;
+
+        snapshot->positionX = static_cast<float*>(malloc(sizeof(float) * capacity));
+        snapshot->positionY = static_cast<float*>(malloc(sizeof(float) * capacity));
+        snapshot->rotation = static_cast<float*>(malloc(sizeof(float) * capacity));
+        snapshot->scaleX = static_cast<float*>(malloc(sizeof(float) * capacity));
+        snapshot->scaleY = static_cast<float*>(malloc(sizeof(float) * capacity));
+
+        if (!snapshot->positionX || !snapshot->positionY || !snapshot->rotation
+            || !snapshot->scaleX || !snapshot->scaleY) {
+            PONG_ERROR("Failed to allocate render snapshot for {0} entities", capacity);
+            destroyRenderSnapshot(snapshot);
+            return false;
+        }
+
+        return true;
+    }
+
+    void destroyRenderSnapshot(RenderSnapshot* snapshot) {
+        free(snapshot->positionX);
+        free(snapshot->positionY);
+        free(snapshot->rotation);
+        free(snapshot->scaleX);
+        free(snapshot->scaleY);
+        *snapshot = RenderSnapshot{};
+    }
+
+    void buildRenderSnapshot(const GameState* game, float alpha, RenderSnapshot* snapshot) {
+
+        const EntityStore& entities = game->entities;
+        const TransformColumns& transforms = entities.transforms;
+
+        uint32_t count = 0;
+
+        for (uint32_t i = 0; i < entities.count && count < snapshot->capacity; i++) {
+            if (!(entities.componentMasks[i] & COMPONENT_TRANSFORM)) continue;
+
+            snapshot->positionX[count] = glm::mix(entities.previousPositionX[i], transforms.positionX[i], alpha);
+            snapshot->positionY[count] = glm::mix(entities.previousPositionY[i], transforms.positionY[i], alpha);
+            snapshot->rotation[count] = glm::mix(entities.previousRotation[i], transforms.rotation[i], alpha);
+            snapshot->scaleX[count] = transforms.scaleX[i];
+            snapshot->scaleY[count] = transforms.scaleY[i];
+            count++;
+        }
+
+        snapshot->count = count;
+
+        // Where they are as of the last tick - not worth interpolating for
+        // something that's only collided against.
+        const Entity paddles[] = { game->paddleA, game->paddleB };
+        snapshot->paddleCount = 0;
+
+        for (Entity paddle : paddles) {
+            if (!isEntityAlive(&entities, paddle)) continue;
+
+            RectBounds bounds = getRectBounds(&entities, getEntityIndex(&entities, paddle));
+            snapshot->paddleBounds[snapshot->paddleCount++] = { bounds.minX, bounds.minY, bounds.maxX, bounds.maxY };
+        }
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef PONG_VK_GAME_H
+#define PONG_VK_GAME_H
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "entities.h"
+#include "broadphase.h"
+#include "kernels.h"
+#include "../jobs/jobs.h"
+#include "../memory/arena.h"
+
+namespace Pong {
+
+    // Everything the player can do in a single tick, packed as a bitset. The
+    // simulation only ever sees this - never the window - so a tick's result
+    // depends purely on the previous state and its input.
+    enum TickInputFlags : uint8_t {
+        INPUT_NONE              = 0,
+        INPUT_PADDLE_A_UP       = 1 << 0,
+        INPUT_PADDLE_A_DOWN     = 1 << 1,
+        INPUT_PADDLE_B_UP       = 1 << 2,
+        INPUT_PADDLE_B_DOWN     = 1 << 3
+    };
+
+    struct TickInput {
+        uint8_t buttons {INPUT_NONE};
+    };
+
+    // Time spent in each stage of tickGame, summed over every tick since the
+    // caller last cleared it.
+    struct TickStageTimes {
+        uint64_t transformNanos     {0};
+        uint64_t broadphaseNanos    {0};
+        uint64_t ballNanos          {0};
+        uint64_t stressNanos        {0};
+    };
+
+    // Something the ball bounced off, or went out past, for effects to react to.
+    struct Impact {
+        glm::vec2 position;
+        // Points away from whatever was hit - back into the field for a goal.
+        glm::vec2 normal;
+    };
+
+    // Impacts held until the caller gets round to them - any more are dropped.
+    constexpr uint32_t MAX_IMPACTS = 16;
+
+    struct GameState {
+        EntityStore entities;
+        Broadphase broadphase;
+
+        Entity paddleA                  {NULL_ENTITY};
+        Entity paddleB                  {NULL_ENTITY};
+        Entity ball                     {NULL_ENTITY};
+
+        // Half the width and height of the playing field.
+        glm::vec2 arenaHalfSize         {400.0f, 300.0f};
+
+        glm::vec2 ballDirection         {1.0f, 0.0f};
+        glm::vec2 oldDirection          {1.0f, 0.0f};
+        bool isResetting                {false};
+        float resetElapsed              {0.0f};
+
+        uint64_t tick                   {0};
+
+        // Balls added by spawnStressEntities.
+        uint32_t stressBallCount        {0};
+
+        // Added to by every tick and only cleared by whoever reacts to them, so
+        // none are missed when several ticks run between frames. Purely for
+        // show - the simulation never reads them back.
+        Impact impacts[MAX_IMPACTS];
+        uint32_t impactCount            {0};
+
+        // Scratch memory which only lives for one tick - reset at the start of each.
+        Memory::Arena tickArena;
+
+        TickStageTimes stageTimes;
+    };
+
+    // Everything needed to draw a frame, copied out of the game state so that
+    // the next ticks can be simulated while this one is being rendered.
+    struct RenderSnapshot {
+        uint32_t count          {0};
+        uint32_t capacity       {0};
+        float* positionX        {nullptr};
+        float* positionY        {nullptr};
+        float* rotation         {nullptr};
+        float* scaleX           {nullptr};
+        float* scaleY           {nullptr};
+        // Clock::nowNanos() of the input this snapshot is the first to respond
+        // to, 0 if there was none.
+        uint64_t inputNanos     {0};
+        // The paddles as (minX, minY, maxX, maxY), for anything the renderer
+        // simulates itself to bounce off.
+        glm::vec4 paddleBounds[2];
+        uint32_t paddleCount    {0};
+    };
+
+    bool initialiseGame(GameState*, glm::vec2 arenaHalfSize, uint32_t entityCapacity);
+    void destroyGame(GameState*);
+
+    // Adds 'ballCount' extra balls and 'obstacleCount' static obstacles with
+    // random sizes, positions and (for balls) velocities, all from 'seed'. The
+    // extra balls travel at a constant speed given the fixed 'tickDelta' the game
+    // will be ticked at, and bounce off the walls, paddles and obstacles - but
+    // not each other. For exercising the simulation and renderer at scale.
+    bool spawnStressEntities(GameState*, uint32_t ballCount, uint32_t obstacleCount, uint32_t seed, float tickDelta);
+
+    // Advances the simulation by exactly one fixed step. Systems are spread
+    // across the job system if one is given.
+    void tickGame(GameState*, TickInput, float deltaTime, Jobs::JobSystem* = nullptr);
+
+    bool initialiseRenderSnapshot(RenderSnapshot*, uint32_t capacity);
+    void destroyRenderSnapshot(RenderSnapshot*);
+    // Captures every drawable entity, interpolated 'alpha' of the way from the
+    // previous tick to the current one.
+    void buildRenderSnapshot(const GameState*, float alpha, RenderSnapshot*);
+}
+
+#endif //PONG_VK_GAME_H
@@ -1,37 +1,80 @@
 #include "input.h"
-#include <GLFW/glfw3.h>
+#include "../logger.h"
 
 namespace Pong {
 
-	bool isKeyPressed(PongWindow::Window* window, int keycode) {
+	static void setBit(uint64_t* bits, uint32_t index, bool isSet) {
+		uint64_t mask = 1ull << (index & 63);
+		if (isSet) bits[index >> 6] |= mask;
+		else bits[index >> 6] &= ~mask;
+	}
+
+	void processInputEvents(PongWindow::Window* window, InputState* state) {
 
-	    bool status = false;
+		PongWindow::InputQueue* queue = &window->windowData.inputQueue;
+		PongWindow::InputEvent event;
 
-		if (window->type == PongWindow::NativeWindowType::GLFW) {
-			status = glfwGetKey(static_cast<GLFWwindow*>(window->nativeWindow), keycode) == GLFW_PRESS;
+		while (PongWindow::popInputEvent(queue, &event)) {
+			switch (event.type) {
+				case PongWindow::InputEventType::KEY:
+					if (event.code < 0 || event.code >= static_cast<int32_t>(INPUT_KEY_COUNT)) break;
+					setBit(state->current.keys, event.code, event.isPressed);
+					if (event.isPressed) setBit(state->pressedKeys, event.code, true);
+					if (state->pendingEventNanos == 0) state->pendingEventNanos = event.timeNanos;
+					break;
+				case PongWindow::InputEventType::MOUSE_BUTTON: {
+					if (event.code < 0 || event.code >= static_cast<int32_t>(INPUT_MOUSE_BUTTON_COUNT)) break;
+					auto mask = static_cast<uint8_t>(1u << event.code);
+					if (event.isPressed) {
+						state->current.mouseButtons |= mask;
+						state->pressedMouseButtons |= mask;
+					} else {
+						state->current.mouseButtons &= static_cast<uint8_t>(~mask);
+					}
+					if (state->pendingEventNanos == 0) state->pendingEventNanos = event.timeNanos;
+					break;
+				}
+				case PongWindow::InputEventType::CURSOR:
+					state->current.mousePosition = { event.x, event.y };
+					break;
+			}
 		}
 
-		return status;
+		uint32_t droppedEvents = queue->droppedEvents.load(std::memory_order_relaxed);
+		if (droppedEvents != state->reportedDroppedEvents) {
+			PONG_WARN("Input queue overflowed - {0} events dropped", droppedEvents - state->reportedDroppedEvents);
+			state->reportedDroppedEvents = droppedEvents;
+		}
 	}
 
-    bool isMouseButtonPressed(PongWindow::Window* window, int mouseButtonCode) {
-        bool status = false;
+	InputSnapshot takeInputSnapshot(InputState* state) {
+
+		InputSnapshot snapshot = state->current;
 
-        if (window->type == PongWindow::NativeWindowType::GLFW) {
-            status = glfwGetMouseButton(static_cast<GLFWwindow*>(window->nativeWindow), mouseButtonCode) == GLFW_PRESS;
-        }
+		for (uint32_t i = 0; i < INPUT_KEY_COUNT / 64; i++) {
+			snapshot.keys[i] |= state->pressedKeys[i];
+			state->pressedKeys[i] = 0;
+		}
+		snapshot.mouseButtons |= state->pressedMouseButtons;
+		state->pressedMouseButtons = 0;
 
-        return status;
-    }
+		snapshot.timeNanos = state->pendingEventNanos;
+		state->pendingEventNanos = 0;
 
-    glm::vec2 getMousePosition(PongWindow::Window* window) {
+		return snapshot;
+	}
 
-	    double xPos, yPos = 0.0;
+	bool isKeyPressed(const InputSnapshot* snapshot, int keycode) {
+		if (keycode < 0 || keycode >= static_cast<int>(INPUT_KEY_COUNT)) return false;
+		return (snapshot->keys[keycode >> 6] >> (keycode & 63)) & 1;
+	}
 
-        if (window->type == PongWindow::NativeWindowType::GLFW) {
-            glfwGetCursorPos(static_cast<GLFWwindow*>(window->nativeWindow), &xPos, &yPos);
-        }
+	bool isMouseButtonPressed(const InputSnapshot* snapshot, int mouseButtonCode) {
+		if (mouseButtonCode < 0 || mouseButtonCode >= static_cast<int>(INPUT_MOUSE_BUTTON_COUNT)) return false;
+		return (snapshot->mouseButtons >> mouseButtonCode) & 1;
+	}
 
-        return { (float)xPos, (float)yPos };
+	glm::vec2 getMousePosition(const InputSnapshot* snapshot) {
+		return snapshot->mousePosition;
 	}
-}
\ No newline at end of file
+}
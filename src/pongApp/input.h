@@ -2,14 +2,50 @@
 #define INPUT_H
 
 #include "../window/window.h"
+#include <cstdint>
 #include <glm/glm.hpp>
 
 namespace Pong {
 
-	bool isKeyPressed(PongWindow::Window*, int);
-	bool isMouseButtonPressed(PongWindow::Window*, int);
-	glm::vec2 getMousePosition(PongWindow::Window*);
+	// Enough bits for every GLFW key and mouse button code.
+	constexpr uint32_t INPUT_KEY_COUNT = 512;
+	constexpr uint32_t INPUT_MOUSE_BUTTON_COUNT = 8;
+
+	// Immutable bitset of everything that counts as held at one point in time.
+	struct InputSnapshot {
+		uint64_t keys[INPUT_KEY_COUNT / 64]		{0};
+		uint8_t mouseButtons					{0};
+		glm::vec2 mousePosition					{0.0f, 0.0f};
+		// Time of the oldest key or button event which arrived since the previous
+		// snapshot (0 if there were none) - the input this snapshot first responds to.
+		uint64_t timeNanos						{0};
+	};
+
+	// Input as seen by whichever thread consumes it - built up purely from the
+	// window's event queue, so it never has to touch the window system itself.
+	struct InputState {
+		// What's down right now.
+		InputSnapshot current;
+		// Keys and buttons which went down since the last snapshot was taken, so a
+		// tap that's already been released still shows up once.
+		uint64_t pressedKeys[INPUT_KEY_COUNT / 64]	{0};
+		uint8_t pressedMouseButtons					{0};
+		// Time of the oldest key or button event not yet included in a snapshot.
+		// Cursor movement is left out - it streams in constantly and would always
+		// make the latency look like a frame's worth.
+		uint64_t pendingEventNanos					{0};
+		uint32_t reportedDroppedEvents				{0};
+	};
+
+	// Drains every event the window has queued up into the input state.
+	void processInputEvents(PongWindow::Window*, InputState*);
+	// Returns everything currently held plus anything pressed since the last
+	// call, then starts latching presses afresh.
+	InputSnapshot takeInputSnapshot(InputState*);
+
+	bool isKeyPressed(const InputSnapshot*, int);
+	bool isMouseButtonPressed(const InputSnapshot*, int);
+	glm::vec2 getMousePosition(const InputSnapshot*);
 }
 
 #endif // !INPUT_H
-
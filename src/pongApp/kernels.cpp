@@ -0,0 +1,427 @@
+#include "kernels.h"
+#include <cmath>
+#include <algorithm>
+#include "../logger.h"
+
+#if defined(PONG_SIMD_AVX2)
+    #include <immintrin.h>
+#elif defined(PONG_SIMD_SSE2)
+    #include <emmintrin.h>
+#endif
+
+namespace Pong {
+
+    // ----------------------------- SCALAR -------------------------------------
+
+    void integrateScalar(TransformColumns* transforms, const VelocityColumns* velocities, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            transforms->positionX[i] += velocities->x[i];
+            transforms->positionY[i] += velocities->y[i];
+            transforms->rotation[i] += velocities->rotation[i];
+        }
+    }
+
+    void clampScalar(TransformColumns* transforms, const uint32_t* masks, uint32_t mask,
+        float halfHeight, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            if ((masks[i] & mask) != mask) continue;
+            float halfScale = transforms->scaleY[i] * 0.5f;
+            transforms->positionY[i] = std::min(std::max(transforms->positionY[i], -halfHeight + halfScale),
+                halfHeight - halfScale);
+        }
+    }
+
+    void computeBoundsScalar(const TransformColumns* transforms, RectBoundsColumns* bounds, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            float halfX = transforms->scaleX[i] * 0.5f;
+            float halfY = transforms->scaleY[i] * 0.5f;
+            bounds->minX[i] = transforms->positionX[i] - halfX;
+            bounds->minY[i] = transforms->positionY[i] - halfY;
+            bounds->maxX[i] = transforms->positionX[i] + halfX;
+            bounds->maxY[i] = transforms->positionY[i] + halfY;
+        }
+    }
+
+    void computeContactsScalar(const RectBoundsColumns* bounds, const CollisionPair* pairs, uint32_t count,
+        Contact* contacts) {
+
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t a = pairs[i].a;
+            uint32_t b = pairs[i].b;
+
+            float overlapX = std::min(bounds->maxX[a], bounds->maxX[b]) - std::max(bounds->minX[a], bounds->minX[b]);
+            float overlapY = std::min(bounds->maxY[a], bounds->maxY[b]) - std::max(bounds->minY[a], bounds->minY[b]);
+
+            if (overlapX <= 0.0f || overlapY <= 0.0f) {
+                contacts[i] = Contact{};
+                continue;
+            }
+
+            float deltaX = ((bounds->minX[a] + bounds->maxX[a]) - (bounds->minX[b] + bounds->maxX[b])) * 0.5f;
+            float deltaY = ((bounds->minY[a] + bounds->maxY[a]) - (bounds->minY[b] + bounds->maxY[b])) * 0.5f;
+            float halfWidth = (bounds->maxX[b] - bounds->minX[b]) * 0.5f;
+            float halfHeight = (bounds->maxY[b] - bounds->minY[b]) * 0.5f;
+
+            bool isAlongX = overlapX < overlapY;
+
+            contacts[i].penetration = isAlongX ? overlapX : overlapY;
+            contacts[i].normalX = isAlongX ? std::copysign(1.0f, deltaX) : 0.0f;
+            contacts[i].normalY = isAlongX ? 0.0f : std::copysign(1.0f, deltaY);
+            contacts[i].offset = std::min(std::max(isAlongX ? deltaY / halfHeight : deltaX / halfWidth, -1.0f), 1.0f);
+        }
+    }
+
+    // ------------------------------ BATCH -------------------------------------
+    // Each kernel handles as many whole vectors as it can and finishes the
+    // remaining (< lane count) entities with the scalar loop.
+
+#if defined(PONG_SIMD_AVX2)
+
+    constexpr uint32_t LANES = 8;
+
+    static void addColumns(float* dst, const float* src, uint32_t count) {
+        for (uint32_t i = 0; i < count; i += LANES) {
+            _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_loadu_ps(src + i)));
+        }
+    }
+
+    static void clampVectors(TransformColumns* transforms, const uint32_t* masks, uint32_t mask,
+        float halfHeight, uint32_t count) {
+
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 height = _mm256_set1_ps(halfHeight);
+        const __m256 negHeight = _mm256_set1_ps(-halfHeight);
+        const __m256i required = _mm256_set1_epi32(static_cast<int>(mask));
+
+        for (uint32_t i = 0; i < count; i += LANES) {
+            __m256 y = _mm256_loadu_ps(transforms->positionY + i);
+            __m256 halfScale = _mm256_mul_ps(_mm256_loadu_ps(transforms->scaleY + i), half);
+            __m256 clamped = _mm256_min_ps(_mm256_max_ps(y, _mm256_add_ps(negHeight, halfScale)),
+                _mm256_sub_ps(height, halfScale));
+
+            // Only lanes whose mask contains every required bit take the clamped value.
+            __m256i laneMasks = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(masks + i));
+            __m256i isSelected = _mm256_cmpeq_epi32(_mm256_and_si256(laneMasks, required), required);
+
+            _mm256_storeu_ps(transforms->positionY + i, _mm256_blendv_ps(y, clamped, _mm256_castsi256_ps(isSelected)));
+        }
+    }
+
+    static void boundsVectors(const TransformColumns* transforms, RectBoundsColumns* bounds, uint32_t count) {
+
+        const __m256 half = _mm256_set1_ps(0.5f);
+
+        for (uint32_t i = 0; i < count; i += LANES) {
+            __m256 x = _mm256_loadu_ps(transforms->positionX + i);
+            __m256 y = _mm256_loadu_ps(transforms->positionY + i);
+            __m256 halfX = _mm256_mul_ps(_mm256_loadu_ps(transforms->scaleX + i), half);
+            __m256 halfY = _mm256_mul_ps(_mm256_loadu_ps(transforms->scaleY + i), half);
+            _mm256_storeu_ps(bounds->minX + i, _mm256_sub_ps(x, halfX));
+            _mm256_storeu_ps(bounds->minY + i, _mm256_sub_ps(y, halfY));
+            _mm256_storeu_ps(bounds->maxX + i, _mm256_add_ps(x, halfX));
+            _mm256_storeu_ps(bounds->maxY + i, _mm256_add_ps(y, halfY));
+        }
+    }
+
+    const char* getKernelInstructionSet() { return "AVX2"; }
+
+#elif defined(PONG_SIMD_SSE2)
+
+    constexpr uint32_t LANES = 4;
+
+    static void addColumns(float* dst, const float* src, uint32_t count) {
+        for (uint32_t i = 0; i < count; i += LANES) {
+            _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+        }
+    }
+
+    static void clampVectors(TransformColumns* transforms, const uint32_t* masks, uint32_t mask,
+        float halfHeight, uint32_t count) {
+
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 height = _mm_set1_ps(halfHeight);
+        const __m128 negHeight = _mm_set1_ps(-halfHeight);
+        const __m128i required = _mm_set1_epi32(static_cast<int>(mask));
+
+        for (uint32_t i = 0; i < count; i += LANES) {
+            __m128 y = _mm_loadu_ps(transforms->positionY + i);
+            __m128 halfScale = _mm_mul_ps(_mm_loadu_ps(transforms->scaleY + i), half);
+            __m128 clamped = _mm_min_ps(_mm_max_ps(y, _mm_add_ps(negHeight, halfScale)),
+                _mm_sub_ps(height, halfScale));
+
+            // SSE2 has no blend instruction, so select with and/andnot/or instead.
+            __m128i laneMasks = _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks + i));
+            __m128 isSelected = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(laneMasks, required), required));
+
+            _mm_storeu_ps(transforms->positionY + i,
+                _mm_or_ps(_mm_and_ps(isSelected, clamped), _mm_andnot_ps(isSelected, y)));
+        }
+    }
+
+    static void boundsVectors(const TransformColumns* transforms, RectBoundsColumns* bounds, uint32_t count) {
+
+        const __m128 half = _mm_set1_ps(0.5f);
+
+        for (uint32_t i = 0; i < count; i += LANES) {
+            __m128 x = _mm_loadu_ps(transforms->positionX + i);
+            __m128 y = _mm_loadu_ps(transforms->positionY + i);
+            __m128 halfX = _mm_mul_ps(_mm_loadu_ps(transforms->scaleX + i), half);
+            __m128 halfY = _mm_mul_ps(_mm_loadu_ps(transforms->scaleY + i), half);
+            _mm_storeu_ps(bounds->minX + i, _mm_sub_ps(x, halfX));
+            _mm_storeu_ps(bounds->minY + i, _mm_sub_ps(y, halfY));
+            _mm_storeu_ps(bounds->maxX + i, _mm_add_ps(x, halfX));
+            _mm_storeu_ps(bounds->maxY + i, _mm_add_ps(y, halfY));
+        }
+    }
+
+    const char* getKernelInstructionSet() { return "SSE2"; }
+
+#endif
+
+#if defined(PONG_SIMD_AVX2) || defined(PONG_SIMD_SSE2)
+
+    // The narrowphase reads entities in pair order rather than streaming columns,
+    // so there's little to gain from wider vectors - both builds use SSE2 here.
+
+    static_assert(sizeof(Contact) == 4 * sizeof(float), "Contacts are written as one SSE register each");
+
+    static inline __m128 gatherA(const float* column, const CollisionPair* pairs) {
+        return _mm_setr_ps(column[pairs[0].a], column[pairs[1].a], column[pairs[2].a], column[pairs[3].a]);
+    }
+
+    static inline __m128 gatherB(const float* column, const CollisionPair* pairs) {
+        return _mm_setr_ps(column[pairs[0].b], column[pairs[1].b], column[pairs[2].b], column[pairs[3].b]);
+    }
+
+    static inline __m128 selectVectors(__m128 mask, __m128 a, __m128 b) {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    static void contactsVectors(const RectBoundsColumns* bounds, const CollisionPair* pairs, uint32_t count,
+        Contact* contacts) {
+
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 negOne = _mm_set1_ps(-1.0f);
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+
+        for (uint32_t i = 0; i < count; i += 4) {
+            const CollisionPair* batch = pairs + i;
+
+            __m128 minXA = gatherA(bounds->minX, batch), maxXA = gatherA(bounds->maxX, batch);
+            __m128 minYA = gatherA(bounds->minY, batch), maxYA = gatherA(bounds->maxY, batch);
+            __m128 minXB = gatherB(bounds->minX, batch), maxXB = gatherB(bounds->maxX, batch);
+            __m128 minYB = gatherB(bounds->minY, batch), maxYB = gatherB(bounds->maxY, batch);
+
+            __m128 overlapX = _mm_sub_ps(_mm_min_ps(maxXA, maxXB), _mm_max_ps(minXA, minXB));
+            __m128 overlapY = _mm_sub_ps(_mm_min_ps(maxYA, maxYB), _mm_max_ps(minYA, minYB));
+
+            __m128 deltaX = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(minXA, maxXA), _mm_add_ps(minXB, maxXB)), half);
+            __m128 deltaY = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(minYA, maxYA), _mm_add_ps(minYB, maxYB)), half);
+            __m128 halfWidth = _mm_mul_ps(_mm_sub_ps(maxXB, minXB), half);
+            __m128 halfHeight = _mm_mul_ps(_mm_sub_ps(maxYB, minYB), half);
+
+            __m128 isColliding = _mm_and_ps(_mm_cmpgt_ps(overlapX, zero), _mm_cmpgt_ps(overlapY, zero));
+            __m128 isAlongX = _mm_cmplt_ps(overlapX, overlapY);
+
+            // +-1 with the sign of the centre delta, i.e. copysign(1, delta).
+            __m128 signX = _mm_or_ps(_mm_and_ps(deltaX, signMask), one);
+            __m128 signY = _mm_or_ps(_mm_and_ps(deltaY, signMask), one);
+
+            __m128 penetration = _mm_and_ps(selectVectors(isAlongX, overlapX, overlapY), isColliding);
+            __m128 normalX = _mm_and_ps(_mm_and_ps(isAlongX, signX), isColliding);
+            __m128 normalY = _mm_and_ps(_mm_andnot_ps(isAlongX, signY), isColliding);
+
+            // The offset runs along the contact face, so it uses the other axis.
+            __m128 tangent = _mm_div_ps(selectVectors(isAlongX, deltaY, deltaX),
+                selectVectors(isAlongX, halfHeight, halfWidth));
+            __m128 offset = _mm_and_ps(_mm_min_ps(_mm_max_ps(tangent, negOne), one), isColliding);
+
+            // Columns to rows - each row is one Contact.
+            _MM_TRANSPOSE4_PS(penetration, normalX, normalY, offset);
+
+            _mm_storeu_ps(&contacts[i + 0].penetration, penetration);
+            _mm_storeu_ps(&contacts[i + 1].penetration, normalX);
+            _mm_storeu_ps(&contacts[i + 2].penetration, normalY);
+            _mm_storeu_ps(&contacts[i + 3].penetration, offset);
+        }
+    }
+
+    void computeContactsBatch(const RectBoundsColumns* bounds, const CollisionPair* pairs, uint32_t count,
+        Contact* contacts) {
+
+        uint32_t vectorCount = count & ~3u;
+
+        contactsVectors(bounds, pairs, vectorCount, contacts);
+        computeContactsScalar(bounds, pairs + vectorCount, count - vectorCount, contacts + vectorCount);
+    }
+
+    void integrateBatch(TransformColumns* transforms, const VelocityColumns* velocities, uint32_t count) {
+
+        uint32_t vectorCount = count & ~(LANES - 1);
+
+        addColumns(transforms->positionX, velocities->x, vectorCount);
+        addColumns(transforms->positionY, velocities->y, vectorCount);
+        addColumns(transforms->rotation, velocities->rotation, vectorCount);
+
+        TransformColumns tailTransforms = {
+            transforms->positionX + vectorCount, transforms->positionY + vectorCount,
+            transforms->scaleX + vectorCount, transforms->scaleY + vectorCount, transforms->rotation + vectorCount
+        };
+        VelocityColumns tailVelocities = {
+            velocities->x + vectorCount, velocities->y + vectorCount, velocities->rotation + vectorCount
+        };
+        integrateScalar(&tailTransforms, &tailVelocities, count - vectorCount);
+    }
+
+    void clampBatch(TransformColumns* transforms, const uint32_t* masks, uint32_t mask,
+        float halfHeight, uint32_t count) {
+
+        uint32_t vectorCount = count & ~(LANES - 1);
+
+        clampVectors(transforms, masks, mask, halfHeight, vectorCount);
+
+        TransformColumns tailTransforms = {
+            transforms->positionX + vectorCount, transforms->positionY + vectorCount,
+            transforms->scaleX + vectorCount, transforms->scaleY + vectorCount, transforms->rotation + vectorCount
+        };
+        clampScalar(&tailTransforms, masks + vectorCount, mask, halfHeight, count - vectorCount);
+    }
+
+    void computeBoundsBatch(const TransformColumns* transforms, RectBoundsColumns* bounds, uint32_t count) {
+
+        uint32_t vectorCount = count & ~(LANES - 1);
+
+        boundsVectors(transforms, bounds, vectorCount);
+
+        TransformColumns tailTransforms = {
+            transforms->positionX + vectorCount, transforms->positionY + vectorCount,
+            transforms->scaleX + vectorCount, transforms->scaleY + vectorCount, transforms->rotation + vectorCount
+        };
+        RectBoundsColumns tailBounds = {
+            bounds->minX + vectorCount, bounds->minY + vectorCount,
+            bounds->maxX + vectorCount, bounds->maxY + vectorCount
+        };
+        computeBoundsScalar(&tailTransforms, &tailBounds, count - vectorCount);
+    }
+
+#else
+
+    void integrateBatch(TransformColumns* transforms, const VelocityColumns* velocities, uint32_t count) {
+        integrateScalar(transforms, velocities, count);
+    }
+
+    void clampBatch(TransformColumns* transforms, const uint32_t* masks, uint32_t mask,
+        float halfHeight, uint32_t count) {
+        clampScalar(transforms, masks, mask, halfHeight, count);
+    }
+
+    void computeBoundsBatch(const TransformColumns* transforms, RectBoundsColumns* bounds, uint32_t count) {
+        computeBoundsScalar(transforms, bounds, count);
+    }
+
+    void computeContactsBatch(const RectBoundsColumns* bounds, const CollisionPair* pairs, uint32_t count,
+        Contact* contacts) {
+        computeContactsScalar(bounds, pairs, count, contacts);
+    }
+
+    const char* getKernelInstructionSet() { return "scalar"; }
+
+#endif
+
+    // --------------------------- VERIFICATION ---------------------------------
+
+#ifdef DEBUG
+
+    static bool compareColumns(const char* kernel, const float* expected, const float* actual, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            float tolerance = 1e-5f * std::max(1.0f, std::fabs(expected[i]));
+            if (std::fabs(expected[i] - actual[i]) > tolerance) {
+                PONG_ERROR("{0} kernel mismatch at {1}: expected {2}, got {3}", kernel, i, expected[i], actual[i]);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool verifyKernels() {
+
+        // An odd count so the scalar tail is exercised as well.
+        constexpr uint32_t COUNT = 1027;
+
+        EntityStore reference, batch;
+        if (!initialiseEntityStore(&reference, COUNT) || !initialiseEntityStore(&batch, COUNT)) return false;
+
+        // Small LCG so the data is the same every run.
+        uint32_t seed = 0x9E3779B9u;
+        auto random = [&seed](float min, float max) {
+            seed = seed * 1664525u + 1013904223u;
+            return min + (max - min) * static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+        };
+
+        for (uint32_t i = 0; i < COUNT; i++) {
+            uint32_t mask = (i % 3 == 0) ? COMPONENT_TRANSFORM | TAG_PADDLE : COMPONENT_TRANSFORM;
+            createEntity(&reference, mask);
+            createEntity(&batch, mask);
+
+            Transform transform = { { random(-400.0f, 400.0f), random(-400.0f, 400.0f) },
+                { random(1.0f, 100.0f), random(1.0f, 100.0f) }, random(0.0f, 360.0f) };
+            Velocity velocity = { { random(-20.0f, 20.0f), random(-20.0f, 20.0f) }, random(-5.0f, 5.0f) };
+
+            setTransform(&reference, i, transform);
+            setTransform(&batch, i, transform);
+            setVelocity(&reference, i, velocity);
+            setVelocity(&batch, i, velocity);
+        }
+
+        integrateScalar(&reference.transforms, &reference.velocities, COUNT);
+        clampScalar(&reference.transforms, reference.componentMasks, TAG_PADDLE, 300.0f, COUNT);
+        computeBoundsScalar(&reference.transforms, &reference.bounds, COUNT);
+
+        integrateBatch(&batch.transforms, &batch.velocities, COUNT);
+        clampBatch(&batch.transforms, batch.componentMasks, TAG_PADDLE, 300.0f, COUNT);
+        computeBoundsBatch(&batch.transforms, &batch.bounds, COUNT);
+
+        bool isMatching =
+            compareColumns("integrate", reference.transforms.positionX, batch.transforms.positionX, COUNT)
+            && compareColumns("integrate", reference.transforms.rotation, batch.transforms.rotation, COUNT)
+            && compareColumns("clamp", reference.transforms.positionY, batch.transforms.positionY, COUNT)
+            && compareColumns("bounds", reference.bounds.minX, batch.bounds.minX, COUNT)
+            && compareColumns("bounds", reference.bounds.minY, batch.bounds.minY, COUNT)
+            && compareColumns("bounds", reference.bounds.maxX, batch.bounds.maxX, COUNT)
+            && compareColumns("bounds", reference.bounds.maxY, batch.bounds.maxY, COUNT);
+
+        // Narrowphase - pair up random (often overlapping) boxes from the bounds above.
+        constexpr uint32_t PAIR_COUNT = 1023;
+        CollisionPair pairs[PAIR_COUNT];
+        Contact expectedContacts[PAIR_COUNT];
+        Contact actualContacts[PAIR_COUNT];
+
+        for (uint32_t i = 0; i < PAIR_COUNT; i++) {
+            uint32_t a = static_cast<uint32_t>(random(0.0f, static_cast<float>(COUNT - 1)));
+            // Mostly nearby entities, so a good share of the pairs actually touch.
+            uint32_t b = (i % 2 == 0)
+                ? static_cast<uint32_t>(random(0.0f, static_cast<float>(COUNT - 1)))
+                : (a + 1) % COUNT;
+            pairs[i] = { a, b };
+            batch.bounds.minX[b] = batch.bounds.minX[a] + random(-30.0f, 30.0f);
+            batch.bounds.minY[b] = batch.bounds.minY[a] + random(-30.0f, 30.0f);
+            batch.bounds.maxX[b] = batch.bounds.minX[b] + random(1.0f, 60.0f);
+            batch.bounds.maxY[b] = batch.bounds.minY[b] + random(1.0f, 60.0f);
+        }
+
+        computeContactsScalar(&batch.bounds, pairs, PAIR_COUNT, expectedContacts);
+        computeContactsBatch(&batch.bounds, pairs, PAIR_COUNT, actualContacts);
+
+        isMatching = isMatching
+            && compareColumns("contacts", &expectedContacts[0].penetration, &actualContacts[0].penetration, PAIR_COUNT * 4);
+
+        destroyEntityStore(&reference);
+        destroyEntityStore(&batch);
+
+        return isMatching;
+    }
+
+#endif
+}
@@ -0,0 +1,57 @@
+#ifndef PONG_VK_KERNELS_H
+#define PONG_VK_KERNELS_H
+
+#include <cstdint>
+#include "entities.h"
+#include "broadphase.h"
+#include "../simd.h"
+
+// Batched simulation kernels. Each one walks the first 'count' entries of the
+// given columns in a single pass, several entities per instruction (see
+// simd.h for which instruction set).
+//
+// The scalar versions are always compiled and double as the reference the
+// vector paths are checked against.
+
+namespace Pong {
+
+    // position += velocity, rotation += rotationVelocity.
+    void integrateBatch(TransformColumns*, const VelocityColumns*, uint32_t count);
+    // Clamps the vertical position of every entity whose mask contains all bits
+    // of 'mask' to [-halfHeight + scaleY / 2, halfHeight - scaleY / 2].
+    void clampBatch(TransformColumns*, const uint32_t* masks, uint32_t mask, float halfHeight, uint32_t count);
+    // bounds = position -/+ scale / 2.
+    void computeBoundsBatch(const TransformColumns*, RectBoundsColumns*, uint32_t count);
+
+    // Narrowphase result for one candidate pair (a, b).
+    struct Contact {
+        // Overlap along the contact normal - 0 if the pair isn't actually touching.
+        float penetration   {0.0f};
+        // Axis-aligned contact normal pointing from b towards a. Moving a by
+        // normal * penetration separates the pair.
+        float normalX       {0.0f};
+        float normalY       {0.0f};
+        // Where a's centre sits along b's contact face, from -1 to 1.
+        float offset        {0.0f};
+    };
+
+    // Computes a Contact for every pair. The normal is always along the axis of
+    // least penetration.
+    void computeContactsBatch(const RectBoundsColumns*, const CollisionPair*, uint32_t count, Contact*);
+
+    void integrateScalar(TransformColumns*, const VelocityColumns*, uint32_t count);
+    void clampScalar(TransformColumns*, const uint32_t* masks, uint32_t mask, float halfHeight, uint32_t count);
+    void computeBoundsScalar(const TransformColumns*, RectBoundsColumns*, uint32_t count);
+    void computeContactsScalar(const RectBoundsColumns*, const CollisionPair*, uint32_t count, Contact*);
+
+    // Name of the instruction set the batch kernels were built for.
+    const char* getKernelInstructionSet();
+
+#ifdef DEBUG
+    // Runs the batch kernels and the scalar reference over the same random data
+    // and checks they agree. Only built in DEBUG.
+    bool verifyKernels();
+#endif
+}
+
+#endif //PONG_VK_KERNELS_H
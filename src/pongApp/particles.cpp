@@ -0,0 +1,349 @@
+#include "particles.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <glm/gtc/constants.hpp>
+#include "../logger.h"
+
+#if defined(PONG_SIMD_AVX2)
+    #include <immintrin.h>
+#elif defined(PONG_SIMD_SSE2)
+    #include <emmintrin.h>
+#endif
+
+namespace Pong {
+
+    // Anything shorter lived is stretched to this, so fadeRate stays finite.
+    const float MIN_PARTICLE_LIFETIME = 0.001f;
+
+    // ----------------------------- LIFETIME -----------------------------------
+
+    bool initialiseParticlePool(ParticlePool* pool, uint32_t capacity) {
+
+        *pool = ParticlePool{};
+        pool->capacity = capacity;
+
+        float** columns[] = {
+            &pool->positionX, &pool->positionY, &pool->velocityX, &pool->velocityY, &pool->lifetime,
+            &pool->fadeRate, &pool->size, &pool->colorR, &pool->colorG, &pool->colorB, &pool->alpha
+        };
+
+        for (float** column : columns) {
+            *column = static_cast<float*>(malloc(sizeof(float) * capacity));
+            if (!*column) {
+                PONG_ERROR("Failed to allocate particle pool for {0} particles", capacity);
+                destroyParticlePool(pool);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void destroyParticlePool(ParticlePool* pool) {
+
+        float* columns[] = {
+            pool->positionX, pool->positionY, pool->velocityX, pool->velocityY, pool->lifetime,
+            pool->fadeRate, pool->size, pool->colorR, pool->colorG, pool->colorB, pool->alpha
+        };
+
+        for (float* column : columns) free(column);
+
+        *pool = ParticlePool{};
+    }
+
+    // ----------------------------- EMITTING -----------------------------------
+
+    uint32_t emitParticles(ParticlePool* pool, const ParticleBurst& burst) {
+
+        uint32_t count = std::min(burst.count, pool->capacity - pool->count);
+        pool->emitted += count;
+        pool->dropped += burst.count - count;
+
+        // Small LCG - effects don't need anything better, and it keeps bursts
+        // the same from run to run.
+        uint32_t& state = pool->randomState;
+        auto random = [&state](float min, float max) {
+            state = state * 1664525u + 1013904223u;
+            return min + (max - min) * static_cast<float>(state >> 8) / static_cast<float>(1u << 24);
+        };
+
+        bool isAimed = burst.direction != glm::vec2(0.0f);
+        float angle = isAimed ? std::atan2(burst.direction.y, burst.direction.x) : 0.0f;
+        float spread = isAimed ? glm::radians(burst.spread) : glm::pi<float>();
+
+        for (uint32_t i = pool->count; i < pool->count + count; i++) {
+            float direction = angle + random(-spread, spread);
+            float speed = random(burst.minSpeed, burst.maxSpeed);
+            float lifetime = std::max(random(burst.minLifetime, burst.maxLifetime), MIN_PARTICLE_LIFETIME);
+
+            pool->positionX[i] = burst.position.x;
+            pool->positionY[i] = burst.position.y;
+            pool->velocityX[i] = std::cos(direction) * speed;
+            pool->velocityY[i] = std::sin(direction) * speed;
+            pool->lifetime[i] = lifetime;
+            pool->fadeRate[i] = 1.0f / lifetime;
+            pool->size[i] = burst.size;
+            pool->colorR[i] = burst.color.x;
+            pool->colorG[i] = burst.color.y;
+            pool->colorB[i] = burst.color.z;
+            pool->alpha[i] = 1.0f;
+        }
+
+        pool->count += count;
+
+        return count;
+    }
+
+    // ----------------------------- SCALAR -------------------------------------
+
+    void updateParticlesScalar(ParticlePool* pool, float deltaTime, float damping, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            pool->positionX[i] += pool->velocityX[i] * deltaTime;
+            pool->positionY[i] += pool->velocityY[i] * deltaTime;
+            pool->velocityX[i] *= damping;
+            pool->velocityY[i] *= damping;
+            pool->lifetime[i] -= deltaTime;
+            pool->alpha[i] = std::max(pool->lifetime[i] * pool->fadeRate[i], 0.0f);
+        }
+    }
+
+    // ------------------------------ BATCH -------------------------------------
+    // Handles as many whole vectors as it can and finishes the remaining
+    // (< lane count) particles with the scalar loop.
+
+#if defined(PONG_SIMD_AVX2)
+
+    constexpr uint32_t LANES = 8;
+
+    static void updateVectors(ParticlePool* pool, float deltaTime, float damping, uint32_t count) {
+
+        const __m256 delta = _mm256_set1_ps(deltaTime);
+        const __m256 damp = _mm256_set1_ps(damping);
+        const __m256 zero = _mm256_setzero_ps();
+
+        for (uint32_t i = 0; i < count; i += LANES) {
+            __m256 velocityX = _mm256_loadu_ps(pool->velocityX + i);
+            __m256 velocityY = _mm256_loadu_ps(pool->velocityY + i);
+            _mm256_storeu_ps(pool->positionX + i,
+                _mm256_add_ps(_mm256_loadu_ps(pool->positionX + i), _mm256_mul_ps(velocityX, delta)));
+            _mm256_storeu_ps(pool->positionY + i,
+                _mm256_add_ps(_mm256_loadu_ps(pool->positionY + i), _mm256_mul_ps(velocityY, delta)));
+            _mm256_storeu_ps(pool->velocityX + i, _mm256_mul_ps(velocityX, damp));
+            _mm256_storeu_ps(pool->velocityY + i, _mm256_mul_ps(velocityY, damp));
+
+            __m256 lifetime = _mm256_sub_ps(_mm256_loadu_ps(pool->lifetime + i), delta);
+            _mm256_storeu_ps(pool->lifetime + i, lifetime);
+            _mm256_storeu_ps(pool->alpha + i,
+                _mm256_max_ps(_mm256_mul_ps(lifetime, _mm256_loadu_ps(pool->fadeRate + i)), zero));
+        }
+    }
+
+#elif defined(PONG_SIMD_SSE2)
+
+    constexpr uint32_t LANES = 4;
+
+    static void updateVectors(ParticlePool* pool, float deltaTime, float damping, uint32_t count) {
+
+        const __m128 delta = _mm_set1_ps(deltaTime);
+        const __m128 damp = _mm_set1_ps(damping);
+        const __m128 zero = _mm_setzero_ps();
+
+        for (uint32_t i = 0; i < count; i += LANES) {
+            __m128 velocityX = _mm_loadu_ps(pool->velocityX + i);
+            __m128 velocityY = _mm_loadu_ps(pool->velocityY + i);
+            _mm_storeu_ps(pool->positionX + i,
+                _mm_add_ps(_mm_loadu_ps(pool->positionX + i), _mm_mul_ps(velocityX, delta)));
+            _mm_storeu_ps(pool->positionY + i,
+                _mm_add_ps(_mm_loadu_ps(pool->positionY + i), _mm_mul_ps(velocityY, delta)));
+            _mm_storeu_ps(pool->velocityX + i, _mm_mul_ps(velocityX, damp));
+            _mm_storeu_ps(pool->velocityY + i, _mm_mul_ps(velocityY, damp));
+
+            __m128 lifetime = _mm_sub_ps(_mm_loadu_ps(pool->lifetime + i), delta);
+            _mm_storeu_ps(pool->lifetime + i, lifetime);
+            _mm_storeu_ps(pool->alpha + i, _mm_max_ps(_mm_mul_ps(lifetime, _mm_loadu_ps(pool->fadeRate + i)), zero));
+        }
+    }
+
+#endif
+
+    void updateParticlesBatch(ParticlePool* pool, float deltaTime, float damping, uint32_t count) {
+
+#if defined(PONG_SIMD_AVX2) || defined(PONG_SIMD_SSE2)
+        uint32_t vectorCount = count & ~(LANES - 1);
+        updateVectors(pool, deltaTime, damping, vectorCount);
+
+        ParticlePool tail = *pool;
+        tail.positionX += vectorCount;
+        tail.positionY += vectorCount;
+        tail.velocityX += vectorCount;
+        tail.velocityY += vectorCount;
+        tail.lifetime += vectorCount;
+        tail.fadeRate += vectorCount;
+        tail.alpha += vectorCount;
+
+        updateParticlesScalar(&tail, deltaTime, damping, count - vectorCount);
+#else
+        updateParticlesScalar(pool, deltaTime, damping, count);
+#endif
+    }
+
+    // --------------------------- RECYCLING ------------------------------------
+
+    // Moves the last live particle into each dead one's slot, so the live ones
+    // stay packed at the front. Order isn't kept - nothing depends on it.
+    static void removeDeadParticles(ParticlePool* pool) {
+
+        uint32_t i = 0;
+        while (i < pool->count) {
+            if (pool->lifetime[i] > 0.0f) {
+                i++;
+                continue;
+            }
+
+            uint32_t last = --pool->count;
+            if (i == last) break;
+
+            pool->positionX[i] = pool->positionX[last];
+            pool->positionY[i] = pool->positionY[last];
+            pool->velocityX[i] = pool->velocityX[last];
+            pool->velocityY[i] = pool->velocityY[last];
+            pool->lifetime[i] = pool->lifetime[last];
+            pool->fadeRate[i] = pool->fadeRate[last];
+            pool->size[i] = pool->size[last];
+            pool->colorR[i] = pool->colorR[last];
+            pool->colorG[i] = pool->colorG[last];
+            pool->colorB[i] = pool->colorB[last];
+            pool->alpha[i] = pool->alpha[last];
+        }
+    }
+
+    void updateParticles(ParticlePool* pool, float deltaTime, float drag) {
+        float damping = std::max(1.0f - drag * deltaTime, 0.0f);
+        updateParticlesBatch(pool, deltaTime, damping, pool->count);
+        removeDeadParticles(pool);
+    }
+
+    // ----------------------------- SNAPSHOT -----------------------------------
+
+    bool initialiseParticleSnapshot(ParticleSnapshot* snapshot, uint32_t capacity) {
+
+        *snapshot = ParticleSnapshot{};
+        snapshot->capacity = capacity;
+
+        float** columns[] = {
+            &snapshot->positionX, &snapshot->positionY, &snapshot->size,
+            &snapshot->colorR, &snapshot->colorG, &snapshot->colorB, &snapshot->alpha
+        };
+
+        for (float** column : columns) {
+            *column = static_cast<float*>(malloc(sizeof(float) * capacity));
+            if (!*column) {
+                PONG_ERROR("Failed to allocate particle snapshot for {0} particles", capacity);
+                destroyParticleSnapshot(snapshot);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void destroyParticleSnapshot(ParticleSnapshot* snapshot) {
+
+        float* columns[] = {
+            snapshot->positionX, snapshot->positionY, snapshot->size,
+            snapshot->colorR, snapshot->colorG, snapshot->colorB, snapshot->alpha
+        };
+
+        for (float* column : columns) free(column);
+
+        *snapshot = ParticleSnapshot{};
+    }
+
+    void buildParticleSnapshot(const ParticlePool* pool, ParticleSnapshot* snapshot) {
+
+        uint32_t count = std::min(pool->count, snapshot->capacity);
+        size_t columnSize = sizeof(float) * count;
+
+        memcpy(snapshot->positionX, pool->positionX, columnSize);
+        memcpy(snapshot->positionY, pool->positionY, columnSize);
+        memcpy(snapshot->size, pool->size, columnSize);
+        memcpy(snapshot->colorR, pool->colorR, columnSize);
+        memcpy(snapshot->colorG, pool->colorG, columnSize);
+        memcpy(snapshot->colorB, pool->colorB, columnSize);
+        memcpy(snapshot->alpha, pool->alpha, columnSize);
+
+        snapshot->count = count;
+    }
+
+    // ---------------------------- VERIFICATION --------------------------------
+
+#ifdef DEBUG
+    static bool compareColumns(const char* column, const float* expected, const float* actual, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            float tolerance = 1e-5f * std::max(1.0f, std::fabs(expected[i]));
+            if (std::fabs(expected[i] - actual[i]) > tolerance) {
+                PONG_ERROR("Particle {0} mismatch at {1}: expected {2}, got {3}", column, i, expected[i], actual[i]);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool verifyParticles() {
+
+        // An odd count so the scalar tail is exercised as well.
+        constexpr uint32_t COUNT = 1027;
+        constexpr uint32_t STEPS = 40;
+        const float deltaTime = 1.0f / 60.0f;
+        const float damping = 0.98f;
+
+        ParticlePool reference, batch;
+        if (!initialiseParticlePool(&reference, COUNT) || !initialiseParticlePool(&batch, COUNT)) {
+            destroyParticlePool(&reference);
+            return false;
+        }
+
+        // Lifetimes spread either side of the run's length, so some particles
+        // die (and are swapped out) part way through and some outlive it.
+        ParticleBurst burst;
+        burst.count = COUNT;
+        burst.minSpeed = 10.0f;
+        burst.maxSpeed = 600.0f;
+        burst.minLifetime = 0.1f;
+        burst.maxLifetime = 1.0f;
+        emitParticles(&reference, burst);
+        emitParticles(&batch, burst);
+
+        bool isMatching = true;
+
+        for (uint32_t step = 0; step < STEPS && isMatching; step++) {
+            updateParticlesScalar(&reference, deltaTime, damping, reference.count);
+            updateParticlesBatch(&batch, deltaTime, damping, batch.count);
+            removeDeadParticles(&reference);
+            removeDeadParticles(&batch);
+
+            if (reference.count != batch.count) {
+                PONG_ERROR("Particle mismatch after {0} steps: {1} alive (reference {2})", step + 1, batch.count,
+                    reference.count);
+                isMatching = false;
+                break;
+            }
+
+            uint32_t count = reference.count;
+            isMatching = compareColumns("position", reference.positionX, batch.positionX, count)
+                && compareColumns("position", reference.positionY, batch.positionY, count)
+                && compareColumns("velocity", reference.velocityX, batch.velocityX, count)
+                && compareColumns("velocity", reference.velocityY, batch.velocityY, count)
+                && compareColumns("lifetime", reference.lifetime, batch.lifetime, count)
+                && compareColumns("alpha", reference.alpha, batch.alpha, count);
+        }
+
+        destroyParticlePool(&reference);
+        destroyParticlePool(&batch);
+
+        return isMatching;
+    }
+#endif
+}
@@ -0,0 +1,99 @@
+#ifndef PONG_VK_PARTICLES_H
+#define PONG_VK_PARTICLES_H
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "../simd.h"
+
+// Short lived, purely cosmetic effects - the ball's trail and the sparks it
+// throws off when it hits something.
+//
+// Particles live in a fixed capacity pool with one column per attribute, so
+// updating them is a single streaming pass over the columns, several
+// particles per instruction (see simd.h). Nothing is allocated once the pool
+// exists: emitting takes slots off the end, and a particle that dies has the
+// last live one moved into its place, so the live particles always sit packed
+// at the front. Particles emitted while the pool is full are dropped.
+
+namespace Pong {
+
+    struct ParticlePool {
+        uint32_t count          {0};
+        uint32_t capacity       {0};
+        float* positionX        {nullptr};
+        float* positionY        {nullptr};
+        float* velocityX        {nullptr};
+        float* velocityY        {nullptr};
+        // Seconds left to live.
+        float* lifetime         {nullptr};
+        // 1 / the lifetime it was emitted with - alpha fades from 1 to 0 over it.
+        float* fadeRate         {nullptr};
+        float* size             {nullptr};
+        float* colorR           {nullptr};
+        float* colorG           {nullptr};
+        float* colorB           {nullptr};
+        float* alpha            {nullptr};
+        // For the spread of each burst - the same emits give the same particles.
+        uint32_t randomState    {0x2545F491u};
+        uint64_t emitted        {0};
+        uint64_t dropped        {0};
+    };
+
+    // A batch of particles thrown out from the same point.
+    struct ParticleBurst {
+        glm::vec2 position      {0.0f, 0.0f};
+        // Which way the burst sprays. Zero sprays every way at once.
+        glm::vec2 direction     {0.0f, 0.0f};
+        // Half the angle of the spray around 'direction', in degrees.
+        float spread            {60.0f};
+        uint32_t count          {0};
+        float minSpeed          {0.0f};
+        float maxSpeed          {0.0f};
+        float minLifetime       {0.5f};
+        float maxLifetime       {0.5f};
+        float size              {4.0f};
+        glm::vec3 color         {1.0f, 1.0f, 1.0f};
+    };
+
+    // The columns the renderer needs, copied out of the pool so it can carry
+    // on being updated while they're drawn.
+    struct ParticleSnapshot {
+        uint32_t count          {0};
+        uint32_t capacity       {0};
+        float* positionX        {nullptr};
+        float* positionY        {nullptr};
+        float* size             {nullptr};
+        float* colorR           {nullptr};
+        float* colorG           {nullptr};
+        float* colorB           {nullptr};
+        float* alpha            {nullptr};
+    };
+
+    bool initialiseParticlePool(ParticlePool*, uint32_t capacity);
+    void destroyParticlePool(ParticlePool*);
+
+    // Returns how many of the burst's particles fitted in the pool.
+    uint32_t emitParticles(ParticlePool*, const ParticleBurst&);
+
+    // Moves every particle along its velocity, slows it down by 'drag' (the
+    // fraction of its speed lost per second), fades it out and removes the
+    // ones which have run out of lifetime.
+    void updateParticles(ParticlePool*, float deltaTime, float drag);
+
+    // position += velocity * deltaTime, velocity *= damping, lifetime -= deltaTime,
+    // alpha = max(lifetime * fadeRate, 0) over the first 'count' particles.
+    // Dead particles are left in place.
+    void updateParticlesBatch(ParticlePool*, float deltaTime, float damping, uint32_t count);
+    void updateParticlesScalar(ParticlePool*, float deltaTime, float damping, uint32_t count);
+
+    bool initialiseParticleSnapshot(ParticleSnapshot*, uint32_t capacity);
+    void destroyParticleSnapshot(ParticleSnapshot*);
+    void buildParticleSnapshot(const ParticlePool*, ParticleSnapshot*);
+
+#ifdef DEBUG
+    // Checks the batch and scalar updates agree. Only built in DEBUG.
+    bool verifyParticles();
+#endif
+}
+
+#endif //PONG_VK_PARTICLES_H
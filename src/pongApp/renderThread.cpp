@@ -0,0 +1,278 @@
+#include "renderThread.h"
+#include <cstdio>
+#include "../clock.h"
+#include "../logger.h"
+
+namespace Pong {
+
+    Renderer::QuadColumns getSnapshotQuads(const RenderSnapshot* snapshot) {
+        Renderer::QuadColumns quads;
+        quads.positionX = snapshot->positionX;
+        quads.positionY = snapshot->positionY;
+        quads.rotation = snapshot->rotation;
+        quads.scaleX = snapshot->scaleX;
+        quads.scaleY = snapshot->scaleY;
+        quads.count = snapshot->count;
+        return quads;
+    }
+
+    Renderer::ParticleQuads getSnapshotParticles(const ParticleSnapshot* snapshot) {
+        Renderer::ParticleQuads particles;
+        particles.positionX = snapshot->positionX;
+        particles.positionY = snapshot->positionY;
+        particles.size = snapshot->size;
+        particles.colorR = snapshot->colorR;
+        particles.colorG = snapshot->colorG;
+        particles.colorB = snapshot->colorB;
+        particles.alpha = snapshot->alpha;
+        particles.count = snapshot->count;
+        return particles;
+    }
+
+    static void drawPacket(Renderer::Renderer* renderer, const RenderPacket* packet) {
+        Renderer::QuadColumns quads = getSnapshotQuads(&packet->snapshot);
+        Renderer::drawQuads(renderer, &quads, {1.0f, 1.0f, 1.0f});
+
+        Renderer::ParticleQuads particles = getSnapshotParticles(&packet->particles);
+        Renderer::drawParticles(renderer, &particles);
+
+        if (Renderer::isGpuBallsEnabled(&renderer->gpuBalls)) {
+            Renderer::setGpuBallColliders(renderer, packet->snapshot.paddleBounds, packet->snapshot.paddleCount);
+        }
+    }
+
+    // The net and the top and bottom borders only move when the window is
+    // resized, so they go in the renderer's static layer rather than being
+    // drawn every frame.
+    static void buildArena(Renderer::Renderer* renderer, glm::vec2 arenaHalfSize) {
+        constexpr float BORDER_THICKNESS = 4.0f;
+        constexpr float NET_WIDTH = 4.0f;
+        constexpr float NET_DASH = 16.0f;
+        constexpr float NET_SPACING = 32.0f;
+        const glm::vec3 color = {0.5f, 0.5f, 0.5f};
+
+        Renderer::clearStaticLayer(renderer);
+
+        float borderY = arenaHalfSize.y - BORDER_THICKNESS * 0.5f;
+        Renderer::drawStaticQuad(renderer, { 0.0f, borderY, 0.0f }, {0.0f, 0.0f, 1.0f}, 0.0f,
+            { arenaHalfSize.x * 2.0f, BORDER_THICKNESS, 1.0f }, color);
+        Renderer::drawStaticQuad(renderer, { 0.0f, -borderY, 0.0f }, {0.0f, 0.0f, 1.0f}, 0.0f,
+            { arenaHalfSize.x * 2.0f, BORDER_THICKNESS, 1.0f }, color);
+
+        for (float y = -arenaHalfSize.y + NET_SPACING * 0.5f; y < arenaHalfSize.y; y += NET_SPACING) {
+            Renderer::drawStaticQuad(renderer, { 0.0f, y, 0.0f }, {0.0f, 0.0f, 1.0f}, 0.0f,
+                { NET_WIDTH, NET_DASH, 1.0f }, color);
+        }
+    }
+
+    static void runRenderThread(RenderThread* renderThread) {
+
+        Renderer::Renderer* renderer = renderThread->renderer;
+        FrameStats* frameStats = renderThread->frameStats;
+
+        bool isResized = false;
+        uint32_t resizeCount = 0;
+        // What the static layer was last laid out for - nothing, until the
+        // first packet arrives.
+        uint32_t arenaResizeCount = 0;
+        glm::vec2 arenaHalfSize = {0.0f, 0.0f};
+        uint64_t lastPresent = Clock::nowNanos();
+        uint64_t reportStart = lastPresent;
+        // Only changes once a second, so it's laid out once a second too.
+        char hudText[64] = "-- fps";
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(renderThread->sleepMutex);
+                renderThread->wakeCondition.wait(lock, [renderThread]() {
+                    return !renderThread->isRunning.load(std::memory_order_acquire)
+                        || (renderThread->readyPacket.load(std::memory_order_acquire) & RENDER_PACKET_NEW);
+                });
+            }
+
+            if (!renderThread->isRunning.load(std::memory_order_acquire)) break;
+
+            // Take the newest packet and give back the one we last drew.
+            renderThread->readPacket = renderThread->readyPacket.exchange(renderThread->readPacket,
+                std::memory_order_acq_rel) & ~RENDER_PACKET_NEW;
+            const RenderPacket* packet = &renderThread->packets[renderThread->readPacket];
+
+            if (packet->resizeCount != resizeCount) {
+                resizeCount = packet->resizeCount;
+                isResized = true;
+            }
+
+            // Nothing to draw into while minimised - keep taking packets so the
+            // game thread's stay fresh, and pick back up once it's restored.
+            // The packet's input is held on to for the first frame drawn.
+            if (renderer->backend == Renderer::Backend::VULKAN
+                && (packet->framebufferWidth == 0 || packet->framebufferHeight == 0)) {
+                Renderer::setFrameInputTime(renderer, packet->snapshot.inputNanos);
+                lastPresent = Clock::nowNanos();
+                continue;
+            }
+
+            // Re-laid out here rather than as soon as the resize is seen, so
+            // it isn't laid out for a minimised window's empty arena.
+            if (packet->resizeCount != arenaResizeCount || packet->arenaHalfSize != arenaHalfSize) {
+                arenaResizeCount = packet->resizeCount;
+                arenaHalfSize = packet->arenaHalfSize;
+                buildArena(renderer, arenaHalfSize);
+
+                if (Renderer::isGpuBallsEnabled(&renderer->gpuBalls)) renderer->gpuBalls.arenaHalfSize = arenaHalfSize;
+            }
+
+            renderer->deviceData.framebufferWidth = packet->framebufferWidth;
+            renderer->deviceData.framebufferHeight = packet->framebufferHeight;
+
+            drawPacket(renderer, packet);
+
+            if (renderThread->showHud) {
+                const Renderer::ViewRect& view = renderer->camera.viewRect;
+                Renderer::drawText(renderer, hudText, { view.minX + 10.0f, view.maxY - 10.0f }, 20.0f,
+                    {1.0f, 1.0f, 1.0f});
+            }
+
+            Renderer::setFrameInputTime(renderer, packet->snapshot.inputNanos);
+            Renderer::Status renderStatus = Renderer::drawFrame(renderer, &isResized);
+
+            if (renderStatus == Renderer::Status::FAILURE) {
+                PONG_ERROR("Error drawing frame - stopping render thread!");
+                renderThread->hasFailed.store(true, std::memory_order_release);
+                break;
+            } else if (renderStatus == Renderer::Status::SKIPPED_FRAME) {
+                if (Renderer::recreateSwapchain(renderer) != VK_SUCCESS) {
+                    PONG_ERROR("Failed to re-create swapchain - stopping render thread!");
+                    renderThread->hasFailed.store(true, std::memory_order_release);
+                    break;
+                }
+                isResized = false;
+            }
+
+            // Collect any frames which have made it to the screen since last time.
+            Renderer::FrameLatency latency;
+            while (Renderer::popFrameLatency(renderer, &latency)) {
+                if (latency.inputNanos == 0) continue;
+                recordLatency(frameStats, Clock::toMicros(latency.submitNanos - latency.inputNanos),
+                    Clock::toMicros(latency.presentNanos - latency.inputNanos),
+                    latency.presentCompleteNanos ? static_cast<int64_t>(
+                        Clock::toMicros(latency.presentCompleteNanos - latency.inputNanos)) : -1);
+            }
+
+            uint64_t presented = Clock::nowNanos();
+            recordFrame(frameStats, packet->cpuMicros, renderer->stats.lastGpuTimeMicros,
+                Clock::toMicros(presented - lastPresent));
+            lastPresent = presented;
+
+            // FPS counter - reports frame time percentiles and hitches for the last second.
+            if (presented - reportStart > Clock::NANOS_PER_SECOND) {
+                HistogramSummary presents = summariseHistogram(&frameStats->presentInterval.interval);
+                snprintf(hudText, sizeof(hudText), "%llu fps  p99 %.1f ms",
+                    static_cast<unsigned long long>(presents.count), presents.p99 / 1000.0);
+
+                reportFrameStatsInterval(frameStats);
+                reportStart = presented;
+
+                // Tallied from the events the GPU balls read back.
+                if (Renderer::isGpuBallsEnabled(&renderer->gpuBalls)) {
+                    const Renderer::GpuBallStats& balls = renderer->gpuBalls.stats;
+                    PONG_INFO("GPU balls: {0} paddle hits, {1} out left, {2} out right", balls.colliderHits,
+                        balls.goalsLeft, balls.goalsRight);
+                }
+            }
+
+            Renderer::flushRenderer(renderer);
+        }
+    }
+
+    bool initialiseRenderThread(RenderThread* renderThread, Renderer::Renderer* renderer, FrameStats* frameStats,
+        uint32_t snapshotCapacity, uint32_t particleCapacity) {
+
+        renderThread->renderer = renderer;
+        renderThread->frameStats = frameStats;
+
+        for (uint32_t i = 0; i < RENDER_PACKET_COUNT; i++) {
+            RenderPacket* packet = &renderThread->packets[i];
+            bool isAllocated = initialiseRenderSnapshot(&packet->snapshot, snapshotCapacity);
+            if (isAllocated && !initialiseParticleSnapshot(&packet->particles, particleCapacity)) {
+                destroyRenderSnapshot(&packet->snapshot);
+                isAllocated = false;
+            }
+
+            if (!isAllocated) {
+                for (uint32_t j = 0; j < i; j++) {
+                    destroyRenderSnapshot(&renderThread->packets[j].snapshot);
+                    destroyParticleSnapshot(&renderThread->packets[j].particles);
+                }
+                PONG_ERROR("Failed to allocate render packets!");
+                return false;
+            }
+        }
+
+        renderThread->writePacket = 0;
+        renderThread->readPacket = 1;
+        renderThread->readyPacket.store(2, std::memory_order_relaxed);
+        renderThread->packetsSkipped = 0;
+        renderThread->hasFailed.store(false, std::memory_order_relaxed);
+        renderThread->isRunning.store(true, std::memory_order_release);
+        renderThread->thread = std::thread(runRenderThread, renderThread);
+
+        PONG_INFO("Started render thread");
+
+        return true;
+    }
+
+    void shutdownRenderThread(RenderThread* renderThread) {
+
+        {
+            std::lock_guard<std::mutex> lock(renderThread->sleepMutex);
+            renderThread->isRunning.store(false, std::memory_order_release);
+        }
+        renderThread->wakeCondition.notify_one();
+
+        if (renderThread->thread.joinable()) renderThread->thread.join();
+
+        for (uint32_t i = 0; i < RENDER_PACKET_COUNT; i++) {
+            destroyRenderSnapshot(&renderThread->packets[i].snapshot);
+            destroyParticleSnapshot(&renderThread->packets[i].particles);
+        }
+
+        PONG_INFO("Stopped render thread ({0} packets published faster than they could be drawn)",
+            renderThread->packetsSkipped);
+    }
+
+    RenderPacket* getRenderPacket(RenderThread* renderThread) {
+        return &renderThread->packets[renderThread->writePacket];
+    }
+
+    void publishRenderPacket(RenderThread* renderThread) {
+
+        // Any input a skipped packet responded to is older than this packet's own.
+        RenderSnapshot* snapshot = &renderThread->packets[renderThread->writePacket].snapshot;
+        if (renderThread->skippedInputNanos != 0) {
+            snapshot->inputNanos = renderThread->skippedInputNanos;
+            renderThread->skippedInputNanos = 0;
+        }
+
+        uint32_t previous = renderThread->readyPacket.exchange(renderThread->writePacket | RENDER_PACKET_NEW,
+            std::memory_order_acq_rel);
+
+        // The render thread never took the last one - it's ours to overwrite now.
+        renderThread->writePacket = previous & ~RENDER_PACKET_NEW;
+        if (previous & RENDER_PACKET_NEW) {
+            renderThread->packetsSkipped++;
+            renderThread->skippedInputNanos = renderThread->packets[renderThread->writePacket].snapshot.inputNanos;
+        }
+
+        // Taking the lock (briefly) makes sure the render thread can't be between
+        // checking for a packet and going to sleep, so the wake-up isn't lost.
+        {
+            std::lock_guard<std::mutex> lock(renderThread->sleepMutex);
+        }
+        renderThread->wakeCondition.notify_one();
+    }
+
+    bool hasRenderThreadFailed(const RenderThread* renderThread) {
+        return renderThread->hasFailed.load(std::memory_order_acquire);
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef PONG_VK_RENDERTHREAD_H
+#define PONG_VK_RENDERTHREAD_H
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "game.h"
+#include "particles.h"
+#include "frameStats.h"
+#include "../renderer/renderer.h"
+
+// Runs the renderer on its own thread.
+//
+// The game thread fills in a render packet - everything needed to draw one
+// frame - and publishes it. The render thread draws whichever packet was
+// published most recently. Handoff goes through three packets: one being
+// written, one being drawn and one ready in between. Publishing swaps the
+// written packet with the ready one, and the render thread swaps the ready
+// one with the one it's finished drawing. Neither side ever waits for the
+// other, so a slow acquire, fence wait or swapchain recreation never holds
+// up the simulation. If the game thread publishes twice before the render
+// thread gets round to it, the older packet is simply overwritten.
+//
+// Once started, the render thread owns the renderer and the frame stats.
+// Nothing else may touch either until the thread has been shut down.
+
+namespace Pong {
+
+    struct RenderPacket {
+        RenderSnapshot snapshot;
+        // Drawn over the snapshot, as of the last tick.
+        ParticleSnapshot particles;
+        // Game thread time spent producing this packet.
+        uint64_t cpuMicros          {0};
+        // Size to (re)create the swapchain at - 0x0 while minimised.
+        int framebufferWidth        {0};
+        int framebufferHeight       {0};
+        // Bumped by the game thread every time the window is resized.
+        uint32_t resizeCount        {0};
+        // The game's arena, which follows the window - the net and borders
+        // are laid out to it.
+        glm::vec2 arenaHalfSize     {0.0f, 0.0f};
+    };
+
+    constexpr uint32_t RENDER_PACKET_COUNT = 3;
+    // Set on the ready packet index until the render thread has taken it.
+    constexpr uint32_t RENDER_PACKET_NEW = 1u << 31;
+
+    struct RenderThread {
+        Renderer::Renderer* renderer            {nullptr};
+        FrameStats* frameStats                  {nullptr};
+        // Draws the frame rate over the game - set before starting the thread.
+        bool showHud                            {false};
+        RenderPacket packets[RENDER_PACKET_COUNT];
+        // Only touched by the game thread.
+        uint32_t writePacket                    {0};
+        // Packets overwritten before the render thread ever saw them.
+        uint64_t packetsSkipped                 {0};
+        // The input the last overwritten packet responded to - carried into
+        // the next one published, so its latency is still measured.
+        uint64_t skippedInputNanos              {0};
+        // Only touched by the render thread.
+        uint32_t readPacket                     {1};
+        // Swapped between the two threads.
+        std::atomic<uint32_t> readyPacket       {2};
+        std::atomic<bool> isRunning             {false};
+        std::atomic<bool> hasFailed             {false};
+        // Only used to sleep the render thread while there's nothing new to draw.
+        std::mutex sleepMutex;
+        std::condition_variable wakeCondition;
+        std::thread thread;
+    };
+
+    // Allocates the packets and starts drawing with the given renderer, which
+    // must already be initialised.
+    bool initialiseRenderThread(RenderThread*, Renderer::Renderer*, FrameStats*, uint32_t snapshotCapacity,
+        uint32_t particleCapacity);
+    // Waits for the current frame to finish and stops the thread. The renderer
+    // can be used (or cleaned up) from the calling thread afterwards.
+    void shutdownRenderThread(RenderThread*);
+
+    // The packet the game thread is free to write into.
+    RenderPacket* getRenderPacket(RenderThread*);
+    // Hands the written packet over to be drawn.
+    void publishRenderPacket(RenderThread*);
+    // True once the renderer has hit an error it can't recover from.
+    bool hasRenderThreadFailed(const RenderThread*);
+
+    // The snapshot's columns, in the form the renderer culls and draws them.
+    Renderer::QuadColumns getSnapshotQuads(const RenderSnapshot*);
+    Renderer::ParticleQuads getSnapshotParticles(const ParticleSnapshot*);
+}
+
+#endif //PONG_VK_RENDERTHREAD_H
@@ -0,0 +1,227 @@
+#include "replay.h"
+#include <cstdlib>
+#include <cstring>
+#include "../logger.h"
+
+namespace Pong {
+
+    static_assert(sizeof(ReplayHeader) == 40, "The replay header is written to disk as-is");
+
+    template <typename T>
+    static bool writeValue(FILE* file, const T& value) {
+        return fwrite(&value, sizeof(T), 1, file) == 1;
+    }
+
+    template <typename T>
+    static bool readValue(ReplayPlayer* player, T* value) {
+        if (player->size - player->cursor < sizeof(T)) return false;
+        memcpy(value, player->data + player->cursor, sizeof(T));
+        player->cursor += sizeof(T);
+        return true;
+    }
+
+    // ----------------------------- RECORDING ----------------------------------
+
+    static void flushRun(ReplayRecorder* recorder) {
+        if (recorder->runTicks == 0) return;
+
+        uint8_t flags = recorder->isArenaChanged ? REPLAY_RUN_ARENA : REPLAY_RUN_NONE;
+
+        writeValue(recorder->file, recorder->runTicks);
+        writeValue(recorder->file, recorder->runInput.buttons);
+        writeValue(recorder->file, flags);
+        if (recorder->isArenaChanged) {
+            writeValue(recorder->file, recorder->arenaHalfSize.x);
+            writeValue(recorder->file, recorder->arenaHalfSize.y);
+        }
+
+        recorder->runTicks = 0;
+        recorder->isArenaChanged = false;
+    }
+
+    bool beginRecording(ReplayRecorder* recorder, const char* path, uint32_t tickRate, uint32_t entityCapacity,
+        glm::vec2 arenaHalfSize) {
+
+        *recorder = ReplayRecorder{};
+
+        recorder->file = fopen(path, "wb");
+        if (!recorder->file) {
+            PONG_ERROR("Failed to open replay file for writing: {0}", path);
+            return false;
+        }
+
+        recorder->header.tickRate = tickRate;
+        recorder->header.entityCapacity = entityCapacity;
+        recorder->header.arenaHalfWidth = arenaHalfSize.x;
+        recorder->header.arenaHalfHeight = arenaHalfSize.y;
+        recorder->arenaHalfSize = arenaHalfSize;
+
+        // Placeholder - the tick count and hash are filled in by endRecording.
+        writeValue(recorder->file, recorder->header);
+
+        PONG_INFO("Recording replay to {0}", path);
+        return true;
+    }
+
+    void recordTicks(ReplayRecorder* recorder, TickInput input, glm::vec2 arenaHalfSize, uint32_t tickCount) {
+        if (!recorder->file || tickCount == 0) return;
+
+        bool isArenaChanged = arenaHalfSize != recorder->arenaHalfSize;
+
+        if (input.buttons != recorder->runInput.buttons || isArenaChanged
+            || recorder->runTicks > UINT32_MAX - tickCount) {
+            flushRun(recorder);
+        }
+
+        if (isArenaChanged) {
+            recorder->arenaHalfSize = arenaHalfSize;
+            recorder->isArenaChanged = true;
+        }
+
+        recorder->runInput = input;
+        recorder->runTicks += tickCount;
+        recorder->header.tickCount += tickCount;
+    }
+
+    void endRecording(ReplayRecorder* recorder, const GameState* game) {
+        if (!recorder->file) return;
+
+        flushRun(recorder);
+
+        recorder->header.finalHash = hashGameState(game);
+
+        fseek(recorder->file, 0, SEEK_SET);
+        writeValue(recorder->file, recorder->header);
+
+        if (ferror(recorder->file)) {
+            PONG_ERROR("Failed to write replay file!");
+        } else {
+            PONG_INFO("Recorded {0} ticks (final state {1:016x})", recorder->header.tickCount,
+                recorder->header.finalHash);
+        }
+
+        fclose(recorder->file);
+        recorder->file = nullptr;
+    }
+
+    // ----------------------------- PLAYBACK -----------------------------------
+
+    bool openReplay(ReplayPlayer* player, const char* path) {
+
+        *player = ReplayPlayer{};
+
+        FILE* file = fopen(path, "rb");
+        if (!file) {
+            PONG_ERROR("Failed to open replay file: {0}", path);
+            return false;
+        }
+
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        if (size < static_cast<long>(sizeof(ReplayHeader))) {
+            PONG_ERROR("Replay file {0} is too small to be a replay", path);
+            fclose(file);
+            return false;
+        }
+
+        player->size = static_cast<size_t>(size);
+        player->data = static_cast<uint8_t*>(malloc(player->size));
+
+        bool isRead = player->data && fread(player->data, 1, player->size, file) == player->size;
+        fclose(file);
+
+        if (!isRead) {
+            PONG_ERROR("Failed to read replay file: {0}", path);
+            closeReplay(player);
+            return false;
+        }
+
+        readValue(player, &player->header);
+
+        if (player->header.magic != REPLAY_MAGIC || player->header.version != REPLAY_VERSION
+            || player->header.tickRate == 0) {
+            PONG_ERROR("{0} is not a supported replay file", path);
+            closeReplay(player);
+            return false;
+        }
+
+        rewindReplay(player);
+        return true;
+    }
+
+    void closeReplay(ReplayPlayer* player) {
+        free(player->data);
+        *player = ReplayPlayer{};
+    }
+
+    void rewindReplay(ReplayPlayer* player) {
+        player->cursor = sizeof(ReplayHeader);
+        player->runInput = TickInput{};
+        player->runTicks = 0;
+        player->arenaHalfSize = { player->header.arenaHalfWidth, player->header.arenaHalfHeight };
+    }
+
+    bool nextReplayTick(ReplayPlayer* player, TickInput* input, glm::vec2* arenaHalfSize) {
+
+        while (player->runTicks == 0) {
+            if (player->cursor == player->size) return false;
+
+            uint8_t flags = REPLAY_RUN_NONE;
+            bool isValid = readValue(player, &player->runTicks)
+                && readValue(player, &player->runInput.buttons)
+                && readValue(player, &flags);
+
+            if (isValid && (flags & REPLAY_RUN_ARENA)) {
+                isValid = readValue(player, &player->arenaHalfSize.x) && readValue(player, &player->arenaHalfSize.y);
+            }
+
+            if (!isValid) {
+                PONG_WARN("Replay file is truncated - stopping early");
+                player->cursor = player->size;
+                player->runTicks = 0;
+                return false;
+            }
+        }
+
+        player->runTicks--;
+        *input = player->runInput;
+        *arenaHalfSize = player->arenaHalfSize;
+        return true;
+    }
+
+    // ------------------------------ HASHING -----------------------------------
+
+    static uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    uint64_t hashGameState(const GameState* game) {
+
+        const EntityStore* entities = &game->entities;
+        size_t columnSize = entities->count * sizeof(float);
+
+        uint64_t hash = 0xCBF29CE484222325ull;
+
+        hash = hashBytes(hash, entities->transforms.positionX, columnSize);
+        hash = hashBytes(hash, entities->transforms.positionY, columnSize);
+        hash = hashBytes(hash, entities->transforms.scaleX, columnSize);
+        hash = hashBytes(hash, entities->transforms.scaleY, columnSize);
+        hash = hashBytes(hash, entities->transforms.rotation, columnSize);
+        hash = hashBytes(hash, entities->velocities.x, columnSize);
+        hash = hashBytes(hash, entities->velocities.y, columnSize);
+
+        hash = hashBytes(hash, &game->ballDirection, sizeof(game->ballDirection));
+        hash = hashBytes(hash, &game->oldDirection, sizeof(game->oldDirection));
+        hash = hashBytes(hash, &game->isResetting, sizeof(game->isResetting));
+        hash = hashBytes(hash, &game->resetElapsed, sizeof(game->resetElapsed));
+        hash = hashBytes(hash, &game->tick, sizeof(game->tick));
+
+        return hash;
+    }
+}
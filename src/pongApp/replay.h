@@ -0,0 +1,91 @@
+#ifndef PONG_VK_REPLAY_H
+#define PONG_VK_REPLAY_H
+
+#include <cstdint>
+#include <cstdio>
+#include <glm/glm.hpp>
+#include "game.h"
+
+namespace Pong {
+
+    // Replays record everything the simulation consumes - the per-tick input
+    // and the arena size - so a session can be re-run without a window or a
+    // renderer and produce exactly the same state. The simulation only ever
+    // advances in fixed steps, so the tick rate is all the timing that's needed.
+    //
+    // File layout (little endian, no padding):
+    //
+    //  - a ReplayHeader,
+    //  - a list of runs: uint32_t ticks, uint8_t buttons, uint8_t flags, followed
+    //    by two floats (the new arena half size) when REPLAY_RUN_ARENA is set.
+    //
+    // A run covers consecutive ticks with identical input, so holding a key for
+    // a few seconds costs six bytes rather than a few hundred.
+
+    constexpr uint32_t REPLAY_MAGIC = 0x4C505250; // "PRPL"
+    constexpr uint32_t REPLAY_VERSION = 1;
+
+    enum ReplayRunFlags : uint8_t {
+        REPLAY_RUN_NONE     = 0,
+        // The arena was resized before this run.
+        REPLAY_RUN_ARENA    = 1 << 0
+    };
+
+    struct ReplayHeader {
+        uint32_t magic              {REPLAY_MAGIC};
+        uint32_t version            {REPLAY_VERSION};
+        uint32_t tickRate           {0};
+        uint32_t entityCapacity     {0};
+        float arenaHalfWidth        {0.0f};
+        float arenaHalfHeight       {0.0f};
+        uint64_t tickCount          {0};
+        // hashGameState() after the last tick - lets a replay check it really did
+        // reproduce the recording.
+        uint64_t finalHash          {0};
+    };
+
+    struct ReplayRecorder {
+        FILE* file                  {nullptr};
+        ReplayHeader header;
+
+        // The run being built - only written out once the input or arena changes.
+        TickInput runInput;
+        uint32_t runTicks           {0};
+        glm::vec2 arenaHalfSize     {0.0f, 0.0f};
+        bool isArenaChanged         {false};
+    };
+
+    struct ReplayPlayer {
+        ReplayHeader header;
+        uint8_t* data               {nullptr};
+        size_t size                 {0};
+        size_t cursor               {0};
+
+        TickInput runInput;
+        uint32_t runTicks           {0};
+        glm::vec2 arenaHalfSize     {0.0f, 0.0f};
+    };
+
+    // Call with the game's initial arena size, before its first tick.
+    bool beginRecording(ReplayRecorder*, const char* path, uint32_t tickRate, uint32_t entityCapacity,
+        glm::vec2 arenaHalfSize);
+    // Records 'tickCount' ticks simulated with the given input and arena size.
+    void recordTicks(ReplayRecorder*, TickInput, glm::vec2 arenaHalfSize, uint32_t tickCount);
+    // Flushes the last run and stamps the header with the final state of the game.
+    void endRecording(ReplayRecorder*, const GameState*);
+
+    // Loads the whole file up front so playback never touches the disk.
+    bool openReplay(ReplayPlayer*, const char* path);
+    void closeReplay(ReplayPlayer*);
+    // Starts playback again from the first tick.
+    void rewindReplay(ReplayPlayer*);
+    // Fetches the input and arena size for the next tick. Returns false once
+    // every recorded tick has been played.
+    bool nextReplayTick(ReplayPlayer*, TickInput*, glm::vec2* arenaHalfSize);
+
+    // FNV-1a over everything a tick can change. Two runs are bit-identical if
+    // and only if (barring collisions) their hashes match.
+    uint64_t hashGameState(const GameState*);
+}
+
+#endif //PONG_VK_REPLAY_H
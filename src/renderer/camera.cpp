@@ -0,0 +1,27 @@
+#include "camera.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace Renderer {
+
+    void updateCamera(Camera* camera, glm::vec2 extent) {
+
+        camera->extent = extent;
+
+        glm::vec2 halfSize = extent * (0.5f / camera->zoom);
+
+        // Set the view
+        glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(-camera->position, -1.0f));
+
+        // Vulkan's clip space has y pointing down, so top and bottom are swapped
+        // to keep world +y pointing up.
+        glm::mat4 proj = glm::ortho(-halfSize.x, halfSize.x, halfSize.y, -halfSize.y, -1.0f, 1.0f);
+
+        glm::mat4 viewProjection = proj * view;
+
+        if (viewProjection != camera->viewProjection) {
+            camera->viewProjection = viewProjection;
+            camera->viewRect = getViewRect(viewProjection);
+            camera->version++;
+        }
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef PONG_VK_CAMERA_H
+#define PONG_VK_CAMERA_H
+
+#include <glm/glm.hpp>
+#include "culling.h"
+
+namespace Renderer {
+
+    // An orthographic camera. One world unit covers one pixel at a zoom of 1,
+    // so resizing the window shows more (or less) of the world rather than
+    // stretching it. World +y is up the screen.
+    //
+    // The view projection is worked out once per frame and handed to the
+    // vertex shader as a push constant - quads only carry their own model
+    // transform.
+    struct Camera {
+        glm::vec2 position              {0.0f};
+        float zoom                      {1.0f};
+        // Size of the image being drawn to, in pixels.
+        glm::vec2 extent                {800.0f, 600.0f};
+        glm::mat4 viewProjection        {1.0f};
+        ViewRect viewRect;
+        // Bumped whenever the view projection changes.
+        uint64_t version                {0};
+    };
+
+    // Recomputes the view projection (and what it can see) for the given extent.
+    void updateCamera(Camera*, glm::vec2 extent);
+}
+
+#endif //PONG_VK_CAMERA_H
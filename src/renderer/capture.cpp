@@ -0,0 +1,489 @@
+#include "capture.h"
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include "../logger.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+namespace Renderer {
+
+    // ============================== ENCODER THREAD ===============================
+
+    struct CaptureWorker {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable workAvailable;
+        std::condition_variable workFinished;
+        // FIFO of slot indices waiting to be encoded. It never holds more than
+        // slotCount entries since a slot can only be queued once.
+        uint32_t* queue             {nullptr};
+        uint32_t capacity           {0};
+        uint32_t head               {0};
+        uint32_t count              {0};
+        bool isRunning              {true};
+        bool isBusy                 {false};
+        // Scratch memory used for swizzling/colour conversion.
+        uint8_t* scratch            {nullptr};
+        size_t scratchSize          {0};
+        // Y4M output state. A new segment is started whenever the extent changes
+        // since a Y4M stream can't change resolution mid-stream.
+        FILE* videoFile             {nullptr};
+        VkExtent2D videoExtent      {0, 0};
+        uint32_t videoSegment       {0};
+        uint64_t encodedFrames      {0};
+    };
+
+    static bool isBGRFormat(VkFormat format) {
+        return format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_B8G8R8A8_UNORM;
+    }
+
+    static bool isSupportedFormat(VkFormat format) {
+        return isBGRFormat(format) || format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_R8G8B8A8_UNORM;
+    }
+
+    static uint8_t* reserveScratch(CaptureWorker* worker, size_t size) {
+        if (worker->scratchSize < size) {
+            free(worker->scratch);
+            worker->scratch = static_cast<uint8_t*>(malloc(size));
+            worker->scratchSize = size;
+        }
+        return worker->scratch;
+    }
+
+    static void encodePNG(CaptureData* capture, CaptureWorker* worker, CaptureSlot* slot) {
+
+        uint32_t pixelCount = capture->extent.width * capture->extent.height;
+        auto* source = static_cast<const uint8_t*>(slot->mappedData);
+        uint8_t* rgba = reserveScratch(worker, pixelCount * 4);
+
+        // Swapchain images are usually BGRA - PNG wants RGBA. The alpha channel
+        // of a presented image is meaningless so we force it to opaque.
+        uint32_t red = isBGRFormat(capture->imageFormat) ? 2 : 0;
+        uint32_t blue = 2 - red;
+        for (uint32_t i = 0; i < pixelCount; i++) {
+            rgba[i * 4 + 0] = source[i * 4 + red];
+            rgba[i * 4 + 1] = source[i * 4 + 1];
+            rgba[i * 4 + 2] = source[i * 4 + blue];
+            rgba[i * 4 + 3] = 255;
+        }
+
+        char path[512];
+        snprintf(path, sizeof(path), "%s_%06llu.png", capture->outputPath,
+            static_cast<unsigned long long>(slot->frameNumber));
+
+        if (!stbi_write_png(path, static_cast<int>(capture->extent.width), static_cast<int>(capture->extent.height),
+            4, rgba, static_cast<int>(capture->extent.width * 4))) {
+            PONG_ERROR("Failed to write capture frame: {0}", path);
+        }
+    }
+
+    static void encodeY4M(CaptureData* capture, CaptureWorker* worker, CaptureSlot* slot) {
+
+        VkExtent2D extent = capture->extent;
+
+        if (worker->videoFile == nullptr || worker->videoExtent.width != extent.width
+            || worker->videoExtent.height != extent.height) {
+
+            if (worker->videoFile) {
+                fclose(worker->videoFile);
+                worker->videoSegment++;
+            }
+
+            char path[512];
+            snprintf(path, sizeof(path), "%s_%u.y4m", capture->outputPath, worker->videoSegment);
+
+            worker->videoFile = fopen(path, "wb");
+            worker->videoExtent = extent;
+
+            if (!worker->videoFile) {
+                PONG_ERROR("Failed to open capture stream: {0}", path);
+                return;
+            }
+
+            // 4:4:4 avoids having to chroma subsample on the encoder thread.
+            fprintf(worker->videoFile, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C444\n",
+                extent.width, extent.height, capture->frameRate);
+        }
+
+        uint32_t pixelCount = extent.width * extent.height;
+        auto* source = static_cast<const uint8_t*>(slot->mappedData);
+        uint8_t* planes = reserveScratch(worker, pixelCount * 3);
+        uint8_t* yPlane = planes;
+        uint8_t* uPlane = planes + pixelCount;
+        uint8_t* vPlane = planes + pixelCount * 2;
+
+        uint32_t red = isBGRFormat(capture->imageFormat) ? 2 : 0;
+        uint32_t blue = 2 - red;
+
+        // BT.601 limited range integer conversion.
+        for (uint32_t i = 0; i < pixelCount; i++) {
+            int r = source[i * 4 + red];
+            int g = source[i * 4 + 1];
+            int b = source[i * 4 + blue];
+            yPlane[i] = static_cast<uint8_t>(16 + ((66 * r + 129 * g + 25 * b + 128) >> 8));
+            uPlane[i] = static_cast<uint8_t>(128 + ((-38 * r - 74 * g + 112 * b + 128) >> 8));
+            vPlane[i] = static_cast<uint8_t>(128 + ((112 * r - 94 * g - 18 * b + 128) >> 8));
+        }
+
+        fputs("FRAME\n", worker->videoFile);
+        fwrite(planes, 1, pixelCount * 3, worker->videoFile);
+    }
+
+    static void runCaptureWorker(CaptureData* capture, CaptureWorker* worker) {
+
+        while (true) {
+            uint32_t slotIndex;
+            {
+                std::unique_lock<std::mutex> lock(worker->mutex);
+                worker->workAvailable.wait(lock, [worker] { return worker->count > 0 || !worker->isRunning; });
+
+                if (worker->count == 0) break;
+
+                slotIndex = worker->queue[worker->head];
+                worker->head = (worker->head + 1) % worker->capacity;
+                worker->count--;
+                worker->isBusy = true;
+            }
+
+            CaptureSlot* slot = &capture->slots[slotIndex];
+
+            if (capture->format == CaptureFormat::PNG) {
+                encodePNG(capture, worker, slot);
+            } else if (capture->format == CaptureFormat::Y4M) {
+                encodeY4M(capture, worker, slot);
+            }
+
+            worker->encodedFrames++;
+            slot->state.store(CaptureSlotState::FREE, std::memory_order_release);
+
+            {
+                std::lock_guard<std::mutex> lock(worker->mutex);
+                worker->isBusy = false;
+            }
+            worker->workFinished.notify_all();
+        }
+    }
+
+    static void submitToWorker(CaptureWorker* worker, uint32_t slotIndex) {
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->queue[(worker->head + worker->count) % worker->capacity] = slotIndex;
+            worker->count++;
+        }
+        worker->workAvailable.notify_one();
+    }
+
+    static void waitForWorker(CaptureWorker* worker) {
+        std::unique_lock<std::mutex> lock(worker->mutex);
+        worker->workFinished.wait(lock, [worker] { return worker->count == 0 && !worker->isBusy; });
+    }
+
+    // ============================== READBACK SLOTS ===============================
+
+    static Status createCaptureSlots(CaptureData* capture, VulkanDeviceData* deviceData, SwapchainData* swapchain) {
+
+        capture->imageFormat = swapchain->swapchainFormat;
+        capture->extent = swapchain->swapchainExtent;
+        capture->imageSize = static_cast<VkDeviceSize>(capture->extent.width) * capture->extent.height * 4;
+
+        for (uint32_t i = 0; i < capture->slotCount; i++) {
+            CaptureSlot& slot = capture->slots[i];
+
+            // Cached memory makes the CPU side reads far cheaper - fall back to
+            // coherent memory if the device doesn't expose any.
+            capture->isCoherent = false;
+            if (Buffers::createBuffer(deviceData, capture->imageSize,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+                slot.readback) != VK_SUCCESS) {
+
+                capture->isCoherent = true;
+                if (Buffers::createBuffer(deviceData, capture->imageSize,
+                    VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    slot.readback) != VK_SUCCESS) {
+
+                    PONG_ERROR("Failed to create capture readback buffer!");
+                    return Status::INITIALIZATION_FAILURE;
+                }
+            }
+
+            // The buffer stays mapped for its whole lifetime. It is only ever read
+            // after the fence of the frame which wrote to it has signalled.
+            if (vkMapMemory(deviceData->logicalDevice, slot.readback.bufferMemory, 0, VK_WHOLE_SIZE, 0,
+                &slot.mappedData) != VK_SUCCESS) {
+                PONG_ERROR("Failed to map capture readback buffer!");
+                return Status::INITIALIZATION_FAILURE;
+            }
+
+            slot.state.store(CaptureSlotState::FREE, std::memory_order_relaxed);
+        }
+
+        return Status::SUCCESS;
+    }
+
+    static void destroyCaptureSlots(CaptureData* capture, VulkanDeviceData* deviceData) {
+
+        for (uint32_t i = 0; i < capture->slotCount; i++) {
+            CaptureSlot& slot = capture->slots[i];
+            if (slot.mappedData) {
+                vkUnmapMemory(deviceData->logicalDevice, slot.readback.bufferMemory);
+                slot.mappedData = nullptr;
+            }
+            Buffers::destroyBuffer(deviceData, slot.readback);
+        }
+    }
+
+    // Hands the selected in-flight slots to the encoder in the order they were
+    // captured. Anything that matches the frame index has already completed.
+    static void collectSlots(CaptureData* capture, VulkanDeviceData* deviceData, bool allFrames, uint32_t frameIndex) {
+
+        uint32_t ready[16];
+        uint32_t readyCount = 0;
+
+        for (uint32_t i = 0; i < capture->slotCount && readyCount < 16; i++) {
+            CaptureSlot& slot = capture->slots[i];
+            if (slot.state.load(std::memory_order_acquire) != CaptureSlotState::IN_FLIGHT) continue;
+            if (!allFrames && slot.frameIndex != frameIndex) continue;
+
+            // Insertion sort on the frame number - there are only ever a handful of slots.
+            uint32_t j = readyCount++;
+            while (j > 0 && capture->slots[ready[j - 1]].frameNumber > slot.frameNumber) {
+                ready[j] = ready[j - 1];
+                j--;
+            }
+            ready[j] = i;
+        }
+
+        for (uint32_t i = 0; i < readyCount; i++) {
+            CaptureSlot& slot = capture->slots[ready[i]];
+
+            if (!capture->isCoherent) {
+                VkMappedMemoryRange range{};
+                range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+                range.memory = slot.readback.bufferMemory;
+                range.offset = 0;
+                range.size = VK_WHOLE_SIZE;
+                vkInvalidateMappedMemoryRanges(deviceData->logicalDevice, 1, &range);
+            }
+
+            slot.state.store(CaptureSlotState::ENCODING, std::memory_order_release);
+            submitToWorker(capture->worker, ready[i]);
+        }
+    }
+
+    // ============================== PUBLIC API ===================================
+
+    Status initialiseCapture(CaptureData* capture, VulkanDeviceData* deviceData, SwapchainData* swapchain,
+        VkCommandPool commandPool, CaptureFormat format, const char* outputPath, uint32_t slotCount) {
+
+        if (format == CaptureFormat::NONE) return Status::SUCCESS;
+
+        if (!(swapchain->imageUsage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)) {
+            PONG_ERROR("Swapchain images can't be used as a transfer source - capture disabled");
+            return Status::FAILURE;
+        }
+
+        if (!isSupportedFormat(swapchain->swapchainFormat)) {
+            PONG_ERROR("Unsupported swapchain format for capture - capture disabled");
+            return Status::FAILURE;
+        }
+
+        // Anything less than three slots would drop every other frame with two
+        // frames in flight.
+        capture->slotCount = std::clamp(slotCount, 3u, 16u);
+        capture->format = format;
+        capture->outputPath = outputPath;
+        capture->commandPool = commandPool;
+        capture->slots = new CaptureSlot[capture->slotCount];
+
+        VkCommandBuffer commandBuffers[16];
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = capture->slotCount;
+
+        if (vkAllocateCommandBuffers(deviceData->logicalDevice, &allocInfo, commandBuffers) != VK_SUCCESS) {
+            PONG_ERROR("Failed to allocate capture command buffers!");
+            cleanupCapture(capture, deviceData);
+            return Status::INITIALIZATION_FAILURE;
+        }
+
+        for (uint32_t i = 0; i < capture->slotCount; i++) {
+            capture->slots[i].commandBuffer = commandBuffers[i];
+        }
+
+        if (createCaptureSlots(capture, deviceData, swapchain) != Status::SUCCESS) {
+            cleanupCapture(capture, deviceData);
+            return Status::INITIALIZATION_FAILURE;
+        }
+
+        capture->worker = new CaptureWorker();
+        capture->worker->capacity = capture->slotCount;
+        capture->worker->queue = static_cast<uint32_t*>(malloc(capture->slotCount * sizeof(uint32_t)));
+        capture->worker->thread = std::thread(runCaptureWorker, capture, capture->worker);
+
+        PONG_INFO("Frame capture enabled with {0} readback slots", capture->slotCount);
+
+        return Status::SUCCESS;
+    }
+
+    VkCommandBuffer recordCapture(CaptureData* capture, VulkanDeviceData* deviceData, SwapchainData* swapchain,
+        uint32_t imageIndex, uint32_t frameIndex) {
+
+        CaptureSlot* slot = nullptr;
+
+        for (uint32_t i = 0; i < capture->slotCount; i++) {
+            if (capture->slots[i].state.load(std::memory_order_acquire) == CaptureSlotState::FREE) {
+                slot = &capture->slots[i];
+                break;
+            }
+        }
+
+        // The encoder has fallen behind - drop this frame rather than wait.
+        if (!slot) {
+            capture->frameNumber++;
+            capture->droppedFrames++;
+            return VK_NULL_HANDLE;
+        }
+
+        VkCommandBuffer commandBuffer = slot->commandBuffer;
+        vkResetCommandBuffer(commandBuffer, 0);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+            return VK_NULL_HANDLE;
+        }
+
+        VkImage image = swapchain->pImages[imageIndex];
+
+        // The render pass leaves the image ready for presentation - move it
+        // into a layout we can copy from once colour output has finished.
+        VkImageMemoryBarrier toTransfer{};
+        toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        toTransfer.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        toTransfer.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toTransfer.image = image;
+        toTransfer.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = { capture->extent.width, capture->extent.height, 1 };
+
+        vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            slot->readback.buffer, 1, &region);
+
+        // Hand the image back to the presentation engine...
+        VkImageMemoryBarrier toPresent = toTransfer;
+        toPresent.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        toPresent.dstAccessMask = 0;
+        toPresent.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        toPresent.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+        // ...and make the copied data visible to the host.
+        VkBufferMemoryBarrier toHost{};
+        toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toHost.buffer = slot->readback.buffer;
+        toHost.offset = 0;
+        toHost.size = VK_WHOLE_SIZE;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr,
+            1, &toHost, 1, &toPresent);
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+            return VK_NULL_HANDLE;
+        }
+
+        slot->frameIndex = frameIndex;
+        slot->frameNumber = capture->frameNumber++;
+        slot->state.store(CaptureSlotState::IN_FLIGHT, std::memory_order_release);
+
+        return commandBuffer;
+    }
+
+    void collectCapture(CaptureData* capture, VulkanDeviceData* deviceData, uint32_t frameIndex) {
+        collectSlots(capture, deviceData, false, frameIndex);
+    }
+
+    Status recreateCapture(CaptureData* capture, VulkanDeviceData* deviceData, SwapchainData* swapchain) {
+
+        // The device is idle at this point, so every in-flight slot is complete.
+        collectSlots(capture, deviceData, true, 0);
+        waitForWorker(capture->worker);
+
+        if (capture->extent.width == swapchain->swapchainExtent.width
+            && capture->extent.height == swapchain->swapchainExtent.height
+            && capture->imageFormat == swapchain->swapchainFormat) {
+            return Status::SUCCESS;
+        }
+
+        destroyCaptureSlots(capture, deviceData);
+        return createCaptureSlots(capture, deviceData, swapchain);
+    }
+
+    void cleanupCapture(CaptureData* capture, VulkanDeviceData* deviceData) {
+
+        if (!capture->slots) return;
+
+        CaptureWorker* worker = capture->worker;
+
+        if (worker) {
+            collectSlots(capture, deviceData, true, 0);
+            {
+                std::lock_guard<std::mutex> lock(worker->mutex);
+                worker->isRunning = false;
+            }
+            worker->workAvailable.notify_one();
+            worker->thread.join();
+
+            if (worker->videoFile) fclose(worker->videoFile);
+
+            PONG_INFO("Frame capture finished: {0} frames encoded, {1} dropped",
+                worker->encodedFrames, capture->droppedFrames);
+
+            free(worker->queue);
+            free(worker->scratch);
+            delete worker;
+            capture->worker = nullptr;
+        }
+
+        destroyCaptureSlots(capture, deviceData);
+
+        for (uint32_t i = 0; i < capture->slotCount; i++) {
+            if (capture->slots[i].commandBuffer != VK_NULL_HANDLE) {
+                vkFreeCommandBuffers(deviceData->logicalDevice, capture->commandPool, 1,
+                    &capture->slots[i].commandBuffer);
+            }
+        }
+
+        delete[] capture->slots;
+        capture->slots = nullptr;
+        capture->slotCount = 0;
+        capture->format = CaptureFormat::NONE;
+    }
+}
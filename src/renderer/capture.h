@@ -0,0 +1,76 @@
+#ifndef PONG_VK_CAPTURE_H
+#define PONG_VK_CAPTURE_H
+
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include "core.h"
+#include "vk/buffers.h"
+#include "vk/vulkanDeviceData.h"
+#include "vk/swapchainData.h"
+
+namespace Renderer {
+
+    // Frame capture copies presented swapchain images into a small ring of
+    // host-visible readback buffers. A slot is only ever read once the
+    // in-flight fence of the frame that wrote it has signalled, and the
+    // actual encoding happens on a background thread - the render loop
+    // never waits on a capture. If every slot is busy the frame is dropped
+    // from the capture instead of stalling.
+
+    enum class CaptureFormat {
+        NONE = 0,
+        PNG,
+        Y4M
+    };
+
+    enum class CaptureSlotState : uint32_t {
+        FREE = 0,
+        IN_FLIGHT,
+        ENCODING
+    };
+
+    struct CaptureSlot {
+        Buffers::BufferData readback                {VK_NULL_HANDLE};
+        VkCommandBuffer commandBuffer               {VK_NULL_HANDLE};
+        void* mappedData                            {nullptr};
+        uint32_t frameIndex                         {0};
+        uint64_t frameNumber                        {0};
+        std::atomic<CaptureSlotState> state         {CaptureSlotState::FREE};
+    };
+
+    // Opaque - owns the encoder thread and its queue.
+    struct CaptureWorker;
+
+    struct CaptureData {
+        CaptureFormat format                        {CaptureFormat::NONE};
+        const char* outputPath                      {"capture"};
+        uint32_t frameRate                          {60};
+        uint32_t slotCount                          {0};
+        CaptureSlot* slots                          {nullptr};
+        CaptureWorker* worker                       {nullptr};
+        VkCommandPool commandPool                   {VK_NULL_HANDLE};
+        VkFormat imageFormat                        {VK_FORMAT_UNDEFINED};
+        VkExtent2D extent                           {0, 0};
+        VkDeviceSize imageSize                      {0};
+        bool isCoherent                             {true};
+        uint64_t frameNumber                        {0};
+        uint64_t droppedFrames                      {0};
+    };
+
+    Status initialiseCapture(CaptureData*, VulkanDeviceData*, SwapchainData*, VkCommandPool,
+        CaptureFormat, const char*, uint32_t = 3);
+    // Records a copy of the given swapchain image into a free slot. Returns
+    // VK_NULL_HANDLE when no slot is available (the frame is dropped).
+    VkCommandBuffer recordCapture(CaptureData*, VulkanDeviceData*, SwapchainData*, uint32_t, uint32_t);
+    // Hands every slot written by the given frame in flight to the encoder.
+    // Must only be called once that frame's fence has signalled.
+    void collectCapture(CaptureData*, VulkanDeviceData*, uint32_t);
+    Status recreateCapture(CaptureData*, VulkanDeviceData*, SwapchainData*);
+    void cleanupCapture(CaptureData*, VulkanDeviceData*);
+
+    inline bool isCaptureEnabled(CaptureData* capture) {
+        return capture->format != CaptureFormat::NONE && capture->slots != nullptr;
+    }
+}
+
+#endif //PONG_VK_CAPTURE_H
@@ -0,0 +1,233 @@
+#include "culling.h"
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "../logger.h"
+
+#if defined(PONG_SIMD_AVX2)
+    #include <immintrin.h>
+#elif defined(PONG_SIMD_SSE2)
+    #include <emmintrin.h>
+#endif
+
+namespace Renderer {
+
+    ViewRect getViewRect(const glm::mat4& viewProjection) {
+
+        glm::mat4 inverse = glm::inverse(viewProjection);
+
+        ViewRect rect = { INFINITY, INFINITY, -INFINITY, -INFINITY };
+
+        const glm::vec2 corners[] = { {-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f} };
+        for (const glm::vec2& corner : corners) {
+            glm::vec4 world = inverse * glm::vec4(corner, 0.0f, 1.0f);
+            rect.minX = std::min(rect.minX, world.x / world.w);
+            rect.minY = std::min(rect.minY, world.y / world.w);
+            rect.maxX = std::max(rect.maxX, world.x / world.w);
+            rect.maxY = std::max(rect.maxY, world.y / world.w);
+        }
+
+        return rect;
+    }
+
+    bool isQuadVisible(const ViewRect& view, float positionX, float positionY, float rotation, float scaleX,
+        float scaleY) {
+
+        // A negative scale mirrors the quad, but it's no smaller for it.
+        float halfX = std::fabs(scaleX) * 0.5f;
+        float halfY = std::fabs(scaleY) * 0.5f;
+
+        // A rotated quad never reaches further than its corners do.
+        if (rotation != 0.0f) {
+            halfX = halfY = std::sqrt(halfX * halfX + halfY * halfY);
+        }
+
+        return positionX + halfX >= view.minX && positionX - halfX <= view.maxX
+            && positionY + halfY >= view.minY && positionY - halfY <= view.maxY;
+    }
+
+    uint32_t cullQuadsScalar(const ViewRect& view, const QuadColumns* quads, uint32_t first, uint32_t count,
+        uint32_t* visible) {
+
+        uint32_t visibleCount = 0;
+
+        for (uint32_t i = first; i < first + count; i++) {
+            visible[visibleCount] = i;
+            visibleCount += isQuadVisible(view, quads->positionX[i], quads->positionY[i],
+                quads->rotation ? quads->rotation[i] : 0.0f, quads->scaleX[i], quads->scaleY[i]);
+        }
+
+        return visibleCount;
+    }
+
+    // ------------------------------ BATCH -------------------------------------
+    // Handles as many whole vectors as it can and finishes the remaining
+    // (< lane count) quads with the scalar loop. The visible lanes of each
+    // vector are packed down without branching - every lane's index is
+    // written, but the count only moves past the visible ones.
+
+#if defined(PONG_SIMD_AVX2)
+
+    constexpr uint32_t LANES = 8;
+
+    static uint32_t cullVectors(const ViewRect& view, const QuadColumns* quads, uint32_t first, uint32_t count,
+        uint32_t* visible) {
+
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 signBit = _mm256_set1_ps(-0.0f);
+        const __m256 minX = _mm256_set1_ps(view.minX);
+        const __m256 minY = _mm256_set1_ps(view.minY);
+        const __m256 maxX = _mm256_set1_ps(view.maxX);
+        const __m256 maxY = _mm256_set1_ps(view.maxY);
+
+        uint32_t visibleCount = 0;
+
+        for (uint32_t i = first; i < first + count; i += LANES) {
+            __m256 x = _mm256_loadu_ps(quads->positionX + i);
+            __m256 y = _mm256_loadu_ps(quads->positionY + i);
+            // Clearing the sign bit gives the absolute scale.
+            __m256 halfX = _mm256_mul_ps(_mm256_andnot_ps(signBit, _mm256_loadu_ps(quads->scaleX + i)), half);
+            __m256 halfY = _mm256_mul_ps(_mm256_andnot_ps(signBit, _mm256_loadu_ps(quads->scaleY + i)), half);
+
+            __m256 radius = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(halfX, halfX), _mm256_mul_ps(halfY, halfY)));
+            __m256 isRotated = quads->rotation
+                ? _mm256_cmp_ps(_mm256_loadu_ps(quads->rotation + i), zero, _CMP_NEQ_UQ) : zero;
+            halfX = _mm256_blendv_ps(halfX, radius, isRotated);
+            halfY = _mm256_blendv_ps(halfY, radius, isRotated);
+
+            __m256 isVisible = _mm256_and_ps(
+                _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(x, halfX), minX, _CMP_GE_OQ),
+                    _mm256_cmp_ps(_mm256_sub_ps(x, halfX), maxX, _CMP_LE_OQ)),
+                _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(y, halfY), minY, _CMP_GE_OQ),
+                    _mm256_cmp_ps(_mm256_sub_ps(y, halfY), maxY, _CMP_LE_OQ)));
+
+            auto mask = static_cast<uint32_t>(_mm256_movemask_ps(isVisible));
+            for (uint32_t lane = 0; lane < LANES; lane++) {
+                visible[visibleCount] = i + lane;
+                visibleCount += (mask >> lane) & 1u;
+            }
+        }
+
+        return visibleCount;
+    }
+
+#elif defined(PONG_SIMD_SSE2)
+
+    constexpr uint32_t LANES = 4;
+
+    static uint32_t cullVectors(const ViewRect& view, const QuadColumns* quads, uint32_t first, uint32_t count,
+        uint32_t* visible) {
+
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 signBit = _mm_set1_ps(-0.0f);
+        const __m128 minX = _mm_set1_ps(view.minX);
+        const __m128 minY = _mm_set1_ps(view.minY);
+        const __m128 maxX = _mm_set1_ps(view.maxX);
+        const __m128 maxY = _mm_set1_ps(view.maxY);
+
+        uint32_t visibleCount = 0;
+
+        for (uint32_t i = first; i < first + count; i += LANES) {
+            __m128 x = _mm_loadu_ps(quads->positionX + i);
+            __m128 y = _mm_loadu_ps(quads->positionY + i);
+            __m128 halfX = _mm_mul_ps(_mm_andnot_ps(signBit, _mm_loadu_ps(quads->scaleX + i)), half);
+            __m128 halfY = _mm_mul_ps(_mm_andnot_ps(signBit, _mm_loadu_ps(quads->scaleY + i)), half);
+
+            // SSE2 has no blend instruction, so select with and/andnot/or instead.
+            __m128 radius = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(halfX, halfX), _mm_mul_ps(halfY, halfY)));
+            __m128 isRotated = quads->rotation ? _mm_cmpneq_ps(_mm_loadu_ps(quads->rotation + i), zero) : zero;
+            halfX = _mm_or_ps(_mm_and_ps(isRotated, radius), _mm_andnot_ps(isRotated, halfX));
+            halfY = _mm_or_ps(_mm_and_ps(isRotated, radius), _mm_andnot_ps(isRotated, halfY));
+
+            __m128 isVisible = _mm_and_ps(
+                _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(x, halfX), minX), _mm_cmple_ps(_mm_sub_ps(x, halfX), maxX)),
+                _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(y, halfY), minY), _mm_cmple_ps(_mm_sub_ps(y, halfY), maxY)));
+
+            auto mask = static_cast<uint32_t>(_mm_movemask_ps(isVisible));
+            for (uint32_t lane = 0; lane < LANES; lane++) {
+                visible[visibleCount] = i + lane;
+                visibleCount += (mask >> lane) & 1u;
+            }
+        }
+
+        return visibleCount;
+    }
+
+#endif
+
+    uint32_t cullQuadsBatch(const ViewRect& view, const QuadColumns* quads, uint32_t first, uint32_t count,
+        uint32_t* visible) {
+
+#if defined(PONG_SIMD_AVX2) || defined(PONG_SIMD_SSE2)
+        uint32_t vectorCount = count - count % LANES;
+        uint32_t visibleCount = cullVectors(view, quads, first, vectorCount, visible);
+        return visibleCount + cullQuadsScalar(view, quads, first + vectorCount, count - vectorCount,
+            visible + visibleCount);
+#else
+        return cullQuadsScalar(view, quads, first, count, visible);
+#endif
+    }
+
+#ifdef DEBUG
+    bool verifyCulling() {
+
+        // An odd count so the scalar tail is exercised as well, and a view
+        // that only covers part of the quads.
+        constexpr uint32_t COUNT = 1027;
+        const ViewRect view = { -400.0f, -300.0f, 400.0f, 300.0f };
+
+        std::vector<float> columns(COUNT * 5);
+        QuadColumns quads;
+        quads.positionX = columns.data();
+        quads.positionY = columns.data() + COUNT;
+        quads.rotation = columns.data() + COUNT * 2;
+        quads.scaleX = columns.data() + COUNT * 3;
+        quads.scaleY = columns.data() + COUNT * 4;
+        quads.count = COUNT;
+
+        // Small LCG so the data is the same every run.
+        uint32_t seed = 0x2545F491u;
+        auto random = [&seed](float min, float max) {
+            seed = seed * 1664525u + 1013904223u;
+            return min + (max - min) * static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+        };
+
+        for (uint32_t i = 0; i < COUNT; i++) {
+            columns[i] = random(-800.0f, 800.0f);
+            columns[COUNT + i] = random(-600.0f, 600.0f);
+            columns[COUNT * 2 + i] = (i % 2 == 0) ? 0.0f : random(0.0f, 360.0f);
+            // Two in three mirrored, along one axis or the other.
+            columns[COUNT * 3 + i] = random(1.0f, 200.0f) * (i % 3 == 1 ? -1.0f : 1.0f);
+            columns[COUNT * 4 + i] = random(1.0f, 200.0f) * (i % 3 == 2 ? -1.0f : 1.0f);
+        }
+
+        std::vector<uint32_t> reference(COUNT), batch(COUNT);
+
+        // Once as they are, then again as if none of them were rotated.
+        for (const float* rotation : { quads.rotation, static_cast<const float*>(nullptr) }) {
+            quads.rotation = rotation;
+
+            // Starting part way in, so the vector loads aren't all aligned.
+            uint32_t first = 3;
+            uint32_t referenceCount = cullQuadsScalar(view, &quads, first, COUNT - first, reference.data());
+            uint32_t batchCount = cullQuadsBatch(view, &quads, first, COUNT - first, batch.data());
+
+            if (referenceCount != batchCount) {
+                PONG_ERROR("Culling mismatch: {0} quads visible (reference {1})", batchCount, referenceCount);
+                return false;
+            }
+
+            for (uint32_t i = 0; i < referenceCount; i++) {
+                if (reference[i] != batch[i]) {
+                    PONG_ERROR("Culling mismatch at {0}: quad {1} (reference {2})", i, batch[i], reference[i]);
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+#endif
+}
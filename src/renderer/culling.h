@@ -0,0 +1,50 @@
+#ifndef PONG_VK_CULLING_H
+#define PONG_VK_CULLING_H
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "../simd.h"
+
+namespace Renderer {
+
+    // Culling quads against the view before any instance data is written for
+    // them. Quads are tested in columns, several per instruction (see simd.h),
+    // against a conservative box: the quad's own half size when it isn't
+    // rotated, its circumradius on both axes when it is.
+
+    // The part of the world the camera can see.
+    struct ViewRect {
+        float minX  {0.0f};
+        float minY  {0.0f};
+        float maxX  {0.0f};
+        float maxY  {0.0f};
+    };
+
+    // Quads to draw, one column per attribute. Rotations are in degrees - with
+    // no rotation column at all, none of the quads are rotated.
+    struct QuadColumns {
+        const float* positionX      {nullptr};
+        const float* positionY      {nullptr};
+        const float* rotation       {nullptr};
+        const float* scaleX         {nullptr};
+        const float* scaleY         {nullptr};
+        uint32_t count              {0};
+    };
+
+    // Maps the corners of clip space back through the view projection.
+    ViewRect getViewRect(const glm::mat4& viewProjection);
+
+    bool isQuadVisible(const ViewRect&, float positionX, float positionY, float rotation, float scaleX, float scaleY);
+
+    // Writes the indices of the quads in [first, first + count) which overlap
+    // the view to 'visible', in order. Returns how many there were.
+    uint32_t cullQuadsBatch(const ViewRect&, const QuadColumns*, uint32_t first, uint32_t count, uint32_t* visible);
+    uint32_t cullQuadsScalar(const ViewRect&, const QuadColumns*, uint32_t first, uint32_t count, uint32_t* visible);
+
+#ifdef DEBUG
+    // Checks the batch and scalar culling agree. Only built in DEBUG.
+    bool verifyCulling();
+#endif
+}
+
+#endif //PONG_VK_CULLING_H
@@ -0,0 +1,482 @@
+#include "gpuBalls.h"
+#include <cmath>
+#include <cstring>
+#include "utils.h"
+#include "vk/initialisers.h"
+#include "vk/vulkanUtils.h"
+#include "../logger.h"
+
+namespace Renderer {
+
+    // Copies the data into a device local buffer through a staging buffer,
+    // waiting for the copy to finish.
+    static bool uploadToBuffer(VulkanDeviceData* deviceData, VkCommandPool commandPool, const void* source,
+        VkDeviceSize size, VkBuffer destination) {
+
+        Buffers::BufferData stagingBuffer{};
+
+        if (Buffers::createBuffer(deviceData, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            stagingBuffer) != VK_SUCCESS) {
+
+            return false;
+        }
+
+        void* data;
+        vkMapMemory(deviceData->logicalDevice, stagingBuffer.bufferMemory, 0, size, 0, &data);
+        memcpy(data, source, static_cast<size_t>(size));
+        vkUnmapMemory(deviceData->logicalDevice, stagingBuffer.bufferMemory);
+
+        copyBuffer(deviceData->graphicsQueue, deviceData->logicalDevice, commandPool, size, stagingBuffer.buffer,
+            destination);
+
+        Buffers::destroyBuffer(deviceData, stagingBuffer);
+
+        return true;
+    }
+
+    static bool createBallBuffers(GpuBallData* balls, VulkanDeviceData* deviceData, VkCommandPool commandPool,
+        uint32_t seed) {
+
+        VkDeviceSize ballsSize = balls->ballCount * sizeof(GpuBall);
+
+        if (Buffers::createBuffer(deviceData, ballsSize,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, balls->ballBuffer) != VK_SUCCESS
+            || Buffers::createBuffer(deviceData, balls->ballCount * sizeof(Renderer2D::QuadInstance),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                balls->instanceBuffer) != VK_SUCCESS
+            || Buffers::createBuffer(deviceData, sizeof(VkDrawIndexedIndirectCommand),
+                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                balls->indirectBuffer) != VK_SUCCESS) {
+
+            return false;
+        }
+
+        // Small LCG so a given seed always starts the balls off the same way.
+        uint32_t state = seed;
+        auto random = [&state](float min, float max) {
+            state = state * 1664525u + 1013904223u;
+            return min + (max - min) * static_cast<float>(state >> 8) / static_cast<float>(1u << 24);
+        };
+
+        auto* initialBalls = static_cast<GpuBall*>(Buffers::alignedAlloc(static_cast<size_t>(ballsSize),
+            alignof(GpuBall)));
+        if (!initialBalls) return false;
+
+        glm::vec2 arena = balls->arenaHalfSize;
+
+        // Kept within 60 degrees of horizontal, so they don't spend forever
+        // bouncing between the top and bottom walls.
+        for (uint32_t i = 0; i < balls->ballCount; i++) {
+            float angle = glm::radians(random(-60.0f, 60.0f));
+            float speed = random(100.0f, 400.0f) * (i % 2 == 0 ? 1.0f : -1.0f);
+
+            initialBalls[i].position = { random(-arena.x * 0.5f, arena.x * 0.5f), random(-arena.y, arena.y) };
+            initialBalls[i].velocity = { std::cos(angle) * speed, std::sin(angle) * speed };
+        }
+
+        // Only the instance count is ever written after this.
+        VkDrawIndexedIndirectCommand draw{};
+        draw.indexCount = 6;
+        draw.instanceCount = 0;
+        draw.firstIndex = 0;
+        draw.vertexOffset = 0;
+        draw.firstInstance = 0;
+
+        bool isUploaded = uploadToBuffer(deviceData, commandPool, initialBalls, ballsSize, balls->ballBuffer.buffer)
+            && uploadToBuffer(deviceData, commandPool, &draw, sizeof(draw), balls->indirectBuffer.buffer);
+
+        Buffers::alignedFree(initialBalls);
+
+        return isUploaded;
+    }
+
+    static bool createBallSlots(GpuBallData* balls, VulkanDeviceData* deviceData) {
+
+        for (uint32_t i = 0; i < balls->slotCount; i++) {
+            GpuBallSlot* slot = &balls->slots[i];
+
+            // Both stay mapped for as long as they live. Coherent, so the
+            // uniforms need no flushing and the events no invalidating.
+            if (Buffers::createBuffer(deviceData, sizeof(GpuBallFrame), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    slot->uniformBuffer) != VK_SUCCESS
+                || Buffers::createBuffer(deviceData, sizeof(GpuBallEventBuffer),
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    slot->eventBuffer) != VK_SUCCESS) {
+
+                return false;
+            }
+
+            void* mappedFrame;
+            void* mappedEvents;
+            if (vkMapMemory(deviceData->logicalDevice, slot->uniformBuffer.bufferMemory, 0, VK_WHOLE_SIZE, 0,
+                    &mappedFrame) != VK_SUCCESS
+                || vkMapMemory(deviceData->logicalDevice, slot->eventBuffer.bufferMemory, 0, VK_WHOLE_SIZE, 0,
+                    &mappedEvents) != VK_SUCCESS) {
+
+                return false;
+            }
+
+            slot->mappedFrame = static_cast<GpuBallFrame*>(mappedFrame);
+            slot->mappedEvents = static_cast<GpuBallEventBuffer*>(mappedEvents);
+            slot->mappedEvents->count = 0;
+        }
+
+        return true;
+    }
+
+    static bool createBallPipeline(GpuBallData* balls, VkDevice device, Memory::Arena* scratchArena) {
+
+        VkDescriptorSetLayoutBinding layoutBindings[] {
+            initiialiseDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            initiialiseDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            initiialiseDescriptorSetLayoutBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            initiialiseDescriptorSetLayoutBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            initiialiseDescriptorSetLayoutBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT)
+        };
+
+        if (createDescriptorSetLayout(device, &balls->descriptorSetLayout, layoutBindings, 5) != VK_SUCCESS) {
+            return false;
+        }
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &balls->descriptorSetLayout;
+
+        if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &balls->pipelineLayout) != VK_SUCCESS) {
+            return false;
+        }
+
+        // The bytecode is only needed until the pipeline exists.
+        Memory::ArenaMarker marker = Memory::getArenaMarker(scratchArena);
+        FileContents compute = readFile("src/shaders/balls.spv", scratchArena);
+
+        if (!compute.p_byteCode) {
+            Memory::rewindArena(scratchArena, marker);
+            return false;
+        }
+
+        VkShaderModule computeShaderModule = createShaderModule(compute, device);
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage = initialisePipelineShaderStageCreateInfo(VK_SHADER_STAGE_COMPUTE_BIT, computeShaderModule,
+            "main");
+        pipelineInfo.layout = balls->pipelineLayout;
+
+        VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr,
+            &balls->pipeline);
+
+        vkDestroyShaderModule(device, computeShaderModule, nullptr);
+        Memory::rewindArena(scratchArena, marker);
+
+        return result == VK_SUCCESS;
+    }
+
+    static bool createBallDescriptorSets(GpuBallData* balls, VulkanDeviceData* deviceData,
+        Memory::Arena* scratchArena, Renderer2D::Renderer2DData* renderer2D) {
+
+        // A compute set per frame in flight, and the one set the draws share.
+        VkDescriptorPoolSize poolSizes[] = {
+            initialisePoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, balls->slotCount),
+            initialisePoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, balls->slotCount * 4),
+            initialisePoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1),
+            initialisePoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, Renderer2D::QUAD_TEXTURE_SLOT_COUNT)
+        };
+
+        if (createDescriptorPool(deviceData->logicalDevice, balls->slotCount + 1, &balls->descriptorPool, poolSizes, 4)
+            != VK_SUCCESS) {
+            return false;
+        }
+
+        // Drawn like any other quads - all of the balls' instances start at
+        // the front of the buffer, so it's bound with an offset of zero.
+        if (createDescriptorSets(deviceData, &balls->drawSet, &renderer2D->quadData.descriptorSetLayout,
+                &balls->descriptorPool, 1, &balls->instanceBuffer,
+                balls->ballCount * sizeof(Renderer2D::QuadInstance), renderer2D->quadData.textures,
+                Renderer2D::QUAD_TEXTURE_SLOT_COUNT, scratchArena) != VK_SUCCESS) {
+            return false;
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = balls->descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &balls->descriptorSetLayout;
+
+        for (uint32_t i = 0; i < balls->slotCount; i++) {
+            GpuBallSlot* slot = &balls->slots[i];
+
+            if (vkAllocateDescriptorSets(deviceData->logicalDevice, &allocInfo, &slot->computeSet) != VK_SUCCESS) {
+                return false;
+            }
+
+            VkDescriptorBufferInfo bufferInfos[] = {
+                initialiseDescriptorBufferInfo(slot->uniformBuffer.buffer, 0, sizeof(GpuBallFrame)),
+                initialiseDescriptorBufferInfo(balls->ballBuffer.buffer, 0, VK_WHOLE_SIZE),
+                initialiseDescriptorBufferInfo(balls->instanceBuffer.buffer, 0, VK_WHOLE_SIZE),
+                initialiseDescriptorBufferInfo(balls->indirectBuffer.buffer, 0, VK_WHOLE_SIZE),
+                initialiseDescriptorBufferInfo(slot->eventBuffer.buffer, 0, VK_WHOLE_SIZE)
+            };
+
+            VkWriteDescriptorSet descriptorWrites[] = {
+                initialiseWriteDescriptorSet(slot->computeSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, 1, &bufferInfos[0]),
+                initialiseWriteDescriptorSet(slot->computeSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, 1, &bufferInfos[1]),
+                initialiseWriteDescriptorSet(slot->computeSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2, 1, &bufferInfos[2]),
+                initialiseWriteDescriptorSet(slot->computeSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3, 1, &bufferInfos[3]),
+                initialiseWriteDescriptorSet(slot->computeSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4, 1, &bufferInfos[4])
+            };
+
+            vkUpdateDescriptorSets(deviceData->logicalDevice, 5, descriptorWrites, 0, nullptr);
+        }
+
+        return true;
+    }
+
+    static bool recordBallCompute(GpuBallData* balls, GpuBallSlot* slot) {
+
+        VkCommandBuffer commandBuffer = slot->computeCommandBuffer;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) return false;
+
+        // The last frame's pass has to be done with the balls, and its draw
+        // with the instances and the indirect command, before any of them are
+        // touched again.
+        VkMemoryBarrier previousFrame{};
+        previousFrame.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        previousFrame.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        previousFrame.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT
+            | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+            | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &previousFrame, 0, nullptr, 0, nullptr);
+
+        // The pass counts up the instances it writes and the events it appends.
+        vkCmdFillBuffer(commandBuffer, balls->indirectBuffer.buffer, offsetof(VkDrawIndexedIndirectCommand, instanceCount),
+            sizeof(uint32_t), 0);
+        vkCmdFillBuffer(commandBuffer, slot->eventBuffer.buffer, 0, sizeof(uint32_t), 0);
+
+        VkMemoryBarrier cleared{};
+        cleared.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        cleared.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        cleared.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &cleared, 0, nullptr, 0, nullptr);
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, balls->pipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, balls->pipelineLayout, 0, 1,
+            &slot->computeSet, 0, nullptr);
+        vkCmdDispatch(commandBuffer, (balls->ballCount + GPU_BALL_GROUP_SIZE - 1) / GPU_BALL_GROUP_SIZE, 1, 1);
+
+        // The draw reads what the pass wrote, and so does the host once the
+        // frame's fence has signalled.
+        VkMemoryBarrier written{};
+        written.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        written.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        written.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT
+            | VK_ACCESS_HOST_READ_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+            0, 1, &written, 0, nullptr, 0, nullptr);
+
+        return vkEndCommandBuffer(commandBuffer) == VK_SUCCESS;
+    }
+
+    Status initialiseGpuBalls(GpuBallData* balls, VulkanDeviceData* deviceData, Renderer2D::Renderer2DData* renderer2D,
+        Memory::Arena* scratchArena, uint32_t framesInFlight, uint32_t ballCount, glm::vec2 arenaHalfSize,
+        uint32_t seed) {
+
+        if (ballCount == 0) return Status::SUCCESS;
+
+        balls->ballCount = ballCount;
+        balls->arenaHalfSize = arenaHalfSize;
+        balls->slotCount = framesInFlight;
+        balls->slots = new GpuBallSlot[framesInFlight];
+
+        if (!createBallBuffers(balls, deviceData, renderer2D->commandPool, seed)
+            || !createBallSlots(balls, deviceData)) {
+            PONG_ERROR("Failed to create GPU ball buffers!");
+            cleanupGpuBalls(balls, deviceData);
+            return Status::INITIALIZATION_FAILURE;
+        }
+
+        if (!createBallPipeline(balls, deviceData->logicalDevice, scratchArena)) {
+            PONG_ERROR("Failed to create GPU ball compute pipeline!");
+            cleanupGpuBalls(balls, deviceData);
+            return Status::INITIALIZATION_FAILURE;
+        }
+
+        if (!createBallDescriptorSets(balls, deviceData, scratchArena, renderer2D)) {
+            PONG_ERROR("Failed to create GPU ball descriptor sets!");
+            cleanupGpuBalls(balls, deviceData);
+            return Status::INITIALIZATION_FAILURE;
+        }
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = renderer2D->commandPool;
+        allocInfo.commandBufferCount = 1;
+
+        for (uint32_t i = 0; i < balls->slotCount; i++) {
+            GpuBallSlot* slot = &balls->slots[i];
+
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            if (vkAllocateCommandBuffers(deviceData->logicalDevice, &allocInfo, &slot->computeCommandBuffer)
+                != VK_SUCCESS) {
+                slot->computeCommandBuffer = VK_NULL_HANDLE;
+            }
+
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            if (vkAllocateCommandBuffers(deviceData->logicalDevice, &allocInfo, &slot->drawCommandBuffer)
+                != VK_SUCCESS) {
+                slot->drawCommandBuffer = VK_NULL_HANDLE;
+            }
+
+            if (slot->computeCommandBuffer == VK_NULL_HANDLE || slot->drawCommandBuffer == VK_NULL_HANDLE
+                || !recordBallCompute(balls, slot)) {
+                PONG_ERROR("Failed to record GPU ball compute pass!");
+                cleanupGpuBalls(balls, deviceData);
+                return Status::INITIALIZATION_FAILURE;
+            }
+        }
+
+        PONG_INFO("Simulating {0} balls on the GPU ({1} KB of instances)", ballCount,
+            ballCount * sizeof(Renderer2D::QuadInstance) / 1024);
+
+        return Status::SUCCESS;
+    }
+
+    void collectGpuBallEvents(GpuBallData* balls, uint32_t frame) {
+
+        GpuBallSlot* slot = &balls->slots[frame];
+        if (!slot->isSubmitted) return;
+
+        const GpuBallEventBuffer* events = slot->mappedEvents;
+        uint32_t eventCount = events->count;
+
+        if (eventCount > MAX_GPU_BALL_EVENTS) {
+            balls->stats.eventsLost += eventCount - MAX_GPU_BALL_EVENTS;
+            eventCount = MAX_GPU_BALL_EVENTS;
+        }
+
+        for (uint32_t i = 0; i < eventCount; i++) {
+            uint32_t kind = events->events[i].kind;
+
+            if (kind < MAX_GPU_BALL_COLLIDERS) balls->stats.colliderHits++;
+            else if (kind == GPU_BALL_EVENT_GOAL_LEFT) balls->stats.goalsLeft++;
+            else if (kind == GPU_BALL_EVENT_GOAL_RIGHT) balls->stats.goalsRight++;
+        }
+
+        slot->isSubmitted = false;
+    }
+
+    VkCommandBuffer prepareGpuBalls(GpuBallData* balls, uint32_t frame, const ViewRect& view, float delta) {
+
+        GpuBallSlot* slot = &balls->slots[frame];
+        GpuBallFrame* uniforms = slot->mappedFrame;
+
+        uniforms->viewRect = { view.minX, view.minY, view.maxX, view.maxY };
+        uniforms->arenaHalfSize = balls->arenaHalfSize;
+        uniforms->delta = delta;
+        uniforms->ballSize = balls->ballSize;
+        uniforms->ballCount = balls->ballCount;
+        uniforms->colliderCount = balls->colliderCount;
+        memcpy(uniforms->colliders, balls->colliders, balls->colliderCount * sizeof(glm::vec4));
+
+        return slot->computeCommandBuffer;
+    }
+
+    VkCommandBuffer recordGpuBallDraw(GpuBallData* balls, Renderer2D::Renderer2DData* renderer2D, uint32_t frame,
+        const glm::mat4& viewProjection, uint64_t cameraVersion) {
+
+        GpuBallSlot* slot = &balls->slots[frame];
+
+        if (slot->renderPassVersion == renderer2D->renderPassVersion && slot->cameraVersion == cameraVersion) {
+            return slot->drawCommandBuffer;
+        }
+
+        vkResetCommandBuffer(slot->drawCommandBuffer, 0);
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = renderer2D->graphicsPipeline.renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        if (vkBeginCommandBuffer(slot->drawCommandBuffer, &beginInfo) != VK_SUCCESS) return VK_NULL_HANDLE;
+
+        bindQuadDraw(slot->drawCommandBuffer, &renderer2D->graphicsPipeline, &renderer2D->quadData.vertexBuffer,
+            &renderer2D->quadData.indexBuffer, balls->drawSet, 0, viewProjection);
+
+        // However many balls the compute pass found to be visible.
+        vkCmdDrawIndexedIndirect(slot->drawCommandBuffer, balls->indirectBuffer.buffer, 0, 1,
+            sizeof(VkDrawIndexedIndirectCommand));
+
+        if (vkEndCommandBuffer(slot->drawCommandBuffer) != VK_SUCCESS) return VK_NULL_HANDLE;
+
+        slot->renderPassVersion = renderer2D->renderPassVersion;
+        slot->cameraVersion = cameraVersion;
+
+        return slot->drawCommandBuffer;
+    }
+
+    void cleanupGpuBalls(GpuBallData* balls, VulkanDeviceData* deviceData) {
+
+        if (!balls->slots) return;
+
+        if (balls->ballCount > 0) {
+            PONG_INFO("GPU balls: {0} collider hits, {1} left and {2} right goals, {3} events lost",
+                balls->stats.colliderHits, balls->stats.goalsLeft, balls->stats.goalsRight, balls->stats.eventsLost);
+        }
+
+        // The command buffers go with the command pool, and the descriptor
+        // sets with their pool.
+        for (uint32_t i = 0; i < balls->slotCount; i++) {
+            GpuBallSlot* slot = &balls->slots[i];
+
+            if (slot->mappedFrame) vkUnmapMemory(deviceData->logicalDevice, slot->uniformBuffer.bufferMemory);
+            if (slot->mappedEvents) vkUnmapMemory(deviceData->logicalDevice, slot->eventBuffer.bufferMemory);
+
+            Buffers::destroyBuffer(deviceData, slot->uniformBuffer);
+            Buffers::destroyBuffer(deviceData, slot->eventBuffer);
+        }
+
+        if (balls->descriptorPool != VK_NULL_HANDLE) {
+            vkDestroyDescriptorPool(deviceData->logicalDevice, balls->descriptorPool, nullptr);
+        }
+        if (balls->pipeline != VK_NULL_HANDLE) vkDestroyPipeline(deviceData->logicalDevice, balls->pipeline, nullptr);
+        if (balls->pipelineLayout != VK_NULL_HANDLE) {
+            vkDestroyPipelineLayout(deviceData->logicalDevice, balls->pipelineLayout, nullptr);
+        }
+        if (balls->descriptorSetLayout != VK_NULL_HANDLE) {
+            vkDestroyDescriptorSetLayout(deviceData->logicalDevice, balls->descriptorSetLayout, nullptr);
+        }
+
+        Buffers::destroyBuffer(deviceData, balls->ballBuffer);
+        Buffers::destroyBuffer(deviceData, balls->instanceBuffer);
+        Buffers::destroyBuffer(deviceData, balls->indirectBuffer);
+
+        delete[] balls->slots;
+        balls->slots = nullptr;
+        balls->slotCount = 0;
+        balls->ballCount = 0;
+    }
+}
@@ -0,0 +1,149 @@
+#ifndef PONG_VK_GPUBALLS_H
+#define PONG_VK_GPUBALLS_H
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include "core.h"
+#include "culling.h"
+#include "renderer2D.h"
+#include "vk/buffers.h"
+#include "vk/vulkanDeviceData.h"
+#include "../memory/arena.h"
+
+namespace Renderer {
+
+    // Balls which live entirely on the GPU.
+    //
+    // For populations big enough that the CPU would spend its frame moving
+    // them and writing out their instances, the balls are kept in a device
+    // local storage buffer instead. Every frame a compute pass moves them,
+    // bounces them off the arena's walls and the colliders (the paddles,
+    // uploaded each frame), and writes an instance for every ball the camera
+    // can see. The number written goes straight into an indirect draw, so
+    // nothing about the balls ever comes back to the CPU to be drawn.
+    //
+    // What the game does need to hear about - a ball hitting a collider or
+    // leaving the arena - is appended to a small host visible event buffer,
+    // one per frame in flight. It's read once that frame's fence has been
+    // waited on anyway, so nothing ever stalls on it; events just arrive a
+    // frame or two after they happened.
+
+    constexpr uint32_t MAX_GPU_BALL_COLLIDERS = 8;
+    // Per frame - any more than this are counted, but lost.
+    constexpr uint32_t MAX_GPU_BALL_EVENTS = 1024;
+    // Has to match the compute shader's local size.
+    constexpr uint32_t GPU_BALL_GROUP_SIZE = 256;
+
+    // Event kinds below MAX_GPU_BALL_COLLIDERS are the collider that was hit.
+    constexpr uint32_t GPU_BALL_EVENT_GOAL_LEFT = 0x100;
+    constexpr uint32_t GPU_BALL_EVENT_GOAL_RIGHT = 0x101;
+
+    struct GpuBall {
+        glm::vec2 position;
+        glm::vec2 velocity;
+    };
+
+    // Everything the compute pass needs for one frame. Laid out to match std140.
+    struct GpuBallFrame {
+        // What the camera can see, as (minX, minY, maxX, maxY).
+        glm::vec4 viewRect;
+        glm::vec2 arenaHalfSize;
+        float delta;
+        float ballSize;
+        uint32_t ballCount;
+        uint32_t colliderCount;
+        uint32_t padding[2];
+        // As (minX, minY, maxX, maxY).
+        glm::vec4 colliders[MAX_GPU_BALL_COLLIDERS];
+    };
+
+    struct GpuBallEvent {
+        glm::vec2 position;
+        uint32_t ball;
+        uint32_t kind;
+    };
+
+    // Laid out to match std430.
+    struct GpuBallEventBuffer {
+        // Every event the pass tried to append, even those which didn't fit.
+        uint32_t count;
+        uint32_t padding[3];
+        GpuBallEvent events[MAX_GPU_BALL_EVENTS];
+    };
+
+    // Everything a single frame in flight writes to, or records.
+    struct GpuBallSlot {
+        Buffers::BufferData uniformBuffer                   {VK_NULL_HANDLE};
+        GpuBallFrame* mappedFrame                           {nullptr};
+        Buffers::BufferData eventBuffer                     {VK_NULL_HANDLE};
+        GpuBallEventBuffer* mappedEvents                    {nullptr};
+        VkDescriptorSet computeSet                          {VK_NULL_HANDLE};
+        // Recorded once - everything that changes from frame to frame is in
+        // the uniforms.
+        VkCommandBuffer computeCommandBuffer                {VK_NULL_HANDLE};
+        // Recorded against a render pass and a camera, like the static layer.
+        VkCommandBuffer drawCommandBuffer                   {VK_NULL_HANDLE};
+        uint64_t renderPassVersion                          {0};
+        uint64_t cameraVersion                              {0};
+        // Set once the slot's compute pass has been submitted - until then,
+        // there are no events to read.
+        bool isSubmitted                                    {false};
+    };
+
+    struct GpuBallStats {
+        uint64_t colliderHits                               {0};
+        // Balls which went out past the left and right of the arena.
+        uint64_t goalsLeft                                  {0};
+        uint64_t goalsRight                                 {0};
+        uint64_t eventsLost                                 {0};
+    };
+
+    struct GpuBallData {
+        uint32_t ballCount                                  {0};
+        float ballSize                                      {8.0f};
+        Buffers::BufferData ballBuffer                      {VK_NULL_HANDLE};
+        // A QuadInstance for every visible ball, written by the compute pass.
+        Buffers::BufferData instanceBuffer                  {VK_NULL_HANDLE};
+        // A single VkDrawIndexedIndirectCommand - the compute pass fills in
+        // its instance count.
+        Buffers::BufferData indirectBuffer                  {VK_NULL_HANDLE};
+        VkDescriptorSetLayout descriptorSetLayout           {VK_NULL_HANDLE};
+        VkPipelineLayout pipelineLayout                     {VK_NULL_HANDLE};
+        VkPipeline pipeline                                 {VK_NULL_HANDLE};
+        // Doesn't depend on the swapchain, so it isn't re-made with it.
+        VkDescriptorPool descriptorPool                     {VK_NULL_HANDLE};
+        // The quad layout, with the instance buffer in place of the frame's quads.
+        VkDescriptorSet drawSet                             {VK_NULL_HANDLE};
+        uint32_t slotCount                                  {0};
+        GpuBallSlot* slots                                  {nullptr};
+        glm::vec4 colliders[MAX_GPU_BALL_COLLIDERS];
+        uint32_t colliderCount                              {0};
+        glm::vec2 arenaHalfSize                             {400.0f, 300.0f};
+        // When the balls were last moved, 0 before the first frame.
+        uint64_t lastFrameNanos                             {0};
+        GpuBallStats stats;
+    };
+
+    // Scatters the balls over the arena, heading off in random directions.
+    // The shader's bytecode and descriptor writes live in the scratch arena,
+    // and are given back before this returns.
+    Status initialiseGpuBalls(GpuBallData*, VulkanDeviceData*, Renderer2D::Renderer2DData*, Memory::Arena* scratchArena,
+        uint32_t framesInFlight, uint32_t ballCount, glm::vec2 arenaHalfSize, uint32_t seed);
+    // Tallies up the events written by the given frame in flight. Must only be
+    // called once that frame's fence has signalled.
+    void collectGpuBallEvents(GpuBallData*, uint32_t frame);
+    // Fills in the frame's uniforms and returns its compute pass, which has to
+    // be submitted ahead of the frame's draw.
+    VkCommandBuffer prepareGpuBalls(GpuBallData*, uint32_t frame, const ViewRect&, float delta);
+    // Records the frame's draw if it's out of date, and returns it for the
+    // render pass to replay. Null if it couldn't be recorded.
+    VkCommandBuffer recordGpuBallDraw(GpuBallData*, Renderer2D::Renderer2DData*, uint32_t frame,
+        const glm::mat4& viewProjection, uint64_t cameraVersion);
+    void cleanupGpuBalls(GpuBallData*, VulkanDeviceData*);
+
+    inline bool isGpuBallsEnabled(const GpuBallData* balls) {
+        return balls->slots != nullptr;
+    }
+}
+
+#endif //PONG_VK_GPUBALLS_H
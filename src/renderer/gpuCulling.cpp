@@ -0,0 +1,433 @@
+#include "gpuCulling.h"
+#include <algorithm>
+#include "utils.h"
+#include "vk/initialisers.h"
+#include "vk/vulkanUtils.h"
+#include "../logger.h"
+
+namespace Renderer {
+
+    // Which dispatch of the pass is running - pushed ahead of each.
+    constexpr uint32_t CULL_PASS_COUNT = 0;
+    constexpr uint32_t CULL_PASS_SCAN = 1;
+    constexpr uint32_t CULL_PASS_WRITE = 2;
+
+    static bool createCullSlots(GpuCullData* culling, VulkanDeviceData* deviceData) {
+
+        uint32_t maxGroups = (culling->maxQuads + GPU_CULL_GROUP_SIZE - 1) / GPU_CULL_GROUP_SIZE;
+
+        for (uint32_t i = 0; i < culling->slotCount; i++) {
+            GpuCullSlot* slot = &culling->slots[i];
+
+            // The frame and readback buffers stay mapped for as long as they
+            // live. Coherent, so the uniforms need no flushing and the count
+            // no invalidating.
+            if (Buffers::createBuffer(deviceData, sizeof(GpuCullFrame),
+                    VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    slot->frameBuffer) != VK_SUCCESS
+                || Buffers::createBuffer(deviceData, maxGroups * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, slot->groupCountBuffer) != VK_SUCCESS
+                || Buffers::createBuffer(deviceData, sizeof(VkDrawIndexedIndirectCommand),
+                    VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                    | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                    slot->drawBuffer) != VK_SUCCESS
+                || Buffers::createBuffer(deviceData, sizeof(uint32_t), VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    slot->readbackBuffer) != VK_SUCCESS) {
+
+                return false;
+            }
+
+            void* mappedFrame;
+            void* mappedReadback;
+            if (vkMapMemory(deviceData->logicalDevice, slot->frameBuffer.bufferMemory, 0, VK_WHOLE_SIZE, 0,
+                    &mappedFrame) != VK_SUCCESS
+                || vkMapMemory(deviceData->logicalDevice, slot->readbackBuffer.bufferMemory, 0, VK_WHOLE_SIZE, 0,
+                    &mappedReadback) != VK_SUCCESS) {
+
+                return false;
+            }
+
+            slot->mappedFrame = static_cast<GpuCullFrame*>(mappedFrame);
+            slot->mappedReadback = static_cast<uint32_t*>(mappedReadback);
+        }
+
+        return true;
+    }
+
+    static bool createCullPipeline(GpuCullData* culling, VkDevice device, Memory::Arena* scratchArena) {
+
+        VkDescriptorSetLayoutBinding layoutBindings[] {
+            initiialiseDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            initiialiseDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            initiialiseDescriptorSetLayoutBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            initiialiseDescriptorSetLayoutBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            initiialiseDescriptorSetLayoutBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT)
+        };
+
+        if (createDescriptorSetLayout(device, &culling->descriptorSetLayout, layoutBindings, 5) != VK_SUCCESS) {
+            return false;
+        }
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(uint32_t);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &culling->descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &culling->pipelineLayout) != VK_SUCCESS) {
+            return false;
+        }
+
+        // The bytecode is only needed until the pipeline exists.
+        Memory::ArenaMarker marker = Memory::getArenaMarker(scratchArena);
+        FileContents compute = readFile("src/shaders/cull.spv", scratchArena);
+
+        if (!compute.p_byteCode) {
+            Memory::rewindArena(scratchArena, marker);
+            return false;
+        }
+
+        VkShaderModule computeShaderModule = createShaderModule(compute, device);
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage = initialisePipelineShaderStageCreateInfo(VK_SHADER_STAGE_COMPUTE_BIT, computeShaderModule,
+            "main");
+        pipelineInfo.layout = culling->pipelineLayout;
+
+        VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr,
+            &culling->pipeline);
+
+        vkDestroyShaderModule(device, computeShaderModule, nullptr);
+        Memory::rewindArena(scratchArena, marker);
+
+        return result == VK_SUCCESS;
+    }
+
+    static bool createCullDescriptorSets(GpuCullData* culling, VulkanDeviceData* deviceData,
+        Memory::Arena* scratchArena, Renderer2D::Renderer2DData* renderer2D) {
+
+        // A compute set per frame in flight, and the one set the draws share.
+        VkDescriptorPoolSize poolSizes[] = {
+            initialisePoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, culling->slotCount),
+            initialisePoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, culling->slotCount * 4),
+            initialisePoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1),
+            initialisePoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, Renderer2D::QUAD_TEXTURE_SLOT_COUNT)
+        };
+
+        if (createDescriptorPool(deviceData->logicalDevice, culling->slotCount + 1, &culling->descriptorPool,
+            poolSizes, 4) != VK_SUCCESS) {
+            return false;
+        }
+
+        // Drawn like any other quads - the dynamic offset picks out the
+        // frame's slice of the survivors.
+        if (createDescriptorSets(deviceData, &culling->drawSet, &renderer2D->quadData.descriptorSetLayout,
+                &culling->descriptorPool, 1, &culling->visibleBuffer, culling->sliceSize,
+                renderer2D->quadData.textures, Renderer2D::QUAD_TEXTURE_SLOT_COUNT, scratchArena) != VK_SUCCESS) {
+            return false;
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = culling->descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &culling->descriptorSetLayout;
+
+        for (uint32_t i = 0; i < culling->slotCount; i++) {
+            GpuCullSlot* slot = &culling->slots[i];
+
+            if (vkAllocateDescriptorSets(deviceData->logicalDevice, &allocInfo, &slot->computeSet) != VK_SUCCESS) {
+                return false;
+            }
+
+            // Each frame reads its own slice of the instance buffer and writes
+            // its own slice of the survivors.
+            VkDeviceSize sliceOffset = i * culling->sliceSize;
+
+            VkDescriptorBufferInfo bufferInfos[] = {
+                initialiseDescriptorBufferInfo(slot->frameBuffer.buffer, 0, sizeof(GpuCullFrame)),
+                initialiseDescriptorBufferInfo(renderer2D->quadData.instanceBuffer.buffer, sliceOffset,
+                    culling->sliceSize),
+                initialiseDescriptorBufferInfo(culling->visibleBuffer.buffer, sliceOffset, culling->sliceSize),
+                initialiseDescriptorBufferInfo(slot->groupCountBuffer.buffer, 0, VK_WHOLE_SIZE),
+                initialiseDescriptorBufferInfo(slot->drawBuffer.buffer, 0, VK_WHOLE_SIZE)
+            };
+
+            VkWriteDescriptorSet descriptorWrites[] = {
+                initialiseWriteDescriptorSet(slot->computeSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, 1,
+                    &bufferInfos[0]),
+                initialiseWriteDescriptorSet(slot->computeSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, 1,
+                    &bufferInfos[1]),
+                initialiseWriteDescriptorSet(slot->computeSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2, 1,
+                    &bufferInfos[2]),
+                initialiseWriteDescriptorSet(slot->computeSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3, 1,
+                    &bufferInfos[3]),
+                initialiseWriteDescriptorSet(slot->computeSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4, 1,
+                    &bufferInfos[4])
+            };
+
+            vkUpdateDescriptorSets(deviceData->logicalDevice, 5, descriptorWrites, 0, nullptr);
+        }
+
+        return true;
+    }
+
+    static bool recordCullCompute(GpuCullData* culling, GpuCullSlot* slot) {
+
+        VkCommandBuffer commandBuffer = slot->computeCommandBuffer;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) return false;
+
+        // Nothing here is shared between frames in flight, and the slot is
+        // only used again once its fence has signalled - so unlike the GPU
+        // balls, the pass doesn't have to wait on the frame before.
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, culling->pipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, culling->pipelineLayout, 0, 1,
+            &slot->computeSet, 0, nullptr);
+
+        // Sized by the host each frame, through the same buffer as the uniforms.
+        vkCmdPushConstants(commandBuffer, culling->pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t),
+            &CULL_PASS_COUNT);
+        vkCmdDispatchIndirect(commandBuffer, slot->frameBuffer.buffer, 0);
+
+        // The scan reads every group's count and writes its offset back.
+        VkMemoryBarrier counted{};
+        counted.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        counted.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        counted.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &counted, 0, nullptr, 0, nullptr);
+
+        // A single group, however many quads there are.
+        vkCmdPushConstants(commandBuffer, culling->pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t),
+            &CULL_PASS_SCAN);
+        vkCmdDispatch(commandBuffer, 1, 1, 1);
+
+        // The last dispatch reads each group's offset.
+        VkMemoryBarrier scanned{};
+        scanned.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        scanned.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        scanned.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &scanned, 0, nullptr, 0, nullptr);
+
+        vkCmdPushConstants(commandBuffer, culling->pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t),
+            &CULL_PASS_WRITE);
+        vkCmdDispatchIndirect(commandBuffer, slot->frameBuffer.buffer, 0);
+
+        // The draw reads the survivors and the command, and the instance
+        // count is copied back for the host.
+        VkMemoryBarrier written{};
+        written.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        written.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        written.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT
+            | VK_ACCESS_TRANSFER_READ_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 1, &written, 0, nullptr, 0, nullptr);
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = offsetof(VkDrawIndexedIndirectCommand, instanceCount);
+        copyRegion.dstOffset = 0;
+        copyRegion.size = sizeof(uint32_t);
+        vkCmdCopyBuffer(commandBuffer, slot->drawBuffer.buffer, slot->readbackBuffer.buffer, 1, &copyRegion);
+
+        VkMemoryBarrier copied{};
+        copied.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        copied.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        copied.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+            0, 1, &copied, 0, nullptr, 0, nullptr);
+
+        return vkEndCommandBuffer(commandBuffer) == VK_SUCCESS;
+    }
+
+    Status initialiseGpuCulling(GpuCullData* culling, VulkanDeviceData* deviceData,
+        Renderer2D::Renderer2DData* renderer2D, Memory::Arena* scratchArena, uint32_t framesInFlight) {
+
+        const Renderer2D::QuadData& quadData = renderer2D->quadData;
+
+        culling->maxQuads = static_cast<uint32_t>(quadData.maxQuads);
+        culling->sliceSize = quadData.instanceSliceSize;
+        culling->slotCount = framesInFlight;
+        culling->slots = new GpuCullSlot[framesInFlight];
+
+        if (Buffers::createBuffer(deviceData, culling->sliceSize * framesInFlight, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, culling->visibleBuffer) != VK_SUCCESS
+            || !createCullSlots(culling, deviceData)) {
+            PONG_ERROR("Failed to create GPU culling buffers!");
+            cleanupGpuCulling(culling, deviceData);
+            return Status::INITIALIZATION_FAILURE;
+        }
+
+        if (!createCullPipeline(culling, deviceData->logicalDevice, scratchArena)) {
+            PONG_ERROR("Failed to create GPU culling compute pipeline!");
+            cleanupGpuCulling(culling, deviceData);
+            return Status::INITIALIZATION_FAILURE;
+        }
+
+        if (!createCullDescriptorSets(culling, deviceData, scratchArena, renderer2D)) {
+            PONG_ERROR("Failed to create GPU culling descriptor sets!");
+            cleanupGpuCulling(culling, deviceData);
+            return Status::INITIALIZATION_FAILURE;
+        }
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = renderer2D->commandPool;
+        allocInfo.commandBufferCount = 1;
+
+        for (uint32_t i = 0; i < culling->slotCount; i++) {
+            GpuCullSlot* slot = &culling->slots[i];
+
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            if (vkAllocateCommandBuffers(deviceData->logicalDevice, &allocInfo, &slot->computeCommandBuffer)
+                != VK_SUCCESS) {
+                slot->computeCommandBuffer = VK_NULL_HANDLE;
+            }
+
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            if (vkAllocateCommandBuffers(deviceData->logicalDevice, &allocInfo, &slot->drawCommandBuffer)
+                != VK_SUCCESS) {
+                slot->drawCommandBuffer = VK_NULL_HANDLE;
+            }
+
+            if (slot->computeCommandBuffer == VK_NULL_HANDLE || slot->drawCommandBuffer == VK_NULL_HANDLE
+                || !recordCullCompute(culling, slot)) {
+                PONG_ERROR("Failed to record GPU culling compute pass!");
+                cleanupGpuCulling(culling, deviceData);
+                return Status::INITIALIZATION_FAILURE;
+            }
+        }
+
+        PONG_INFO("Culling up to {0} quads per frame on the GPU", culling->maxQuads);
+
+        return Status::SUCCESS;
+    }
+
+    uint32_t collectGpuCulling(GpuCullData* culling, uint32_t frame) {
+
+        GpuCullSlot* slot = &culling->slots[frame];
+        if (!slot->isSubmitted) return 0;
+
+        slot->isSubmitted = false;
+
+        uint32_t visibleCount = std::min(*slot->mappedReadback, slot->submittedQuadCount);
+        return slot->submittedQuadCount - visibleCount;
+    }
+
+    VkCommandBuffer prepareGpuCulling(GpuCullData* culling, uint32_t frame, const ViewRect& view, uint32_t quadCount) {
+
+        GpuCullSlot* slot = &culling->slots[frame];
+        GpuCullFrame* uniforms = slot->mappedFrame;
+
+        quadCount = std::min(quadCount, culling->maxQuads);
+
+        // No groups at all on frames without any quads - the scan still
+        // writes the draw command, with nothing to draw.
+        uniforms->groupCountX = (quadCount + GPU_CULL_GROUP_SIZE - 1) / GPU_CULL_GROUP_SIZE;
+        uniforms->groupCountY = 1;
+        uniforms->groupCountZ = 1;
+        uniforms->quadCount = quadCount;
+        uniforms->viewRect = { view.minX, view.minY, view.maxX, view.maxY };
+
+        slot->submittedQuadCount = quadCount;
+
+        return slot->computeCommandBuffer;
+    }
+
+    VkCommandBuffer recordGpuCullingDraw(GpuCullData* culling, Renderer2D::Renderer2DData* renderer2D, uint32_t frame,
+        const glm::mat4& viewProjection, uint64_t cameraVersion) {
+
+        GpuCullSlot* slot = &culling->slots[frame];
+
+        if (slot->renderPassVersion == renderer2D->renderPassVersion && slot->cameraVersion == cameraVersion) {
+            return slot->drawCommandBuffer;
+        }
+
+        vkResetCommandBuffer(slot->drawCommandBuffer, 0);
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = renderer2D->graphicsPipeline.renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        if (vkBeginCommandBuffer(slot->drawCommandBuffer, &beginInfo) != VK_SUCCESS) return VK_NULL_HANDLE;
+
+        bindQuadDraw(slot->drawCommandBuffer, &renderer2D->graphicsPipeline, &renderer2D->quadData.vertexBuffer,
+            &renderer2D->quadData.indexBuffer, culling->drawSet, static_cast<uint32_t>(frame * culling->sliceSize),
+            viewProjection);
+
+        // However many quads the compute pass found to be visible.
+        vkCmdDrawIndexedIndirect(slot->drawCommandBuffer, slot->drawBuffer.buffer, 0, 1,
+            sizeof(VkDrawIndexedIndirectCommand));
+
+        if (vkEndCommandBuffer(slot->drawCommandBuffer) != VK_SUCCESS) return VK_NULL_HANDLE;
+
+        slot->renderPassVersion = renderer2D->renderPassVersion;
+        slot->cameraVersion = cameraVersion;
+
+        return slot->drawCommandBuffer;
+    }
+
+    void cleanupGpuCulling(GpuCullData* culling, VulkanDeviceData* deviceData) {
+
+        if (!culling->slots) return;
+
+        // The command buffers go with the command pool, and the descriptor
+        // sets with their pool.
+        for (uint32_t i = 0; i < culling->slotCount; i++) {
+            GpuCullSlot* slot = &culling->slots[i];
+
+            if (slot->mappedFrame) vkUnmapMemory(deviceData->logicalDevice, slot->frameBuffer.bufferMemory);
+            if (slot->mappedReadback) vkUnmapMemory(deviceData->logicalDevice, slot->readbackBuffer.bufferMemory);
+
+            Buffers::destroyBuffer(deviceData, slot->frameBuffer);
+            Buffers::destroyBuffer(deviceData, slot->groupCountBuffer);
+            Buffers::destroyBuffer(deviceData, slot->drawBuffer);
+            Buffers::destroyBuffer(deviceData, slot->readbackBuffer);
+        }
+
+        if (culling->descriptorPool != VK_NULL_HANDLE) {
+            vkDestroyDescriptorPool(deviceData->logicalDevice, culling->descriptorPool, nullptr);
+        }
+        if (culling->pipeline != VK_NULL_HANDLE) {
+            vkDestroyPipeline(deviceData->logicalDevice, culling->pipeline, nullptr);
+        }
+        if (culling->pipelineLayout != VK_NULL_HANDLE) {
+            vkDestroyPipelineLayout(deviceData->logicalDevice, culling->pipelineLayout, nullptr);
+        }
+        if (culling->descriptorSetLayout != VK_NULL_HANDLE) {
+            vkDestroyDescriptorSetLayout(deviceData->logicalDevice, culling->descriptorSetLayout, nullptr);
+        }
+
+        Buffers::destroyBuffer(deviceData, culling->visibleBuffer);
+
+        delete[] culling->slots;
+        culling->slots = nullptr;
+        culling->slotCount = 0;
+        culling->maxQuads = 0;
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef PONG_VK_GPUCULLING_H
+#define PONG_VK_GPUCULLING_H
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include "core.h"
+#include "culling.h"
+#include "renderer2D.h"
+#include "vk/buffers.h"
+#include "vk/vulkanDeviceData.h"
+#include "../memory/arena.h"
+
+namespace Renderer {
+
+    // Culling the frame's quads on the GPU.
+    //
+    // With it enabled, every quad drawn is written to the frame's slice of the
+    // instance buffer, seen or not. A compute pre-pass then tests each one's
+    // bounds against the view and copies the survivors, still in the order
+    // they were drawn, into a device local buffer - along with the indirect
+    // draw command that draws them. The CPU never learns how many were
+    // visible, so the draw is recorded once per frame in flight and replayed
+    // until the camera moves or the render pass is re-made.
+    //
+    // The pass runs in three dispatches, so the survivors keep their order
+    // (quads are blended, so it matters which ends up on top): the first
+    // counts the survivors in each group, the second is a single group which
+    // scans the counts into where each group's survivors go, and the third
+    // writes them there.
+
+    // Has to match the compute shader's local size.
+    constexpr uint32_t GPU_CULL_GROUP_SIZE = 256;
+
+    // Everything the pass needs for one frame. Laid out to match std140, and
+    // starts with a VkDispatchIndirectCommand so the same buffer sizes the
+    // dispatch.
+    struct GpuCullFrame {
+        uint32_t groupCountX;
+        uint32_t groupCountY;
+        uint32_t groupCountZ;
+        uint32_t quadCount;
+        // What the camera can see, as (minX, minY, maxX, maxY).
+        glm::vec4 viewRect;
+    };
+
+    // Everything a single frame in flight writes to, or records.
+    struct GpuCullSlot {
+        // Host visible and kept mapped - used as both the uniforms and the
+        // dispatch's indirect arguments.
+        Buffers::BufferData frameBuffer                     {VK_NULL_HANDLE};
+        GpuCullFrame* mappedFrame                           {nullptr};
+        // Survivors per group, written by the first dispatch and turned into
+        // where each group's survivors start by the second.
+        Buffers::BufferData groupCountBuffer                {VK_NULL_HANDLE};
+        // A VkDrawIndexedIndirectCommand, written by the second dispatch.
+        Buffers::BufferData drawBuffer                      {VK_NULL_HANDLE};
+        // The draw's instance count, copied back for the stats.
+        Buffers::BufferData readbackBuffer                  {VK_NULL_HANDLE};
+        uint32_t* mappedReadback                            {nullptr};
+        VkDescriptorSet computeSet                          {VK_NULL_HANDLE};
+        // Recorded once - everything that changes from frame to frame is in
+        // the frame buffer.
+        VkCommandBuffer computeCommandBuffer                {VK_NULL_HANDLE};
+        // Recorded against a render pass and a camera, like the static layer.
+        VkCommandBuffer drawCommandBuffer                   {VK_NULL_HANDLE};
+        uint64_t renderPassVersion                          {0};
+        uint64_t cameraVersion                              {0};
+        // Quads handed to the pass when it was last submitted - until it has
+        // been, there's nothing to read back.
+        uint32_t submittedQuadCount                         {0};
+        bool isSubmitted                                    {false};
+    };
+
+    struct GpuCullData {
+        uint32_t maxQuads                                   {0};
+        // The survivors - one slice per frame in flight, the same size as the
+        // instance buffer's.
+        Buffers::BufferData visibleBuffer                   {VK_NULL_HANDLE};
+        VkDeviceSize sliceSize                              {0};
+        VkDescriptorSetLayout descriptorSetLayout           {VK_NULL_HANDLE};
+        VkPipelineLayout pipelineLayout                     {VK_NULL_HANDLE};
+        VkPipeline pipeline                                 {VK_NULL_HANDLE};
+        // Doesn't depend on the swapchain, so it isn't re-made with it.
+        VkDescriptorPool descriptorPool                     {VK_NULL_HANDLE};
+        // The quad layout, with the survivors in place of the frame's quads.
+        VkDescriptorSet drawSet                             {VK_NULL_HANDLE};
+        uint32_t slotCount                                  {0};
+        GpuCullSlot* slots                                  {nullptr};
+    };
+
+    // The shader's bytecode and descriptor writes live in the scratch arena,
+    // and are given back before this returns.
+    Status initialiseGpuCulling(GpuCullData*, VulkanDeviceData*, Renderer2D::Renderer2DData*,
+        Memory::Arena* scratchArena, uint32_t framesInFlight);
+    // Returns how many of the quads the given frame in flight last handed to
+    // the pass were culled. Must only be called once that frame's fence has
+    // signalled.
+    uint32_t collectGpuCulling(GpuCullData*, uint32_t frame);
+    // Fills in the frame's uniforms and returns its compute pass, which has to
+    // be submitted ahead of the frame's draw.
+    VkCommandBuffer prepareGpuCulling(GpuCullData*, uint32_t frame, const ViewRect&, uint32_t quadCount);
+    // Records the frame's draw if it's out of date, and returns it for the
+    // render pass to replay. Null if it couldn't be recorded.
+    VkCommandBuffer recordGpuCullingDraw(GpuCullData*, Renderer2D::Renderer2DData*, uint32_t frame,
+        const glm::mat4& viewProjection, uint64_t cameraVersion);
+    void cleanupGpuCulling(GpuCullData*, VulkanDeviceData*);
+
+    inline bool isGpuCullingEnabled(const GpuCullData* culling) {
+        return culling->slots != nullptr;
+    }
+}
+
+#endif //PONG_VK_GPUCULLING_H
@@ -0,0 +1,68 @@
+#include "latency.h"
+#include "../clock.h"
+#include "core.h"
+
+namespace Renderer {
+
+    void initialiseLatency(LatencyData* latency, VulkanDeviceData* deviceData) {
+
+        *latency = LatencyData{};
+
+#ifdef VK_KHR_present_wait
+        if (deviceData->isPresentWaitSupported) {
+            latency->waitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(
+                vkGetDeviceProcAddr(deviceData->logicalDevice, "vkWaitForPresentKHR"));
+        }
+
+        if (latency->waitForPresent) {
+            PONG_INFO("Present wait is available - measuring latency up to present completion");
+            return;
+        }
+#endif
+        PONG_INFO("Present wait is unavailable - measuring latency up to vkQueuePresentKHR");
+    }
+
+    void finishFrameLatency(LatencyData* latency) {
+
+        // Nobody is collecting them fast enough - lose the oldest rather than stall.
+        if (latency->count == LATENCY_QUEUE_SIZE) {
+            latency->head = (latency->head + 1) % LATENCY_QUEUE_SIZE;
+            latency->count--;
+            latency->droppedFrames++;
+        }
+
+        latency->frames[(latency->head + latency->count) % LATENCY_QUEUE_SIZE] = latency->current;
+        latency->count++;
+        latency->current = FrameLatency{};
+    }
+
+    void abandonPendingPresents(LatencyData* latency) {
+        for (uint32_t i = 0; i < latency->count; i++) {
+            latency->frames[(latency->head + i) % LATENCY_QUEUE_SIZE].presentId = 0;
+        }
+    }
+
+    bool popFrameLatency(LatencyData* latency, VulkanDeviceData* deviceData, SwapchainData* swapchain,
+        FrameLatency* frame) {
+
+        if (latency->count == 0) return false;
+
+        FrameLatency* oldest = &latency->frames[latency->head];
+
+#ifdef VK_KHR_present_wait
+        // Presents complete in order, so only the oldest one needs checking.
+        if (latency->waitForPresent && oldest->presentId != 0) {
+            VkResult result = latency->waitForPresent(deviceData->logicalDevice, swapchain->swapchain,
+                oldest->presentId, 0);
+
+            if (result == VK_TIMEOUT) return false;
+            if (result == VK_SUCCESS) oldest->presentCompleteNanos = Clock::nowNanos();
+        }
+#endif
+
+        *frame = *oldest;
+        latency->head = (latency->head + 1) % LATENCY_QUEUE_SIZE;
+        latency->count--;
+        return true;
+    }
+}
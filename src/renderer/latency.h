@@ -0,0 +1,60 @@
+#ifndef PONG_VK_LATENCY_H
+#define PONG_VK_LATENCY_H
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include "vk/vulkanDeviceData.h"
+#include "vk/swapchainData.h"
+
+namespace Renderer {
+
+    // Input-to-photon tracking. Every frame can be tagged with the time of the
+    // input it's the first to respond to, and drawFrame stamps the acquire,
+    // submit and present on top of it. Where VK_KHR_present_wait is available
+    // each present also carries an id, and the frame is only handed back once
+    // the presentation engine reports it has actually reached the screen.
+    //
+    // vkWaitForPresentKHR needs the swapchain externally synchronised, so it
+    // can't sit on its own thread - pending presents are polled (never waited
+    // on) from the render loop instead, which makes the completion time accurate
+    // to within one frame.
+
+    // All times are Clock::nowNanos(), or 0 where unknown.
+    struct FrameLatency {
+        uint64_t inputNanos             {0};
+        uint64_t acquireNanos           {0};
+        uint64_t submitNanos            {0};
+        uint64_t presentNanos           {0};
+        uint64_t presentCompleteNanos   {0};
+        // 0 if the present can't be waited on.
+        uint64_t presentId              {0};
+    };
+
+    constexpr uint32_t LATENCY_QUEUE_SIZE = 16;
+
+    struct LatencyData {
+        // The frame currently being built.
+        FrameLatency current;
+        // Presented frames, oldest first, waiting to be collected.
+        FrameLatency frames[LATENCY_QUEUE_SIZE];
+        uint32_t head                   {0};
+        uint32_t count                  {0};
+        uint64_t nextPresentId          {1};
+        uint64_t droppedFrames          {0};
+#ifdef VK_KHR_present_wait
+        PFN_vkWaitForPresentKHR waitForPresent  {nullptr};
+#endif
+    };
+
+    void initialiseLatency(LatencyData*, VulkanDeviceData*);
+    // Moves the current frame into the presented queue and starts a new one.
+    void finishFrameLatency(LatencyData*);
+    // Presents to a swapchain which has since been destroyed can't be waited on
+    // any more - hand them back without a completion time.
+    void abandonPendingPresents(LatencyData*);
+    // Returns the oldest presented frame once its completion is known (or can
+    // never be known).
+    bool popFrameLatency(LatencyData*, VulkanDeviceData*, SwapchainData*, FrameLatency*);
+}
+
+#endif //PONG_VK_LATENCY_H
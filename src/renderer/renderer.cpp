@@ -1,5 +1,7 @@
 #include "renderer.h"
 #include <cstring>
+#include <algorithm>
+#include <chrono>
 #include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include "vk/initialisers.h"
@@ -7,6 +9,7 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include "vk/texture2d.h"
+#include "../clock.h"
 
 namespace Renderer {
 
@@ -18,7 +21,122 @@ namespace Renderer {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME
     };
 
-    Status initialiseRenderer(Renderer* renderer, bool enableValidationLayers, void* nativeWindow, WindowType type) {
+    // Mostly the font and the text atlas.
+    static const size_t LIFETIME_ARENA_SIZE = 1024 * 1024;
+    static const size_t SWAPCHAIN_ARENA_SIZE = 16 * 1024;
+    static const size_t FRAME_ARENA_SIZE = 256 * 1024;
+
+    static const char* FONT_PATH = "assets/fonts/DejaVuSansMono.ttf";
+
+    // GPU balls don't try to catch up on anything longer - after a hitch they
+    // just carry on from where they were.
+    static const float MAX_GPU_BALL_DELTA = 0.05f;
+
+    static void writeQuadTexture(VkDevice device, VkDescriptorSet set, VkDescriptorImageInfo* imageInfo) {
+
+        if (set == VK_NULL_HANDLE) return;
+
+        VkWriteDescriptorSet write = initialiseWriteDescriptorSet(set, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+            1, nullptr, imageInfo);
+        write.dstArrayElement = Renderer2D::QUAD_TEXTURE_SLOT;
+
+        vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    }
+
+    // Points the quad texture slot of every set quads are drawn with at the
+    // given texture. The sets can't be written while a frame in flight might
+    // be using them, so this waits for the device to go idle, and anything
+    // recorded with them is recorded again.
+    static void bindQuadTexture(Renderer* renderer, const Texture2D& texture) {
+
+        Renderer2D::Renderer2DData* renderer2D = &renderer->renderer2DData;
+        VkDevice device = renderer->deviceData.logicalDevice;
+
+        vkDeviceWaitIdle(device);
+
+        renderer2D->quadData.textures[Renderer2D::QUAD_TEXTURE_SLOT] = texture;
+
+        VkDescriptorImageInfo imageInfo = initialiseDescriptorImageInfo(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            texture.view, texture.sampler);
+
+        if (renderer2D->quadData.dynamicDescriptorSets) {
+            for (uint32_t i = 0; i < renderer->swapchainData.imageCount; i++) {
+                writeQuadTexture(device, renderer2D->quadData.dynamicDescriptorSets[i], &imageInfo);
+            }
+        }
+        writeQuadTexture(device, renderer2D->staticLayer.descriptorSet, &imageInfo);
+        if (isGpuBallsEnabled(&renderer->gpuBalls)) writeQuadTexture(device, renderer->gpuBalls.drawSet, &imageInfo);
+        if (isGpuCullingEnabled(&renderer->gpuCulling)) {
+            writeQuadTexture(device, renderer->gpuCulling.drawSet, &imageInfo);
+        }
+
+        renderer2D->renderPassVersion++;
+    }
+
+    // Keeps the quad texture resident for the frame being drawn. If it had
+    // been evicted it's loaded back in with a new view, which the quads' sets
+    // are moved over to.
+    static Status useQuadTexture(Renderer* renderer) {
+
+        Renderer2D::QuadData* quadData = &renderer->renderer2DData.quadData;
+
+        Texture2D* texture = useTexture(renderer, quadData->textureHandle);
+        if (!texture) {
+            PONG_ERROR("Failed to re-load the quad texture!");
+            return Status::FAILURE;
+        }
+
+        if (texture->view != quadData->textures[Renderer2D::QUAD_TEXTURE_SLOT].view) {
+            bindQuadTexture(renderer, *texture);
+        }
+
+        return Status::SUCCESS;
+    }
+
+    // Makes room on a heap that's over budget by evicting textures.
+    static bool evictTextureForAllocation(void* userData, uint32_t heapIndex) {
+        auto renderer = static_cast<Renderer*>(userData);
+        Renderer2D::QuadData* quadData = &renderer->renderer2DData.quadData;
+
+        TextureHandle handle = findEvictableTexture(&renderer->textureCache, &renderer->deviceData, heapIndex);
+        if (handle == INVALID_TEXTURE) return false;
+
+        // The quads' sets can't be left pointing at a freed image, so until the
+        // texture's next drawn with they're given the text atlas (which is
+        // never evicted) instead.
+        if (handle == quadData->textureHandle) {
+            bindQuadTexture(renderer, quadData->textures[Renderer2D::TEXT_ATLAS_SLOT]);
+        }
+
+        evictTexture(&renderer->textureCache, &renderer->deviceData, handle);
+        return true;
+    }
+
+    // The frame slot's quads were all counted as drawn when they were handed
+    // to the GPU - move the ones it culled over. The slot's fence has to have
+    // signalled.
+    static void countGpuCulledQuads(Renderer* renderer, uint32_t frame) {
+        uint32_t culledCount = collectGpuCulling(&renderer->gpuCulling, frame);
+        renderer->stats.quadsDrawn -= std::min<uint64_t>(culledCount, renderer->stats.quadsDrawn);
+        renderer->stats.quadsCulled += culledCount;
+    }
+
+    static glm::vec2 getSwapchainExtent(const SwapchainData* swapchain) {
+        return { static_cast<float>(swapchain->swapchainExtent.width),
+            static_cast<float>(swapchain->swapchainExtent.height) };
+    }
+
+    Status initialiseRenderer(Renderer* renderer, bool enableValidationLayers, void* nativeWindow, WindowType type,
+        Backend backend) {
+
+        renderer->backend = backend;
+        // Sized to the swapchain once there is one.
+        updateCamera(&renderer->camera, renderer->camera.extent);
+
+        if (backend == Backend::NONE) {
+            PONG_INFO("Using null renderer backend - no GPU work will be done");
+            return Status::SUCCESS;
+        }
 
         if (type == WindowType::GLFW) {
             auto window = static_cast<GLFWwindow*>(nativeWindow);
@@ -35,14 +153,28 @@ namespace Renderer {
                 &renderer->deviceData.framebufferHeight);
         }
 
+        initialiseLatency(&renderer->latencyData, &renderer->deviceData);
+
+        renderer->deviceData.gpuMemory.evict = evictTextureForAllocation;
+        renderer->deviceData.gpuMemory.evictUserData = renderer;
+
+        if (!Memory::initialiseArena(&renderer->lifetimeArena, "renderer", LIFETIME_ARENA_SIZE)
+            || !Memory::initialiseArena(&renderer->swapchainArena, "swapchain", SWAPCHAIN_ARENA_SIZE)) {
+            PONG_ERROR("Failed to allocate renderer memory!");
+            return Status::INITIALIZATION_FAILURE;
+        }
+
         // ============================= SWAPCHAIN CREATION =================================
 
         // Create the swapchain (should initialise both the swapchain and image views)
-        if (createSwapchain(&renderer->swapchainData, &renderer->deviceData) != VK_SUCCESS) {
+        if (createSwapchain(&renderer->swapchainData, &renderer->deviceData, &renderer->swapchainArena)
+            != VK_SUCCESS) {
             PONG_ERROR("Failed to create swapchain!");
             return Status::FAILURE;
         }
 
+        updateCamera(&renderer->camera, getSwapchainExtent(&renderer->swapchainData));
+
         // ========================= COMMAND POOL CREATION =========================
 
         // In vulkan, all steps and operations that happen are not handled via
@@ -71,22 +203,34 @@ namespace Renderer {
 
         PONG_INFO("Initialised Swapchain");
 
-        Texture2D texture;
-        loadImage(renderer, "assets/awesomeface.png", texture);
-        texture.sampler = initialiseSampler(
-                renderer->deviceData.logicalDevice,
-                VK_FILTER_LINEAR, VK_FILTER_LINEAR,
-                VK_SAMPLER_ADDRESS_MODE_REPEAT,
-                VK_BORDER_COLOR_INT_OPAQUE_BLACK,
-                VK_COMPARE_OP_ALWAYS,
-                VK_SAMPLER_MIPMAP_MODE_LINEAR
-        );
+        TextureHandle texture = loadTexture(renderer, "assets/awesomeface.png");
+        if (texture == INVALID_TEXTURE) {
+            PONG_ERROR("Failed to load quad texture!");
+            return Status::INITIALIZATION_FAILURE;
+        }
+
+        renderer->renderer2DData.quadData.textureHandle = texture;
+        renderer->renderer2DData.quadData.textures[Renderer2D::QUAD_TEXTURE_SLOT] = *useTexture(renderer, texture);
+
+        // Text is optional - without a font the atlas is just left blank.
+        if (initialiseText(&renderer->textData, FONT_PATH, &renderer->lifetimeArena) != Status::SUCCESS) {
+            PONG_WARN("No font loaded - text won't be drawn");
+        }
+
+        if (createTextAtlas(&renderer->textData, &renderer->deviceData, renderer->renderer2DData.commandPool)
+            != Status::SUCCESS) {
+            return Status::INITIALIZATION_FAILURE;
+        }
+
+        renderer->renderer2DData.quadData.textures[Renderer2D::TEXT_ATLAS_SLOT] = renderer->textData.atlas;
 
-        renderer->renderer2DData.quadData.texture = texture;
+        // One slice of the instance buffer for each frame that can be in flight.
+        renderer->renderer2DData.quadData.framesInFlight = renderer->maxFramesInFlight;
 
         // ================================= RENDERER 2D ====================================
 
-        if (!Renderer2D::initialiseRenderer2D(&renderer->deviceData, &renderer->renderer2DData, renderer->swapchainData)) {
+        if (!Renderer2D::initialiseRenderer2D(&renderer->deviceData, &renderer->renderer2DData, renderer->swapchainData,
+            &renderer->swapchainArena)) {
             PONG_ERROR("Failed to create renderer2D");
             return Status::INITIALIZATION_FAILURE;
         }
@@ -100,9 +244,54 @@ namespace Renderer {
 
         PONG_INFO("Created synchronisation objects");
 
+        // GPU timings are optional - carry on without them if they aren't supported.
+        createTimestampQueries(renderer);
+
         return Status::SUCCESS;
     }
 
+    Status enableCapture(Renderer* pRenderer, CaptureFormat format, const char* outputPath) {
+
+        if (pRenderer->backend == Backend::NONE) {
+            PONG_ERROR("Frame capture is not available with the null renderer backend");
+            return Status::FAILURE;
+        }
+
+        return initialiseCapture(&pRenderer->captureData, &pRenderer->deviceData, &pRenderer->swapchainData,
+            pRenderer->renderer2DData.commandPool, format, outputPath);
+    }
+
+    Status enableGpuBalls(Renderer* pRenderer, uint32_t ballCount, glm::vec2 arenaHalfSize, uint32_t seed) {
+
+        if (pRenderer->backend == Backend::NONE) {
+            PONG_ERROR("GPU balls are not available with the null renderer backend");
+            return Status::FAILURE;
+        }
+
+        return initialiseGpuBalls(&pRenderer->gpuBalls, &pRenderer->deviceData, &pRenderer->renderer2DData,
+            &pRenderer->lifetimeArena, pRenderer->maxFramesInFlight, ballCount, arenaHalfSize, seed);
+    }
+
+    Status enableGpuCulling(Renderer* pRenderer) {
+
+        if (pRenderer->backend == Backend::NONE) {
+            PONG_ERROR("GPU culling is not available with the null renderer backend");
+            return Status::FAILURE;
+        }
+
+        return initialiseGpuCulling(&pRenderer->gpuCulling, &pRenderer->deviceData, &pRenderer->renderer2DData,
+            &pRenderer->lifetimeArena, pRenderer->maxFramesInFlight);
+    }
+
+    void setGpuBallColliders(Renderer* pRenderer, const glm::vec4* colliders, uint32_t colliderCount) {
+        GpuBallData* balls = &pRenderer->gpuBalls;
+
+        balls->colliderCount = std::min(colliderCount, MAX_GPU_BALL_COLLIDERS);
+        for (uint32_t i = 0; i < balls->colliderCount; i++) {
+            balls->colliders[i] = colliders[i];
+        }
+    }
+
     void loadDefaultValidationLayers(Renderer* renderer) {
 
         renderer->deviceData.validationLayers = validationLayers;
@@ -130,6 +319,42 @@ namespace Renderer {
         renderer->deviceData.deviceExtensionCount = 1;
     }
 
+    void setMaxQuads(Renderer* renderer, size_t maxQuads) {
+        renderer->renderer2DData.quadData.maxQuads = maxQuads;
+    }
+
+    void setGpuMemoryBudget(Renderer* renderer, VkDeviceSize budget) {
+        renderer->deviceData.gpuMemory.budget = budget;
+    }
+
+    void setFrameInputTime(Renderer* renderer, uint64_t inputNanos) {
+        // A skipped frame keeps its input, so it isn't lost when the next one is drawn.
+        if (renderer->latencyData.current.inputNanos == 0) {
+            renderer->latencyData.current.inputNanos = inputNanos;
+        }
+    }
+
+    bool popFrameLatency(Renderer* renderer, FrameLatency* frame) {
+        return popFrameLatency(&renderer->latencyData, &renderer->deviceData, &renderer->swapchainData, frame);
+    }
+
+    void collectFrameStats(Renderer* renderer) {
+
+        if (renderer->backend == Backend::NONE || !isGpuCullingEnabled(&renderer->gpuCulling)) return;
+
+        vkWaitForFences(renderer->deviceData.logicalDevice, renderer->maxFramesInFlight, renderer->inFlightFences,
+            VK_TRUE, UINT64_MAX);
+
+        for (uint32_t i = 0; i < renderer->maxFramesInFlight; i++) {
+            countGpuCulledQuads(renderer, i);
+        }
+    }
+
+    Memory::Arena* getFrameArena(Renderer* renderer) {
+        if (!renderer->frameArenas) return nullptr;
+        return &renderer->frameArenas[renderer->currentFrame];
+    }
+
     [[maybe_unused]] Status loadCustomDeviceExtensions(Renderer* renderer, const char** extensions,
                        uint32_t extensionCount) {
 
@@ -146,23 +371,35 @@ namespace Renderer {
 
     Status cleanupRenderer(Renderer* pRenderer, bool enableValidationLayers) {
 
+        if (pRenderer->backend == Backend::NONE) return Status::SUCCESS;
+
         // Since our image drawing is asynchronous, we need to make sure that
         // our resources aren't in use when trying to clean them up:
         vkDeviceWaitIdle(pRenderer->deviceData.logicalDevice);
 
+        // Flushes any outstanding captures before the command pool goes away.
+        cleanupCapture(&pRenderer->captureData, &pRenderer->deviceData);
+
+        cleanupGpuBalls(&pRenderer->gpuBalls, &pRenderer->deviceData);
+        cleanupGpuCulling(&pRenderer->gpuCulling, &pRenderer->deviceData);
+
         cleanupSwapchain(
-            pRenderer->deviceData.logicalDevice,
+            &pRenderer->deviceData,
             &pRenderer->swapchainData,
             &pRenderer->renderer2DData.graphicsPipeline,
             pRenderer->renderer2DData.commandPool,
             pRenderer->renderer2DData.frameBuffers,
             pRenderer->renderer2DData.commandBuffers,
-            &pRenderer->renderer2DData.quadData.dynamicData.buffer,
+            pRenderer->renderer2DData.quadCommandBuffers,
             pRenderer->renderer2DData.descriptorPool
         );
 
         Renderer2D::cleanupRenderer2D(&pRenderer->deviceData, &pRenderer->renderer2DData);
 
+        cleanupText(&pRenderer->textData, &pRenderer->deviceData);
+
+        destroyTextureCache(&pRenderer->textureCache, &pRenderer->deviceData);
+
         // Clean up the semaphores we created earlier.
         for (size_t i = 0; i < pRenderer->maxFramesInFlight; i++) {
             vkDestroySemaphore(pRenderer->deviceData.logicalDevice, pRenderer->renderFinishedSemaphores[i],
@@ -172,14 +409,27 @@ namespace Renderer {
             vkDestroyFence(pRenderer->deviceData.logicalDevice, pRenderer->inFlightFences[i], nullptr);
         }
 
-        // Free the memory used by the arrays
-        free(pRenderer->imageAvailableSemaphores);
-        free(pRenderer->inFlightFences);
-        free(pRenderer->renderFinishedSemaphores);
+        if (pRenderer->timestampQueryPool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(pRenderer->deviceData.logicalDevice, pRenderer->timestampQueryPool, nullptr);
+        }
 
         vkDestroyCommandPool(pRenderer->deviceData.logicalDevice, pRenderer->renderer2DData.commandPool,
     nullptr);
 
+        // Free the memory used by the arrays. The frame arenas live in the
+        // lifetime arena, so that has to go last.
+        if (pRenderer->frameArenas) {
+            Memory::logArenaUsage(&pRenderer->frameArenas[0]);
+            for (size_t i = 0; i < pRenderer->maxFramesInFlight; i++) {
+                Memory::destroyArena(&pRenderer->frameArenas[i]);
+            }
+            pRenderer->frameArenas = nullptr;
+        }
+        Memory::logArenaUsage(&pRenderer->swapchainArena);
+        Memory::logArenaUsage(&pRenderer->lifetimeArena);
+        Memory::destroyArena(&pRenderer->swapchainArena);
+        Memory::destroyArena(&pRenderer->lifetimeArena);
+
         cleanupVulkanDevice(&pRenderer->deviceData, enableValidationLayers);
 
         return Status::SUCCESS;
@@ -212,21 +462,27 @@ namespace Renderer {
             pRenderer->maxFramesInFlight = maxFramesInFlight;
         }
 
-        pRenderer->imageAvailableSemaphores = static_cast<VkSemaphore *>(malloc(
-        pRenderer->maxFramesInFlight * sizeof(VkSemaphore)));
+        pRenderer->textureCache.framesInFlight = pRenderer->maxFramesInFlight;
+
+        Memory::Arena* arena = &pRenderer->lifetimeArena;
+
+        pRenderer->imageAvailableSemaphores = Memory::allocateArray<VkSemaphore>(arena,
+            pRenderer->maxFramesInFlight, Memory::MemoryTag::SYNC);
 
-        pRenderer->renderFinishedSemaphores = static_cast<VkSemaphore *>(malloc(
-                pRenderer->maxFramesInFlight * sizeof(VkSemaphore)));
+        pRenderer->renderFinishedSemaphores = Memory::allocateArray<VkSemaphore>(arena,
+            pRenderer->maxFramesInFlight, Memory::MemoryTag::SYNC);
 
         // The semaphore info struct only has one field
         VkSemaphoreCreateInfo semaphoreInfo{};
         semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-        pRenderer->inFlightFences = static_cast<VkFence *>(malloc(
-                pRenderer->maxFramesInFlight * sizeof(VkFence)));
+        pRenderer->inFlightFences = Memory::allocateArray<VkFence>(arena,
+            pRenderer->maxFramesInFlight, Memory::MemoryTag::SYNC);
 
-        pRenderer->imagesInFlight = static_cast<VkFence *>(malloc(
-                pRenderer->swapchainData.imageCount * sizeof(VkFence)));
+        // This one's per swapchain image rather than per frame, so is re-made
+        // whenever the swapchain is.
+        pRenderer->imagesInFlight = Memory::allocateArray<VkFence>(&pRenderer->swapchainArena,
+            pRenderer->swapchainData.imageCount, Memory::MemoryTag::SYNC);
 
         // Initialise all these images to 0 to start with.
         for (size_t i = 0; i < pRenderer->swapchainData.imageCount; i++) {
@@ -257,19 +513,214 @@ namespace Renderer {
             }
         }
 
+        // Scratch memory for each frame in flight.
+        pRenderer->frameArenas = Memory::allocateArray<Memory::Arena>(arena, pRenderer->maxFramesInFlight,
+            Memory::MemoryTag::FRAME);
+        for (size_t i = 0; i < pRenderer->maxFramesInFlight; i++) {
+            if (!Memory::initialiseArena(&pRenderer->frameArenas[i], "frame", FRAME_ARENA_SIZE)) {
+                PONG_ERROR("Failed to allocate frame memory!");
+                return Status::INITIALIZATION_FAILURE;
+            }
+        }
+
+        return Status::SUCCESS;
+    }
+
+    Status createTimestampQueries(Renderer* pRenderer) {
+
+        // Timestamps are only meaningful if the graphics queue actually supports
+        // them (timestampValidBits of 0 means it doesn't).
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(pRenderer->deviceData.physicalDevice, &queueFamilyCount, nullptr);
+
+        Memory::ArenaMarker marker = Memory::getArenaMarker(&pRenderer->lifetimeArena);
+        auto* queueFamilies = Memory::allocateArray<VkQueueFamilyProperties>(&pRenderer->lifetimeArena,
+            queueFamilyCount, Memory::MemoryTag::QUERIES);
+        vkGetPhysicalDeviceQueueFamilyProperties(pRenderer->deviceData.physicalDevice, &queueFamilyCount, queueFamilies);
+
+        uint32_t validBits = queueFamilies[pRenderer->deviceData.indices.graphicsFamily.value()].timestampValidBits;
+        Memory::rewindArena(&pRenderer->lifetimeArena, marker);
+
+        if (validBits == 0) {
+            PONG_WARN("Graphics queue doesn't support timestamps - GPU frame times unavailable");
+            return Status::FAILURE;
+        }
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(pRenderer->deviceData.physicalDevice, &properties);
+
+        pRenderer->timestampPeriod = properties.limits.timestampPeriod;
+        pRenderer->timestampMask = validBits >= 64 ? UINT64_MAX : ((1ull << validBits) - 1);
+
+        VkQueryPoolCreateInfo queryPoolInfo{};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = pRenderer->maxFramesInFlight * 2;
+
+        if (vkCreateQueryPool(pRenderer->deviceData.logicalDevice, &queryPoolInfo, nullptr,
+            &pRenderer->timestampQueryPool) != VK_SUCCESS) {
+            PONG_WARN("Failed to create timestamp query pool - GPU frame times unavailable");
+            return Status::FAILURE;
+        }
+
+        pRenderer->isTimestampWritten = Memory::allocateArray<bool>(&pRenderer->lifetimeArena,
+            pRenderer->maxFramesInFlight, Memory::MemoryTag::QUERIES);
+        for (size_t i = 0; i < pRenderer->maxFramesInFlight; i++) {
+            pRenderer->isTimestampWritten[i] = false;
+        }
+
         return Status::SUCCESS;
     }
 
     Status drawFrame(Renderer* pRenderer, bool* resized) {
 
+        pRenderer->stats.framesDrawn++;
+
+        if (pRenderer->backend == Backend::NONE) {
+            FrameLatency* latency = &pRenderer->latencyData.current;
+            latency->acquireNanos = latency->submitNanos = latency->presentNanos = Clock::nowNanos();
+            finishFrameLatency(&pRenderer->latencyData);
+            return Status::SUCCESS;
+        }
+
         // This function takes an array of fences and waits for either one or all
         // of them to be signalled. The fourth parameter specifies that we're
         // waiting for all fences to be signalled before moving on. The last
         // parameter takes a timeout period which we set really high (effectively
         // making it null)
+        auto waitStart = std::chrono::steady_clock::now();
+
         vkWaitForFences(pRenderer->deviceData.logicalDevice, 1,
             &pRenderer->inFlightFences[pRenderer->currentFrame], VK_TRUE, UINT64_MAX);
 
+        pRenderer->stats.lastFenceWaitMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - waitStart).count();
+
+        // Nothing from the last use of this frame slot is in flight any more.
+        Memory::resetArena(&pRenderer->frameArenas[pRenderer->currentFrame]);
+
+        // The last frame to use this slot has finished, so its timestamps are ready.
+        if (pRenderer->timestampQueryPool != VK_NULL_HANDLE && pRenderer->isTimestampWritten[pRenderer->currentFrame]) {
+            uint64_t timestamps[2];
+            if (vkGetQueryPoolResults(pRenderer->deviceData.logicalDevice, pRenderer->timestampQueryPool,
+                pRenderer->currentFrame * 2, 2, sizeof(timestamps), timestamps, sizeof(uint64_t),
+                VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+
+                uint64_t ticks = (timestamps[1] - timestamps[0]) & pRenderer->timestampMask;
+                pRenderer->stats.lastGpuTimeMicros = static_cast<int64_t>(ticks * pRenderer->timestampPeriod / 1000.0);
+            }
+        }
+
+        // The quad texture is only kept from being evicted while something's
+        // drawn with it - the CPU's quads or the GPU balls.
+        Renderer2D::QuadData* quadData = &pRenderer->renderer2DData.quadData;
+        if ((quadData->isTextureDrawn || isGpuBallsEnabled(&pRenderer->gpuBalls))
+            && useQuadTexture(pRenderer) != Status::SUCCESS) {
+            return Status::FAILURE;
+        }
+
+        // Glyphs drawn for the first time this frame need to reach the atlas
+        // before it's drawn. This waits for the upload, but only happens on
+        // frames that add glyphs - once a HUD's been on screen, it never does.
+        if (pRenderer->textData.isAtlasDirty
+            && uploadTextAtlas(&pRenderer->textData, &pRenderer->deviceData, pRenderer->renderer2DData.commandPool)
+            != Status::SUCCESS) {
+            return Status::FAILURE;
+        }
+
+        // The static layer only needs uploading when it's changed, and
+        // recording when it's been uploaded, the render pass it was recorded
+        // against has been re-made or the camera has moved.
+        Renderer2D::StaticLayer* staticLayer = &pRenderer->renderer2DData.staticLayer;
+        if (staticLayer->isDirty && !Renderer2D::bakeStaticLayer(&pRenderer->deviceData, &pRenderer->renderer2DData)) {
+            PONG_ERROR("Failed to upload static layer!");
+            return Status::FAILURE;
+        }
+
+        if (staticLayer->quadCount > 0 && !Renderer2D::recordStaticLayer(&pRenderer->renderer2DData,
+            pRenderer->currentFrame, pRenderer->camera.viewProjection, pRenderer->camera.version)) {
+            PONG_ERROR("Failed to record static layer!");
+            return Status::FAILURE;
+        }
+
+        // The frame's command buffer lists are sized by which passes are
+        // enabled, and live until this slot comes around again.
+        Memory::Arena* frameArena = getFrameArena(pRenderer);
+        bool isCapturing = isCaptureEnabled(&pRenderer->captureData);
+        uint32_t computePassCount = (isGpuBallsEnabled(&pRenderer->gpuBalls) ? 1 : 0)
+            + (isGpuCullingEnabled(&pRenderer->gpuCulling) ? 1 : 0);
+
+        // Replayed in the render pass ahead of the frame's own quads - the
+        // static layer, then one draw per compute pass.
+        VkCommandBuffer* replayedBuffers = Memory::allocateArray<VkCommandBuffer>(frameArena, 1 + computePassCount,
+            Memory::MemoryTag::FRAME);
+        uint32_t replayedBufferCount = 0;
+
+        if (staticLayer->quadCount > 0) {
+            replayedBuffers[replayedBufferCount++] = staticLayer->recordings[pRenderer->currentFrame].commandBuffer;
+        }
+
+        // The GPU balls' events from the last use of this slot are ready, and
+        // its uniforms are free to be rewritten.
+        VkCommandBuffer gpuBallBuffer = VK_NULL_HANDLE;
+        GpuBallData* gpuBalls = &pRenderer->gpuBalls;
+
+        if (isGpuBallsEnabled(gpuBalls)) {
+            collectGpuBallEvents(gpuBalls, pRenderer->currentFrame);
+
+            uint64_t now = Clock::nowNanos();
+            float delta = gpuBalls->lastFrameNanos == 0 ? 0.0f
+                : std::min(static_cast<float>(Clock::toSeconds(now - gpuBalls->lastFrameNanos)), MAX_GPU_BALL_DELTA);
+            gpuBalls->lastFrameNanos = now;
+
+            gpuBallBuffer = prepareGpuBalls(gpuBalls, pRenderer->currentFrame, pRenderer->camera.viewRect, delta);
+
+            VkCommandBuffer drawBuffer = recordGpuBallDraw(gpuBalls, &pRenderer->renderer2DData,
+                pRenderer->currentFrame, pRenderer->camera.viewProjection, pRenderer->camera.version);
+            if (drawBuffer == VK_NULL_HANDLE) {
+                PONG_ERROR("Failed to record GPU ball draw!");
+                return Status::FAILURE;
+            }
+
+            replayedBuffers[replayedBufferCount++] = drawBuffer;
+        }
+
+        // This frame's slice of the instance buffer was last read by the frame
+        // we've just waited on, so it's free to be overwritten.
+        auto instanceOffset = static_cast<uint32_t>(pRenderer->currentFrame * quadData->instanceSliceSize);
+        memcpy(static_cast<uint8_t*>(quadData->mappedInstances) + instanceOffset, quadData->instances,
+            quadData->quadCount * sizeof(Renderer2D::QuadInstance));
+
+        // With GPU culling, the frame's quads are drawn by an indirect draw
+        // recorded up front, after the static layer and the GPU balls - so
+        // the render pass records no draw of its own. How many of the quads
+        // the last use of this slot culled is only known now.
+        VkCommandBuffer cullingBuffer = VK_NULL_HANDLE;
+        size_t recordedQuadCount = quadData->quadCount;
+        GpuCullData* gpuCulling = &pRenderer->gpuCulling;
+
+        if (isGpuCullingEnabled(gpuCulling)) {
+            countGpuCulledQuads(pRenderer, pRenderer->currentFrame);
+
+            cullingBuffer = prepareGpuCulling(gpuCulling, pRenderer->currentFrame, pRenderer->camera.viewRect,
+                static_cast<uint32_t>(quadData->quadCount));
+
+            VkCommandBuffer drawBuffer = recordGpuCullingDraw(gpuCulling, &pRenderer->renderer2DData,
+                pRenderer->currentFrame, pRenderer->camera.viewProjection, pRenderer->camera.version);
+            if (drawBuffer == VK_NULL_HANDLE) {
+                PONG_ERROR("Failed to record GPU culling draw!");
+                return Status::FAILURE;
+            }
+
+            replayedBuffers[replayedBufferCount++] = drawBuffer;
+            recordedQuadCount = 0;
+        }
+
+        // Any captures made by this frame are now complete and safe to read.
+        if (isCaptureEnabled(&pRenderer->captureData)) {
+            collectCapture(&pRenderer->captureData, &pRenderer->deviceData, pRenderer->currentFrame);
+        }
+
         // In each frame of the main loop, we'll need to perform the following
         // operations:
         // 1. acquire an image from the swapchain.
@@ -284,30 +735,7 @@ namespace Renderer {
             pRenderer->swapchainData.swapchain, UINT64_MAX, pRenderer->imageAvailableSemaphores[pRenderer->currentFrame],
             VK_NULL_HANDLE, &pRenderer->imageIndex);
 
-        if (vkGetFenceStatus(pRenderer->deviceData.logicalDevice, pRenderer->inFlightFences[pRenderer->currentFrame])
-            == VK_SUCCESS) {
-
-            vkResetCommandBuffer(pRenderer->renderer2DData.commandBuffers[pRenderer->imageIndex],
-            VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
-
-            if (rerecordCommandBuffer(
-                    pRenderer->deviceData.logicalDevice,
-                    &pRenderer->renderer2DData.commandBuffers[pRenderer->imageIndex],
-                    pRenderer->imageIndex,
-                    &pRenderer->renderer2DData.graphicsPipeline,
-                    &pRenderer->swapchainData,
-                    pRenderer->renderer2DData.frameBuffers,
-                    &pRenderer->renderer2DData.commandPool,
-                    &pRenderer->renderer2DData.quadData.vertexBuffer,
-                    &pRenderer->renderer2DData.quadData.indexBuffer,
-                    pRenderer->renderer2DData.quadData.dynamicDescriptorSets,
-                    pRenderer->renderer2DData.quadData.quadCount,
-                    pRenderer->renderer2DData.quadData.dynamicData.dynamicAlignment) != VK_SUCCESS) {
-
-                PONG_ERROR("Failed to re-record command buffer!");
-                return Status::FAILURE;
-            }
-        }
+        pRenderer->latencyData.current.acquireNanos = Clock::nowNanos();
 
         // If our swapchain is out of date (no longer valid, then we re-create
         // it)
@@ -331,6 +759,39 @@ namespace Renderer {
         // Now, use the image in this frame!.
         pRenderer->imagesInFlight[pRenderer->imageIndex] = pRenderer->inFlightFences[pRenderer->currentFrame];
 
+        // Only now that the image's last frame has finished can its command
+        // buffer be re-recorded.
+        if (vkGetFenceStatus(pRenderer->deviceData.logicalDevice, pRenderer->inFlightFences[pRenderer->currentFrame])
+            == VK_SUCCESS) {
+
+            vkResetCommandBuffer(pRenderer->renderer2DData.commandBuffers[pRenderer->imageIndex],
+            VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
+
+            if (rerecordCommandBuffer(
+                    pRenderer->deviceData.logicalDevice,
+                    &pRenderer->renderer2DData.commandBuffers[pRenderer->imageIndex],
+                    pRenderer->imageIndex,
+                    &pRenderer->renderer2DData.graphicsPipeline,
+                    &pRenderer->swapchainData,
+                    pRenderer->renderer2DData.frameBuffers,
+                    &pRenderer->renderer2DData.commandPool,
+                    &pRenderer->renderer2DData.quadData.vertexBuffer,
+                    &pRenderer->renderer2DData.quadData.indexBuffer,
+                    quadData->dynamicDescriptorSets,
+                    recordedQuadCount,
+                    instanceOffset,
+                    pRenderer->camera.viewProjection,
+                    pRenderer->renderer2DData.quadCommandBuffers,
+                    replayedBuffers,
+                    replayedBufferCount,
+                    pRenderer->timestampQueryPool,
+                    pRenderer->currentFrame * 2) != VK_SUCCESS) {
+
+                PONG_ERROR("Failed to re-record command buffer!");
+                return Status::FAILURE;
+            }
+        }
+
         // Once we have that, we now need to submit the image to the queue:
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -347,8 +808,25 @@ namespace Renderer {
         submitInfo.pWaitDstStageMask = waitStages;
         // Now we need to specify which command buffers to submit to. In our
         // case we need to submit to the buffer which corresponds to our image.
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &pRenderer->renderer2DData.commandBuffers[pRenderer->imageIndex];
+        // The GPU balls' and GPU culling's compute passes go first (they only
+        // wait on their own barriers, not the acquire), and if we're
+        // capturing, the readback copy is submitted straight after, so they're
+        // all covered by the same fence and semaphores.
+        VkCommandBuffer* commandBuffers = Memory::allocateArray<VkCommandBuffer>(frameArena,
+            computePassCount + 1 + (isCapturing ? 1 : 0), Memory::MemoryTag::FRAME);
+        submitInfo.commandBufferCount = 0;
+
+        if (gpuBallBuffer != VK_NULL_HANDLE) commandBuffers[submitInfo.commandBufferCount++] = gpuBallBuffer;
+        if (cullingBuffer != VK_NULL_HANDLE) commandBuffers[submitInfo.commandBufferCount++] = cullingBuffer;
+        commandBuffers[submitInfo.commandBufferCount++] = pRenderer->renderer2DData.commandBuffers[pRenderer->imageIndex];
+
+        if (isCapturing) {
+            VkCommandBuffer captureBuffer = recordCapture(&pRenderer->captureData, &pRenderer->deviceData,
+                &pRenderer->swapchainData, pRenderer->imageIndex, pRenderer->currentFrame);
+            if (captureBuffer != VK_NULL_HANDLE) commandBuffers[submitInfo.commandBufferCount++] = captureBuffer;
+        }
+
+        submitInfo.pCommandBuffers = commandBuffers;
         // Now we specify which semaphores we need to signal once our command buffers
         // have finished execution.
         VkSemaphore signalSemaphores[] = { pRenderer->renderFinishedSemaphores[pRenderer->currentFrame] };
@@ -365,6 +843,16 @@ namespace Renderer {
             return Status::FAILURE;
         }
 
+        pRenderer->latencyData.current.submitNanos = Clock::nowNanos();
+        pRenderer->textureCache.currentFrame++;
+
+        if (gpuBallBuffer != VK_NULL_HANDLE) gpuBalls->slots[pRenderer->currentFrame].isSubmitted = true;
+        if (cullingBuffer != VK_NULL_HANDLE) gpuCulling->slots[pRenderer->currentFrame].isSubmitted = true;
+
+        if (pRenderer->timestampQueryPool != VK_NULL_HANDLE) {
+            pRenderer->isTimestampWritten[pRenderer->currentFrame] = true;
+        }
+
         // The final step to drawing a frame is resubmitting the the result back
         // to the swapchain. This is done by configuring our swapchain presentation.
 
@@ -384,9 +872,26 @@ namespace Renderer {
         // of every swapchain was successful.
         presentInfo.pResults = nullptr; // optional
 
+#ifdef VK_KHR_present_wait
+        // Tag the present with an id so we can find out when it reaches the screen.
+        VkPresentIdKHR presentId{};
+        if (pRenderer->latencyData.waitForPresent) {
+            pRenderer->latencyData.current.presentId = pRenderer->latencyData.nextPresentId++;
+            presentId.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+            presentId.swapchainCount = 1;
+            presentId.pPresentIds = &pRenderer->latencyData.current.presentId;
+            presentInfo.pNext = &presentId;
+        }
+#endif
+
         // Now we submit a request to present an image to the swapchain.
         result = vkQueuePresentKHR(pRenderer->deviceData.presentQueue, &presentInfo);
 
+        pRenderer->latencyData.current.presentNanos = Clock::nowNanos();
+        // An out of date swapchain never queues the present, so there's nothing to wait for.
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) pRenderer->latencyData.current.presentId = 0;
+        finishFrameLatency(&pRenderer->latencyData);
+
         // Again, we make sure that we're using the best possible swapchain.
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR
             || *resized) {
@@ -403,25 +908,183 @@ namespace Renderer {
         return Status::SUCCESS;
     }
 
-    // Handles a case where the window is minimised - pauses rendering until its opened again.
-    Status onWindowMinimised(GLFWwindow* window, int* width, int* height) {
+    // With GPU culling on, every quad is kept, and the compute pass culls them.
+    static uint32_t cullChunk(Renderer* pRenderer, const QuadColumns* quads, uint32_t first, uint32_t count,
+        uint32_t* visible) {
 
-        glfwGetFramebufferSize(window, width, height);
+        if (isGpuCullingEnabled(&pRenderer->gpuCulling)) {
+            for (uint32_t i = 0; i < count; i++) visible[i] = first + i;
+            return count;
+        }
+
+        return cullQuadsBatch(pRenderer->camera.viewRect, quads, first, count, visible);
+    }
 
-        // If the window is minimized we simply pause rendering until it
-        // comes back!
+    Status drawQuad(Renderer* pRenderer, glm::vec3 pos, glm::vec3 rot, float degrees, glm::vec3 scale, glm::vec3 color) {
+
+        Renderer2D::QuadData* quadData = &pRenderer->renderer2DData.quadData;
 
-        while (*width == 0 && *height == 0) {
-            glfwGetFramebufferSize(window, width, height);
-            glfwWaitEvents();
+        if (!isGpuCullingEnabled(&pRenderer->gpuCulling)
+            && !isQuadVisible(pRenderer->camera.viewRect, pos.x, pos.y, degrees, scale.x, scale.y)) {
+            pRenderer->stats.quadsCulled++;
+            return Status::SUCCESS;
         }
 
+        if (quadData->quadCount >= quadData->maxQuads) {
+            pRenderer->stats.quadsDropped++;
+            return Status::FAILURE;
+        }
+
+        pRenderer->stats.quadsDrawn++;
+
+        // The null backend keeps count too, so it drops the same quads Vulkan would.
+        if (pRenderer->backend == Backend::NONE) {
+            quadData->quadCount++;
+            return Status::SUCCESS;
+        }
+
+        glm::mat4 model = glm::mat4(1.0f);
+
+        model = glm::translate(model, pos);
+        model = glm::rotate(model, degrees, rot);
+        model = glm::scale(model, scale);
+
+        // Only written to the GPU once the frame's drawn, in one go.
+        Renderer2D::QuadInstance* instance = &quadData->instances[quadData->quadCount++];
+        instance->model = model;
+        instance->color = glm::vec4(color, 1.0f);
+        instance->uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+        instance->flags = Renderer2D::QUAD_FLAG_NONE;
+        quadData->isTextureDrawn = true;
+
         return Status::SUCCESS;
     }
 
-    Status drawQuad(Renderer* pRenderer, glm::vec3 pos, glm::vec3 rot, float degrees, glm::vec3 scale, glm::vec3 color) {
+    Status drawQuads(Renderer* pRenderer, const QuadColumns* quads, glm::vec3 color) {
+
+        // Culled a chunk at a time so the visible indices fit on the stack.
+        constexpr uint32_t CHUNK_SIZE = 256;
+        uint32_t visible[CHUNK_SIZE];
+
+        Renderer2D::QuadData* quadData = &pRenderer->renderer2DData.quadData;
+        Status status = Status::SUCCESS;
+        glm::vec4 quadColor = glm::vec4(color, 1.0f);
+
+        for (uint32_t first = 0; first < quads->count; first += CHUNK_SIZE) {
+            uint32_t chunkSize = std::min(CHUNK_SIZE, quads->count - first);
+            uint32_t visibleCount = cullChunk(pRenderer, quads, first, chunkSize, visible);
+
+            pRenderer->stats.quadsCulled += chunkSize - visibleCount;
+
+            size_t available = quadData->maxQuads - quadData->quadCount;
+            if (visibleCount > available) {
+                pRenderer->stats.quadsDropped += visibleCount - available;
+                visibleCount = static_cast<uint32_t>(available);
+                status = Status::FAILURE;
+            }
+
+            pRenderer->stats.quadsDrawn += visibleCount;
+
+            if (pRenderer->backend == Backend::NONE) {
+                quadData->quadCount += visibleCount;
+                continue;
+            }
+
+            for (uint32_t i = 0; i < visibleCount; i++) {
+                uint32_t index = visible[i];
+
+                glm::mat4 model = glm::translate(glm::mat4(1.0f),
+                    glm::vec3(quads->positionX[index], quads->positionY[index], 0.0f));
+                model = glm::rotate(model, glm::radians(quads->rotation[index]), glm::vec3(0.0f, 0.0f, 1.0f));
+                model = glm::scale(model, glm::vec3(quads->scaleX[index], quads->scaleY[index], 1.0f));
 
-        Buffers::DynamicUniformBuffer<Renderer2D::QuadProperties>& dynamicUniformBuffer = pRenderer->renderer2DData.quadData.dynamicData;
+                Renderer2D::QuadInstance* instance = &quadData->instances[quadData->quadCount++];
+                instance->model = model;
+                instance->color = quadColor;
+                instance->uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+                instance->flags = Renderer2D::QUAD_FLAG_NONE;
+            }
+
+            if (visibleCount > 0) quadData->isTextureDrawn = true;
+        }
+
+        return status;
+    }
+
+    Status drawParticles(Renderer* pRenderer, const ParticleQuads* particles) {
+
+        constexpr uint32_t CHUNK_SIZE = 256;
+        uint32_t visible[CHUNK_SIZE];
+
+        // Particles are square and never rotated, so they cull as quads with
+        // the same column for both scales and no rotation column at all.
+        QuadColumns quads;
+        quads.positionX = particles->positionX;
+        quads.positionY = particles->positionY;
+        quads.scaleX = particles->size;
+        quads.scaleY = particles->size;
+        quads.count = particles->count;
+
+        Renderer2D::QuadData* quadData = &pRenderer->renderer2DData.quadData;
+        Status status = Status::SUCCESS;
+
+        for (uint32_t first = 0; first < quads.count; first += CHUNK_SIZE) {
+            uint32_t chunkSize = std::min(CHUNK_SIZE, quads.count - first);
+            uint32_t visibleCount = cullChunk(pRenderer, &quads, first, chunkSize, visible);
+
+            pRenderer->stats.quadsCulled += chunkSize - visibleCount;
+
+            size_t available = quadData->maxQuads - quadData->quadCount;
+            if (visibleCount > available) {
+                pRenderer->stats.quadsDropped += visibleCount - available;
+                visibleCount = static_cast<uint32_t>(available);
+                status = Status::FAILURE;
+            }
+
+            pRenderer->stats.quadsDrawn += visibleCount;
+
+            if (pRenderer->backend == Backend::NONE) {
+                quadData->quadCount += visibleCount;
+                continue;
+            }
+
+            for (uint32_t i = 0; i < visibleCount; i++) {
+                uint32_t index = visible[i];
+                float size = particles->size[index];
+
+                // Scale then translate, written out rather than multiplied together.
+                glm::mat4 model(1.0f);
+                model[0][0] = size;
+                model[1][1] = size;
+                model[3][0] = particles->positionX[index];
+                model[3][1] = particles->positionY[index];
+
+                Renderer2D::QuadInstance* instance = &quadData->instances[quadData->quadCount++];
+                instance->model = model;
+                instance->color = glm::vec4(particles->colorR[index], particles->colorG[index],
+                    particles->colorB[index], particles->alpha[index]);
+                instance->uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+                instance->flags = Renderer2D::QUAD_FLAG_UNTEXTURED;
+            }
+        }
+
+        return status;
+    }
+
+    Status drawStaticQuad(Renderer* pRenderer, glm::vec3 pos, glm::vec3 rot, float degrees, glm::vec3 scale,
+        glm::vec3 color) {
+
+        Renderer2D::StaticLayer* layer = &pRenderer->renderer2DData.staticLayer;
+
+        if (layer->quadCount >= layer->maxQuads) {
+            pRenderer->stats.quadsDropped++;
+            return Status::FAILURE;
+        }
+
+        if (pRenderer->backend == Backend::NONE) {
+            layer->quadCount++;
+            return Status::SUCCESS;
+        }
 
         glm::mat4 model = glm::mat4(1.0f);
 
@@ -429,64 +1092,116 @@ namespace Renderer {
         model = glm::rotate(model, degrees, rot);
         model = glm::scale(model, scale);
 
-        // Set the view
-        glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+        Renderer2D::QuadInstance* instance = &layer->instances[layer->quadCount++];
+        instance->model = model;
+        instance->color = glm::vec4(color, 1.0f);
+        instance->uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+        instance->flags = Renderer2D::QUAD_FLAG_UNTEXTURED;
 
-        // TODO: Need to find a way to pass the original size to the ortho camera to keep it stretching
-        glm::mat4 proj = glm::ortho(-400.0f, 400.f, 300.0f, -300.0f, -1.0f, 1.0f);
+        layer->isDirty = true;
 
-        // Rotate the model matrix
-        model = proj * view * model;
+        return Status::SUCCESS;
+    }
 
-        auto* properties = (Renderer2D::QuadProperties*)(((uint64_t)dynamicUniformBuffer.data
-                + (pRenderer->renderer2DData.quadData.quadCount * dynamicUniformBuffer.dynamicAlignment)));
+    void clearStaticLayer(Renderer* pRenderer) {
+        Renderer2D::StaticLayer* layer = &pRenderer->renderer2DData.staticLayer;
 
-        properties->mvp = model;
-        properties->color = color;
+        if (layer->quadCount == 0) return;
 
-        VkDeviceMemory memory = pRenderer->renderer2DData.quadData.dynamicData.buffer.bufferMemory;
+        layer->quadCount = 0;
+        layer->isDirty = pRenderer->backend != Backend::NONE;
+    }
 
-        // Now we bind our data to the UBO for later use
-        void* data;
-        vkMapMemory(pRenderer->deviceData.logicalDevice, memory,0, VK_WHOLE_SIZE, 0, &data);
-        memcpy(data, pRenderer->renderer2DData.quadData.dynamicData.data, pRenderer->renderer2DData.quadData.dynamicData.bufferSize);
+    Status drawText(Renderer* pRenderer, const char* text, glm::vec2 position, float height, glm::vec3 color) {
 
-        VkMappedMemoryRange mappedMemoryRange {};
-        mappedMemoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedMemoryRange.memory = pRenderer->renderer2DData.quadData.dynamicData.buffer.bufferMemory;
-        mappedMemoryRange.size = pRenderer->renderer2DData.quadData.dynamicData.bufferSize;
-        vkFlushMappedMemoryRanges(pRenderer->deviceData.logicalDevice, 1, &mappedMemoryRange);
+        if (pRenderer->backend == Backend::NONE || !pRenderer->textData.isLoaded) return Status::SUCCESS;
 
-        vkUnmapMemory(pRenderer->deviceData.logicalDevice, memory);
+        const TextRun* run = getTextRun(&pRenderer->textData, text);
+        Renderer2D::QuadData* quadData = &pRenderer->renderer2DData.quadData;
 
-        pRenderer->renderer2DData.quadData.quadCount++;
+        Status status = Status::SUCCESS;
+        uint32_t quadCount = run->quadCount;
+        size_t available = quadData->maxQuads - quadData->quadCount;
 
-        return Status::SUCCESS;
+        if (quadCount > available) {
+            pRenderer->stats.quadsDropped += quadCount - available;
+            quadCount = static_cast<uint32_t>(available);
+            status = Status::FAILURE;
+        }
+
+        pRenderer->stats.quadsDrawn += quadCount;
+
+        // The layout is in atlas pixels with y pointing down - quads are placed
+        // with y pointing up.
+        float scale = height / TEXT_GLYPH_HEIGHT;
+        glm::vec4 textColor = glm::vec4(color, 1.0f);
+
+        for (uint32_t i = 0; i < quadCount; i++) {
+            const GlyphQuad& glyph = run->quads[i];
+
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(position.x + glyph.center.x * scale,
+                position.y - glyph.center.y * scale, 0.0f));
+            model = glm::scale(model, glm::vec3(glyph.size * scale, 1.0f));
+
+            Renderer2D::QuadInstance* instance = &quadData->instances[quadData->quadCount++];
+            instance->model = model;
+            instance->color = textColor;
+            instance->uvRect = glyph.uvRect;
+            instance->flags = Renderer2D::QUAD_FLAG_SDF;
+        }
+
+        return status;
     }
 
     VkResult recreateSwapchain(Renderer* pRenderer) {
 
+        if (pRenderer->backend == Backend::NONE) return VK_SUCCESS;
+
         vkDeviceWaitIdle(pRenderer->deviceData.logicalDevice);
 
+        abandonPendingPresents(&pRenderer->latencyData);
+
         cleanupSwapchain(
-            pRenderer->deviceData.logicalDevice, &pRenderer->swapchainData,
+            &pRenderer->deviceData, &pRenderer->swapchainData,
             &pRenderer->renderer2DData.graphicsPipeline,
             pRenderer->renderer2DData.commandPool, pRenderer->renderer2DData.frameBuffers,
-            pRenderer->renderer2DData.commandBuffers, &pRenderer->renderer2DData.quadData.dynamicData.buffer,
+            pRenderer->renderer2DData.commandBuffers, pRenderer->renderer2DData.quadCommandBuffers,
             pRenderer->renderer2DData.descriptorPool
         );
 
+        // Everything sized by the old swapchain has now been destroyed.
+        Memory::resetArena(&pRenderer->swapchainArena);
+
         // Re-populate the swapchain
-        if (createSwapchain(&pRenderer->swapchainData, &pRenderer->deviceData) != VK_SUCCESS) {
+        if (createSwapchain(&pRenderer->swapchainData, &pRenderer->deviceData, &pRenderer->swapchainArena)
+            != VK_SUCCESS) {
 
             return VK_ERROR_INITIALIZATION_FAILED;
         }
 
-        if (!Renderer2D::recreateRenderer2D(&pRenderer->deviceData, &pRenderer->renderer2DData, pRenderer->swapchainData)) {
+        // The new swapchain may have a different number of images.
+        pRenderer->imagesInFlight = Memory::allocateArray<VkFence>(&pRenderer->swapchainArena,
+            pRenderer->swapchainData.imageCount, Memory::MemoryTag::SYNC);
+        for (size_t i = 0; i < pRenderer->swapchainData.imageCount; i++) {
+            pRenderer->imagesInFlight[i] = VK_NULL_HANDLE;
+        }
+
+        // Draws at the new size rather than stretching what was there.
+        updateCamera(&pRenderer->camera, getSwapchainExtent(&pRenderer->swapchainData));
+
+        if (!Renderer2D::recreateRenderer2D(&pRenderer->deviceData, &pRenderer->renderer2DData, pRenderer->swapchainData,
+            &pRenderer->swapchainArena)) {
             PONG_ERROR("Failed to re-create swap chain on resize!");
             return VK_ERROR_INITIALIZATION_FAILED;
         }
 
+        if (isCaptureEnabled(&pRenderer->captureData)
+            && recreateCapture(&pRenderer->captureData, &pRenderer->deviceData, &pRenderer->swapchainData)
+            != Status::SUCCESS) {
+            PONG_ERROR("Failed to re-create capture buffers on resize!");
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+
         if (createCommandBuffers(
                 pRenderer->deviceData.logicalDevice,
                 pRenderer->renderer2DData.commandBuffers,
@@ -498,7 +1213,8 @@ namespace Renderer {
                 &pRenderer->renderer2DData.quadData.indexBuffer,
                 pRenderer->renderer2DData.quadData.dynamicDescriptorSets,
                 pRenderer->renderer2DData.quadData.quadCount,
-                pRenderer->renderer2DData.quadData.dynamicData.dynamicAlignment)
+                0,
+                pRenderer->camera.viewProjection)
             != VK_SUCCESS) {
 
             PONG_ERROR("Failed to create command buffers!");
@@ -508,20 +1224,27 @@ namespace Renderer {
         return VK_SUCCESS;
     }
 
+    void setCamera(Renderer* pRenderer, glm::vec2 position, float zoom) {
+        pRenderer->camera.position = position;
+        pRenderer->camera.zoom = zoom;
+        updateCamera(&pRenderer->camera, pRenderer->camera.extent);
+    }
+
     void flushRenderer(Renderer* pRenderer) {
+        pRenderer->stats.flushes++;
         pRenderer->renderer2DData.quadData.quadCount = 0;
+        pRenderer->renderer2DData.quadData.isTextureDrawn = false;
     }
 
     Status createImage(
-        VulkanDeviceData* deviceData, 
-        uint32_t width, 
-        uint32_t height, 
-        VkFormat format, 
+        VulkanDeviceData* deviceData,
+        uint32_t width,
+        uint32_t height,
+        VkFormat format,
         VkImageTiling tiling,
-        VkImageUsageFlags usageFlags, 
-        VkMemoryPropertyFlags properties, 
-        VkImage& image, 
-        VkDeviceMemory& imageMemory) {
+        VkImageUsageFlags usageFlags,
+        VkMemoryPropertyFlags properties,
+        Texture2D& texture) {
 
         VkImageCreateInfo imageInfo{};
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -538,24 +1261,38 @@ namespace Renderer {
         imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
         imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 
-        if (vkCreateImage(deviceData->logicalDevice, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+        if (vkCreateImage(deviceData->logicalDevice, &imageInfo, nullptr, &texture.image) != VK_SUCCESS) {
             PONG_ERROR("failed to create image!");
             return Status::INITIALIZATION_FAILURE;
         }
 
         VkMemoryRequirements memRequirements;
-        vkGetImageMemoryRequirements(deviceData->logicalDevice, image, &memRequirements);
-
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        Buffers::findMemoryType(deviceData->physicalDevice, &allocInfo.memoryTypeIndex, memRequirements.memoryTypeBits, properties);
+        vkGetImageMemoryRequirements(deviceData->logicalDevice, texture.image, &memRequirements);
+
+        uint32_t memoryType;
+        if (!Buffers::findMemoryType(deviceData->physicalDevice, &memoryType, memRequirements.memoryTypeBits,
+            properties)) {
+            PONG_ERROR("No suitable memory type for image!");
+            vkDestroyImage(deviceData->logicalDevice, texture.image, nullptr);
+            texture.image = VK_NULL_HANDLE;
+            return Status::INITIALIZATION_FAILURE;
+        }
 
-        if (vkAllocateMemory(deviceData->logicalDevice, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate image memory!");
+        // Goes through the tracker, which will evict other textures to make room
+        // if this takes the heap over budget.
+        if (allocateGpuMemory(&deviceData->gpuMemory, deviceData->logicalDevice, memRequirements.size, memoryType,
+            &texture.memory) != VK_SUCCESS) {
+            PONG_ERROR("failed to allocate image memory!");
+            vkDestroyImage(deviceData->logicalDevice, texture.image, nullptr);
+            texture.image = VK_NULL_HANDLE;
+            return Status::INITIALIZATION_FAILURE;
         }
 
-        vkBindImageMemory(deviceData->logicalDevice, image, imageMemory, 0);
+        texture.memorySize = memRequirements.size;
+        texture.memoryType = memoryType;
+        texture.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        vkBindImageMemory(deviceData->logicalDevice, texture.image, texture.memory, 0);
 
         return Status::SUCCESS;
     }
@@ -566,18 +1303,17 @@ namespace Renderer {
 
         stbi_uc* pixels = stbi_load(imagePath, &width, &height, &channels, STBI_rgb_alpha);
 
-        VkDeviceSize imageSize = width * height * 4;
-
         if (!pixels) {
-            PONG_ERROR("Failed to load in texture!");
+            PONG_ERROR("Failed to load in texture '{0}'!", imagePath);
             return Status::INITIALIZATION_FAILURE;
         }
 
+        VkDeviceSize imageSize = static_cast<VkDeviceSize>(width) * height * 4;
+
         Buffers::BufferData bufferData;
 
         if (Buffers::createBuffer(
-            renderer->deviceData.physicalDevice,
-            renderer->deviceData.logicalDevice,
+            &renderer->deviceData,
             imageSize,
             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
@@ -585,6 +1321,7 @@ namespace Renderer {
             bufferData) != VK_SUCCESS) {
 
             PONG_ERROR("Failed to create buffer for texture");
+            stbi_image_free(pixels);
             return Status::INITIALIZATION_FAILURE;
         }
 
@@ -595,7 +1332,7 @@ namespace Renderer {
 
         stbi_image_free(pixels);
 
-        createImage(
+        if (createImage(
             &renderer->deviceData,
             width, 
             height, 
@@ -603,32 +1340,146 @@ namespace Renderer {
             VK_IMAGE_TILING_OPTIMAL, 
             VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
-            texture.image,
-            texture.memory
-        );
+            texture) != Status::SUCCESS) {
 
-        if (transitionImageLayout(renderer->deviceData.logicalDevice, renderer->deviceData.graphicsQueue,
-            renderer->renderer2DData.commandPool, texture.image, VK_FORMAT_R8G8B8A8_SRGB,
-            texture.layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) != Status::SUCCESS) {
+            Buffers::destroyBuffer(&renderer->deviceData, bufferData);
             return Status::INITIALIZATION_FAILURE;
         }
-        texture.layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        copyBufferToImage(renderer->deviceData.logicalDevice, renderer->renderer2DData.commandPool,
-            renderer->deviceData.graphicsQueue, bufferData.buffer, texture.image,
-            static_cast<uint32_t>(width), static_cast<uint32_t>(height));
-        if (transitionImageLayout(renderer->deviceData.logicalDevice, renderer->deviceData.graphicsQueue,
+
+        Status status = transitionImageLayout(renderer->deviceData.logicalDevice, renderer->deviceData.graphicsQueue,
             renderer->renderer2DData.commandPool, texture.image, VK_FORMAT_R8G8B8A8_SRGB,
-            texture.layout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) != Status::SUCCESS) {
+            texture.layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+        if (status == Status::SUCCESS) {
+            texture.layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            copyBufferToImage(renderer->deviceData.logicalDevice, renderer->renderer2DData.commandPool,
+                renderer->deviceData.graphicsQueue, bufferData.buffer, texture.image,
+                static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+            status = transitionImageLayout(renderer->deviceData.logicalDevice, renderer->deviceData.graphicsQueue,
+                renderer->renderer2DData.commandPool, texture.image, VK_FORMAT_R8G8B8A8_SRGB,
+                texture.layout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        }
+
+        Buffers::destroyBuffer(&renderer->deviceData, bufferData);
+
+        if (status == Status::SUCCESS) {
+            status = createImageView(renderer->deviceData.logicalDevice, texture.image, VK_FORMAT_R8G8B8A8_SRGB,
+                texture.view);
+        }
+
+        if (status != Status::SUCCESS) {
+            PONG_ERROR("Failed to upload texture '{0}'!", imagePath);
+            destroyTextureImage(&renderer->deviceData, texture);
             return Status::INITIALIZATION_FAILURE;
         }
 
-        vkDestroyBuffer(renderer->deviceData.logicalDevice, bufferData.buffer, nullptr);
-        vkFreeMemory(renderer->deviceData.logicalDevice, bufferData.bufferMemory, nullptr);
+        PONG_INFO("Loaded image '{0}'", imagePath);
+
+        return Status::SUCCESS;
+    }
+
+    static Status loadCachedTexture(Renderer* renderer, CachedTexture* cached) {
+
+        if (loadImage(renderer, cached->path.c_str(), cached->texture) != Status::SUCCESS) {
+            return Status::INITIALIZATION_FAILURE;
+        }
 
-        createImageView(renderer->deviceData.logicalDevice, texture.image, VK_FORMAT_R8G8B8A8_SRGB, texture.view);
+        // The sampler doesn't use any device memory, so it's kept through evictions.
+        if (cached->texture.sampler == VK_NULL_HANDLE) {
+            cached->texture.sampler = initialiseSampler(
+                renderer->deviceData.logicalDevice,
+                VK_FILTER_LINEAR, VK_FILTER_LINEAR,
+                VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+                VK_COMPARE_OP_ALWAYS,
+                VK_SAMPLER_MIPMAP_MODE_LINEAR
+            );
+        }
 
-        PONG_INFO("SUCCESSFULLY LOADED IMAGE!");
+        cached->isResident = true;
+        cached->lastUsedFrame = renderer->textureCache.currentFrame;
 
         return Status::SUCCESS;
     }
-}
\ No newline at end of file
+
+    TextureHandle loadTexture(Renderer* renderer, const char* imagePath) {
+
+        TextureCache* cache = &renderer->textureCache;
+
+        for (TextureHandle i = 0; i < cache->textureCount; i++) {
+            if (cache->textures[i].path == imagePath) return i;
+        }
+
+        if (cache->textureCount == MAX_CACHED_TEXTURES) {
+            PONG_ERROR("Texture cache is full - can't load '{0}'", imagePath);
+            return INVALID_TEXTURE;
+        }
+
+        CachedTexture* cached = &cache->textures[cache->textureCount];
+        cached->path = imagePath;
+
+        if (loadCachedTexture(renderer, cached) != Status::SUCCESS) {
+            *cached = CachedTexture{};
+            return INVALID_TEXTURE;
+        }
+
+        return cache->textureCount++;
+    }
+
+    Texture2D* useTexture(Renderer* renderer, TextureHandle handle) {
+
+        TextureCache* cache = &renderer->textureCache;
+        if (handle >= cache->textureCount) return nullptr;
+
+        CachedTexture* cached = &cache->textures[handle];
+
+        if (!cached->isResident) {
+            if (loadCachedTexture(renderer, cached) != Status::SUCCESS) return nullptr;
+            cache->reloadCount++;
+            PONG_INFO("Re-loaded evicted texture '{0}'", cached->path);
+        }
+
+        cached->lastUsedFrame = cache->currentFrame;
+
+        return &cached->texture;
+    }
+
+#ifdef DEBUG
+    bool verifyTextureEviction(Renderer* renderer) {
+
+        if (renderer->backend == Backend::NONE) return true;
+
+        TextureCache* cache = &renderer->textureCache;
+        GpuMemoryData* gpuMemory = &renderer->deviceData.gpuMemory;
+        Renderer2D::QuadData* quadData = &renderer->renderer2DData.quadData;
+        const CachedTexture* cached = &cache->textures[quadData->textureHandle];
+        VkDevice device = renderer->deviceData.logicalDevice;
+
+        uint64_t evictions = cache->evictionCount;
+        uint64_t reloads = cache->reloadCount;
+        VkDeviceSize budget = gpuMemory->budget;
+        uint32_t memoryType = cached->texture.memoryType;
+
+        // As if the texture had gone unused for longer than any frame can be
+        // in flight, and its heap had filled up - the next allocation on it
+        // has to make room first.
+        cache->currentFrame += cache->framesInFlight + 1;
+        gpuMemory->budget = 1;
+
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkResult result = allocateGpuMemory(gpuMemory, device, 256, memoryType, &memory);
+        if (result == VK_SUCCESS) freeGpuMemory(gpuMemory, device, memory, 256, memoryType);
+
+        gpuMemory->budget = budget;
+
+        bool isEvicted = cache->evictionCount > evictions && !cached->isResident
+            && quadData->textures[Renderer2D::QUAD_TEXTURE_SLOT].view
+                == quadData->textures[Renderer2D::TEXT_ATLAS_SLOT].view;
+
+        bool isRebound = useQuadTexture(renderer) == Status::SUCCESS && cache->reloadCount > reloads
+            && quadData->textures[Renderer2D::QUAD_TEXTURE_SLOT].view == cached->texture.view;
+
+        return result == VK_SUCCESS && isEvicted && isRebound;
+    }
+#endif
+}
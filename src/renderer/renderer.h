@@ -8,14 +8,63 @@
 #include "core.h"
 #include "vk/initialisers.h"
 #include "vk/texture2d.h"
+#include "capture.h"
+#include "latency.h"
+#include "../memory/arena.h"
+#include "textureCache.h"
+#include "text.h"
+#include "culling.h"
+#include "camera.h"
+#include "gpuBalls.h"
+#include "gpuCulling.h"
 
 namespace Renderer {
 
     enum class WindowType {
+        NONE = 0,
         GLFW
     };
 
+    // The NONE backend accepts all draw calls and counts them, but never touches
+    // Vulkan. Useful for measuring the cost of the simulation on its own.
+    enum class Backend {
+        VULKAN,
+        NONE
+    };
+
+    // Particles to draw, one column per attribute - flat colored squares,
+    // 'size' across and never rotated, which fade out with their alpha.
+    struct ParticleQuads {
+        const float* positionX      {nullptr};
+        const float* positionY      {nullptr};
+        const float* size           {nullptr};
+        const float* colorR         {nullptr};
+        const float* colorG         {nullptr};
+        const float* colorB         {nullptr};
+        const float* alpha          {nullptr};
+        uint32_t count              {0};
+    };
+
+    struct RendererStats {
+        uint64_t quadsDrawn         {0};
+        // Quads rejected because the frame's quad buffer was already full.
+        uint64_t quadsDropped       {0};
+        // Quads skipped because they were entirely outside the view. With GPU
+        // culling, a frame's culled quads are only known once its frame slot
+        // comes round again - until then (or until collectFrameStats) they're
+        // counted as drawn.
+        uint64_t quadsCulled        {0};
+        uint64_t framesDrawn        {0};
+        uint64_t flushes            {0};
+        // GPU time of the most recently completed frame, -1 if unavailable.
+        int64_t lastGpuTimeMicros   {-1};
+        // Time drawFrame spent blocked on the in-flight fence this frame.
+        uint64_t lastFenceWaitMicros{0};
+    };
+
     struct Renderer {
+        Backend backend                             {Backend::VULKAN};
+        RendererStats stats;
         // Vulkan Device Data
         VulkanDeviceData deviceData                 {nullptr};
         // Swapchain
@@ -30,15 +79,67 @@ namespace Renderer {
         VkFence* imagesInFlight                     {nullptr};
         uint32_t currentFrame                       {0};
         uint32_t imageIndex                         {0};
+        // GPU timing - two timestamps per frame in flight
+        VkQueryPool timestampQueryPool              {VK_NULL_HANDLE};
+        float timestampPeriod                       {0.0f};
+        uint64_t timestampMask                      {0};
+        bool* isTimestampWritten                    {nullptr};
+        // Frame capture
+        CaptureData captureData;
+        // Input-to-photon latency
+        LatencyData latencyData;
+        // Memory - the lifetime arena holds everything that lives as long as the
+        // renderer, the swapchain arena everything sized by the swapchain (reset on
+        // recreation), and there's one frame arena per frame in flight, reset once
+        // that frame's fence has been waited on.
+        Memory::Arena lifetimeArena;
+        Memory::Arena swapchainArena;
+        Memory::Arena* frameArenas                  {nullptr};
+        // Textures loaded from disk, evicted when device memory is over budget.
+        TextureCache textureCache;
+        // Font, glyph atlas and cached text layouts.
+        TextData textData;
+        // Quads entirely outside what the camera can see aren't drawn.
+        Camera camera;
+        // Balls simulated and drawn without ever coming back to the CPU.
+        GpuBallData gpuBalls;
+        // Quads culled by a compute pass rather than as they're drawn.
+        GpuCullData gpuCulling;
     };
 
     // Device creation functions
-    Status initialiseRenderer(Renderer*, bool, void*, WindowType type);
+    Status initialiseRenderer(Renderer*, bool, void*, WindowType type, Backend = Backend::VULKAN);
     Status createSyncObjects(Renderer*, uint32_t = 2);
+    Status createTimestampQueries(Renderer*);
     Status drawFrame(Renderer*, bool*);
 
-    // Code to handle window minimisation
-    Status onWindowMinimised(GLFWwindow*, int*, int*);
+    // Frame capture - must be called after the renderer has been initialised.
+    Status enableCapture(Renderer*, CaptureFormat, const char*);
+
+    // Balls simulated on the GPU (see gpuBalls.h) - must be called after the
+    // renderer has been initialised. They move once per frame drawn, and
+    // bounce off whatever colliders were set last, as (minX, minY, maxX, maxY).
+    Status enableGpuBalls(Renderer*, uint32_t, glm::vec2, uint32_t = 1);
+    void setGpuBallColliders(Renderer*, const glm::vec4*, uint32_t);
+
+    // Culling on the GPU (see gpuCulling.h) - must be called after the
+    // renderer has been initialised. Quads are no longer culled as they're
+    // drawn, so every one takes up space in the instance buffer.
+    Status enableGpuCulling(Renderer*);
+    // Waits for every frame in flight and counts what the GPU culled in them,
+    // so the stats cover every frame drawn so far.
+    void collectFrameStats(Renderer*);
+
+    // Latency tracking - tags the next frame drawn with the time of the input it
+    // responds to (0 for none). Frames come back out of popFrameLatency in the order
+    // they were presented, once the time they reached the screen is known.
+    void setFrameInputTime(Renderer*, uint64_t);
+    bool popFrameLatency(Renderer*, FrameLatency*);
+
+    // Scratch memory for the frame currently being recorded - anything allocated
+    // from it is valid until the same frame slot comes around again. Null until
+    // the sync objects have been created.
+    Memory::Arena* getFrameArena(Renderer*);
 
     // Cleanup code
     Status cleanupRenderer(Renderer*,  bool);
@@ -47,20 +148,59 @@ namespace Renderer {
     // Default data
     void loadDefaultValidationLayers(Renderer*);
     void loadDefaultDeviceExtensions(Renderer*);
+    // Number of quads that can be drawn in a single frame.
+    void setMaxQuads(Renderer*, size_t);
+    // Cap on device-local memory use, in bytes. 0 (the default) leaves it to the
+    // driver's budget.
+    void setGpuMemoryBudget(Renderer*, VkDeviceSize);
     // Custom data
     [[maybe_unused]] Status loadCustomValidationLayers(Renderer*, const char**, uint32_t);
     [[maybe_unused]] Status loadCustomDeviceExtensions(Renderer*, const char**, uint32_t);
 
     // Drawing
+    // Quads entirely outside the view are culled (and counted in the stats)
+    // before anything is written for them.
     Status drawQuad(Renderer*, glm::vec3, glm::vec3, float, glm::vec3, glm::vec3);
+    // Culls and draws a whole set of quads in one go, all in the same color.
+    Status drawQuads(Renderer*, const QuadColumns*, glm::vec3);
+    // Culls and draws a whole set of particles in one go. With no rotation to
+    // apply, their instances are written straight from the columns.
+    Status drawParticles(Renderer*, const ParticleQuads*);
+    // Draws the text with its top left corner at the given position, one quad
+    // per glyph. The height runs from the font's ascent to its descent, in the
+    // same units as quad positions.
+    Status drawText(Renderer*, const char*, glm::vec2, float, glm::vec3);
+    // The static layer - quads added to it are drawn every frame, underneath
+    // everything else, until it's cleared. Changing it re-uploads the whole
+    // layer and waits for the GPU to go idle, so it's for things that are set
+    // up once and left alone. Static quads are flat colored, not textured,
+    // and never culled.
+    Status drawStaticQuad(Renderer*, glm::vec3, glm::vec3, float, glm::vec3, glm::vec3);
+    void clearStaticLayer(Renderer*);
+
+    // Centres the view on the given world position. At a zoom of 1 one world
+    // unit is one pixel.
+    void setCamera(Renderer*, glm::vec2, float);
 
     VkResult recreateSwapchain(Renderer* pRenderer);
     void flushRenderer(Renderer* pRenderer);
 
+    // Textures - loading the same path twice gives back the same handle.
+    TextureHandle loadTexture(Renderer*, const char*);
+    // Marks the texture as used by the frame being drawn, re-loading it first if
+    // it was evicted. Null if it couldn't be loaded.
+    Texture2D* useTexture(Renderer*, TextureHandle);
+
+#ifdef DEBUG
+    // Takes device memory over budget to check the quad texture is evicted,
+    // then re-loaded and re-bound when it's next used. Only built in DEBUG.
+    bool verifyTextureEviction(Renderer*);
+#endif
+
     Status loadImage(Renderer*, char const*, Texture2D&);
     Status createImage(VulkanDeviceData*, uint32_t,
         uint32_t, VkFormat, VkImageTiling, VkImageUsageFlags,
-        VkMemoryPropertyFlags, VkImage&, VkDeviceMemory&);
+        VkMemoryPropertyFlags, Texture2D&);
 }
 
 #endif //PONG_VK_RENDERER_H
@@ -1,6 +1,7 @@
 #include "renderer2D.h"
 #include "vk/initialisers.h"
 #include "vk/texture2d.h"
+#include <cstring>
 
 
 namespace Renderer2D {
@@ -17,8 +18,166 @@ namespace Renderer2D {
         0, 1, 2, 2, 3, 0
     };
 
+    static bool createInstanceBuffer(Renderer::VulkanDeviceData* deviceData, QuadData* quadData) {
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(deviceData->physicalDevice, &properties);
+
+        // Each frame's slice has to start on an offset the device can bind.
+        VkDeviceSize alignment = properties.limits.minStorageBufferOffsetAlignment;
+        VkDeviceSize sliceSize = quadData->maxQuads * sizeof(QuadInstance);
+        if (alignment > 0) sliceSize = (sliceSize + alignment - 1) & ~(alignment - 1);
+
+        if (Buffers::createBuffer(
+                deviceData,
+                sliceSize * quadData->framesInFlight,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                quadData->instanceBuffer) != VK_SUCCESS) {
+
+            return false;
+        }
+
+        // Coherent, so it can stay mapped for as long as the buffer lives.
+        if (vkMapMemory(deviceData->logicalDevice, quadData->instanceBuffer.bufferMemory, 0, VK_WHOLE_SIZE, 0,
+            &quadData->mappedInstances) != VK_SUCCESS) {
+
+            Buffers::destroyBuffer(deviceData, quadData->instanceBuffer);
+            return false;
+        }
+
+        quadData->instanceSliceSize = sliceSize;
+        quadData->instances = static_cast<QuadInstance*>(Buffers::alignedAlloc(
+            quadData->maxQuads * sizeof(QuadInstance), alignof(QuadInstance)));
+
+        PONG_INFO("Instance buffer: {0} quads per frame, {1} bytes per slice", quadData->maxQuads, sliceSize);
+
+        return quadData->instances != nullptr;
+    }
+
+    static bool createStaticLayer(Renderer::VulkanDeviceData* deviceData, Renderer2DData* renderer2D) {
+
+        StaticLayer* layer = &renderer2D->staticLayer;
+
+        // Only ever written by a copy, so it can live where the GPU reads it fastest.
+        if (Buffers::createBuffer(
+                deviceData,
+                layer->maxQuads * sizeof(QuadInstance),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                layer->instanceBuffer) != VK_SUCCESS) {
+
+            return false;
+        }
+
+        uint32_t framesInFlight = renderer2D->quadData.framesInFlight;
+
+        layer->instances = static_cast<QuadInstance*>(Buffers::alignedAlloc(
+            layer->maxQuads * sizeof(QuadInstance), alignof(QuadInstance)));
+        layer->recordings = static_cast<StaticLayerRecording*>(Buffers::alignedAlloc(
+            framesInFlight * sizeof(StaticLayerRecording), alignof(StaticLayerRecording)));
+
+        if (!layer->instances || !layer->recordings) return false;
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = renderer2D->commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+
+        for (uint32_t i = 0; i < framesInFlight; i++) {
+            layer->recordings[i] = StaticLayerRecording{};
+            if (vkAllocateCommandBuffers(deviceData->logicalDevice, &allocInfo, &layer->recordings[i].commandBuffer)
+                != VK_SUCCESS) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Everything allocated out of the descriptor pool, along with the secondary
+    // command buffers the frame's quads are recorded into.
+    static bool createSwapchainResources(Renderer::VulkanDeviceData* deviceData, Renderer2DData* renderer2D,
+        Renderer::SwapchainData swapchain, Memory::Arena* swapchainArena) {
+
+        // One set per image for the frame's quads, plus one for the static layer.
+        VkDescriptorPoolSize poolSizes[] = {
+                Renderer::initialisePoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, swapchain.imageCount + 1),
+                Renderer::initialisePoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                    (swapchain.imageCount + 1) * QUAD_TEXTURE_SLOT_COUNT)
+        };
+
+        if (Renderer::createDescriptorPool(
+                deviceData->logicalDevice,
+                swapchain.imageCount + 1, &renderer2D->descriptorPool, poolSizes,
+                2) != VK_SUCCESS) {
+
+            PONG_ERROR("Failed to create descriptor pool.");
+            return false;
+        }
+
+        renderer2D->quadData.dynamicDescriptorSets = Memory::allocateArray<VkDescriptorSet>(swapchainArena,
+            swapchain.imageCount, Memory::MemoryTag::RENDERER2D);
+
+        if (Renderer::createDescriptorSets(
+                deviceData,
+                renderer2D->quadData.dynamicDescriptorSets,
+                &renderer2D->quadData.descriptorSetLayout,
+                &renderer2D->descriptorPool,
+                swapchain.imageCount,
+                &renderer2D->quadData.instanceBuffer,
+                renderer2D->quadData.instanceSliceSize,
+                renderer2D->quadData.textures,
+                QUAD_TEXTURE_SLOT_COUNT,
+                swapchainArena) != VK_SUCCESS) {
+
+            PONG_ERROR("Failed to create descriptor sets!");
+            return false;
+        }
+
+        // The static layer's instances all start at the front of its buffer,
+        // so it's always bound with an offset of zero.
+        if (Renderer::createDescriptorSets(
+                deviceData,
+                &renderer2D->staticLayer.descriptorSet,
+                &renderer2D->quadData.descriptorSetLayout,
+                &renderer2D->descriptorPool,
+                1,
+                &renderer2D->staticLayer.instanceBuffer,
+                renderer2D->staticLayer.maxQuads * sizeof(QuadInstance),
+                renderer2D->quadData.textures,
+                QUAD_TEXTURE_SLOT_COUNT,
+                swapchainArena) != VK_SUCCESS) {
+
+            PONG_ERROR("Failed to create static layer descriptor set!");
+            return false;
+        }
+
+        renderer2D->quadCommandBuffers = Memory::allocateArray<VkCommandBuffer>(swapchainArena,
+            swapchain.imageCount, Memory::MemoryTag::RENDERER2D);
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = renderer2D->commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = swapchain.imageCount;
+
+        if (vkAllocateCommandBuffers(deviceData->logicalDevice, &allocInfo, renderer2D->quadCommandBuffers)
+            != VK_SUCCESS) {
+
+            PONG_ERROR("Failed to allocate secondary command buffers!");
+            return false;
+        }
+
+        renderer2D->renderPassVersion++;
+
+        return true;
+    }
+
     bool initialiseRenderer2D(Renderer::VulkanDeviceData* deviceData,
-        Renderer2DData* renderer2D, Renderer::SwapchainData swapchain) {
+        Renderer2DData* renderer2D, Renderer::SwapchainData swapchain, Memory::Arena* swapchainArena) {
 
         // ================================== RENDER PASS ====================================
 
@@ -30,16 +189,10 @@ namespace Renderer2D {
 
         // ============================== DESCRIPTOR SET LAYOUT ==============================
 
-        VkDescriptorSetLayoutBinding samplerLayoutBinding{};
-        samplerLayoutBinding.binding = 1;
-        samplerLayoutBinding.descriptorCount = 1;
-        samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        samplerLayoutBinding.pImmutableSamplers = nullptr;
-        samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
         VkDescriptorSetLayoutBinding layoutBindings[] {
-            Renderer::initiialiseDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_VERTEX_BIT),
-            Renderer::initiialiseDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT)
+            Renderer::initiialiseDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_VERTEX_BIT),
+            Renderer::initiialiseDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                QUAD_TEXTURE_SLOT_COUNT, VK_SHADER_STAGE_FRAGMENT_BIT)
         };
 
         if (Renderer::createDescriptorSetLayout(deviceData->logicalDevice,
@@ -57,7 +210,7 @@ namespace Renderer2D {
         // a complete rewrite if you need anything different).
 
         if (Renderer::createGraphicsPipeline(deviceData->logicalDevice, &renderer2D->graphicsPipeline,
-            &swapchain, &renderer2D->quadData.descriptorSetLayout) != VK_SUCCESS) {
+            &swapchain, &renderer2D->quadData.descriptorSetLayout, swapchainArena) != VK_SUCCESS) {
             PONG_ERROR("Failed to create graphics pipeline!");
             return false;
         }
@@ -73,7 +226,8 @@ namespace Renderer2D {
         // represent these attachments. In our case, we only have one to reference,
         // namely the color attachment.
 
-        renderer2D->frameBuffers = static_cast<VkFramebuffer*>(malloc(swapchain.imageCount * sizeof(VkFramebuffer)));
+        renderer2D->frameBuffers = Memory::allocateArray<VkFramebuffer>(swapchainArena, swapchain.imageCount,
+            Memory::MemoryTag::RENDERER2D);
 
         if (Renderer::createFramebuffer(deviceData->logicalDevice, renderer2D->frameBuffers,
             &swapchain, &renderer2D->graphicsPipeline) != VK_SUCCESS) {
@@ -103,65 +257,22 @@ namespace Renderer2D {
             return false;
         }
 
-        VkDescriptorPoolSize poolSizes[] = {
-                Renderer::initialisePoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, swapchain.imageCount),
-                Renderer::initialisePoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, swapchain.imageCount)
-        };
-
-        if (Renderer::createDescriptorPool(
-                deviceData->logicalDevice,
-                swapchain.imageCount, &renderer2D->descriptorPool, poolSizes,
-                2) != VK_SUCCESS) {
-
-            PONG_ERROR("Failed to create descriptor pool.");
+        if (!createInstanceBuffer(deviceData, &renderer2D->quadData)) {
+            PONG_ERROR("Failed to create quad instance buffer.");
             return false;
         }
 
-        // Calculate Uniform Buffer Memory
-        Buffers::DynamicUniformBuffer<QuadProperties> dynamicUbo;
-        Buffers::calculateBufferSize(&dynamicUbo, deviceData->physicalDevice, renderer2D->quadData.maxQuads);
-
-        PONG_INFO("Buffer size: " + std::to_string(dynamicUbo.bufferSize));
-        PONG_INFO("Dynamic alignment: " + std::to_string(dynamicUbo.dynamicAlignment));
-
-        // CREATE UNIFORM BUFFER
-        if (Buffers::createBuffer(
-                deviceData->physicalDevice,
-                deviceData->logicalDevice,
-                dynamicUbo.bufferSize,
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                dynamicUbo.buffer) != VK_SUCCESS) {
-
-            return VK_ERROR_INITIALIZATION_FAILED;
-        }
-
-        renderer2D->quadData.dynamicData = dynamicUbo;
-
-        VkDescriptorSet* descriptorSets =
-                static_cast<VkDescriptorSet*>(malloc(swapchain.imageCount * sizeof(VkDescriptorSet)));
-
-        if (Renderer::createDescriptorSets(
-            deviceData,
-            descriptorSets,
-            &renderer2D->quadData.descriptorSetLayout,
-            &renderer2D->descriptorPool,
-            swapchain.imageCount,
-            &renderer2D->quadData.dynamicData.buffer,
-            renderer2D->quadData.dynamicData.bufferSize,
-            renderer2D->quadData.texture) != VK_SUCCESS) {
-
-            PONG_ERROR("Failed to create descriptor sets!");
+        if (!createStaticLayer(deviceData, renderer2D)) {
+            PONG_ERROR("Failed to create static layer.");
             return false;
         }
 
-        renderer2D->quadData.dynamicDescriptorSets = descriptorSets;
+        if (!createSwapchainResources(deviceData, renderer2D, swapchain, swapchainArena)) return false;
 
         // =============================== COMMAND BUFFERS ==================================
 
-        renderer2D->commandBuffers = static_cast<VkCommandBuffer *>(malloc(
-                swapchain.imageCount * sizeof(VkCommandBuffer)));
+        renderer2D->commandBuffers = Memory::allocateArray<VkCommandBuffer>(swapchainArena,
+            swapchain.imageCount, Memory::MemoryTag::RENDERER2D);
 
         // With the command pool created, we can now start creating and allocating
         // command buffers. Because these commands involve allocating a framebuffer,
@@ -181,7 +292,8 @@ namespace Renderer2D {
                 &renderer2D->quadData.indexBuffer,
                 renderer2D->quadData.dynamicDescriptorSets,
                 renderer2D->quadData.quadCount,
-                renderer2D->quadData.dynamicData.dynamicAlignment)
+                0,
+                glm::mat4(1.0f))
             != VK_SUCCESS) {
 
             PONG_ERROR("Failed to create command buffers!");
@@ -193,34 +305,30 @@ namespace Renderer2D {
 
     void cleanupRenderer2D(Renderer::VulkanDeviceData* deviceData, Renderer2DData* pRenderer) {
 
-        free(pRenderer->frameBuffers);
-        free(pRenderer->quadData.dynamicDescriptorSets);
-
         vkDestroyDescriptorSetLayout(deviceData->logicalDevice,
                                      pRenderer->quadData.descriptorSetLayout,nullptr);
 
-        // Cleans up the memory buffer
-        vkDestroyBuffer(deviceData->logicalDevice,
-                        pRenderer->quadData.vertexBuffer.bufferData.buffer, nullptr);
-
-        // Frees the allocated vertex buffer memory
-        vkFreeMemory(deviceData->logicalDevice,
-                     pRenderer->quadData.vertexBuffer.bufferData.bufferMemory, nullptr);
+        // Cleans up the memory buffers
+        Buffers::destroyBuffer(deviceData, pRenderer->quadData.vertexBuffer.bufferData);
+        Buffers::destroyBuffer(deviceData, pRenderer->quadData.indexBuffer.bufferData);
 
-        vkDestroyBuffer(deviceData->logicalDevice,
-                        pRenderer->quadData.indexBuffer.bufferData.buffer, nullptr);
+        vkUnmapMemory(deviceData->logicalDevice, pRenderer->quadData.instanceBuffer.bufferMemory);
+        Buffers::destroyBuffer(deviceData, pRenderer->quadData.instanceBuffer);
+        pRenderer->quadData.mappedInstances = nullptr;
 
-        vkFreeMemory(deviceData->logicalDevice,
-                     pRenderer->quadData.indexBuffer.bufferData.bufferMemory, nullptr);
+        Buffers::alignedFree(pRenderer->quadData.instances);
+        pRenderer->quadData.instances = nullptr;
 
-        Buffers::alignedFree(pRenderer->quadData.dynamicData.data);
-        free(pRenderer->commandBuffers);
-
-        Renderer::destroyTexture2D(deviceData->logicalDevice, pRenderer->quadData.texture);
+        // The static layer's command buffers go with the command pool.
+        Buffers::destroyBuffer(deviceData, pRenderer->staticLayer.instanceBuffer);
+        Buffers::alignedFree(pRenderer->staticLayer.instances);
+        Buffers::alignedFree(pRenderer->staticLayer.recordings);
+        pRenderer->staticLayer.instances = nullptr;
+        pRenderer->staticLayer.recordings = nullptr;
     }
 
     bool recreateRenderer2D(Renderer::VulkanDeviceData* deviceData, Renderer2DData* renderer2D,
-        Renderer::SwapchainData swapchain) {
+        Renderer::SwapchainData swapchain, Memory::Arena* swapchainArena) {
 
         // ================================== RENDER PASS ====================================
 
@@ -233,67 +341,104 @@ namespace Renderer2D {
         // ================================ GRAPHICS PIPELINE ================================
 
         if (Renderer::createGraphicsPipeline(deviceData->logicalDevice, &renderer2D->graphicsPipeline,
-                                             &swapchain, &renderer2D->quadData.descriptorSetLayout) != VK_SUCCESS) {
+                                             &swapchain, &renderer2D->quadData.descriptorSetLayout,
+                                             swapchainArena) != VK_SUCCESS) {
             PONG_ERROR("Failed to create graphics pipeline!");
             return false;
         }
 
         // ================================ FRAMEBUFFER SETUP ================================
 
+        // The swapchain arena has been reset, and the new swapchain may not have
+        // the same number of images - so every per-image array starts afresh.
+        renderer2D->frameBuffers = Memory::allocateArray<VkFramebuffer>(swapchainArena, swapchain.imageCount,
+            Memory::MemoryTag::RENDERER2D);
+        renderer2D->commandBuffers = Memory::allocateArray<VkCommandBuffer>(swapchainArena,
+            swapchain.imageCount, Memory::MemoryTag::RENDERER2D);
+
         if (Renderer::createFramebuffer(deviceData->logicalDevice, renderer2D->frameBuffers,
                                         &swapchain, &renderer2D->graphicsPipeline) != VK_SUCCESS) {
             PONG_ERROR("Failed to create framebuffers!");
             return false;
         }
 
-        VkDescriptorPoolSize poolSizes[] = {
-                Renderer::initialisePoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, swapchain.imageCount)
-        };
+        // The instance buffers don't depend on the swapchain, so they're kept.
+        return createSwapchainResources(deviceData, renderer2D, swapchain, swapchainArena);
+    }
 
-        if (Renderer::createDescriptorPool(
-                deviceData->logicalDevice,
-                swapchain.imageCount, &renderer2D->descriptorPool, poolSizes,
-                1) != VK_SUCCESS) {
+    bool bakeStaticLayer(Renderer::VulkanDeviceData* deviceData, Renderer2DData* renderer2D) {
 
-            PONG_ERROR("Failed to create descriptor pool.");
-            return false;
-        }
+        StaticLayer* layer = &renderer2D->staticLayer;
 
-        Buffers::DynamicUniformBuffer<Renderer2D::QuadProperties> dynamicUbo;
-        Buffers::calculateBufferSize(&dynamicUbo, deviceData->physicalDevice, renderer2D->quadData.maxQuads);
+        // Rare enough (the layer's built once, then left alone) that it's not
+        // worth keeping a copy per frame in flight.
+        vkQueueWaitIdle(deviceData->graphicsQueue);
 
-        PONG_INFO("Buffer size: " + std::to_string(dynamicUbo.bufferSize));
-        PONG_INFO("Dynamic alignment: " + std::to_string(dynamicUbo.dynamicAlignment));
+        if (layer->quadCount > 0) {
+            VkDeviceSize size = layer->quadCount * sizeof(QuadInstance);
+            Buffers::BufferData stagingBuffer{};
 
-        // ALLOCATE UNIFORM BUFFER
-        if (Buffers::createBuffer(
-                deviceData->physicalDevice,
-                deviceData->logicalDevice,
-                dynamicUbo.bufferSize,
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                dynamicUbo.buffer) != VK_SUCCESS) {
+            if (Buffers::createBuffer(deviceData, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                stagingBuffer) != VK_SUCCESS) {
 
-            return VK_ERROR_INITIALIZATION_FAILED;
-        }
+                return false;
+            }
 
-        renderer2D->quadData.dynamicData = dynamicUbo;
+            void* data;
+            vkMapMemory(deviceData->logicalDevice, stagingBuffer.bufferMemory, 0, size, 0, &data);
+            memcpy(data, layer->instances, static_cast<size_t>(size));
+            vkUnmapMemory(deviceData->logicalDevice, stagingBuffer.bufferMemory);
 
-        if (Renderer::createDescriptorSets(
-                deviceData,
-                renderer2D->quadData.dynamicDescriptorSets,
-                &renderer2D->quadData.descriptorSetLayout,
-                &renderer2D->descriptorPool,
-                swapchain.imageCount,
-                &renderer2D->quadData.dynamicData.buffer,
-                renderer2D->quadData.dynamicData.bufferSize,
-                renderer2D->quadData.texture) != VK_SUCCESS) {
+            Renderer::copyBuffer(deviceData->graphicsQueue, deviceData->logicalDevice, renderer2D->commandPool,
+                size, stagingBuffer.buffer, layer->instanceBuffer.buffer);
 
-            PONG_ERROR("Failed to create descriptor sets!");
-            return false;
+            Buffers::destroyBuffer(deviceData, stagingBuffer);
         }
 
+        layer->isDirty = false;
+        layer->version++;
+        layer->bakeCount++;
+
+        return true;
+    }
+
+    bool recordStaticLayer(Renderer2DData* renderer2D, uint32_t frame, const glm::mat4& viewProjection,
+        uint64_t cameraVersion) {
+
+        StaticLayer* layer = &renderer2D->staticLayer;
+        StaticLayerRecording* recording = &layer->recordings[frame];
+
+        if (recording->layerVersion == layer->version && recording->renderPassVersion == renderer2D->renderPassVersion
+            && recording->cameraVersion == cameraVersion) return true;
+
+        vkResetCommandBuffer(recording->commandBuffer, 0);
+
+        // Replayed inside the render pass of every frame that uses this slot,
+        // whichever framebuffer it's drawing to.
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = renderer2D->graphicsPipeline.renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        if (vkBeginCommandBuffer(recording->commandBuffer, &beginInfo) != VK_SUCCESS) return false;
+
+        Renderer::recordQuadDraw(recording->commandBuffer, &renderer2D->graphicsPipeline,
+            &renderer2D->quadData.vertexBuffer, &renderer2D->quadData.indexBuffer,
+            layer->descriptorSet, layer->quadCount, 0, viewProjection);
+
+        if (vkEndCommandBuffer(recording->commandBuffer) != VK_SUCCESS) return false;
+
+        recording->layerVersion = layer->version;
+        recording->renderPassVersion = renderer2D->renderPassVersion;
+        recording->cameraVersion = cameraVersion;
+
         return true;
     }
-}
\ No newline at end of file
+}
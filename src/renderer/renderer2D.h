@@ -6,23 +6,90 @@
 #include "vk/vulkanDeviceData.h"
 #include "core.h"
 #include "vk/texture2d.h"
+#include "textureCache.h"
 
 namespace Renderer2D {
 
-    struct QuadProperties {
-        glm::mat4 mvp;
-        glm::vec3 color;
+    // Quads are drawn as instances of one mesh - each instance's data is read
+    // by the vertex shader out of a storage buffer, so a whole frame's worth
+    // of quads is a single draw. Laid out to match std430. The camera's view
+    // projection is pushed once per draw, so each quad only has its model
+    // transform.
+    struct QuadInstance {
+        glm::mat4 model;
+        glm::vec4 color;
+        // Region of the texture to sample, as (u0, v0, u1, v1).
+        glm::vec4 uvRect;
+        uint32_t flags;
+        uint32_t padding[3];
     };
 
+    enum QuadFlags : uint32_t {
+        QUAD_FLAG_NONE  = 0,
+        // Sampled from the text atlas as a signed distance field.
+        QUAD_FLAG_SDF   = 1,
+        // Just the quad's color, nothing sampled.
+        QUAD_FLAG_UNTEXTURED = 2
+    };
+
+    // Textures bound to every quad - which one a quad samples depends on its flags.
+    constexpr uint32_t QUAD_TEXTURE_SLOT = 0;
+    constexpr uint32_t TEXT_ATLAS_SLOT = 1;
+    constexpr uint32_t QUAD_TEXTURE_SLOT_COUNT = 2;
+
     struct QuadData {
         VkDescriptorSetLayout descriptorSetLayout                   {VK_NULL_HANDLE};
         size_t quadCount                                            {0};
         size_t maxQuads                                             {256};
         Buffers::VertexBuffer vertexBuffer                          {0};
         Buffers::IndexBuffer indexBuffer                            {nullptr};
-        Buffers::DynamicUniformBuffer<QuadProperties> dynamicData   {0};
+        // Quads are written here as they're drawn, then copied into the frame's
+        // slice of the instance buffer once the GPU has finished with it.
+        QuadInstance* instances                                     {nullptr};
+        // One slice of maxQuads instances per frame in flight, kept mapped.
+        Buffers::BufferData instanceBuffer                          {VK_NULL_HANDLE};
+        void* mappedInstances                                       {nullptr};
+        VkDeviceSize instanceSliceSize                              {0};
+        uint32_t framesInFlight                                     {2};
         VkDescriptorSet* dynamicDescriptorSets                      {nullptr};
-        Renderer::Texture2D texture                                 {0};
+        // The quad texture is owned by the renderer's texture cache, the text
+        // atlas by the renderer's text data.
+        Renderer::Texture2D textures[QUAD_TEXTURE_SLOT_COUNT];
+        Renderer::TextureHandle textureHandle                       {Renderer::INVALID_TEXTURE};
+        // A quad sampling the quad texture has been drawn since the last flush.
+        bool isTextureDrawn                                         {false};
+    };
+
+    // A recording of the static layer's draw. Each frame in flight has its
+    // own, so one can be re-recorded (when the camera moves) while the others
+    // are still in use.
+    struct StaticLayerRecording {
+        VkCommandBuffer commandBuffer                               {VK_NULL_HANDLE};
+        // The layer, render pass and camera versions it was recorded against.
+        uint64_t layerVersion                                       {0};
+        uint64_t renderPassVersion                                  {0};
+        uint64_t cameraVersion                                      {0};
+    };
+
+    // Quads that don't move from one frame to the next (the net, the arena's
+    // borders). They're uploaded once into device local memory and recorded
+    // into secondary command buffers which every frame just replays - so they
+    // cost nothing per frame until the layer is changed or the camera moves.
+    struct StaticLayer {
+        // Written as quads are added, then baked into the instance buffer.
+        QuadInstance* instances                                     {nullptr};
+        size_t quadCount                                            {0};
+        size_t maxQuads                                             {256};
+        Buffers::BufferData instanceBuffer                          {VK_NULL_HANDLE};
+        // Allocated from the descriptor pool, so it's re-made with the swapchain.
+        VkDescriptorSet descriptorSet                               {VK_NULL_HANDLE};
+        // One per frame in flight.
+        StaticLayerRecording* recordings                            {nullptr};
+        // The instances have changed since they were last uploaded.
+        bool isDirty                                                {false};
+        // Bumped whenever the instances are re-uploaded.
+        uint64_t version                                            {1};
+        uint64_t bakeCount                                          {0};
     };
 
     struct Renderer2DData {
@@ -32,12 +99,28 @@ namespace Renderer2D {
         VkCommandPool commandPool                               { VK_NULL_HANDLE };
         VkDescriptorPool descriptorPool                         { VK_NULL_HANDLE };
         VkCommandBuffer* commandBuffers                         {nullptr};
+        // Secondary command buffers the frame's quads are recorded into, one per image.
+        VkCommandBuffer* quadCommandBuffers                     {nullptr};
+        // Bumped every time the render pass is re-made - anything recorded
+        // against the old one has to be recorded again.
+        uint64_t renderPassVersion                              {0};
+        StaticLayer staticLayer;
     };
 
-    bool initialiseRenderer2D(Renderer::VulkanDeviceData*, Renderer2DData*, Renderer::SwapchainData);
+    // The per-image arrays (framebuffers, descriptor sets and command buffers)
+    // come from the swapchain arena, so they're re-allocated on every recreation.
+    bool initialiseRenderer2D(Renderer::VulkanDeviceData*, Renderer2DData*, Renderer::SwapchainData,
+        Memory::Arena* swapchainArena);
     void cleanupRenderer2D(Renderer::VulkanDeviceData*, Renderer2DData*);
     bool recreateRenderer2D(Renderer::VulkanDeviceData* deviceData, Renderer2DData* renderer2D,
-        Renderer::SwapchainData swapchain);
+        Renderer::SwapchainData swapchain, Memory::Arena* swapchainArena);
+
+    // Uploads the static layer's instances. Waits for the queue to go idle
+    // first, since frames in flight may still be reading the old ones.
+    bool bakeStaticLayer(Renderer::VulkanDeviceData*, Renderer2DData*);
+    // Records the static layer's draw for the given frame in flight, if it's
+    // out of date. That frame can't still be in flight.
+    bool recordStaticLayer(Renderer2DData*, uint32_t frame, const glm::mat4& viewProjection, uint64_t cameraVersion);
 }
 
 #endif //PONG_VK_RENDERER2D_H
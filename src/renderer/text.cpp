@@ -0,0 +1,350 @@
+#include "text.h"
+#include <cstring>
+#include <algorithm>
+#include "renderer.h"
+#include "utils.h"
+#include "vk/initialisers.h"
+#include "vk/vulkanUtils.h"
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb_truetype.h>
+
+namespace Renderer {
+
+    // FNV-1a
+    static uint64_t hashText(const char* text, uint32_t length) {
+        uint64_t hash = 14695981039346656037ull;
+        for (uint32_t i = 0; i < length; i++) {
+            hash ^= static_cast<uint8_t>(text[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // Reads the UTF-8 sequence starting at index and moves index past it.
+    // Anything malformed comes out as the replacement character.
+    static int32_t decodeUtf8(const char* text, uint32_t length, uint32_t* index) {
+
+        auto lead = static_cast<uint8_t>(text[(*index)++]);
+        if (lead < 0x80) return lead;
+
+        uint32_t continuationCount = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+        if (continuationCount == 0 || *index + continuationCount > length) return 0xFFFD;
+
+        int32_t codepoint = lead & (0x3F >> continuationCount);
+        for (uint32_t i = 0; i < continuationCount; i++) {
+            auto next = static_cast<uint8_t>(text[*index]);
+            if ((next & 0xC0) != 0x80) return 0xFFFD;
+            codepoint = (codepoint << 6) | (next & 0x3F);
+            (*index)++;
+        }
+
+        return codepoint;
+    }
+
+    static Glyph* findGlyph(TextData* text, int32_t codepoint) {
+
+        uint32_t slot = (static_cast<uint32_t>(codepoint) * 2654435761u) & (MAX_TEXT_GLYPHS - 1);
+
+        // There's always at least one empty slot, so this ends.
+        while (text->glyphs[slot].codepoint != codepoint && text->glyphs[slot].codepoint != -1) {
+            slot = (slot + 1) & (MAX_TEXT_GLYPHS - 1);
+        }
+
+        return &text->glyphs[slot];
+    }
+
+    // Glyphs are packed left to right along shelves, starting a new shelf
+    // below the tallest glyph on the current one when it fills up. Glyphs
+    // are kept a pixel apart so filtering never picks up a neighbour.
+    static bool packGlyph(TextData* text, uint32_t width, uint32_t height, uint32_t* x, uint32_t* y) {
+
+        if (text->shelfX + width > TEXT_ATLAS_SIZE) {
+            text->shelfY += text->shelfHeight + 1;
+            text->shelfX = 0;
+            text->shelfHeight = 0;
+        }
+
+        if (width > TEXT_ATLAS_SIZE || text->shelfY + height > TEXT_ATLAS_SIZE) return false;
+
+        *x = text->shelfX;
+        *y = text->shelfY;
+
+        text->shelfX += width + 1;
+        text->shelfHeight = std::max(text->shelfHeight, height);
+
+        return true;
+    }
+
+    // Finds the glyph for the codepoint, rasterising it into the atlas if it
+    // hasn't been seen before. Null if the glyph table is full.
+    static Glyph* getGlyph(TextData* text, int32_t codepoint) {
+
+        Glyph* glyph = findGlyph(text, codepoint);
+        if (glyph->codepoint == codepoint) return glyph;
+
+        if (text->glyphCount == MAX_TEXT_GLYPHS - 1) return nullptr;
+
+        glyph->codepoint = codepoint;
+        glyph->glyphIndex = stbtt_FindGlyphIndex(&text->font, codepoint);
+        text->glyphCount++;
+
+        int advance, leftSideBearing;
+        stbtt_GetGlyphHMetrics(&text->font, glyph->glyphIndex, &advance, &leftSideBearing);
+        glyph->advance = static_cast<float>(advance) * text->scale;
+
+        // The edge sits at 128, and the field falls to 0 at the edge of the padding.
+        int width, height, offsetX, offsetY;
+        uint8_t* field = stbtt_GetGlyphSDF(&text->font, text->scale, glyph->glyphIndex, TEXT_GLYPH_PADDING, 128,
+            128.0f / TEXT_GLYPH_PADDING, &width, &height, &offsetX, &offsetY);
+
+        // Whitespace has nothing to draw.
+        if (!field) return glyph;
+
+        uint32_t x, y;
+        if (packGlyph(text, width, height, &x, &y)) {
+            for (int row = 0; row < height; row++) {
+                memcpy(&text->atlasPixels[(y + row) * TEXT_ATLAS_SIZE + x], &field[row * width], width);
+            }
+
+            glyph->offset = { static_cast<float>(offsetX), static_cast<float>(offsetY) };
+            glyph->size = { static_cast<float>(width), static_cast<float>(height) };
+            // Quads are textured bottom to top, but the atlas's rows run top to
+            // bottom - so the glyph's region is flipped.
+            glyph->uvRect = {
+                static_cast<float>(x) / TEXT_ATLAS_SIZE, static_cast<float>(y + height) / TEXT_ATLAS_SIZE,
+                static_cast<float>(x + width) / TEXT_ATLAS_SIZE, static_cast<float>(y) / TEXT_ATLAS_SIZE
+            };
+
+            text->isAtlasDirty = true;
+        } else if (!text->isAtlasFull) {
+            text->isAtlasFull = true;
+            PONG_WARN("Text atlas is full - new glyphs won't be drawn");
+        }
+
+        stbtt_FreeSDF(field, nullptr);
+
+        return glyph;
+    }
+
+    static void layoutTextRun(TextData* text, TextRun* run) {
+
+        float penX = 0.0f;
+        float lineTop = 0.0f;
+        float width = 0.0f;
+        int32_t previousGlyph = -1;
+
+        run->quadCount = 0;
+
+        uint32_t i = 0;
+        while (i < run->length) {
+            int32_t codepoint = decodeUtf8(run->text, run->length, &i);
+
+            if (codepoint == '\n') {
+                width = std::max(width, penX);
+                penX = 0.0f;
+                lineTop += text->lineHeight;
+                previousGlyph = -1;
+                continue;
+            }
+
+            Glyph* glyph = getGlyph(text, codepoint);
+            if (!glyph) continue;
+
+            if (previousGlyph >= 0) {
+                penX += static_cast<float>(stbtt_GetGlyphKernAdvance(&text->font, previousGlyph,
+                    glyph->glyphIndex)) * text->scale;
+            }
+
+            if (glyph->size.x > 0.0f) {
+                GlyphQuad* quad = &run->quads[run->quadCount++];
+                quad->center = {
+                    penX + glyph->offset.x + glyph->size.x * 0.5f,
+                    lineTop + text->ascent + glyph->offset.y + glyph->size.y * 0.5f
+                };
+                quad->size = glyph->size;
+                quad->uvRect = glyph->uvRect;
+            }
+
+            penX += glyph->advance;
+            previousGlyph = glyph->glyphIndex;
+        }
+
+        run->extent = { std::max(width, penX), lineTop + text->lineHeight };
+    }
+
+    const TextRun* getTextRun(TextData* text, const char* string) {
+
+        text->useCount++;
+
+        auto length = static_cast<uint32_t>(strlen(string));
+        if (length > MAX_TEXT_RUN_LENGTH) {
+            // Don't cut a character in half.
+            length = MAX_TEXT_RUN_LENGTH;
+            while (length > 0 && (static_cast<uint8_t>(string[length]) & 0xC0) == 0x80) length--;
+        }
+
+        uint64_t hash = hashText(string, length);
+
+        TextRun* oldest = &text->runs[0];
+
+        for (uint32_t i = 0; i < MAX_TEXT_RUNS; i++) {
+            TextRun* run = &text->runs[i];
+
+            if (run->hash == hash && run->length == length && memcmp(run->text, string, length) == 0) {
+                run->lastUsed = text->useCount;
+                text->runHits++;
+                return run;
+            }
+
+            if (run->lastUsed < oldest->lastUsed) oldest = run;
+        }
+
+        text->runMisses++;
+
+        oldest->hash = hash;
+        oldest->length = length;
+        memcpy(oldest->text, string, length);
+        oldest->lastUsed = text->useCount;
+
+        layoutTextRun(text, oldest);
+
+        return oldest;
+    }
+
+    Status initialiseText(TextData* text, const char* fontPath, Memory::Arena* arena) {
+
+        text->glyphs = Memory::allocateArray<Glyph>(arena, MAX_TEXT_GLYPHS, Memory::MemoryTag::TEXT);
+        for (uint32_t i = 0; i < MAX_TEXT_GLYPHS; i++) text->glyphs[i] = Glyph{};
+
+        text->runs = Memory::allocateArray<TextRun>(arena, MAX_TEXT_RUNS, Memory::MemoryTag::TEXT);
+        for (uint32_t i = 0; i < MAX_TEXT_RUNS; i++) text->runs[i] = TextRun{};
+
+        text->atlasPixels = Memory::allocateArray<uint8_t>(arena, TEXT_ATLAS_SIZE * TEXT_ATLAS_SIZE,
+            Memory::MemoryTag::TEXT);
+        memset(text->atlasPixels, 0, TEXT_ATLAS_SIZE * TEXT_ATLAS_SIZE);
+        text->isAtlasDirty = true;
+
+        // stb_truetype reads straight out of the file's bytes, so they're kept.
+        FileContents font = readFile(fontPath, arena, Memory::MemoryTag::TEXT);
+        if (!font.p_byteCode) {
+            PONG_ERROR("Failed to load font '{0}'!", fontPath);
+            return Status::FAILURE;
+        }
+
+        auto data = reinterpret_cast<const unsigned char*>(font.p_byteCode);
+        int offset = stbtt_GetFontOffsetForIndex(data, 0);
+
+        if (offset < 0 || !stbtt_InitFont(&text->font, data, offset)) {
+            PONG_ERROR("'{0}' isn't a font that can be read!", fontPath);
+            return Status::FAILURE;
+        }
+
+        text->scale = stbtt_ScaleForPixelHeight(&text->font, TEXT_GLYPH_HEIGHT);
+
+        int ascent, descent, lineGap;
+        stbtt_GetFontVMetrics(&text->font, &ascent, &descent, &lineGap);
+        text->ascent = static_cast<float>(ascent) * text->scale;
+        text->lineHeight = static_cast<float>(ascent - descent + lineGap) * text->scale;
+
+        text->isLoaded = true;
+
+        PONG_INFO("Loaded font '{0}'", fontPath);
+
+        return Status::SUCCESS;
+    }
+
+    Status createTextAtlas(TextData* text, VulkanDeviceData* deviceData, VkCommandPool commandPool) {
+
+        if (createImage(
+            deviceData,
+            TEXT_ATLAS_SIZE,
+            TEXT_ATLAS_SIZE,
+            VK_FORMAT_R8_UNORM,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            text->atlas) != Status::SUCCESS) {
+
+            PONG_ERROR("Failed to create text atlas!");
+            return Status::INITIALIZATION_FAILURE;
+        }
+
+        if (createImageView(deviceData->logicalDevice, text->atlas.image, VK_FORMAT_R8_UNORM, text->atlas.view)
+            != Status::SUCCESS) {
+            destroyTexture2D(deviceData, text->atlas);
+            return Status::INITIALIZATION_FAILURE;
+        }
+
+        // Clamped, so glyphs on the atlas's edge don't pick up the other side.
+        text->atlas.sampler = initialiseSampler(
+            deviceData->logicalDevice,
+            VK_FILTER_LINEAR, VK_FILTER_LINEAR,
+            VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+            VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+            VK_COMPARE_OP_ALWAYS,
+            VK_SAMPLER_MIPMAP_MODE_LINEAR
+        );
+
+        return uploadTextAtlas(text, deviceData, commandPool);
+    }
+
+    Status uploadTextAtlas(TextData* text, VulkanDeviceData* deviceData, VkCommandPool commandPool) {
+
+        VkDeviceSize atlasSize = TEXT_ATLAS_SIZE * TEXT_ATLAS_SIZE;
+
+        Buffers::BufferData stagingBuffer;
+
+        if (Buffers::createBuffer(
+            deviceData,
+            atlasSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            stagingBuffer) != VK_SUCCESS) {
+
+            PONG_ERROR("Failed to create buffer for text atlas");
+            return Status::FAILURE;
+        }
+
+        void* data;
+        vkMapMemory(deviceData->logicalDevice, stagingBuffer.bufferMemory, 0, atlasSize, 0, &data);
+        memcpy(data, text->atlasPixels, static_cast<size_t>(atlasSize));
+        vkUnmapMemory(deviceData->logicalDevice, stagingBuffer.bufferMemory);
+
+        // Waits on anything already submitted that samples the atlas, so it can
+        // be written over.
+        Status status = transitionImageLayout(deviceData->logicalDevice, deviceData->graphicsQueue, commandPool,
+            text->atlas.image, VK_FORMAT_R8_UNORM, text->atlas.layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+        if (status == Status::SUCCESS) {
+            copyBufferToImage(deviceData->logicalDevice, commandPool, deviceData->graphicsQueue,
+                stagingBuffer.buffer, text->atlas.image, TEXT_ATLAS_SIZE, TEXT_ATLAS_SIZE);
+            status = transitionImageLayout(deviceData->logicalDevice, deviceData->graphicsQueue, commandPool,
+                text->atlas.image, VK_FORMAT_R8_UNORM, text->atlas.layout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        }
+
+        Buffers::destroyBuffer(deviceData, stagingBuffer);
+
+        if (status != Status::SUCCESS) {
+            PONG_ERROR("Failed to upload text atlas!");
+            return status;
+        }
+
+        text->isAtlasDirty = false;
+        text->atlasUploads++;
+
+        return Status::SUCCESS;
+    }
+
+    void cleanupText(TextData* text, VulkanDeviceData* deviceData) {
+
+        destroyTexture2D(deviceData, text->atlas);
+
+        if (text->isLoaded) {
+            PONG_INFO("Text: {0} glyphs, {1} layout cache hits, {2} misses, {3} atlas uploads",
+                text->glyphCount, text->runHits, text->runMisses, text->atlasUploads);
+        }
+
+        text->isLoaded = false;
+    }
+}
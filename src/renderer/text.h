@@ -0,0 +1,111 @@
+#ifndef PONG_VK_TEXT_H
+#define PONG_VK_TEXT_H
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <stb_truetype.h>
+#include "core.h"
+#include "vk/texture2d.h"
+#include "vk/vulkanDeviceData.h"
+#include "../memory/arena.h"
+
+namespace Renderer {
+
+    // Text, drawn from signed distance field glyphs.
+    //
+    // Glyphs are rasterised into a single channel atlas the first time they're
+    // needed. They're stored as distances to the glyph's edge rather than as
+    // coverage, so the one size kept in the atlas stays sharp when it's drawn
+    // larger or smaller. Nothing is ever removed from the atlas, so once a
+    // glyph is in it, it never moves.
+    //
+    // Laying out a string (finding each glyph, applying kerning) is done once
+    // and cached against the string's contents. Text that doesn't change from
+    // frame to frame - labels, most of a HUD - costs a hash and a compare to
+    // find again. Each glyph is then drawn as a quad in the quad batch, so text
+    // adds no draws of its own.
+
+    constexpr uint32_t TEXT_ATLAS_SIZE = 512;
+    // Height glyphs are rasterised at, in atlas pixels.
+    constexpr float TEXT_GLYPH_HEIGHT = 32.0f;
+    // How far the distance field reaches out past the glyph's edge, in atlas pixels.
+    constexpr int TEXT_GLYPH_PADDING = 4;
+    // Must be a power of two.
+    constexpr uint32_t MAX_TEXT_GLYPHS = 256;
+    constexpr uint32_t MAX_TEXT_RUNS = 64;
+    // Longer strings are cut short.
+    constexpr uint32_t MAX_TEXT_RUN_LENGTH = 64;
+
+    struct Glyph {
+        // -1 for an empty slot.
+        int32_t codepoint           {-1};
+        int32_t glyphIndex          {0};
+        // Box around the glyph's distance field, relative to the pen position
+        // on the baseline (y down), in atlas pixels. Zero sized for glyphs with
+        // nothing to draw.
+        glm::vec2 offset            {0.0f};
+        glm::vec2 size              {0.0f};
+        float advance               {0.0f};
+        glm::vec4 uvRect            {0.0f};
+    };
+
+    // A glyph placed within a laid out string, in atlas pixels from the top
+    // left of the string (y down).
+    struct GlyphQuad {
+        glm::vec2 center;
+        glm::vec2 size;
+        glm::vec4 uvRect;
+    };
+
+    struct TextRun {
+        uint64_t hash               {0};
+        uint32_t length             {0};
+        char text[MAX_TEXT_RUN_LENGTH];
+        GlyphQuad quads[MAX_TEXT_RUN_LENGTH];
+        uint32_t quadCount          {0};
+        // Size of the laid out string, in atlas pixels.
+        glm::vec2 extent            {0.0f};
+        uint64_t lastUsed           {0};
+    };
+
+    struct TextData {
+        bool isLoaded               {false};
+        stbtt_fontinfo font;
+        // Font units to atlas pixels.
+        float scale                 {0.0f};
+        float ascent                {0.0f};
+        float lineHeight            {0.0f};
+        // Open addressed on the codepoint.
+        Glyph* glyphs               {nullptr};
+        uint32_t glyphCount         {0};
+        // CPU copy of the atlas. Glyphs are rasterised into it as they're
+        // needed, and it's re-uploaded before the next frame that uses them.
+        uint8_t* atlasPixels        {nullptr};
+        uint32_t shelfX             {0};
+        uint32_t shelfY             {0};
+        uint32_t shelfHeight        {0};
+        bool isAtlasDirty           {false};
+        bool isAtlasFull            {false};
+        Texture2D atlas;
+        TextRun* runs               {nullptr};
+        uint64_t useCount           {0};
+        uint64_t runHits            {0};
+        uint64_t runMisses          {0};
+        uint64_t atlasUploads       {0};
+    };
+
+    // The font and the glyph and run tables come out of the arena, which has
+    // to outlive the text data. Fails if the font can't be loaded, but still
+    // leaves behind a (blank) atlas that can be uploaded and bound.
+    Status initialiseText(TextData*, const char* fontPath, Memory::Arena*);
+    // Creates the atlas image and uploads its current contents.
+    Status createTextAtlas(TextData*, VulkanDeviceData*, VkCommandPool);
+    // Copies the CPU atlas over to the atlas image. Waits for the upload to
+    // finish, so only worth calling when there are new glyphs.
+    Status uploadTextAtlas(TextData*, VulkanDeviceData*, VkCommandPool);
+    // Finds the string's layout, laying it out first if it isn't cached.
+    const TextRun* getTextRun(TextData*, const char*);
+    void cleanupText(TextData*, VulkanDeviceData*);
+}
+
+#endif //PONG_VK_TEXT_H
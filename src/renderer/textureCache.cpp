@@ -0,0 +1,50 @@
+#include "textureCache.h"
+
+namespace Renderer {
+
+    TextureHandle findEvictableTexture(const TextureCache* cache, const VulkanDeviceData* deviceData,
+        uint32_t heapIndex) {
+
+        TextureHandle oldest = INVALID_TEXTURE;
+
+        for (TextureHandle i = 0; i < cache->textureCount; i++) {
+            const CachedTexture* cached = &cache->textures[i];
+
+            if (!cached->isResident
+                || getMemoryHeapIndex(&deviceData->gpuMemory, cached->texture.memoryType) != heapIndex
+                || cached->lastUsedFrame + cache->framesInFlight >= cache->currentFrame) continue;
+
+            if (oldest == INVALID_TEXTURE || cached->lastUsedFrame < cache->textures[oldest].lastUsedFrame) {
+                oldest = i;
+            }
+        }
+
+        return oldest;
+    }
+
+    void evictTexture(TextureCache* cache, VulkanDeviceData* deviceData, TextureHandle handle) {
+
+        CachedTexture* cached = &cache->textures[handle];
+
+        PONG_INFO("Evicting texture '{0}' ({1} KB, last used {2} frames ago)", cached->path,
+            cached->texture.memorySize / 1024, cache->currentFrame - cached->lastUsedFrame);
+
+        destroyTextureImage(deviceData, cached->texture);
+        cached->isResident = false;
+        cache->evictionCount++;
+    }
+
+    void destroyTextureCache(TextureCache* cache, VulkanDeviceData* deviceData) {
+
+        for (uint32_t i = 0; i < cache->textureCount; i++) {
+            destroyTexture2D(deviceData, cache->textures[i].texture);
+            cache->textures[i] = CachedTexture{};
+        }
+
+        if (cache->evictionCount > 0) {
+            PONG_INFO("Texture cache: {0} evictions, {1} re-loads", cache->evictionCount, cache->reloadCount);
+        }
+
+        cache->textureCount = 0;
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef PONG_VK_TEXTURECACHE_H
+#define PONG_VK_TEXTURECACHE_H
+
+#include <string>
+#include <cstdint>
+#include "vk/texture2d.h"
+#include "vk/vulkanDeviceData.h"
+
+namespace Renderer {
+
+    // Textures loaded from disk. When device memory goes over budget, the least
+    // recently used texture that no frame in flight can still be reading is
+    // evicted (its image and memory freed), and it's loaded back in from disk
+    // the next time it's used.
+    //
+    // A texture counts as used whenever useTexture is called for it. Anything
+    // which holds on to a texture's view (in a descriptor set, say) has to call
+    // it every frame it draws with the texture, and rebind the texture if its
+    // view has changed. Whatever evicts a texture has to move anything still
+    // pointing at it off it first.
+
+    typedef uint32_t TextureHandle;
+
+    constexpr TextureHandle INVALID_TEXTURE = UINT32_MAX;
+    constexpr uint32_t MAX_CACHED_TEXTURES = 64;
+
+    struct CachedTexture {
+        std::string path;
+        Texture2D texture;
+        bool isResident                             {false};
+        uint64_t lastUsedFrame                      {0};
+    };
+
+    struct TextureCache {
+        CachedTexture textures[MAX_CACHED_TEXTURES];
+        uint32_t textureCount                       {0};
+        // Counts submitted frames. Textures used within the last framesInFlight
+        // of them may still be being read by the GPU.
+        uint64_t currentFrame                       {0};
+        uint32_t framesInFlight                     {2};
+        uint64_t evictionCount                      {0};
+        uint64_t reloadCount                        {0};
+    };
+
+    // The least recently used texture on the heap that can be evicted, or
+    // INVALID_TEXTURE if there isn't one.
+    TextureHandle findEvictableTexture(const TextureCache*, const VulkanDeviceData*, uint32_t heapIndex);
+    void evictTexture(TextureCache*, VulkanDeviceData*, TextureHandle);
+    void destroyTextureCache(TextureCache*, VulkanDeviceData*);
+}
+
+#endif //PONG_VK_TEXTURECACHE_H
@@ -1,22 +1,23 @@
 #include "utils.h"
 #include <fstream>
-#include <iostream>
+#include "../logger.h"
 
 // Simple utility function for returnng the contents of a file.
-FileContents readFile(const std::string &fileName) {
+FileContents readFile(const std::string &fileName, Memory::Arena* arena, Memory::MemoryTag tag) {
     // Get the contents of the file and interpret it as a byte 
     // array
     
     std::ifstream file(fileName, std::ios::ate | std::ios::binary);
     // Make sure we've actually opened the file
     if (!file.is_open()) {
-        std::cout << "Failed to open file!" << std::endl;
+        PONG_ERROR("Failed to open file '{0}'!", fileName);
+        return FileContents{nullptr, 0};
     }
     
     FileContents contents;
     // Create an array with the size of this file into it.
     size_t fileSize = (size_t) file.tellg();
-    char* buffer = new char[fileSize];
+    char* buffer = Memory::allocateArray<char>(arena, fileSize, tag);
 
     file.seekg(0);
     // Pass the file contents to the array
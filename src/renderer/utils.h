@@ -2,13 +2,16 @@
 #define UTILS_H
 
 #include <string>
+#include "../memory/arena.h"
 
 struct FileContents {
     char* p_byteCode;
     uint32_t fileSize;
 };
 
-// Utility function used to read a file name (usually a shader).
-FileContents readFile(const std::string &fileName); 
+// Utility function used to read a file name (usually a shader). The contents
+// are allocated from the given arena. Null contents if the file can't be opened.
+FileContents readFile(const std::string &fileName, Memory::Arena* arena,
+    Memory::MemoryTag tag = Memory::MemoryTag::PIPELINE);
 
 #endif
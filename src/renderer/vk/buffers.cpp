@@ -4,8 +4,7 @@ namespace Buffers {
 	
 	// ---------------------------- BUFFER ----------------------------------
 	VkResult createBuffer(
-		VkPhysicalDevice physicalDevice,
-		VkDevice logicalDevice,
+		Renderer::VulkanDeviceData* deviceData,
 		VkDeviceSize size,
 		VkBufferUsageFlags usage,
 		VkMemoryPropertyFlags properties,
@@ -23,7 +22,7 @@ namespace Buffers {
 		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
 		// Create the buffer using the create object we specified before
-		if ((vkCreateBuffer(logicalDevice, &bufferInfo, nullptr,
+		if ((vkCreateBuffer(deviceData->logicalDevice, &bufferInfo, nullptr,
 			&bufferData.buffer)) != VK_SUCCESS) {
 			return VkResult::VK_ERROR_INITIALIZATION_FAILED;
 		}
@@ -32,40 +31,50 @@ namespace Buffers {
 
 		// First we need to get the memory requirements for the buffer
 		VkMemoryRequirements memRequirements;
-		vkGetBufferMemoryRequirements(logicalDevice, bufferData.buffer,
+		vkGetBufferMemoryRequirements(deviceData->logicalDevice, bufferData.buffer,
 			&memRequirements);
 
-		VkMemoryAllocateInfo allocInfo{};
-
 		// Store the memory type in a variable
 		uint32_t memoryType;
 
 		// Search for our memory requirements and check if we can map this memory from
 		// our CPU to the GPU.
-		if (!findMemoryType(physicalDevice, &memoryType,
+		if (!findMemoryType(deviceData->physicalDevice, &memoryType,
 			memRequirements.memoryTypeBits, properties)) {
 
+			vkDestroyBuffer(deviceData->logicalDevice, bufferData.buffer, nullptr);
+			bufferData.buffer = VK_NULL_HANDLE;
 			return VK_ERROR_INITIALIZATION_FAILED;
 		}
 
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		// Specify the size of our allocation using our memory requirements
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = memoryType;
-
-		// Now allocate the memory
-		if (vkAllocateMemory(logicalDevice, &allocInfo, nullptr,
-			&bufferData.bufferMemory) != VK_SUCCESS) {
+		// Now allocate the memory - this goes through the tracker so it's counted
+		// against the heap's budget.
+		if (Renderer::allocateGpuMemory(&deviceData->gpuMemory, deviceData->logicalDevice,
+			memRequirements.size, memoryType, &bufferData.bufferMemory) != VK_SUCCESS) {
 
+			vkDestroyBuffer(deviceData->logicalDevice, bufferData.buffer, nullptr);
+			bufferData.buffer = VK_NULL_HANDLE;
 			return VK_ERROR_INITIALIZATION_FAILED;
 		}
 
+		bufferData.memorySize = memRequirements.size;
+		bufferData.memoryType = memoryType;
+
 		// Now we associate the buffer with our memory
-		vkBindBufferMemory(logicalDevice, bufferData.buffer, bufferData.bufferMemory, 0);
+		vkBindBufferMemory(deviceData->logicalDevice, bufferData.buffer, bufferData.bufferMemory, 0);
 
 		return VK_SUCCESS;
 	}
 
+	void destroyBuffer(Renderer::VulkanDeviceData* deviceData, BufferData& bufferData) {
+
+		vkDestroyBuffer(deviceData->logicalDevice, bufferData.buffer, nullptr);
+		Renderer::freeGpuMemory(&deviceData->gpuMemory, deviceData->logicalDevice, bufferData.bufferMemory,
+			bufferData.memorySize, bufferData.memoryType);
+
+		bufferData = {};
+	}
+
 	void copyBuffer(VkCommandBuffer commandBuffer, VkDeviceSize size, VkBuffer srcBuffer, VkBuffer dstBuffer) {
 
 		// Define how data will be transferred between buffers in a
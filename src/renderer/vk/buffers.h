@@ -4,6 +4,7 @@
 #include <vulkan/vulkan.h>
 #include <glm/glm.hpp>
 #include <array>
+#include "vulkanDeviceData.h"
 
 namespace Buffers {
 
@@ -13,6 +14,9 @@ namespace Buffers {
     struct BufferData {
         VkBuffer buffer { VK_NULL_HANDLE };
         VkDeviceMemory bufferMemory { VK_NULL_HANDLE };
+        // Needed to give the memory back to the tracker.
+        VkDeviceSize memorySize { 0 };
+        uint32_t memoryType { 0 };
     };
 
     // -------------------------- INDEX BUFFER STRUCT ---------------------------
@@ -47,26 +51,28 @@ namespace Buffers {
         glm::mat4 mvp {glm::mat4(1.0f)};
     };
 
-    template <typename T>
-    struct DynamicUniformBuffer {
-        size_t dynamicAlignment     {0};
-        size_t bufferSize           {0};
-        T* data                     {nullptr};
-        BufferData buffer           {VK_NULL_HANDLE};
+    // ------------------------- PUSH CONSTANT STRUCT ------------------------
+
+    // Pushed once per command buffer - the same for every quad drawn.
+    struct PushConstants {
+        glm::mat4 viewProjection {glm::mat4(1.0f)};
     };
 
     // ---------------------------- BUFFER METHODS ---------------------------
 
-    // A method for creating a generic buffer - to be used for buffer creation
+    // A method for creating a generic buffer - to be used for buffer creation.
+    // Nothing is left behind if this fails.
     VkResult createBuffer(
-        VkPhysicalDevice,
-        VkDevice,
+        Renderer::VulkanDeviceData*,
         VkDeviceSize,
         VkBufferUsageFlags,
         VkMemoryPropertyFlags,
         BufferData&
     );
 
+    // Destroys the buffer and frees its memory.
+    void destroyBuffer(Renderer::VulkanDeviceData*, BufferData&);
+
     // Used to copy data between a staging buffer and a standard buffer (index or vertex)
     void copyBuffer(
         VkCommandBuffer,
@@ -96,27 +102,6 @@ namespace Buffers {
     // TODO: Find a more appropriate location for these functions
     void* alignedAlloc(size_t, size_t);
     void alignedFree(void*);
-
-    template <typename T>
-    void calculateBufferSize(DynamicUniformBuffer<T>* ubo, VkPhysicalDevice device, size_t objects) {
-
-        VkPhysicalDeviceProperties properties;
-        vkGetPhysicalDeviceProperties(device, &properties);
-
-        size_t minUboAlignment = properties.limits.minUniformBufferOffsetAlignment;
-
-        size_t dynamicAlignment = sizeof(T);
-
-        if (minUboAlignment > 0) {
-            dynamicAlignment = (dynamicAlignment + minUboAlignment - 1) & ~(minUboAlignment - 1);
-        }
-
-        size_t bufferSize = objects * dynamicAlignment;
-
-        ubo->bufferSize = bufferSize;
-        ubo->dynamicAlignment = dynamicAlignment;
-        ubo->data = (T*)alignedAlloc(bufferSize, dynamicAlignment);
-    }
 }
 
 #endif // !BUFFERS_H
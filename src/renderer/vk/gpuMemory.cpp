@@ -0,0 +1,171 @@
+#include "gpuMemory.h"
+#include <algorithm>
+#include "../core.h"
+
+namespace Renderer {
+
+    // Without VK_EXT_memory_budget, leave a fifth of each heap for everything
+    // else that might be using it.
+    static const VkDeviceSize FALLBACK_BUDGET_NUMERATOR = 4;
+    static const VkDeviceSize FALLBACK_BUDGET_DENOMINATOR = 5;
+
+    static double toMegabytes(VkDeviceSize bytes) {
+        return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
+
+    void initialiseGpuMemory(GpuMemoryData* memory, VkPhysicalDevice physicalDevice, bool isBudgetSupported) {
+
+        memory->physicalDevice = physicalDevice;
+        memory->isBudgetSupported = isBudgetSupported;
+
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memory->properties);
+
+        for (uint32_t i = 0; i < memory->properties.memoryHeapCount; i++) {
+            memory->heaps[i] = GpuHeapUsage{};
+            memory->heaps[i].size = memory->properties.memoryHeaps[i].size;
+            memory->heaps[i].isDeviceLocal =
+                (memory->properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        }
+
+        refreshGpuMemoryBudget(memory);
+
+        for (uint32_t i = 0; i < memory->properties.memoryHeapCount; i++) {
+            PONG_INFO("Memory heap {0}: {1:.1f} MB{2}, budget {3:.1f} MB", i, toMegabytes(memory->heaps[i].size),
+                memory->heaps[i].isDeviceLocal ? " (device local)" : "", toMegabytes(getHeapBudget(memory, i)));
+        }
+
+        if (!isBudgetSupported) {
+            PONG_INFO("VK_EXT_memory_budget unavailable - budgeting from heap sizes instead");
+        }
+    }
+
+    void refreshGpuMemoryBudget(GpuMemoryData* memory) {
+
+        if (!memory->isBudgetSupported) return;
+
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+        budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+        VkPhysicalDeviceMemoryProperties2 properties{};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        properties.pNext = &budgetProperties;
+
+        vkGetPhysicalDeviceMemoryProperties2(memory->physicalDevice, &properties);
+
+        for (uint32_t i = 0; i < memory->properties.memoryHeapCount; i++) {
+            memory->heaps[i].driverBudget = budgetProperties.heapBudget[i];
+            memory->heaps[i].driverUsage = budgetProperties.heapUsage[i];
+        }
+    }
+
+    uint32_t getMemoryHeapIndex(const GpuMemoryData* memory, uint32_t memoryType) {
+        return memory->properties.memoryTypes[memoryType].heapIndex;
+    }
+
+    VkDeviceSize getHeapBudget(const GpuMemoryData* memory, uint32_t heapIndex) {
+
+        const GpuHeapUsage& heap = memory->heaps[heapIndex];
+        VkDeviceSize budget;
+
+        if (memory->isBudgetSupported) {
+            // The driver's budget is for the whole process - take off whatever
+            // isn't ours to get what's left for us.
+            VkDeviceSize otherUsage = heap.driverUsage > heap.allocatedBytes ? heap.driverUsage - heap.allocatedBytes : 0;
+            budget = heap.driverBudget > otherUsage ? heap.driverBudget - otherUsage : 0;
+        } else {
+            budget = heap.size / FALLBACK_BUDGET_DENOMINATOR * FALLBACK_BUDGET_NUMERATOR;
+        }
+
+        if (heap.isDeviceLocal && memory->budget > 0) {
+            budget = std::min(budget, memory->budget);
+        }
+
+        return budget;
+    }
+
+    static bool isOverBudget(const GpuMemoryData* memory, uint32_t heapIndex, VkDeviceSize size) {
+        return memory->heaps[heapIndex].allocatedBytes + size > getHeapBudget(memory, heapIndex);
+    }
+
+    static bool evict(GpuMemoryData* memory, uint32_t heapIndex) {
+        if (!memory->evict || !memory->evict(memory->evictUserData, heapIndex)) return false;
+        memory->evictionCount++;
+        return true;
+    }
+
+    VkResult allocateGpuMemory(GpuMemoryData* memory, VkDevice device, VkDeviceSize size, uint32_t memoryType,
+        VkDeviceMemory* deviceMemory) {
+
+        uint32_t heapIndex = getMemoryHeapIndex(memory, memoryType);
+        GpuHeapUsage& heap = memory->heaps[heapIndex];
+
+        refreshGpuMemoryBudget(memory);
+
+        // Make room first, rather than waiting for the allocation to fail.
+        while (isOverBudget(memory, heapIndex, size) && evict(memory, heapIndex)) {}
+
+        if (isOverBudget(memory, heapIndex, size)) {
+            memory->overBudgetCount++;
+            PONG_WARN("Allocating {0:.2f} MB takes heap {1} over its {2:.1f} MB budget ({3:.1f} MB in use)",
+                toMegabytes(size), heapIndex, toMegabytes(getHeapBudget(memory, heapIndex)),
+                toMegabytes(heap.allocatedBytes));
+        }
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryType;
+
+        VkResult result = vkAllocateMemory(device, &allocInfo, nullptr, deviceMemory);
+
+        // The budget was wrong (or wasn't available) - free what we can and try again.
+        while ((result == VK_ERROR_OUT_OF_DEVICE_MEMORY || result == VK_ERROR_OUT_OF_HOST_MEMORY)
+            && evict(memory, heapIndex)) {
+            result = vkAllocateMemory(device, &allocInfo, nullptr, deviceMemory);
+        }
+
+        if (result != VK_SUCCESS) {
+            memory->failedAllocationCount++;
+            *deviceMemory = VK_NULL_HANDLE;
+            PONG_ERROR("Failed to allocate {0:.2f} MB from heap {1} ({2:.1f} MB in use)", toMegabytes(size),
+                heapIndex, toMegabytes(heap.allocatedBytes));
+            return result;
+        }
+
+        heap.allocatedBytes += size;
+        heap.driverUsage += size;
+        heap.peakBytes = std::max(heap.peakBytes, heap.allocatedBytes);
+        heap.allocationCount++;
+
+        return VK_SUCCESS;
+    }
+
+    void freeGpuMemory(GpuMemoryData* memory, VkDevice device, VkDeviceMemory deviceMemory, VkDeviceSize size,
+        uint32_t memoryType) {
+
+        if (deviceMemory == VK_NULL_HANDLE) return;
+
+        vkFreeMemory(device, deviceMemory, nullptr);
+
+        // Usage only gets re-queried on the next allocation, so keep it roughly
+        // right in the meantime.
+        GpuHeapUsage& heap = memory->heaps[getMemoryHeapIndex(memory, memoryType)];
+        heap.allocatedBytes -= std::min(size, heap.allocatedBytes);
+        heap.driverUsage -= std::min(size, heap.driverUsage);
+        heap.allocationCount--;
+    }
+
+    void logGpuMemoryUsage(const GpuMemoryData* memory) {
+
+        for (uint32_t i = 0; i < memory->properties.memoryHeapCount; i++) {
+            const GpuHeapUsage& heap = memory->heaps[i];
+            if (heap.peakBytes == 0) continue;
+            PONG_INFO("Memory heap {0}: peak {1:.1f} MB of {2:.1f} MB budget, {3:.1f} MB still allocated",
+                i, toMegabytes(heap.peakBytes), toMegabytes(getHeapBudget(memory, i)),
+                toMegabytes(heap.allocatedBytes));
+        }
+
+        PONG_INFO("GPU memory: {0} evictions, {1} allocations over budget, {2} failed allocations",
+            memory->evictionCount, memory->overBudgetCount, memory->failedAllocationCount);
+    }
+}
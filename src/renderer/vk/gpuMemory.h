@@ -0,0 +1,77 @@
+#ifndef PONG_VK_GPUMEMORY_H
+#define PONG_VK_GPUMEMORY_H
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+namespace Renderer {
+
+    // Device memory accounting. Every vkAllocateMemory the renderer makes goes
+    // through allocateGpuMemory, which keeps a running total for each memory heap
+    // and checks it against that heap's budget before allocating.
+    //
+    // The budget comes from VK_EXT_memory_budget where the device has it (which
+    // also accounts for other processes and the driver's own allocations), and
+    // is otherwise a fixed share of the heap's size. It can be capped further for
+    // device-local heaps with a configured budget.
+    //
+    // When an allocation would go over budget, the evict callback is asked to
+    // free something on that heap first - it's called until the allocation fits
+    // or it has nothing left to give. Allocating past the budget is still tried
+    // after that, since a budget is a target rather than a hard limit.
+    //
+    // None of this is thread safe - all GPU allocations are made from the
+    // render thread.
+
+    // Frees something on the given heap. Returns false if there's nothing left
+    // it can free.
+    typedef bool (*GpuMemoryEvictFunction)(void* userData, uint32_t heapIndex);
+
+    struct GpuHeapUsage {
+        VkDeviceSize size                           {0};
+        bool isDeviceLocal                          {false};
+        // What we've allocated on this heap, and the most it's ever held.
+        VkDeviceSize allocatedBytes                 {0};
+        VkDeviceSize peakBytes                      {0};
+        uint32_t allocationCount                    {0};
+        // As last reported by VK_EXT_memory_budget. Usage here is the whole
+        // process's, so includes memory the driver allocated on our behalf.
+        VkDeviceSize driverBudget                   {0};
+        VkDeviceSize driverUsage                    {0};
+    };
+
+    struct GpuMemoryData {
+        VkPhysicalDevice physicalDevice             {VK_NULL_HANDLE};
+        VkPhysicalDeviceMemoryProperties properties {};
+        GpuHeapUsage heaps[VK_MAX_MEMORY_HEAPS];
+        // VK_EXT_memory_budget was enabled.
+        bool isBudgetSupported                      {false};
+        // Cap on any device-local heap, in bytes. 0 for no cap beyond the
+        // heap's own budget.
+        VkDeviceSize budget                         {0};
+        GpuMemoryEvictFunction evict                {nullptr};
+        void* evictUserData                         {nullptr};
+        uint64_t evictionCount                      {0};
+        // Allocations made even though they took a heap over budget.
+        uint64_t overBudgetCount                    {0};
+        uint64_t failedAllocationCount              {0};
+    };
+
+    // Leaves the configured budget and evict callback alone, so they can be set
+    // before the device is created.
+    void initialiseGpuMemory(GpuMemoryData*, VkPhysicalDevice, bool isBudgetSupported);
+    // Re-queries VK_EXT_memory_budget, if enabled.
+    void refreshGpuMemoryBudget(GpuMemoryData*);
+
+    uint32_t getMemoryHeapIndex(const GpuMemoryData*, uint32_t memoryType);
+    // How much we may use of the heap, taking the configured cap into account.
+    VkDeviceSize getHeapBudget(const GpuMemoryData*, uint32_t heapIndex);
+
+    VkResult allocateGpuMemory(GpuMemoryData*, VkDevice, VkDeviceSize size, uint32_t memoryType,
+        VkDeviceMemory*);
+    void freeGpuMemory(GpuMemoryData*, VkDevice, VkDeviceMemory, VkDeviceSize size, uint32_t memoryType);
+
+    void logGpuMemoryUsage(const GpuMemoryData*);
+}
+
+#endif //PONG_VK_GPUMEMORY_H
@@ -19,11 +19,13 @@ namespace Renderer {
 
     // ------------------------- Higher Level Structs ---------------------------
 
-    VkResult createSwapchain(SwapchainData* data, VulkanDeviceData* deviceData) {
-        // Start by getting the supported formats for the swapchain
+    VkResult createSwapchain(SwapchainData* data, VulkanDeviceData* deviceData, Memory::Arena* arena) {
+        // Start by getting the supported formats for the swapchain. These are
+        // only needed until the swapchain has been created.
+        Memory::ArenaMarker marker = Memory::getArenaMarker(arena);
         SwapchainSupportDetails supportDetails =
                 querySwapchainSupport(deviceData->physicalDevice,
-                                      deviceData->surface);
+                                      deviceData->surface, arena);
 
         // We want to find three settings for our swapchain:
         // 1. We want to find the surface format (color depth).
@@ -126,6 +128,12 @@ namespace Renderer {
         swapchainCreateInfo.imageArrayLayers = 1;
         swapchainCreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
+        // If the surface allows it, we also want to be able to copy out of the
+        // swapchain images so frames can be read back (see capture.h).
+        if (supportDetails.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) {
+            swapchainCreateInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
+
         uint32_t queueFamilyIndices[] = {
                 deviceData->indices.graphicsFamily.value(),
                 deviceData->indices.presentFamily.value()
@@ -163,9 +171,12 @@ namespace Renderer {
         // With all the config done, we can finally make the swapchain.
         VkSwapchainKHR swapchain;
 
-        if (vkCreateSwapchainKHR(deviceData->logicalDevice, &swapchainCreateInfo,
-                                 nullptr, &swapchain) != VK_SUCCESS) {
+        VkResult result = vkCreateSwapchainKHR(deviceData->logicalDevice, &swapchainCreateInfo,
+                                               nullptr, &swapchain);
 
+        Memory::rewindArena(arena, marker);
+
+        if (result != VK_SUCCESS) {
             return VK_ERROR_INITIALIZATION_FAILED;
         }
 
@@ -174,7 +185,7 @@ namespace Renderer {
         vkGetSwapchainImagesKHR(deviceData->logicalDevice, swapchain,
                                 &imageCount, nullptr);
 
-        VkImage* swapchainImages = new VkImage[imageCount];
+        VkImage* swapchainImages = Memory::allocateArray<VkImage>(arena, imageCount, Memory::MemoryTag::SWAPCHAIN);
 
         vkGetSwapchainImagesKHR(deviceData->logicalDevice, swapchain, &imageCount,
                                 swapchainImages);
@@ -184,24 +195,24 @@ namespace Renderer {
         data->imageCount = imageCount;
         data->swapchainFormat = chosenFormat.format;
         data->swapchainExtent = chosenExtent;
+        data->imageUsage = swapchainCreateInfo.imageUsage;
         data->pImages = swapchainImages;
 
         // Now we can create image views for use later on in the program.
-        if (createImageViews(deviceData->logicalDevice, data) != VK_SUCCESS) {
+        if (createImageViews(deviceData->logicalDevice, data, arena) != VK_SUCCESS) {
             return VK_ERROR_INITIALIZATION_FAILED;
         }
 
-        cleanupSwapchainSupportDetails(&supportDetails);
-
         return VK_SUCCESS;
     }
 
     // A VkImageView object is required to use any Images in Vulkan.
     // A view describes how to access an image and which part of an image
     // should be accessed.
-    VkResult createImageViews(VkDevice device, SwapchainData* data) {
+    VkResult createImageViews(VkDevice device, SwapchainData* data, Memory::Arena* arena) {
 
-        VkImageView* imageViews = new VkImageView[data->imageCount];
+        VkImageView* imageViews = Memory::allocateArray<VkImageView>(arena, data->imageCount,
+            Memory::MemoryTag::SWAPCHAIN);
 
         for (size_t i = 0; i < data->imageCount; i++) {
             if (createImageView(device, data->pImages[i], data->swapchainFormat, imageViews[i])
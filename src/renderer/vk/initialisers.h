@@ -14,8 +14,10 @@ namespace Renderer {
 
     // TODO: Change return types to Status
     VkApplicationInfo initialiseVulkanApplicationInfo(const char*, const char*, uint32_t, uint32_t, uint32_t);
-    VkResult createSwapchain(SwapchainData*, VulkanDeviceData*);
-    VkResult createImageViews(VkDevice, SwapchainData*);
+    // The image and view arrays are allocated from the given arena, which should
+    // be reset whenever the swapchain is re-created.
+    VkResult createSwapchain(SwapchainData*, VulkanDeviceData*, Memory::Arena*);
+    VkResult createImageViews(VkDevice, SwapchainData*, Memory::Arena*);
     Status createImageView(VkDevice, VkImage, VkFormat, VkImageView&);
     Status initialiseVulkanInstance(VulkanDeviceData*, bool, const char*, const char*);
     Status createVulkanDeviceData(VulkanDeviceData*, GLFWwindow*, bool);
@@ -2,10 +2,11 @@
 
 namespace Renderer {
 
-    SwapchainSupportDetails querySwapchainSupport(VkPhysicalDevice device, VkSurfaceKHR surface) {
+    SwapchainSupportDetails querySwapchainSupport(VkPhysicalDevice device, VkSurfaceKHR surface,
+        Memory::Arena* arena) {
 
         // instantiate a struct to store swapchain details.
-        SwapchainSupportDetails details;
+        SwapchainSupportDetails details{};
 
         // Now follow a familiar pattern and query all the support details
         // from Vulkan...
@@ -19,8 +20,8 @@ namespace Renderer {
         // Using a vector for the utility functions - statically resize the
         // data within it to hold·the data we need.
         if (formatCount != 0) {
-            VkSurfaceFormatKHR* formats = static_cast<VkSurfaceFormatKHR *>(malloc(
-                    formatCount * sizeof(VkSurfaceFormatKHR)));
+            VkSurfaceFormatKHR* formats = Memory::allocateArray<VkSurfaceFormatKHR>(arena, formatCount,
+                    Memory::MemoryTag::QUERIES);
             vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount,
                                                  formats);
             details.formats = formats;
@@ -32,8 +33,8 @@ namespace Renderer {
 
         // Same as above ^
         if (presentModeCount != 0) {
-            VkPresentModeKHR* presentModes = static_cast<VkPresentModeKHR *>(malloc(
-                    presentModeCount * sizeof(VkPresentModeKHR)));
+            VkPresentModeKHR* presentModes = Memory::allocateArray<VkPresentModeKHR>(arena, presentModeCount,
+                    Memory::MemoryTag::QUERIES);
             vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, presentModes);
             details.presentModes = presentModes;
             details.presentModesCount = presentModeCount;
@@ -42,9 +43,4 @@ namespace Renderer {
         // Return the details we need
         return details;
     }
-
-    void cleanupSwapchainSupportDetails(SwapchainSupportDetails* details) {
-        free(details->formats);
-        free(details->presentModes);
-    }
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <vulkan/vulkan.h>
 #include "../core.h"
+#include "../../memory/arena.h"
 
 namespace Renderer {
 
@@ -12,6 +13,7 @@ namespace Renderer {
         uint32_t imageCount;
         VkFormat swapchainFormat;
         VkExtent2D swapchainExtent;
+        VkImageUsageFlags imageUsage;
         VkImageView* pImageViews;
         VkImage* pImages;
     };
@@ -25,8 +27,8 @@ namespace Renderer {
         uint32_t presentModesCount;
     };
 
-    SwapchainSupportDetails querySwapchainSupport(VkPhysicalDevice device,VkSurfaceKHR surface);
-    void cleanupSwapchainSupportDetails(SwapchainSupportDetails*);
+    // The format and present mode arrays are allocated from the given arena.
+    SwapchainSupportDetails querySwapchainSupport(VkPhysicalDevice device,VkSurfaceKHR surface, Memory::Arena*);
 };
 
 #endif //PONG_VK_SWAPCHAINDATA_H
@@ -2,13 +2,25 @@
 
 namespace Renderer {
 
-    void destroyTexture2D(VkDevice device, Texture2D& texture) {
+    void destroyTextureImage(VulkanDeviceData* deviceData, Texture2D& texture) {
 
-        vkDestroySampler(device, texture.sampler, nullptr);
-        vkDestroyImageView(device, texture.view, nullptr);
-        vkDestroyImage(device, texture.image, nullptr);
-        vkFreeMemory(device, texture.memory, nullptr);
+        vkDestroyImageView(deviceData->logicalDevice, texture.view, nullptr);
+        vkDestroyImage(deviceData->logicalDevice, texture.image, nullptr);
+        freeGpuMemory(&deviceData->gpuMemory, deviceData->logicalDevice, texture.memory, texture.memorySize,
+            texture.memoryType);
+
+        texture.view = VK_NULL_HANDLE;
+        texture.image = VK_NULL_HANDLE;
+        texture.memory = VK_NULL_HANDLE;
+        texture.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        texture.memorySize = 0;
     }
 
-}
+    void destroyTexture2D(VulkanDeviceData* deviceData, Texture2D& texture) {
 
+        destroyTextureImage(deviceData, texture);
+        vkDestroySampler(deviceData->logicalDevice, texture.sampler, nullptr);
+        texture.sampler = VK_NULL_HANDLE;
+    }
+
+}
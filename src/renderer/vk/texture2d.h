@@ -3,6 +3,7 @@
 
 #include <vulkan/vulkan.h>
 #include "../core.h"
+#include "vulkanDeviceData.h"
 
 namespace Renderer {
 
@@ -12,9 +13,14 @@ namespace Renderer {
         VkImageLayout layout        {VK_IMAGE_LAYOUT_UNDEFINED};
         VkImageView view            {VK_NULL_HANDLE};
         VkSampler sampler           {VK_NULL_HANDLE};
+        // Needed to give the memory back to the tracker.
+        VkDeviceSize memorySize     {0};
+        uint32_t memoryType         {0};
     };
 
-    void destroyTexture2D(VkDevice, Texture2D&);
+    // Destroys the image, its view and its memory, but keeps the sampler.
+    void destroyTextureImage(VulkanDeviceData*, Texture2D&);
+    void destroyTexture2D(VulkanDeviceData*, Texture2D&);
 }
 
 #endif //PONG_VK_TEXTURE2D_H
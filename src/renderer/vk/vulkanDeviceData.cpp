@@ -118,7 +118,7 @@ namespace Renderer {
 
         vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount,nullptr);
 
-        VkQueueFamilyProperties* queueFamilies = new VkQueueFamilyProperties[queueFamilyCount];
+        VkQueueFamilyProperties queueFamilies[queueFamilyCount];
 
         vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies);
 
@@ -139,8 +139,6 @@ namespace Renderer {
             }
         }
 
-        delete [] queueFamilies;
-
         return indices;
     }
 
@@ -175,6 +173,9 @@ namespace Renderer {
         // Destroy window surface
         vkDestroySurfaceKHR(pDeviceData->instance, pDeviceData->surface, nullptr);
 
+        // Anything still allocated here has leaked.
+        logGpuMemoryUsage(&pDeviceData->gpuMemory);
+
         // Destroy logical device
         vkDestroyDevice(pDeviceData->logicalDevice, nullptr);
 
@@ -234,12 +235,14 @@ namespace Renderer {
             bool swapchainAdequate = false;
 
             if (extensionsSupported) {
-                // Get the swap-chain details
-                SwapchainSupportDetails supportDetails = querySwapchainSupport(devices[i], pDeviceData->surface);
-                // Make sure that we have at least one supported format and one supported presentation mode.
-                swapchainAdequate = supportDetails.formatCount > 0 && supportDetails.presentModesCount > 0;
-
-                cleanupSwapchainSupportDetails(&supportDetails);
+                // Make sure that we have at least one supported format and one supported presentation
+                // mode - only the counts matter here.
+                uint32_t formatCount = 0;
+                uint32_t presentModeCount = 0;
+                vkGetPhysicalDeviceSurfaceFormatsKHR(devices[i], pDeviceData->surface, &formatCount, nullptr);
+                vkGetPhysicalDeviceSurfacePresentModesKHR(devices[i], pDeviceData->surface, &presentModeCount,
+                    nullptr);
+                swapchainAdequate = formatCount > 0 && presentModeCount > 0;
             }
 
             VkPhysicalDeviceFeatures supportedFeatures;
@@ -267,6 +270,19 @@ namespace Renderer {
         return status;
     }
 
+    static bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char* name) {
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+        VkExtensionProperties availableExtensions[extensionCount];
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions);
+
+        for (size_t i = 0; i < extensionCount; i++) {
+            if (strcmp(name, availableExtensions[i].extensionName) == 0) return true;
+        }
+        return false;
+    }
+
     Status createLogicalDevice(VulkanDeviceData* pDeviceData) {
         // First, we need to query which queue families our physical device supports.
         pDeviceData->indices = findQueueFamilies(pDeviceData->physicalDevice, pDeviceData->surface);
@@ -311,8 +327,60 @@ namespace Renderer {
         logicalDeviceInfo.pQueueCreateInfos = createInfos;
         logicalDeviceInfo.queueCreateInfoCount = static_cast<uint32_t>(createSize);
         logicalDeviceInfo.pEnabledFeatures = &deviceFeatures;
-        logicalDeviceInfo.enabledExtensionCount = pDeviceData->deviceExtensionCount;
-        logicalDeviceInfo.ppEnabledExtensionNames = pDeviceData->deviceExtensions;
+
+        // Present wait and memory budget are optional - they're only used to measure when frames
+        // actually reach the screen and to decide how much memory we can use, so they're enabled
+        // on top of the requested extensions whenever the device has them.
+        const char* enabledExtensions[pDeviceData->deviceExtensionCount + 3];
+        uint32_t enabledExtensionCount = 0;
+        for (uint32_t i = 0; i < pDeviceData->deviceExtensionCount; i++) {
+            enabledExtensions[enabledExtensionCount++] = pDeviceData->deviceExtensions[i];
+        }
+
+        pDeviceData->isPresentWaitSupported = false;
+
+#ifdef VK_KHR_present_wait
+        VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+        presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+
+        VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+        presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+        presentWaitFeatures.pNext = &presentIdFeatures;
+
+        VkPhysicalDeviceFeatures2 enabledFeatures{};
+        enabledFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        enabledFeatures.pNext = &presentWaitFeatures;
+
+        if (isDeviceExtensionAvailable(pDeviceData->physicalDevice, VK_KHR_PRESENT_ID_EXTENSION_NAME)
+            && isDeviceExtensionAvailable(pDeviceData->physicalDevice, VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+
+            vkGetPhysicalDeviceFeatures2(pDeviceData->physicalDevice, &enabledFeatures);
+            pDeviceData->isPresentWaitSupported = presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+        }
+
+        if (pDeviceData->isPresentWaitSupported) {
+            enabledExtensions[enabledExtensionCount++] = VK_KHR_PRESENT_ID_EXTENSION_NAME;
+            enabledExtensions[enabledExtensionCount++] = VK_KHR_PRESENT_WAIT_EXTENSION_NAME;
+
+            // Only turn on the features we asked for, not everything the query returned.
+            enabledFeatures.features = deviceFeatures;
+            presentIdFeatures.presentId = VK_TRUE;
+            presentWaitFeatures.presentWait = VK_TRUE;
+
+            // With a features chain, the core features go in the chain instead.
+            logicalDeviceInfo.pNext = &enabledFeatures;
+            logicalDeviceInfo.pEnabledFeatures = nullptr;
+        }
+#endif
+
+        bool isMemoryBudgetSupported = isDeviceExtensionAvailable(pDeviceData->physicalDevice,
+            VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        if (isMemoryBudgetSupported) {
+            enabledExtensions[enabledExtensionCount++] = VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+        }
+
+        logicalDeviceInfo.enabledExtensionCount = enabledExtensionCount;
+        logicalDeviceInfo.ppEnabledExtensionNames = enabledExtensions;
 
         // Now we create the logical device using the data we've accumulated thus far.
         if (vkCreateDevice(pDeviceData->physicalDevice, &logicalDeviceInfo,nullptr,
@@ -331,6 +399,8 @@ namespace Renderer {
                          pDeviceData->indices.presentFamily.value(), 0,
                          &pDeviceData->presentQueue);
 
+        initialiseGpuMemory(&pDeviceData->gpuMemory, pDeviceData->physicalDevice, isMemoryBudgetSupported);
+
         return Status::SUCCESS;
     }
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <vulkan/vulkan.h>
 #include <optional>
 #include "../core.h"
+#include "gpuMemory.h"
 #include <GLFW/glfw3.h>
 
 namespace Renderer {
@@ -33,6 +34,10 @@ namespace Renderer {
         int framebufferHeight                       {0};
         VkQueue graphicsQueue                       {VK_NULL_HANDLE};
         VkQueue presentQueue                        {VK_NULL_HANDLE};
+        // VK_KHR_present_id and VK_KHR_present_wait were both enabled.
+        bool isPresentWaitSupported                 {false};
+        // Device memory accounting - every allocation goes through this.
+        GpuMemoryData gpuMemory;
     };
 
     Status checkValidationLayerSupport(uint32_t, VkLayerProperties*, const char**, uint32_t);
@@ -143,12 +143,20 @@ namespace Renderer {
         VkDevice device, 
         GraphicsPipelineData* data,
         const SwapchainData* swapchain,
-        VkDescriptorSetLayout* descriptorSetLayout
+        VkDescriptorSetLayout* descriptorSetLayout,
+        Memory::Arena* scratchArena
     ) {
         
         // Load out vertex and fragment shaders in machine readable bytecode.
-        auto vert = readFile("src/shaders/vert.spv");
-        auto frag = readFile("src/shaders/frag.spv");
+        // The bytecode is only needed until the pipeline exists.
+        Memory::ArenaMarker marker = Memory::getArenaMarker(scratchArena);
+        auto vert = readFile("src/shaders/vert.spv", scratchArena);
+        auto frag = readFile("src/shaders/frag.spv", scratchArena);
+
+        if (!vert.p_byteCode || !frag.p_byteCode) {
+            Memory::rewindArena(scratchArena, marker);
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
 
         // Wrap the file contents in a shader module
         VkShaderModule vertShaderModule = createShaderModule(vert, device);
@@ -271,7 +279,14 @@ namespace Renderer {
         // Defines how th color will be formatted
         colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT
             | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-        colorBlendAttachment.blendEnable = VK_FALSE; 
+        // Glyphs fade out at their edges, so blend on the fragment's alpha.
+        colorBlendAttachment.blendEnable = VK_TRUE;
+        colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+        colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+        colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
         // Now we need to actually build the createInfo struct.·
         VkPipelineColorBlendStateCreateInfo colorBlending{};
         colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
@@ -281,9 +296,9 @@ namespace Renderer {
         colorBlending.pAttachments = &colorBlendAttachment;
 
         VkPushConstantRange range = {};
-        range.stageFlags = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
         range.offset = 0;
-        range.size = sizeof(Buffers::UniformBufferObject);
+        range.size = sizeof(Buffers::PushConstants);
 
         // With all those defined, we now need to build a pipeline layout
         // struct. A pipeline layout struct details all the uniform values 
@@ -302,6 +317,7 @@ namespace Renderer {
         // Now create the pipeline layout using the usual method:
         if (vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, 
                 &pipelineLayout) != VK_SUCCESS) {
+            Memory::rewindArena(scratchArena, marker);
             return VK_ERROR_INITIALIZATION_FAILED;
         }
 
@@ -332,6 +348,7 @@ namespace Renderer {
 
         if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo,
                 nullptr, &graphicsPipeline) != VK_SUCCESS) {
+                Memory::rewindArena(scratchArena, marker);
                 return VK_ERROR_INITIALIZATION_FAILED;
         }
 
@@ -340,9 +357,8 @@ namespace Renderer {
         vkDestroyShaderModule(device, vertShaderModule, nullptr);
         vkDestroyShaderModule(device, fragShaderModule, nullptr);
         
-        // Delete the pointers to the bytecode
-        delete [] vert.p_byteCode;
-        delete [] frag.p_byteCode;
+        // Give the bytecode back
+        Memory::rewindArena(scratchArena, marker);
 
         data->graphicsPipeline = graphicsPipeline;
         data->pipelineLayout = pipelineLayout;
@@ -388,13 +404,57 @@ namespace Renderer {
         return VK_SUCCESS;
     }
 
+    void bindQuadDraw(VkCommandBuffer buffer, GraphicsPipelineData* pGraphicsPipeline,
+            Buffers::VertexBuffer* vertexBuffer, Buffers::IndexBuffer* indexBuffer,
+            VkDescriptorSet descriptorSet, uint32_t instanceOffset, const glm::mat4& viewProjection) {
+
+        // Once the render pass has started, we can now attach the graphics pipeline. The second·
+        // parameter of this function call specifies whether this pipeline object is a graphics·
+        // or compute pipeline.
+        vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pGraphicsPipeline->graphicsPipeline);
+
+        // Specify a list of vertex buffers that need to be recorded by the command buffer
+        VkBuffer vertexBuffers[] = { vertexBuffer->bufferData.buffer };
+        VkDeviceSize offsets[] = {0};
+
+        // Bind the vertex buffers to the command buffer being recorded.
+        vkCmdBindVertexBuffers(buffer, 0, 1, vertexBuffers, offsets);
+
+        vkCmdBindIndexBuffer(buffer, indexBuffer->bufferData.buffer, 0, VK_INDEX_TYPE_UINT16);
+
+        // The dynamic offset picks out where the instances start in the buffer.
+        vkCmdBindDescriptorSets(
+                buffer,VK_PIPELINE_BIND_POINT_GRAPHICS,
+                pGraphicsPipeline->pipelineLayout, 0, 1,
+                &descriptorSet,1, &instanceOffset);
+
+        Buffers::PushConstants pushConstants = { viewProjection };
+        vkCmdPushConstants(buffer, pGraphicsPipeline->pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+            sizeof(pushConstants), &pushConstants);
+    }
+
+    void recordQuadDraw(VkCommandBuffer buffer, GraphicsPipelineData* pGraphicsPipeline,
+            Buffers::VertexBuffer* vertexBuffer, Buffers::IndexBuffer* indexBuffer,
+            VkDescriptorSet descriptorSet, size_t quadCount, uint32_t instanceOffset,
+            const glm::mat4& viewProjection) {
+
+        if (quadCount == 0) return;
+
+        bindQuadDraw(buffer, pGraphicsPipeline, vertexBuffer, indexBuffer, descriptorSet, instanceOffset,
+            viewProjection);
+
+        // Every quad is an instance of the same mesh, so they all go in one draw.
+        vkCmdDrawIndexed(buffer, indexBuffer->indexCount, static_cast<uint32_t>(quadCount), 0, 0, 0);
+    }
+
     // Command buffer creation method
     VkResult createCommandBuffers(
             VkDevice device, VkCommandBuffer* buffers,
             GraphicsPipelineData* pGraphicsPipeline, SwapchainData* pSwapchain,
             VkFramebuffer* pFramebuffers, VkCommandPool commandPool,
             Buffers::VertexBuffer* vertexBuffer, Buffers::IndexBuffer* indexBuffer,
-            VkDescriptorSet* descriptorSets, size_t objectCount, uint32_t dynamicAlignment) {
+            VkDescriptorSet* descriptorSets, size_t objectCount, uint32_t instanceOffset,
+            const glm::mat4& viewProjection) {
 
         // We alocate command buffers by using a CommandBufferAllocationInfo struct.
         // // This struct specifies a command pool, as well as the number of buffers to
@@ -452,33 +512,9 @@ namespace Renderer {
             // command buffer. No secondary command buffers wll be executed.
             vkCmdBeginRenderPass(buffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-            // Once the render pass has started, we can now attach the graphics pipeline. The second·
-            // parameter of this function call specifies whether this pipeline object is a graphics·
-            // or compute pipeline.
-            vkCmdBindPipeline(buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pGraphicsPipeline->graphicsPipeline);
-
-            // Specify a list of vertex buffers that need to be recorded by the command buffer
-            VkBuffer vertexBuffers[] = { vertexBuffer->bufferData.buffer };
-            VkDeviceSize offsets[] = {0};
-
-            // Bind the vertex buffers to the command buffer being recorded.
-            vkCmdBindVertexBuffers(buffers[i], 0, 1, vertexBuffers, offsets);
-
-            vkCmdBindIndexBuffer(buffers[i], indexBuffer->bufferData.buffer, 0,
-                                 VK_INDEX_TYPE_UINT16);
-
-            for (size_t j = 0; j < objectCount; j++) {
-
-                uint32_t dynamicOffset = j * static_cast<uint32_t>(dynamicAlignment);
+            recordQuadDraw(buffers[i], pGraphicsPipeline, vertexBuffer, indexBuffer, descriptorSets[i],
+                objectCount, instanceOffset, viewProjection);
 
-                vkCmdBindDescriptorSets(
-                        buffers[i],VK_PIPELINE_BIND_POINT_GRAPHICS,
-                        pGraphicsPipeline->pipelineLayout, 0, 1,
-                        &descriptorSets[i],1, &dynamicOffset);
-
-                // Now we can tell Vulkan to draw our triangle. This function has the parameters:
-                vkCmdDrawIndexed(buffers[i], indexBuffer->indexCount, 1, 0, 0, 0);
-            }
             // Now we can end the render pass:
             vkCmdEndRenderPass(buffers[i]);
 
@@ -497,7 +533,10 @@ namespace Renderer {
             GraphicsPipelineData* pGraphicsPipeline, SwapchainData* pSwapchain,
             VkFramebuffer* pFramebuffers, VkCommandPool* commandPool,
             Buffers::VertexBuffer* vertexBuffer, Buffers::IndexBuffer* indexBuffer,
-            VkDescriptorSet* descriptorSets, size_t objectCount, uint32_t dynamicAlignment) {
+            VkDescriptorSet* descriptorSets, size_t objectCount, uint32_t instanceOffset,
+            const glm::mat4& viewProjection, VkCommandBuffer* secondaryBuffers,
+            const VkCommandBuffer* replayedBuffers, uint32_t replayedBufferCount,
+            VkQueryPool timestampQueryPool, uint32_t firstQuery) {
 
         // We allocate command buffers by using a CommandBufferAllocationInfo struct.
         // // This struct specifies a command pool, as well as the number of buffers to
@@ -521,6 +560,13 @@ namespace Renderer {
             return VK_ERROR_INITIALIZATION_FAILED;
         }
 
+        // If we're timing the GPU, bracket the frame with a pair of timestamps.
+        // Queries have to be reset before they can be written again.
+        if (timestampQueryPool != VK_NULL_HANDLE) {
+            vkCmdResetQueryPool(*buffer, timestampQueryPool, firstQuery, 2);
+            vkCmdWriteTimestamp(*buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool, firstQuery);
+        }
+
         // Now we can start setting up our render pass. Render passes are
         // configured using a RenderPassBeginInfo struct:
 
@@ -543,40 +589,47 @@ namespace Renderer {
         renderPassInfo.clearValueCount = 1;
         renderPassInfo.pClearValues = &clearColor;
 
-        // Specify that render pass commands will be embedded in the primary
-        // command buffer. No secondary command buffers wll be executed.
-        vkCmdBeginRenderPass(*buffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        // Everything drawn in the render pass comes from secondary command
+        // buffers - the ones recorded ahead of time and just replayed (the
+        // static layer, say), then one holding this frame's quads.
+        vkCmdBeginRenderPass(*buffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-        // Once the render pass has started, we can now attach the graphics pipeline. The second·
-        // parameter of this function call specifies whether this pipeline object is a graphics·
-        // or compute pipeline.
-        vkCmdBindPipeline(*buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pGraphicsPipeline->graphicsPipeline);
+        VkCommandBuffer quadBuffer = secondaryBuffers[bufferIndex];
 
-        // Specify a list of vertex buffers that need to be recorded by the command buffer
-        VkBuffer vertexBuffers[] = { vertexBuffer->bufferData.buffer };
-        VkDeviceSize offsets[] = {0};
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = pGraphicsPipeline->renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = pFramebuffers[bufferIndex];
 
-        // Bind the vertex buffers to the command buffer being recorded.
-        vkCmdBindVertexBuffers(*buffer, 0, 1, vertexBuffers, offsets);
+        VkCommandBufferBeginInfo secondaryBeginInfo{};
+        secondaryBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        secondaryBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT
+            | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        secondaryBeginInfo.pInheritanceInfo = &inheritanceInfo;
 
-        vkCmdBindIndexBuffer(*buffer, indexBuffer->bufferData.buffer, 0,
-                             VK_INDEX_TYPE_UINT16);
+        if (vkBeginCommandBuffer(quadBuffer, &secondaryBeginInfo) != VK_SUCCESS) {
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
 
-        for (size_t j = 0; j < objectCount; j++) {
+        // The dynamic offset picks out this frame's slice of the instance buffer.
+        recordQuadDraw(quadBuffer, pGraphicsPipeline, vertexBuffer, indexBuffer, descriptorSets[bufferIndex],
+            objectCount, instanceOffset, viewProjection);
 
-            uint32_t dynamicOffset = j * static_cast<uint32_t>(dynamicAlignment);
+        if (vkEndCommandBuffer(quadBuffer) != VK_SUCCESS) {
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
 
-            vkCmdBindDescriptorSets(
-                    *buffer,VK_PIPELINE_BIND_POINT_GRAPHICS,
-                    pGraphicsPipeline->pipelineLayout, 0, 1,
-                    &descriptorSets[bufferIndex],1, &dynamicOffset);
+        if (replayedBufferCount > 0) vkCmdExecuteCommands(*buffer, replayedBufferCount, replayedBuffers);
+        vkCmdExecuteCommands(*buffer, 1, &quadBuffer);
 
-            // Now we can tell Vulkan to draw our triangle. This function has the parameters:
-            vkCmdDrawIndexed(*buffer, indexBuffer->indexCount, 1, 0, 0, 0);
-        }
         // Now we can end the render pass:
         vkCmdEndRenderPass(*buffer);
 
+        if (timestampQueryPool != VK_NULL_HANDLE) {
+            vkCmdWriteTimestamp(*buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, firstQuery + 1);
+        }
+
         //  Now we can end the command buffer recording
         if (vkEndCommandBuffer(*buffer) != VK_SUCCESS) {
             return VK_ERROR_INITIALIZATION_FAILED;
@@ -587,21 +640,25 @@ namespace Renderer {
 
     // Simple method for cleaning up all items relating to our swapchain
     void cleanupSwapchain(
-        VkDevice device,
+        VulkanDeviceData* deviceData,
         SwapchainData* pSwapchain,
         GraphicsPipelineData* pGraphicsPipeline,
         VkCommandPool commandPool,
         VkFramebuffer* pFramebuffers,
         VkCommandBuffer* pCommandbuffers,
-        Buffers::BufferData* uniformBuffers,
+        VkCommandBuffer* pSecondaryCommandBuffers,
         VkDescriptorPool& descriptorPool) {
 
+        VkDevice device = deviceData->logicalDevice;
+
         for (size_t i = 0; i < pSwapchain->imageCount; i++) {
             vkDestroyFramebuffer(device, pFramebuffers[i], nullptr);
         }
 
         vkFreeCommandBuffers(device, commandPool, pSwapchain->imageCount, 
                 pCommandbuffers);
+        vkFreeCommandBuffers(device, commandPool, pSwapchain->imageCount,
+                pSecondaryCommandBuffers);
 
         // Destroy the graphics pipeline··
         vkDestroyPipeline(device, pGraphicsPipeline->graphicsPipeline, nullptr);
@@ -615,16 +672,12 @@ namespace Renderer {
             vkDestroyImageView(device, pSwapchain->pImageViews[i], nullptr);
         }
 
-        delete [] pSwapchain->pImageViews;
-
-        delete [] pSwapchain->pImages;
+        // The image and view arrays live in the swapchain arena, which is reset
+        // before the swapchain is re-created.
 
         // Destroy the Swapchain
         vkDestroySwapchainKHR(device, pSwapchain->swapchain, nullptr);
 
-        vkDestroyBuffer(device, uniformBuffers->buffer, nullptr);
-        vkFreeMemory(device, uniformBuffers->bufferMemory, nullptr);
-
         vkDestroyDescriptorPool(device, descriptorPool, nullptr);
     }
 
@@ -670,8 +723,7 @@ namespace Renderer {
 
         // Create a buffer for the staging buffer.
         if (Buffers::createBuffer(
-            deviceData->physicalDevice, 
-            deviceData->logicalDevice, 
+            deviceData,
             bufferSize, 
             VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
@@ -692,8 +744,7 @@ namespace Renderer {
 
         // Now create the actual buffer that we'll end up using:
         if (Buffers::createBuffer(
-            deviceData->physicalDevice, 
-            deviceData->logicalDevice, 
+            deviceData,
             bufferSize,
             VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
@@ -714,8 +765,7 @@ namespace Renderer {
         );
 
         // Destroy the staging buffer and free memory
-        vkDestroyBuffer(deviceData->logicalDevice, stagingBuffer.buffer, nullptr);
-        vkFreeMemory(deviceData->logicalDevice, stagingBuffer.bufferMemory, nullptr);
+        Buffers::destroyBuffer(deviceData, stagingBuffer);
 
         return VK_SUCCESS;
     }
@@ -733,8 +783,7 @@ namespace Renderer {
         
         // Create the staging buffer
         if (Buffers::createBuffer(
-            deviceData->physicalDevice, 
-            deviceData->logicalDevice, 
+            deviceData,
             bufferSize,
             VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
@@ -755,8 +804,7 @@ namespace Renderer {
         
         // Create the actual buffer that we'll end up using
         if (Buffers::createBuffer(
-            deviceData->physicalDevice, 
-            deviceData->logicalDevice, 
+            deviceData,
             bufferSize,
             VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
@@ -776,8 +824,7 @@ namespace Renderer {
         );
 
         // Destroy the staging buffer and de-allocate its memory
-        vkDestroyBuffer(deviceData->logicalDevice, stagingBuffer.buffer, nullptr);
-        vkFreeMemory(deviceData->logicalDevice, stagingBuffer.bufferMemory, nullptr);
+        Buffers::destroyBuffer(deviceData, stagingBuffer);
    
         return VK_SUCCESS;
 
@@ -790,8 +837,7 @@ namespace Renderer {
 
         for (size_t i = 0; i < imageCount; i++) {
             if (Buffers::createBuffer(
-                deviceData->physicalDevice,
-                deviceData->logicalDevice,
+                deviceData,
                 bufferSize,
                 VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | 
@@ -809,37 +855,55 @@ namespace Renderer {
             VulkanDeviceData* deviceData,
             VkDescriptorSet* sets, VkDescriptorSetLayout* layout,
             VkDescriptorPool* pool, uint32_t imageCount,
-            Buffers::BufferData* uBuffers, uint32_t bufferSize, Texture2D& texture) {
+            Buffers::BufferData* instanceBuffer, VkDeviceSize instanceRange,
+            Texture2D* textures, uint32_t textureCount,
+            Memory::Arena* scratchArena) {
+
+        Memory::ArenaMarker marker = Memory::getArenaMarker(scratchArena);
 
-        std::vector<VkDescriptorSetLayout> layouts(imageCount, *layout);
+        VkDescriptorSetLayout* layouts = Memory::allocateArray<VkDescriptorSetLayout>(scratchArena, imageCount,
+            Memory::MemoryTag::RENDERER2D);
+        for (uint32_t i = 0; i < imageCount; i++) layouts[i] = *layout;
 
         VkDescriptorSetAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
         allocInfo.descriptorPool = *pool;
         allocInfo.descriptorSetCount = imageCount;
-        allocInfo.pSetLayouts = layouts.data();
+        allocInfo.pSetLayouts = layouts;
 
         if (vkAllocateDescriptorSets(deviceData->logicalDevice, &allocInfo,
                                      sets) != VK_SUCCESS) {
 
+            Memory::rewindArena(scratchArena, marker);
             return VK_ERROR_INITIALIZATION_FAILED;
         }
 
-        for (size_t i = 0; i < imageCount; i++) {
+        // Every set samples the same textures.
+        VkDescriptorImageInfo* imageInfos = Memory::allocateArray<VkDescriptorImageInfo>(scratchArena, textureCount,
+            Memory::MemoryTag::RENDERER2D);
+        for (uint32_t j = 0; j < textureCount; j++) {
+            imageInfos[j] = initialiseDescriptorImageInfo(
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, textures[j].view, textures[j].sampler);
+        }
 
-            VkDescriptorBufferInfo bufferInfo = initialiseDescriptorBufferInfo(uBuffers->buffer, 0, VK_WHOLE_SIZE);
+        for (size_t i = 0; i < imageCount; i++) {
 
-            VkDescriptorImageInfo imageInfo = initialiseDescriptorImageInfo(
-                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, texture.view, texture.sampler);
+            // The range covers one frame's instances - the dynamic offset given
+            // at bind time says which frame.
+            VkDescriptorBufferInfo bufferInfo = initialiseDescriptorBufferInfo(instanceBuffer->buffer, 0,
+                instanceRange);
 
             VkWriteDescriptorSet descriptorSets[] = {
-                    initialiseWriteDescriptorSet(sets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 0, 1, &bufferInfo),
-                    initialiseWriteDescriptorSet(sets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, 1, nullptr, &imageInfo)
+                    initialiseWriteDescriptorSet(sets[i], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 0, 1, &bufferInfo),
+                    initialiseWriteDescriptorSet(sets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, textureCount,
+                        nullptr, imageInfos)
             };
 
             vkUpdateDescriptorSets(deviceData->logicalDevice, 2, descriptorSets, 0, nullptr);
         }
 
+        Memory::rewindArena(scratchArena, marker);
+
         return VK_SUCCESS;
     }
 
@@ -921,6 +985,14 @@ namespace Renderer {
 
             sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
             destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        } else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+            // Re-uploading - anything submitted earlier that samples the image has
+            // to be done with it first.
+            barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+            sourceStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
         } else {
             PONG_ERROR("FAILED DUE TO UNSUPPORTED LAYOUT TRANSITION!");
             return Status::INITIALIZATION_FAILURE;
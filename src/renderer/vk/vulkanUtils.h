@@ -41,7 +41,8 @@ namespace Renderer {
         VkDevice, 
         GraphicsPipelineData*, 
         const SwapchainData*,
-        VkDescriptorSetLayout* descriptorSetLayout
+        VkDescriptorSetLayout* descriptorSetLayout,
+        Memory::Arena* scratchArena
     );
 
     VkShaderModule createShaderModule(
@@ -56,6 +57,29 @@ namespace Renderer {
         GraphicsPipelineData* graphicsPipeline
     );
 
+    // Binds the quad pipeline, mesh and instances, and pushes the camera.
+    void bindQuadDraw(
+        VkCommandBuffer buffer,
+        GraphicsPipelineData* pGraphicsPipeline,
+        Buffers::VertexBuffer* vertexBuffer,
+        Buffers::IndexBuffer* indexBuffer,
+        VkDescriptorSet descriptorSet,
+        uint32_t instanceOffset,
+        const glm::mat4& viewProjection
+    );
+
+    // Binds the quad mesh and its instances, and draws every quad in one go.
+    void recordQuadDraw(
+        VkCommandBuffer buffer,
+        GraphicsPipelineData* pGraphicsPipeline,
+        Buffers::VertexBuffer* vertexBuffer,
+        Buffers::IndexBuffer* indexBuffer,
+        VkDescriptorSet descriptorSet,
+        size_t quadCount,
+        uint32_t instanceOffset,
+        const glm::mat4& viewProjection
+    );
+
     VkResult createCommandBuffers(
         VkDevice device,
         VkCommandBuffer* buffers,
@@ -67,7 +91,8 @@ namespace Renderer {
         Buffers::IndexBuffer*,
         VkDescriptorSet* descriptorSets,
         size_t objectCount,
-        uint32_t dynamicAlignment
+        uint32_t instanceOffset,
+        const glm::mat4& viewProjection
     );
 
     VkResult rerecordCommandBuffer(
@@ -75,17 +100,20 @@ namespace Renderer {
         GraphicsPipelineData* pGraphicsPipeline, SwapchainData* pSwapchain,
         VkFramebuffer* pFramebuffers, VkCommandPool* commandPool,
         Buffers::VertexBuffer* vertexBuffer, Buffers::IndexBuffer* indexBuffer,
-        VkDescriptorSet* descriptorSets, size_t objectCount, uint32_t dynamicAlignment
+        VkDescriptorSet* descriptorSets, size_t objectCount, uint32_t instanceOffset,
+        const glm::mat4& viewProjection, VkCommandBuffer* secondaryBuffers,
+        const VkCommandBuffer* replayedBuffers, uint32_t replayedBufferCount,
+        VkQueryPool timestampQueryPool = VK_NULL_HANDLE, uint32_t firstQuery = 0
     );
 
     void cleanupSwapchain(
-        VkDevice device,
+        VulkanDeviceData* deviceData,
         SwapchainData* pSwapchain,
         GraphicsPipelineData* pGraphicsPipeline,
         VkCommandPool commandPool,
         VkFramebuffer* pFramebuffers,
         VkCommandBuffer* pCommandbuffers,
-        Buffers::BufferData* uniformBuffers,
+        VkCommandBuffer* pSecondaryCommandBuffers,
         VkDescriptorPool& descriptorPool
     );
 
@@ -111,7 +139,10 @@ namespace Renderer {
         VulkanDeviceData* deviceData,
         VkDescriptorSet* sets, VkDescriptorSetLayout* layout,
         VkDescriptorPool* pool, uint32_t imageCount,
-        Buffers::BufferData* uBuffers, uint32_t bufferSize, Texture2D& texture
+        Buffers::BufferData* instanceBuffer, VkDeviceSize instanceRange,
+        Texture2D* textures, uint32_t textureCount,
+        // Only used while the sets are written, and given back before returning.
+        Memory::Arena* scratchArena
     );
 
     VkCommandBuffer beginSingleTimeCommands(VkDevice, VkCommandPool);
@@ -1,16 +1,34 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(binding = 1) uniform sampler2D texSampler;
+// Matches QuadFlags in renderer2D.h
+const uint QUAD_FLAG_SDF = 1;
+const uint QUAD_FLAG_UNTEXTURED = 2;
+
+// [0] is the quad texture, [1] the text atlas.
+layout(binding = 1) uniform sampler2D textures[2];
 // Define a variable for the color of each vertex
 layout(location = 0) out vec4 outColor;
 // Define the variable that will be passed in (from 
 // the vertex shader)
-layout(location = 0) in vec3 fragColor;
+layout(location = 0) in vec4 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in uint fragFlags;
 
 void main() {
-    // Define the color as being that of the fragColor
-    // variable
-    outColor = vec4(fragColor * texture(texSampler, fragTexCoord).rgb, 1.0);
+    if ((fragFlags & QUAD_FLAG_SDF) != 0) {
+        // The atlas holds the distance to the glyph's edge, with the edge at
+        // 0.5. Smoothing over one screen pixel's worth of distance keeps the
+        // edge sharp however large the glyph is drawn.
+        float distance = texture(textures[1], fragTexCoord).r;
+        float width = fwidth(distance);
+        float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
+        outColor = vec4(fragColor.rgb, fragColor.a * alpha);
+    } else if ((fragFlags & QUAD_FLAG_UNTEXTURED) != 0) {
+        outColor = fragColor;
+    } else {
+        // Define the color as being that of the fragColor
+        // variable
+        outColor = vec4(fragColor.rgb * texture(textures[0], fragTexCoord).rgb, fragColor.a);
+    }
 }
@@ -1,23 +1,39 @@
 #version 450
 
-// Layout the struct for handling a model-view projection
-layout (binding = 0) uniform UniformBufferObject {
-    mat4 mvp;
-    vec3 color;
-} ubo;
+// Everything needed to draw one quad - every quad in the frame is an
+// instance of the same mesh.
+struct QuadInstance {
+    mat4 model;
+    vec4 color;
+    // Region of the texture to sample, as (u0, v0, u1, v1).
+    vec4 uvRect;
+    uint flags;
+};
+
+layout (std430, binding = 0) readonly buffer Instances {
+    QuadInstance instances[];
+};
+
+// The same for every quad - pushed once per draw.
+layout (push_constant) uniform Camera {
+    mat4 viewProjection;
+} camera;
 
 layout (location = 0) in vec2 inPosition;
 layout(location = 1) in vec2 inTexCoord;
 
 // We can define a color which will be passed into the 
 // fragment shader.
-layout (location = 0) out vec3 fragColor;
+layout (location = 0) out vec4 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragFlags;
 
 void main() {
+    QuadInstance quad = instances[gl_InstanceIndex];
     // Define the position of the triangle
-    gl_Position = ubo.mvp * vec4(inPosition, 0.0, 1.0);
+    gl_Position = camera.viewProjection * quad.model * vec4(inPosition, 0.0, 1.0);
     // Pass the colors to the fragColor variable
-    fragColor = ubo.color;
-    fragTexCoord = inTexCoord;
+    fragColor = quad.color;
+    fragTexCoord = mix(quad.uvRect.xy, quad.uvRect.zw, inTexCoord);
+    fragFlags = quad.flags;
 }
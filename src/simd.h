@@ -0,0 +1,17 @@
+#ifndef PONG_VK_SIMD_H
+#define PONG_VK_SIMD_H
+
+// Which instruction set the batched (several entities per instruction) code
+// paths are built for:
+//
+//  - AVX2 (8 lanes) when built with PONG_AVX2 (premake5 --avx2),
+//  - SSE2 (4 lanes) on any x86/x86-64 target,
+//  - plain scalar loops everywhere else.
+
+#if defined(PONG_AVX2)
+    #define PONG_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define PONG_SIMD_SSE2
+#endif
+
+#endif //PONG_VK_SIMD_H
@@ -0,0 +1,68 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace PongWindow {
+
+	enum class InputEventType : uint8_t {
+		KEY = 0,
+		MOUSE_BUTTON,
+		CURSOR
+	};
+
+	struct InputEvent {
+		// Clock::nowNanos() when the window system reported the event.
+		uint64_t timeNanos		{0};
+		InputEventType type		{InputEventType::KEY};
+		// Key or mouse button code, and whether it went down or up.
+		int32_t code			{0};
+		bool isPressed			{false};
+		// Cursor position, for CURSOR events.
+		float x					{0.0f};
+		float y					{0.0f};
+	};
+
+	// Must be a power of two.
+	constexpr uint32_t INPUT_QUEUE_CAPACITY = 1024;
+
+	// Single producer, single consumer ring buffer. The window callbacks push
+	// on whichever thread polls the window, and one other thread (or the same
+	// one) pops - neither side ever takes a lock or waits on the other. head and
+	// tail only ever increase and are wrapped when indexing.
+	struct InputQueue {
+		InputEvent events[INPUT_QUEUE_CAPACITY];
+		// Only written by the consumer.
+		std::atomic<uint32_t> head				{0};
+		// Only written by the producer.
+		std::atomic<uint32_t> tail				{0};
+		// Events thrown away because the consumer fell too far behind.
+		std::atomic<uint32_t> droppedEvents		{0};
+	};
+
+	inline bool pushInputEvent(InputQueue* queue, const InputEvent& event) {
+		uint32_t tail = queue->tail.load(std::memory_order_relaxed);
+
+		if (tail - queue->head.load(std::memory_order_acquire) == INPUT_QUEUE_CAPACITY) {
+			queue->droppedEvents.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		queue->events[tail & (INPUT_QUEUE_CAPACITY - 1)] = event;
+		queue->tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	inline bool popInputEvent(InputQueue* queue, InputEvent* event) {
+		uint32_t head = queue->head.load(std::memory_order_relaxed);
+
+		if (head == queue->tail.load(std::memory_order_acquire)) return false;
+
+		*event = queue->events[head & (INPUT_QUEUE_CAPACITY - 1)];
+		queue->head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+}
+
+#endif
@@ -1,6 +1,9 @@
 #include "window.h"
 #include <GLFW/glfw3.h>
 #include "../logger.h"
+#include "../clock.h"
+#include <thread>
+#include <chrono>
 
 namespace PongWindow {
 
@@ -11,6 +14,8 @@ namespace PongWindow {
 		window->windowData.name = name;
 		window->windowData.width = width;
 		window->windowData.height = height;
+		window->windowData.framebufferWidth = width;
+		window->windowData.framebufferHeight = height;
 		window->windowData.isUsingVsync = isUsingVsync;
 		window->type = type;
 
@@ -28,9 +33,14 @@ namespace PongWindow {
 
 			glfwSetWindowUserPointer(glfwWindow, &window->windowData);
 
+			glfwGetFramebufferSize(glfwWindow, &window->windowData.framebufferWidth,
+				&window->windowData.framebufferHeight);
+
 			glfwSetFramebufferSizeCallback(glfwWindow, [](GLFWwindow* window, int width,
 				int height) {
 				auto data = reinterpret_cast<WindowData*>(glfwGetWindowUserPointer(window));
+				data->framebufferWidth = width;
+				data->framebufferHeight = height;
 				data->isResized = true;
 			});
 
@@ -39,6 +49,39 @@ namespace PongWindow {
 				data->isRunning = false;
 			});
 
+			// Input is forwarded as events rather than polled, so presses shorter
+			// than a frame aren't lost. Key repeats carry no new information.
+			glfwSetKeyCallback(glfwWindow, [](GLFWwindow* window, int key, int, int action, int) {
+				if (key == GLFW_KEY_UNKNOWN || action == GLFW_REPEAT) return;
+				auto data = reinterpret_cast<WindowData*>(glfwGetWindowUserPointer(window));
+				InputEvent event;
+				event.timeNanos = Clock::nowNanos();
+				event.type = InputEventType::KEY;
+				event.code = key;
+				event.isPressed = action == GLFW_PRESS;
+				pushInputEvent(&data->inputQueue, event);
+			});
+
+			glfwSetMouseButtonCallback(glfwWindow, [](GLFWwindow* window, int button, int action, int) {
+				auto data = reinterpret_cast<WindowData*>(glfwGetWindowUserPointer(window));
+				InputEvent event;
+				event.timeNanos = Clock::nowNanos();
+				event.type = InputEventType::MOUSE_BUTTON;
+				event.code = button;
+				event.isPressed = action == GLFW_PRESS;
+				pushInputEvent(&data->inputQueue, event);
+			});
+
+			glfwSetCursorPosCallback(glfwWindow, [](GLFWwindow* window, double x, double y) {
+				auto data = reinterpret_cast<WindowData*>(glfwGetWindowUserPointer(window));
+				InputEvent event;
+				event.timeNanos = Clock::nowNanos();
+				event.type = InputEventType::CURSOR;
+				event.x = static_cast<float>(x);
+				event.y = static_cast<float>(y);
+				pushInputEvent(&data->inputQueue, event);
+			});
+
 			window->nativeWindow = glfwWindow;
 		}
 
@@ -48,9 +91,9 @@ namespace PongWindow {
 	void destroyWindow(Window* window) {
 		if (window->type == NativeWindowType::GLFW) {
 			glfwDestroyWindow(static_cast<GLFWwindow*>(window->nativeWindow));
-			delete window;
 			glfwTerminate();
 		}
+		delete window;
 	}
 
 	// Handles a case where the window is minimised - pauses rendering until its opened again.
@@ -68,8 +111,20 @@ namespace PongWindow {
 		}
 	}
 
-	void onWindowUpdate() {
-		glfwPollEvents();
+	void onWindowUpdate(Window* window) {
+		if (window->type == NativeWindowType::GLFW) {
+			glfwPollEvents();
+		}
+	}
+
+	void waitForWindowEvents(Window* window, double timeoutSeconds) {
+		if (timeoutSeconds <= 0.0) return;
+
+		if (window->type == NativeWindowType::GLFW) {
+			glfwWaitEventsTimeout(timeoutSeconds);
+		} else {
+			std::this_thread::sleep_for(std::chrono::duration<double>(timeoutSeconds));
+		}
 	}
 
 	bool isWindowRunning(Window* window) {
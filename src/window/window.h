@@ -2,6 +2,8 @@
 #ifndef WINDOW_H
 #define WINDOW_H
 
+#include "inputQueue.h"
+
 namespace PongWindow {
 
 	enum class NativeWindowType
@@ -13,10 +15,15 @@ namespace PongWindow {
 	struct WindowData {
 		int width{ 0 };
 		int height{ 0 };
+		// Size of the drawable surface in pixels - 0x0 while minimised.
+		int framebufferWidth{ 0 };
+		int framebufferHeight{ 0 };
 		char* name{ "Window" };
 		bool isUsingVsync{ true };
 		bool isResized{ false };
 		bool isRunning{ true };
+		// Key, mouse button and cursor events, in the order they happened.
+		InputQueue inputQueue;
 	};
 
 	struct Window {
@@ -28,7 +35,9 @@ namespace PongWindow {
 	Window* initialiseWindow(NativeWindowType, int, int, char*, bool = true);
 	void destroyWindow(Window*);
 	void onWindowMinimised(void*, NativeWindowType, int*, int*);
-	void onWindowUpdate();
+	void onWindowUpdate(Window*);
+	// Sleeps until the window receives an event or the timeout runs out.
+	void waitForWindowEvents(Window*, double timeoutSeconds);
 	bool isWindowRunning(Window*);
 }
 